@@ -0,0 +1,579 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "block_compression.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace BlockCompression
+{
+
+static constexpr uint32_t NUM_BLOCK_TEXELS = BLOCK_DIM * BLOCK_DIM;
+
+// BC7 interpolation weights for 4-bit indices, out of 64
+static constexpr uint32_t BC7_NUM_IDXS = 16;
+static constexpr uint32_t BC7_WEIGHTS[BC7_NUM_IDXS] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static constexpr uint32_t BC7_MODE = 6;
+// least squares refits of the endpoints to the chosen indices
+static constexpr uint32_t BC7_MAX_REFINE_ITERATIONS = 3;
+static constexpr uint32_t BC7_POWER_ITERATIONS = 8;
+
+static constexpr uint32_t BC4_BLOCK_SIZE_BYTES = 8;
+static constexpr uint32_t BC4_NUM_IDXS = 8;
+
+// bits are stored from the least significant bit of the first byte up
+class BitWriter
+{
+private:
+    uint8_t* data;
+    uint32_t bitIdx{ 0 };
+
+public:
+    explicit BitWriter(uint8_t* data) : data(data) {}
+
+    void write(uint32_t value, uint32_t numBits)
+    {
+        for (uint32_t i = 0; i < numBits; ++i, ++this->bitIdx)
+        {
+            this->data[this->bitIdx >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (this->bitIdx & 7));
+        }
+    }
+};
+
+class BitReader
+{
+private:
+    const uint8_t* data;
+    uint32_t bitIdx{ 0 };
+
+public:
+    explicit BitReader(const uint8_t* data) : data(data) {}
+
+    uint32_t read(uint32_t numBits)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < numBits; ++i, ++this->bitIdx)
+        {
+            value |= ((this->data[this->bitIdx >> 3] >> (this->bitIdx & 7)) & 1u) << i;
+        }
+        return value;
+    }
+};
+
+struct Bc7Candidate
+{
+    // 7 bits each, extended to 8 by the endpoint's p-bit
+    uint8_t endpoints[2][4];
+    uint8_t pBits[2];
+    uint8_t idxs[NUM_BLOCK_TEXELS];
+    uint32_t error;
+};
+
+static uint32_t interpolateBc7(uint32_t e0, uint32_t e1, uint32_t weight)
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+static uint32_t getSquaredError(const uint8_t* a, const uint32_t* b)
+{
+    uint32_t error = 0;
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        const int32_t diff = static_cast<int32_t>(a[c]) - static_cast<int32_t>(b[c]);
+        error += static_cast<uint32_t>(diff * diff);
+    }
+    return error;
+}
+
+// Quantizes both endpoints, each with the p-bit that keeps it closest to the unquantized one, and picks the best index
+// for every texel. Trying all four p-bit combinations with full index searches gains about 0.1 dB for twice the time.
+static Bc7Candidate fitBc7Endpoints(const uint8_t* rgba, const float (*endpoints)[4])
+{
+    Bc7Candidate candidate;
+    candidate.error = 0;
+
+    uint32_t expanded[2][4];
+    for (uint32_t endpointIdx = 0; endpointIdx < 2; ++endpointIdx)
+    {
+        uint8_t quantized[2][4];
+        float quantizationErrors[2] = {};
+        for (uint32_t pBit = 0; pBit < 2; ++pBit)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const float value = std::clamp((endpoints[endpointIdx][c] - pBit) * 0.5f, 0.f, 127.f);
+                quantized[pBit][c] = static_cast<uint8_t>(value + 0.5f);
+                const float diff = static_cast<float>((quantized[pBit][c] << 1) | pBit) - endpoints[endpointIdx][c];
+                quantizationErrors[pBit] += diff * diff;
+            }
+        }
+
+        const uint32_t pBit = quantizationErrors[1] < quantizationErrors[0] ? 1 : 0;
+        candidate.pBits[endpointIdx] = static_cast<uint8_t>(pBit);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            candidate.endpoints[endpointIdx][c] = quantized[pBit][c];
+            expanded[endpointIdx][c] = (quantized[pBit][c] << 1) | pBit;
+        }
+    }
+
+    uint32_t palette[BC7_NUM_IDXS][4];
+    for (uint32_t idx = 0; idx < BC7_NUM_IDXS; ++idx)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            palette[idx][c] = interpolateBc7(expanded[0][c], expanded[1][c], BC7_WEIGHTS[idx]);
+        }
+    }
+
+    // the weights are nearly evenly spaced, so projecting onto the endpoint line and checking the neighbors of the
+    // closest index finds the best one
+    int32_t dir[4];
+    int32_t dirLengthSquared = 0;
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        dir[c] = static_cast<int32_t>(expanded[1][c]) - static_cast<int32_t>(expanded[0][c]);
+        dirLengthSquared += dir[c] * dir[c];
+    }
+
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        const uint8_t* texel = rgba + texelIdx * 4;
+
+        int32_t guessIdx = 0;
+        if (dirLengthSquared > 0)
+        {
+            int32_t dot = 0;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                dot += (static_cast<int32_t>(texel[c]) - static_cast<int32_t>(expanded[0][c])) * dir[c];
+            }
+            // rounded, in integers since this runs for every texel of every fit
+            dot = std::clamp(dot, 0, dirLengthSquared);
+            guessIdx = (30 * dot + dirLengthSquared) / (2 * dirLengthSquared);
+        }
+
+        uint32_t bestIdx = 0;
+        uint32_t bestError = ~0u;
+        for (int32_t idx = std::max(guessIdx - 1, 0); idx <= std::min(guessIdx + 1, 15); ++idx)
+        {
+            const uint32_t error = getSquaredError(texel, palette[idx]);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestIdx = static_cast<uint32_t>(idx);
+            }
+        }
+
+        candidate.idxs[texelIdx] = static_cast<uint8_t>(bestIdx);
+        candidate.error += bestError;
+    }
+
+    return candidate;
+}
+
+// Least squares fit of both endpoints to the texels, given each texel's interpolation weight. Returns false if the
+// weights don't pin down both endpoints.
+static bool refitBc7Endpoints(const uint8_t* rgba, const uint8_t* idxs, float (*outEndpoints)[4])
+{
+    float aa = 0.f;
+    float ab = 0.f;
+    float bb = 0.f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        const float b = BC7_WEIGHTS[idxs[texelIdx]] / 64.f;
+        const float a = 1.f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            ax[c] += a * rgba[texelIdx * 4 + c];
+            bx[c] += b * rgba[texelIdx * 4 + c];
+        }
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f)
+    {
+        return false;
+    }
+
+    const float rcpDet = 1.f / det;
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        outEndpoints[0][c] = std::clamp((bb * ax[c] - ab * bx[c]) * rcpDet, 0.f, 255.f);
+        outEndpoints[1][c] = std::clamp((aa * bx[c] - ab * ax[c]) * rcpDet, 0.f, 255.f);
+    }
+    return true;
+}
+
+static void encodeBc7Block(const uint8_t* rgba, uint8_t* outBlock)
+{
+    // endpoints start at the extremes of the texels along their principal axis
+    float mean[4] = {};
+    float minValues[4] = { 255.f, 255.f, 255.f, 255.f };
+    float maxValues[4] = {};
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            const float value = rgba[texelIdx * 4 + c];
+            mean[c] += value;
+            minValues[c] = std::min(minValues[c], value);
+            maxValues[c] = std::max(maxValues[c], value);
+        }
+    }
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        mean[c] /= NUM_BLOCK_TEXELS;
+    }
+
+    float covariance[4][4] = {};
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        float diff[4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            diff[c] = rgba[texelIdx * 4 + c] - mean[c];
+        }
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+            for (uint32_t col = 0; col < 4; ++col)
+            {
+                covariance[row][col] += diff[row] * diff[col];
+            }
+        }
+    }
+
+    float axis[4];
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        axis[c] = maxValues[c] - minValues[c];
+    }
+    for (uint32_t iteration = 0; iteration < BC7_POWER_ITERATIONS; ++iteration)
+    {
+        float nextAxis[4] = {};
+        float maxComponent = 0.f;
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+            for (uint32_t col = 0; col < 4; ++col)
+            {
+                nextAxis[row] += covariance[row][col] * axis[col];
+            }
+            maxComponent = std::max(maxComponent, std::abs(nextAxis[row]));
+        }
+        if (maxComponent < 1e-6f)
+        {
+            break;
+        }
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            axis[c] = nextAxis[c] / maxComponent;
+        }
+    }
+
+    float axisLengthSquared = 0.f;
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        axisLengthSquared += axis[c] * axis[c];
+    }
+
+    float minT = 0.f;
+    float maxT = 0.f;
+    if (axisLengthSquared > 1e-6f)
+    {
+        for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+        {
+            float t = 0.f;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                t += (rgba[texelIdx * 4 + c] - mean[c]) * axis[c];
+            }
+            t /= axisLengthSquared;
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+    }
+
+    float endpoints[2][4];
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        endpoints[0][c] = std::clamp(mean[c] + minT * axis[c], 0.f, 255.f);
+        endpoints[1][c] = std::clamp(mean[c] + maxT * axis[c], 0.f, 255.f);
+    }
+
+    Bc7Candidate best = fitBc7Endpoints(rgba, endpoints);
+    for (uint32_t iteration = 0; iteration < BC7_MAX_REFINE_ITERATIONS && best.error > 0; ++iteration)
+    {
+        if (!refitBc7Endpoints(rgba, best.idxs, endpoints))
+        {
+            break;
+        }
+
+        const Bc7Candidate candidate = fitBc7Endpoints(rgba, endpoints);
+        if (candidate.error >= best.error)
+        {
+            break;
+        }
+        best = candidate;
+    }
+
+    // the first texel's index is stored without its top bit, which must therefore be 0; the weights are symmetric, so
+    // swapping the endpoints and flipping every index gives the same texels
+    if (best.idxs[0] >= BC7_NUM_IDXS / 2)
+    {
+        std::swap(best.endpoints[0], best.endpoints[1]);
+        std::swap(best.pBits[0], best.pBits[1]);
+        for (uint8_t& idx : best.idxs)
+        {
+            idx = static_cast<uint8_t>(BC7_NUM_IDXS - 1 - idx);
+        }
+    }
+
+    memset(outBlock, 0, BLOCK_SIZE_BYTES);
+    BitWriter writer(outBlock);
+    writer.write(1u << BC7_MODE, BC7_MODE + 1);
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        writer.write(best.endpoints[0][c], 7);
+        writer.write(best.endpoints[1][c], 7);
+    }
+    writer.write(best.pBits[0], 1);
+    writer.write(best.pBits[1], 1);
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        writer.write(best.idxs[texelIdx], texelIdx == 0 ? 3 : 4);
+    }
+}
+
+static void decodeBc7Block(const uint8_t* block, uint8_t* outRgba)
+{
+    BitReader reader(block);
+    if (reader.read(BC7_MODE + 1) != 1u << BC7_MODE)
+    {
+        memset(outRgba, 0, NUM_BLOCK_TEXELS * 4);
+        return;
+    }
+
+    uint32_t endpoints[2][4];
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        endpoints[0][c] = reader.read(7) << 1;
+        endpoints[1][c] = reader.read(7) << 1;
+    }
+    for (uint32_t endpointIdx = 0; endpointIdx < 2; ++endpointIdx)
+    {
+        const uint32_t pBit = reader.read(1);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            endpoints[endpointIdx][c] |= pBit;
+        }
+    }
+
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        const uint32_t weight = BC7_WEIGHTS[reader.read(texelIdx == 0 ? 3 : 4)];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            outRgba[texelIdx * 4 + c] = static_cast<uint8_t>(interpolateBc7(endpoints[0][c], endpoints[1][c], weight));
+        }
+    }
+}
+
+// Endpoints are the channel's extremes, in the order that selects the 8-value palette: 0 and 1 are the endpoints
+// themselves and 2 through 7 lie evenly between them.
+static void encodeBc4Channel(const uint8_t* rgba, uint32_t channel, uint8_t* outBlock)
+{
+    uint8_t minValue = 255;
+    uint8_t maxValue = 0;
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        minValue = std::min(minValue, rgba[texelIdx * 4 + channel]);
+        maxValue = std::max(maxValue, rgba[texelIdx * 4 + channel]);
+    }
+
+    memset(outBlock, 0, BC4_BLOCK_SIZE_BYTES);
+    outBlock[0] = maxValue;
+    outBlock[1] = minValue;
+    if (maxValue == minValue)
+    {
+        return;
+    }
+
+    float palette[BC4_NUM_IDXS];
+    palette[0] = maxValue;
+    palette[1] = minValue;
+    for (uint32_t idx = 2; idx < BC4_NUM_IDXS; ++idx)
+    {
+        palette[idx] = ((8 - idx) * maxValue + (idx - 1) * minValue) / 7.f;
+    }
+
+    uint64_t idxBits = 0;
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        const float value = rgba[texelIdx * 4 + channel];
+
+        uint64_t bestIdx = 0;
+        float bestError = 256.f;
+        for (uint32_t idx = 0; idx < BC4_NUM_IDXS; ++idx)
+        {
+            const float error = std::abs(palette[idx] - value);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestIdx = idx;
+            }
+        }
+        idxBits |= bestIdx << (texelIdx * 3);
+    }
+
+    for (uint32_t byteIdx = 0; byteIdx < 6; ++byteIdx)
+    {
+        outBlock[2 + byteIdx] = static_cast<uint8_t>(idxBits >> (byteIdx * 8));
+    }
+}
+
+static void decodeBc4Channel(const uint8_t* block, uint32_t channel, uint8_t* outRgba)
+{
+    const uint32_t e0 = block[0];
+    const uint32_t e1 = block[1];
+
+    uint32_t palette[BC4_NUM_IDXS];
+    palette[0] = e0;
+    palette[1] = e1;
+    if (e0 > e1)
+    {
+        for (uint32_t idx = 2; idx < 8; ++idx)
+        {
+            palette[idx] = ((8 - idx) * e0 + (idx - 1) * e1 + 3) / 7;
+        }
+    }
+    else
+    {
+        for (uint32_t idx = 2; idx < 6; ++idx)
+        {
+            palette[idx] = ((6 - idx) * e0 + (idx - 1) * e1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t idxBits = 0;
+    for (uint32_t byteIdx = 0; byteIdx < 6; ++byteIdx)
+    {
+        idxBits |= static_cast<uint64_t>(block[2 + byteIdx]) << (byteIdx * 8);
+    }
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        outRgba[texelIdx * 4 + channel] = static_cast<uint8_t>(palette[(idxBits >> (texelIdx * 3)) & 7]);
+    }
+}
+
+void encodeBlock(Format format, const uint8_t* rgba, uint8_t* outBlock)
+{
+    if (format == Format::BC7)
+    {
+        encodeBc7Block(rgba, outBlock);
+        return;
+    }
+
+    encodeBc4Channel(rgba, 0, outBlock);
+    encodeBc4Channel(rgba, 1, outBlock + BC4_BLOCK_SIZE_BYTES);
+}
+
+void decodeBlock(Format format, const uint8_t* block, uint8_t* outRgba)
+{
+    if (format == Format::BC7)
+    {
+        decodeBc7Block(block, outRgba);
+        return;
+    }
+
+    decodeBc4Channel(block, 0, outRgba);
+    decodeBc4Channel(block + BC4_BLOCK_SIZE_BYTES, 1, outRgba);
+    for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+    {
+        outRgba[texelIdx * 4 + 2] = 0;
+        outRgba[texelIdx * 4 + 3] = 255;
+    }
+}
+
+uint64_t getEncodedSizeBytes(uint32_t width, uint32_t height)
+{
+    const uint64_t numBlocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint64_t numBlocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+    return numBlocksX * numBlocksY * BLOCK_SIZE_BYTES;
+}
+
+void encodeImage(
+    Format format, const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t numThreads, uint8_t* outBlocks)
+{
+    const uint32_t numBlocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint32_t numBlocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+
+    Parallel::forEach(numBlocksY, numThreads, [&](uint32_t blockY) {
+        uint8_t blockTexels[NUM_BLOCK_TEXELS * 4];
+        for (uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+        {
+            for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+            {
+                const uint32_t x = std::min(blockX * BLOCK_DIM + texelIdx % BLOCK_DIM, width - 1);
+                const uint32_t y = std::min(blockY * BLOCK_DIM + texelIdx / BLOCK_DIM, height - 1);
+                memcpy(blockTexels + texelIdx * 4, rgba + (static_cast<size_t>(y) * width + x) * 4, 4);
+            }
+
+            const size_t blockIdx = static_cast<size_t>(blockY) * numBlocksX + blockX;
+            encodeBlock(format, blockTexels, outBlocks + blockIdx * BLOCK_SIZE_BYTES);
+        }
+    });
+}
+
+void decodeImage(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* outRgba)
+{
+    const uint32_t numBlocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint32_t numBlocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+
+    uint8_t blockTexels[NUM_BLOCK_TEXELS * 4];
+    for (uint32_t blockY = 0; blockY < numBlocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+        {
+            const size_t blockIdx = static_cast<size_t>(blockY) * numBlocksX + blockX;
+            decodeBlock(format, blocks + blockIdx * BLOCK_SIZE_BYTES, blockTexels);
+
+            for (uint32_t texelIdx = 0; texelIdx < NUM_BLOCK_TEXELS; ++texelIdx)
+            {
+                const uint32_t x = blockX * BLOCK_DIM + texelIdx % BLOCK_DIM;
+                const uint32_t y = blockY * BLOCK_DIM + texelIdx / BLOCK_DIM;
+                if (x < width && y < height)
+                {
+                    memcpy(outRgba + (static_cast<size_t>(y) * width + x) * 4, blockTexels + texelIdx * 4, 4);
+                }
+            }
+        }
+    }
+}
+
+} // namespace BlockCompression
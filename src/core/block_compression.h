@@ -0,0 +1,52 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// BC7 and BC5 block compression. Both store a 4x4 block of texels in 16 bytes, read from and decoded to RGBA8 texels
+// in row-major order.
+namespace BlockCompression
+{
+
+static constexpr uint32_t BLOCK_DIM = 4;
+static constexpr uint32_t BLOCK_SIZE_BYTES = 16;
+
+enum class Format
+{
+    // RGBA, as the single-subset mode 6 with endpoints fit along each block's principal axis
+    BC7,
+    // red and green only, as two BC4 channels; meant for tangent-space normal maps
+    BC5,
+};
+
+// Encodes and decodes one block of 16 texels. The BC7 decoder only handles mode 6, which is all the encoder writes;
+// blocks in other modes decode to zero.
+void encodeBlock(Format format, const uint8_t* rgba, uint8_t* outBlock);
+void decodeBlock(Format format, const uint8_t* block, uint8_t* outRgba);
+
+uint64_t getEncodedSizeBytes(uint32_t width, uint32_t height);
+
+// Encodes an image into rows of blocks, on up to `numThreads` threads (0 for Parallel::getDefaultNumThreads()).
+// Blocks that hang over the right or bottom edge repeat the edge texels.
+void encodeImage(
+    Format format, const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t numThreads, uint8_t* outBlocks);
+void decodeImage(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* outRgba);
+
+} // namespace BlockCompression
@@ -0,0 +1,58 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "build_scheduler.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace BuildScheduler
+{
+
+std::vector<uint32_t> selectBuilds(const std::vector<Candidate>& candidates, uint64_t budget)
+{
+    std::vector<uint32_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return candidates[a].priority < candidates[b].priority;
+    });
+
+    if (budget == 0)
+    {
+        return order;
+    }
+
+    uint64_t totalCost = 0;
+    uint32_t numSelected = 0;
+    for (const uint32_t candidateIdx : order)
+    {
+        const uint64_t cost = candidates[candidateIdx].cost;
+        if (numSelected > 0 && totalCost + cost > budget)
+        {
+            break;
+        }
+
+        totalCost += cost;
+        ++numSelected;
+    }
+
+    order.resize(numSelected);
+    return order;
+}
+
+} // namespace BuildScheduler
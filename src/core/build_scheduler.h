@@ -0,0 +1,42 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Spreads queued acceleration structure builds over several frames. Nothing here knows about the GPU; the caller
+// estimates each build's cost and decides what its priority means.
+namespace BuildScheduler
+{
+
+struct Candidate
+{
+    // in whatever unit the budget is in, e.g. triangles
+    uint64_t cost;
+    // lower values are built first
+    float priority;
+};
+
+// Returns the indices of the candidates to build now, taken in priority order until the next one would exceed
+// `budget`. The first candidate is always taken so that builds larger than the budget still make progress, and the
+// cheaper candidates behind an expensive one wait for it rather than overtaking it. A budget of 0 takes everything.
+std::vector<uint32_t> selectBuilds(const std::vector<Candidate>& candidates, uint64_t budget);
+
+} // namespace BuildScheduler
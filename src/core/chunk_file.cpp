@@ -0,0 +1,307 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "chunk_file.h"
+
+#include "hash.h"
+#include "lz_codec.h"
+#include "parallel.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+static constexpr uint32_t MAGIC = 0x4B484342; // "BCHK"
+static constexpr uint32_t FORMAT_VERSION = 1;
+// chunk data starts on this boundary, so uncompressed chunks are aligned for any element type
+static constexpr uint64_t CHUNK_ALIGNMENT_BYTES = 16;
+
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint64_t key;
+    uint32_t numChunks;
+    uint32_t pad0;
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignmentBytes)
+{
+    return (value + alignmentBytes - 1) & ~(alignmentBytes - 1);
+}
+
+// Unique to this write, so that processes or threads writing the same file at once each get their own temporary file
+// and the last one to finish wins.
+static std::string makeTempFileSuffix()
+{
+    static std::atomic<uint32_t> nextWriteIdx{ 0 };
+
+#ifdef _WIN32
+    const int processId = _getpid();
+#else
+    const int processId = static_cast<int>(getpid());
+#endif
+
+    std::string suffix = ".";
+    suffix += std::to_string(processId);
+    suffix += '.';
+    suffix += std::to_string(nextWriteIdx++);
+    suffix += ".tmp";
+    return suffix;
+}
+
+uint32_t ChunkFileWriter::addChunk(uint32_t type, std::vector<uint8_t>&& data)
+{
+    PendingChunk& chunk = this->chunks.emplace_back();
+    chunk.type = type;
+    chunk.ownedData = std::move(data);
+    chunk.data = chunk.ownedData.data();
+    chunk.sizeBytes = chunk.ownedData.size();
+    return static_cast<uint32_t>(this->chunks.size() - 1);
+}
+
+uint32_t ChunkFileWriter::addChunk(uint32_t type, const void* data, uint64_t sizeBytes)
+{
+    PendingChunk& chunk = this->chunks.emplace_back();
+    chunk.type = type;
+    chunk.data = static_cast<const uint8_t*>(data);
+    chunk.sizeBytes = sizeBytes;
+    return static_cast<uint32_t>(this->chunks.size() - 1);
+}
+
+bool ChunkFileWriter::write(const std::string& filePathStr, uint64_t key, uint32_t numThreads) const
+{
+    const uint32_t numChunks = static_cast<uint32_t>(this->chunks.size());
+    std::vector<ChunkFileEntry> entries(numChunks);
+    std::vector<std::vector<uint8_t>> compressedDatas(numChunks);
+
+    Parallel::forEach(numChunks, numThreads, [&](uint32_t chunkIdx) {
+        const PendingChunk& chunk = this->chunks[chunkIdx];
+        std::vector<uint8_t> compressedData = LzCodec::compress(chunk.data, chunk.sizeBytes);
+
+        ChunkFileEntry& entry = entries[chunkIdx];
+        entry.type = chunk.type;
+        entry.sizeBytes = chunk.sizeBytes;
+        entry.hash = Hash::hashBytes(chunk.data, chunk.sizeBytes);
+
+        // chunks that don't compress are stored as is
+        entry.isCompressed = compressedData.size() < chunk.sizeBytes;
+        if (entry.isCompressed)
+        {
+            entry.storedSizeBytes = compressedData.size();
+            compressedDatas[chunkIdx] = std::move(compressedData);
+        }
+        else
+        {
+            entry.storedSizeBytes = chunk.sizeBytes;
+        }
+    });
+
+    uint64_t offsetBytes = alignUp(sizeof(FileHeader) + sizeof(ChunkFileEntry) * numChunks, CHUNK_ALIGNMENT_BYTES);
+    for (ChunkFileEntry& entry : entries)
+    {
+        entry.offsetBytes = offsetBytes;
+        offsetBytes = alignUp(offsetBytes + entry.storedSizeBytes, CHUNK_ALIGNMENT_BYTES);
+    }
+
+    const std::filesystem::path filePath(filePathStr);
+    std::error_code errorCode;
+    if (filePath.has_parent_path())
+    {
+        std::filesystem::create_directories(filePath.parent_path(), errorCode);
+    }
+
+    std::filesystem::path tempFilePath = filePath;
+    tempFilePath += makeTempFileSuffix();
+
+    {
+        std::ofstream stream(tempFilePath, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            return false;
+        }
+
+        const FileHeader header = {
+            .magic = MAGIC,
+            .formatVersion = FORMAT_VERSION,
+            .key = key,
+            .numChunks = numChunks,
+            .pad0 = 0,
+        };
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char*>(entries.data()), sizeof(ChunkFileEntry) * numChunks);
+
+        static constexpr char padding[CHUNK_ALIGNMENT_BYTES] = {};
+        for (uint32_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+        {
+            const ChunkFileEntry& entry = entries[chunkIdx];
+            stream.write(padding, entry.offsetBytes - static_cast<uint64_t>(stream.tellp()));
+
+            const uint8_t* storedData =
+                entry.isCompressed ? compressedDatas[chunkIdx].data() : this->chunks[chunkIdx].data;
+            stream.write(reinterpret_cast<const char*>(storedData), entry.storedSizeBytes);
+        }
+
+        if (!stream)
+        {
+            stream.close();
+            std::filesystem::remove(tempFilePath, errorCode);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempFilePath, filePath, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFilePath, errorCode);
+        return false;
+    }
+
+    return true;
+}
+
+bool ChunkFileReader::open(const std::string& filePathStr, uint64_t key)
+{
+    this->close();
+
+    if (!this->file.open(filePathStr) || this->file.getSizeBytes() < sizeof(FileHeader))
+    {
+        this->close();
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, this->file.getData(), sizeof(header));
+    if (header.magic != MAGIC || header.formatVersion != FORMAT_VERSION || header.key != key)
+    {
+        this->close();
+        return false;
+    }
+
+    const uint64_t fileSizeBytes = this->file.getSizeBytes();
+    if (header.numChunks > (fileSizeBytes - sizeof(FileHeader)) / sizeof(ChunkFileEntry))
+    {
+        this->close();
+        return false;
+    }
+
+    // the header's size keeps the table 8-byte aligned within the mapping
+    this->entries = reinterpret_cast<const ChunkFileEntry*>(this->file.getData() + sizeof(FileHeader));
+    this->numChunks = header.numChunks;
+
+    for (uint32_t chunkIdx = 0; chunkIdx < this->numChunks; ++chunkIdx)
+    {
+        const ChunkFileEntry& entry = this->entries[chunkIdx];
+        if (entry.offsetBytes > fileSizeBytes || entry.storedSizeBytes > fileSizeBytes - entry.offsetBytes ||
+            (!entry.isCompressed && entry.storedSizeBytes != entry.sizeBytes))
+        {
+            this->close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ChunkFileReader::close()
+{
+    this->file.close();
+    this->entries = nullptr;
+    this->numChunks = 0;
+}
+
+uint32_t ChunkFileReader::getNumChunks() const
+{
+    return this->numChunks;
+}
+
+uint32_t ChunkFileReader::getChunkType(uint32_t chunkIdx) const
+{
+    return this->entries[chunkIdx].type;
+}
+
+uint64_t ChunkFileReader::getChunkSizeBytes(uint32_t chunkIdx) const
+{
+    return this->entries[chunkIdx].sizeBytes;
+}
+
+bool ChunkFileReader::readChunk(uint32_t chunkIdx, void* dst, uint64_t dstSizeBytes) const
+{
+    const ChunkFileEntry& entry = this->entries[chunkIdx];
+    if (dstSizeBytes != entry.sizeBytes)
+    {
+        return false;
+    }
+
+    const uint8_t* storedData = this->file.getData() + entry.offsetBytes;
+    if (entry.isCompressed)
+    {
+        if (!LzCodec::decompress(storedData, entry.storedSizeBytes, static_cast<uint8_t*>(dst), dstSizeBytes))
+        {
+            return false;
+        }
+    }
+    else if (dstSizeBytes > 0)
+    {
+        memcpy(dst, storedData, dstSizeBytes);
+    }
+
+    return Hash::hashBytes(dst, dstSizeBytes) == entry.hash;
+}
+
+bool ChunkFileReader::readChunkToWriteOnly(uint32_t chunkIdx,
+                                           void* dst,
+                                           uint64_t dstSizeBytes,
+                                           std::vector<uint8_t>* scratch) const
+{
+    const ChunkFileEntry& entry = this->entries[chunkIdx];
+    if (dstSizeBytes != entry.sizeBytes)
+    {
+        return false;
+    }
+
+    const uint8_t* data = this->file.getData() + entry.offsetBytes;
+    if (entry.isCompressed)
+    {
+        scratch->resize(dstSizeBytes);
+        if (!LzCodec::decompress(data, entry.storedSizeBytes, scratch->data(), dstSizeBytes))
+        {
+            return false;
+        }
+        data = scratch->data();
+    }
+
+    if (Hash::hashBytes(data, dstSizeBytes) != entry.hash)
+    {
+        return false;
+    }
+
+    if (dstSizeBytes > 0)
+    {
+        memcpy(dst, data, dstSizeBytes);
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A versioned container of typed binary chunks, used for on-disk caches. Chunks are compressed independently with
+// LzCodec, so they can be decompressed in parallel and straight into their final destination. Each file carries a
+// caller-defined key; opening a file whose key doesn't match fails, as does reading a chunk whose contents don't hash
+// to what was written.
+// on-disk layout of a chunk table entry
+struct ChunkFileEntry
+{
+    uint32_t type;
+    uint32_t isCompressed;
+    uint64_t offsetBytes;
+    uint64_t storedSizeBytes;
+    uint64_t sizeBytes;
+    uint64_t hash;
+};
+
+class ChunkFileWriter
+{
+private:
+    struct PendingChunk
+    {
+        uint32_t type;
+        // empty for chunks whose data the caller keeps
+        std::vector<uint8_t> ownedData;
+        const uint8_t* data;
+        uint64_t sizeBytes;
+    };
+
+    std::vector<PendingChunk> chunks;
+
+public:
+    // Return the chunk's index. Data passed by pointer or const reference isn't copied, so it has to stay valid until
+    // write() returns.
+    uint32_t addChunk(uint32_t type, std::vector<uint8_t>&& data);
+    uint32_t addChunk(uint32_t type, const void* data, uint64_t sizeBytes);
+
+    template<typename T>
+    inline uint32_t addChunk(uint32_t type, const std::vector<T>& data)
+    {
+        return this->addChunk(type, data.data(), data.size() * sizeof(T));
+    }
+
+    // Compresses the chunks on up to `numThreads` threads (0 for Parallel::getDefaultNumThreads()) and writes them to
+    // a temporary file of its own that then replaces `filePathStr`, so readers never see a partially written file.
+    bool write(const std::string& filePathStr, uint64_t key, uint32_t numThreads) const;
+};
+
+class ChunkFileReader
+{
+private:
+    MappedFile file;
+    const ChunkFileEntry* entries{ nullptr };
+    uint32_t numChunks{ 0 };
+
+public:
+    // returns false if the file can't be mapped, isn't a chunk file of the current format or has a different key
+    bool open(const std::string& filePathStr, uint64_t key);
+    void close();
+
+    uint32_t getNumChunks() const;
+    uint32_t getChunkType(uint32_t chunkIdx) const;
+    // uncompressed
+    uint64_t getChunkSizeBytes(uint32_t chunkIdx) const;
+
+    // Decompresses a chunk into `dst`, which must be exactly getChunkSizeBytes() long. Safe to call for different
+    // chunks from multiple threads. Returns false if the chunk is corrupt.
+    bool readChunk(uint32_t chunkIdx, void* dst, uint64_t dstSizeBytes) const;
+    // Same as readChunk(), for destinations that are slow to read back from, like write-combined upload memory.
+    // Compressed chunks are decompressed and verified in `scratch` and then copied to `dst` in one pass.
+    bool readChunkToWriteOnly(uint32_t chunkIdx, void* dst, uint64_t dstSizeBytes, std::vector<uint8_t>* scratch) const;
+
+    template<typename T>
+    inline bool readChunk(uint32_t chunkIdx, std::vector<T>* outData) const
+    {
+        const uint64_t sizeBytes = this->getChunkSizeBytes(chunkIdx);
+        if (sizeBytes % sizeof(T) != 0)
+        {
+            return false;
+        }
+
+        outData->resize(sizeBytes / sizeof(T));
+        return this->readChunk(chunkIdx, outData->data(), sizeBytes);
+    }
+};
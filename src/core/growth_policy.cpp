@@ -0,0 +1,52 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "growth_policy.h"
+
+#include <cstdint>
+
+uint64_t GrowthPolicy::getGrownSize(uint64_t currentSizeBytes, uint64_t minSizeBytes) const
+{
+    uint64_t newSizeBytes = currentSizeBytes > 0 ? currentSizeBytes : 1;
+    while (newSizeBytes < minSizeBytes && (this->incrementBytes == 0 || newSizeBytes < this->doublingLimitBytes))
+    {
+        // doubling again would wrap around, so settle for exactly what was asked for
+        if (newSizeBytes > UINT64_MAX / 2)
+        {
+            return minSizeBytes;
+        }
+
+        newSizeBytes *= 2;
+    }
+
+    if (newSizeBytes < minSizeBytes)
+    {
+        // same for rounding up to a whole number of increments
+        const uint64_t missingBytes = minSizeBytes - newSizeBytes;
+        const uint64_t numIncrements =
+            missingBytes / this->incrementBytes + (missingBytes % this->incrementBytes != 0 ? 1 : 0);
+        if (numIncrements > (UINT64_MAX - newSizeBytes) / this->incrementBytes)
+        {
+            return minSizeBytes;
+        }
+
+        newSizeBytes += numIncrements * this->incrementBytes;
+    }
+
+    return newSizeBytes;
+}
@@ -0,0 +1,35 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Decides how far a growable buffer is resized when it runs out of space. Doubling keeps the number of resizes
+// logarithmic, but past a few hundred MB it wastes a lot of memory and makes every copy huge, so beyond
+// `doublingLimitBytes` the size grows in multiples of `incrementBytes` instead.
+struct GrowthPolicy
+{
+    uint64_t doublingLimitBytes{ 256ull * 1024 * 1024 };
+    // 0 means keep doubling forever
+    uint64_t incrementBytes{ 128ull * 1024 * 1024 };
+
+    // returns the smallest size reachable from `currentSizeBytes` by this policy that is at least `minSizeBytes`, or
+    // `minSizeBytes` itself if every reachable size that large would overflow
+    uint64_t getGrownSize(uint64_t currentSizeBytes, uint64_t minSizeBytes) const;
+};
@@ -0,0 +1,81 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "hash.h"
+
+#include <cstring>
+
+namespace Hash
+{
+
+uint64_t hashBytes(const void* data, uint64_t sizeBytes, uint64_t seed)
+{
+    constexpr uint64_t m = 0xc6a4a7935bd1e995ull;
+    constexpr int r = 47;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (sizeBytes * m);
+
+    const uint64_t numWords = sizeBytes / 8;
+    for (uint64_t wordIdx = 0; wordIdx < numWords; ++wordIdx)
+    {
+        uint64_t k;
+        memcpy(&k, bytes + wordIdx * 8, sizeof(k));
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    const uint8_t* tail = bytes + numWords * 8;
+    switch (sizeBytes & 7)
+    {
+    case 7:
+        h ^= uint64_t(tail[6]) << 48;
+        [[fallthrough]];
+    case 6:
+        h ^= uint64_t(tail[5]) << 40;
+        [[fallthrough]];
+    case 5:
+        h ^= uint64_t(tail[4]) << 32;
+        [[fallthrough]];
+    case 4:
+        h ^= uint64_t(tail[3]) << 24;
+        [[fallthrough]];
+    case 3:
+        h ^= uint64_t(tail[2]) << 16;
+        [[fallthrough]];
+    case 2:
+        h ^= uint64_t(tail[1]) << 8;
+        [[fallthrough]];
+    case 1:
+        h ^= uint64_t(tail[0]);
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+} // namespace Hash
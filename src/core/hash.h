@@ -0,0 +1,30 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Hash
+{
+
+// 64-bit MurmurHash2 (MurmurHash64A). Not cryptographic; meant for keying caches by content. Data can be hashed in
+// pieces by passing each result as the next piece's seed.
+uint64_t hashBytes(const void* data, uint64_t sizeBytes, uint64_t seed = 0);
+
+} // namespace Hash
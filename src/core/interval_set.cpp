@@ -0,0 +1,116 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "interval_set.h"
+
+#include <algorithm>
+
+void IntervalSet::setMergeGap(uint32_t mergeGap)
+{
+    this->mergeGap = mergeGap;
+}
+
+void IntervalSet::add(uint32_t idx)
+{
+    if (this->lastIntervalIdx < this->intervals.size())
+    {
+        Interval& last = this->intervals[this->lastIntervalIdx];
+        if (idx >= last.begin && idx < last.end)
+        {
+            return;
+        }
+
+        // extending the last interval is only safe if that doesn't bring it within the merge gap of the next one
+        const uint32_t nextIntervalIdx = this->lastIntervalIdx + 1;
+        const bool isNextFarEnough = (nextIntervalIdx == this->intervals.size()) ||
+                                     (uint64_t(idx) + 1 + this->mergeGap < this->intervals[nextIntervalIdx].begin);
+        if (idx == last.end && isNextFarEnough)
+        {
+            ++last.end;
+            return;
+        }
+    }
+
+    this->add(idx, idx + 1);
+}
+
+void IntervalSet::add(uint32_t begin, uint32_t end)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    // first interval that could touch [begin, end) once the merge gap is taken into account
+    auto firstIt = std::lower_bound(this->intervals.begin(),
+                                    this->intervals.end(),
+                                    begin,
+                                    [this](const Interval& interval, uint32_t value)
+                                    { return uint64_t(interval.end) + this->mergeGap < value; });
+
+    // one past the last interval that could touch it
+    auto lastIt = std::upper_bound(firstIt,
+                                   this->intervals.end(),
+                                   end,
+                                   [this](uint32_t value, const Interval& interval)
+                                   { return uint64_t(value) + this->mergeGap < interval.begin; });
+
+    if (firstIt == lastIt)
+    {
+        this->lastIntervalIdx = static_cast<uint32_t>(firstIt - this->intervals.begin());
+        this->intervals.insert(firstIt, { begin, end });
+        return;
+    }
+
+    firstIt->begin = std::min(firstIt->begin, begin);
+    firstIt->end = std::max((lastIt - 1)->end, end);
+
+    this->lastIntervalIdx = static_cast<uint32_t>(firstIt - this->intervals.begin());
+    this->intervals.erase(firstIt + 1, lastIt);
+}
+
+void IntervalSet::clip(uint32_t end)
+{
+    while (!this->intervals.empty() && this->intervals.back().begin >= end)
+    {
+        this->intervals.pop_back();
+    }
+
+    if (!this->intervals.empty())
+    {
+        this->intervals.back().end = std::min(this->intervals.back().end, end);
+    }
+
+    this->lastIntervalIdx = 0;
+}
+
+void IntervalSet::clear()
+{
+    this->intervals.clear();
+    this->lastIntervalIdx = 0;
+}
+
+bool IntervalSet::isEmpty() const
+{
+    return this->intervals.empty();
+}
+
+const std::vector<IntervalSet::Interval>& IntervalSet::getIntervals() const
+{
+    return this->intervals;
+}
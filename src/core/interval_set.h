@@ -0,0 +1,54 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Sorted set of disjoint [begin, end) index ranges. Ranges closer together than the merge gap are joined into one,
+// trading a few redundant elements for fewer ranges.
+class IntervalSet
+{
+public:
+    struct Interval
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+private:
+    std::vector<Interval> intervals;
+    uint32_t mergeGap{ 0 };
+
+    // index of the interval that was last added to, since writes tend to be sequential
+    uint32_t lastIntervalIdx{ 0 };
+
+public:
+    void setMergeGap(uint32_t mergeGap);
+
+    void add(uint32_t idx);
+    void add(uint32_t begin, uint32_t end);
+
+    // drops everything at or past `end`
+    void clip(uint32_t end);
+    void clear();
+
+    bool isEmpty() const;
+    const std::vector<Interval>& getIntervals() const;
+};
@@ -0,0 +1,205 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lz_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace LzCodec
+{
+
+static constexpr size_t MIN_MATCH_BYTES = 4;
+static constexpr size_t MAX_OFFSET_BYTES = 65535;
+static constexpr uint32_t HASH_BITS = 16;
+static constexpr size_t NO_POSITION = ~size_t(0);
+
+static uint32_t read32(const uint8_t* src)
+{
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+static uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeExtraLength(std::vector<uint8_t>& out, size_t length)
+{
+    while (length >= 255)
+    {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static void writeSequence(std::vector<uint8_t>& out,
+                          const uint8_t* literals,
+                          size_t numLiterals,
+                          size_t offset,
+                          size_t matchLength)
+{
+    const bool hasMatch = matchLength > 0;
+    const size_t matchNibble = hasMatch ? std::min<size_t>(matchLength - MIN_MATCH_BYTES, 15) : 0;
+    out.push_back(static_cast<uint8_t>((std::min<size_t>(numLiterals, 15) << 4) | matchNibble));
+
+    if (numLiterals >= 15)
+    {
+        writeExtraLength(out, numLiterals - 15);
+    }
+    out.insert(out.end(), literals, literals + numLiterals);
+
+    if (!hasMatch)
+    {
+        return;
+    }
+
+    out.push_back(static_cast<uint8_t>(offset & 0xFF));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchNibble == 15)
+    {
+        writeExtraLength(out, matchLength - MIN_MATCH_BYTES - 15);
+    }
+}
+
+std::vector<uint8_t> compress(const uint8_t* src, size_t srcSizeBytes)
+{
+    std::vector<uint8_t> out;
+    out.reserve(srcSizeBytes + srcSizeBytes / 255 + 16);
+
+    std::vector<size_t> lastPositions(size_t(1) << HASH_BITS, NO_POSITION);
+
+    size_t literalsStart = 0;
+    size_t pos = 0;
+    while (pos + MIN_MATCH_BYTES <= srcSizeBytes)
+    {
+        const uint32_t sequence = read32(src + pos);
+        size_t& lastPos = lastPositions[hashSequence(sequence)];
+        const size_t candidate = lastPos;
+        lastPos = pos;
+
+        if (candidate == NO_POSITION || pos - candidate > MAX_OFFSET_BYTES || read32(src + candidate) != sequence)
+        {
+            // skip ahead faster the longer nothing has matched, so incompressible data stays cheap
+            pos += 1 + ((pos - literalsStart) >> 6);
+            continue;
+        }
+
+        size_t matchLength = MIN_MATCH_BYTES;
+        while (pos + matchLength < srcSizeBytes && src[candidate + matchLength] == src[pos + matchLength])
+        {
+            ++matchLength;
+        }
+
+        writeSequence(out, src + literalsStart, pos - literalsStart, pos - candidate, matchLength);
+        pos += matchLength;
+        literalsStart = pos;
+    }
+
+    writeSequence(out, src + literalsStart, srcSizeBytes - literalsStart, 0, 0);
+    return out;
+}
+
+static bool readExtraLength(const uint8_t*& ip, const uint8_t* ipEnd, size_t& length)
+{
+    uint8_t byte;
+    do
+    {
+        if (ip >= ipEnd)
+        {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompress(const uint8_t* src, size_t srcSizeBytes, uint8_t* dst, size_t dstSizeBytes)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const ipEnd = src + srcSizeBytes;
+    uint8_t* op = dst;
+    uint8_t* const opEnd = dst + dstSizeBytes;
+
+    while (ip < ipEnd)
+    {
+        const uint8_t token = *ip++;
+
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readExtraLength(ip, ipEnd, numLiterals))
+        {
+            return false;
+        }
+        if (numLiterals > static_cast<size_t>(ipEnd - ip) || numLiterals > static_cast<size_t>(opEnd - op))
+        {
+            return false;
+        }
+        memcpy(op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        if (ip == ipEnd)
+        {
+            break;
+        }
+
+        if (ipEnd - ip < 2)
+        {
+            return false;
+        }
+        const size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst))
+        {
+            return false;
+        }
+
+        size_t matchLength = (token & 15) + MIN_MATCH_BYTES;
+        if ((token & 15) == 15 && !readExtraLength(ip, ipEnd, matchLength))
+        {
+            return false;
+        }
+        if (matchLength > static_cast<size_t>(opEnd - op))
+        {
+            return false;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(op, match, matchLength);
+        }
+        else
+        {
+            // byte by byte, since the match overlaps the bytes it produces
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                op[i] = match[i];
+            }
+        }
+        op += matchLength;
+    }
+
+    return op == opEnd;
+}
+
+} // namespace LzCodec
@@ -0,0 +1,37 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte-oriented LZ77 in the style of LZ4: fast to decode, with a modest ratio. A block is a series of sequences, each
+// a token byte (literal length in the high nibble, match length - 4 in the low one, 15 meaning that more length bytes
+// follow), the literals, a 2-byte little-endian match offset and any extra match length bytes. The last sequence has
+// literals only.
+namespace LzCodec
+{
+
+std::vector<uint8_t> compress(const uint8_t* src, size_t srcSizeBytes);
+
+// Safe on untrusted input. Returns false unless `src` is a well-formed block that decodes to exactly `dstSizeBytes`.
+bool decompress(const uint8_t* src, size_t srcSizeBytes, uint8_t* dst, size_t dstSizeBytes);
+
+} // namespace LzCodec
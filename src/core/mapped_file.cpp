@@ -0,0 +1,158 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filePathStr)
+{
+    this->close();
+
+    this->fileHandle = CreateFileA(filePathStr.c_str(),
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ,
+                                   nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                   nullptr);
+    if (this->fileHandle == INVALID_HANDLE_VALUE)
+    {
+        this->fileHandle = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        this->close();
+        return false;
+    }
+
+    this->mappingHandle = CreateFileMappingA(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->mappingHandle == nullptr)
+    {
+        this->close();
+        return false;
+    }
+
+    this->data = static_cast<const uint8_t*>(MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (this->data == nullptr)
+    {
+        this->close();
+        return false;
+    }
+
+    this->sizeBytes = static_cast<uint64_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (this->data)
+    {
+        UnmapViewOfFile(this->data);
+    }
+    if (this->mappingHandle)
+    {
+        CloseHandle(this->mappingHandle);
+    }
+    if (this->fileHandle)
+    {
+        CloseHandle(this->fileHandle);
+    }
+
+    this->data = nullptr;
+    this->sizeBytes = 0;
+    this->mappingHandle = nullptr;
+    this->fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filePathStr)
+{
+    this->close();
+
+    this->fd = ::open(filePathStr.c_str(), O_RDONLY);
+    if (this->fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(this->fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        this->close();
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        this->close();
+        return false;
+    }
+
+    this->data = static_cast<const uint8_t*>(mapping);
+    this->sizeBytes = static_cast<uint64_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (this->data)
+    {
+        munmap(const_cast<uint8_t*>(this->data), static_cast<size_t>(this->sizeBytes));
+    }
+    if (this->fd >= 0)
+    {
+        ::close(this->fd);
+    }
+
+    this->data = nullptr;
+    this->sizeBytes = 0;
+    this->fd = -1;
+}
+
+#endif
+
+const uint8_t* MappedFile::getData() const
+{
+    return this->data;
+}
+
+uint64_t MappedFile::getSizeBytes() const
+{
+    return this->sizeBytes;
+}
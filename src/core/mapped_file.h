@@ -0,0 +1,51 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// A read-only memory mapping of a whole file, so that large files can be read without first copying them into memory.
+class MappedFile
+{
+private:
+    const uint8_t* data{ nullptr };
+    uint64_t sizeBytes{ 0 };
+
+#ifdef _WIN32
+    void* fileHandle{ nullptr };
+    void* mappingHandle{ nullptr };
+#else
+    int fd{ -1 };
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // returns false if the file doesn't exist, is empty or can't be mapped
+    bool open(const std::string& filePathStr);
+    void close();
+
+    const uint8_t* getData() const;
+    uint64_t getSizeBytes() const;
+};
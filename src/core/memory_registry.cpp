@@ -0,0 +1,263 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "memory_registry.h"
+
+#include "tinygltf/json.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+const char* getMemoryTagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+    case MemoryTag::VERTEX_POOL:
+        return "vertexPool";
+    case MemoryTag::INDEX_POOL:
+        return "indexPool";
+    case MemoryTag::LIGHTS:
+        return "lights";
+    case MemoryTag::ACCELERATION_STRUCTURES:
+        return "accelerationStructures";
+    case MemoryTag::SCRATCH:
+        return "scratch";
+    case MemoryTag::UPLOAD:
+        return "upload";
+    case MemoryTag::READBACK:
+        return "readback";
+    case MemoryTag::INSTANCES:
+        return "instances";
+    case MemoryTag::MATERIALS:
+        return "materials";
+    case MemoryTag::TEXTURES:
+        return "textures";
+    case MemoryTag::RENDER_TARGETS:
+        return "renderTargets";
+    case MemoryTag::SHADER_TABLE:
+        return "shaderTable";
+    case MemoryTag::CONSTANTS:
+        return "constants";
+    default:
+        return "other";
+    }
+}
+
+const char* getMemoryHeapName(MemoryHeap heap)
+{
+    switch (heap)
+    {
+    case MemoryHeap::DEVICE:
+        return "device";
+    case MemoryHeap::UPLOAD:
+        return "upload";
+    case MemoryHeap::READBACK:
+        return "readback";
+    default:
+        return "unknown";
+    }
+}
+
+void MemoryRegistry::addUsage(UsageStats* stats, uint64_t sizeBytes)
+{
+    stats->currentBytes += sizeBytes;
+    stats->peakBytes = std::max(stats->peakBytes, stats->currentBytes);
+    stats->totalAllocatedBytes += sizeBytes;
+    ++stats->numLive;
+    ++stats->numAllocations;
+}
+
+void MemoryRegistry::removeUsage(UsageStats* stats, uint64_t sizeBytes)
+{
+    stats->currentBytes -= sizeBytes;
+    --stats->numLive;
+    ++stats->numFrees;
+}
+
+uint32_t MemoryRegistry::registerAllocation(MemoryTag tag, MemoryHeap heap, uint64_t sizeBytes)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    uint32_t allocationId;
+    if (!this->unusedAllocationIds.empty())
+    {
+        allocationId = this->unusedAllocationIds.back();
+        this->unusedAllocationIds.pop_back();
+    }
+    else
+    {
+        allocationId = static_cast<uint32_t>(this->allocations.size());
+        this->allocations.emplace_back();
+    }
+
+    this->allocations[allocationId] = { sizeBytes, this->frameIdx, tag, heap, true };
+
+    addUsage(&this->tagStats[static_cast<size_t>(tag)], sizeBytes);
+    addUsage(&this->heapStats[static_cast<size_t>(heap)], sizeBytes);
+    addUsage(&this->totalStats, sizeBytes);
+
+    return allocationId;
+}
+
+void MemoryRegistry::unregisterAllocation(uint32_t allocationId)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+#ifdef _DEBUG
+    if (allocationId >= this->allocations.size() || !this->allocations[allocationId].isLive)
+    {
+        throw std::runtime_error("Attempting to unregister invalid MemoryRegistry allocation");
+    }
+#endif
+
+    Allocation& allocation = this->allocations[allocationId];
+    allocation.isLive = false;
+
+    removeUsage(&this->tagStats[static_cast<size_t>(allocation.tag)], allocation.sizeBytes);
+    removeUsage(&this->heapStats[static_cast<size_t>(allocation.heap)], allocation.sizeBytes);
+    removeUsage(&this->totalStats, allocation.sizeBytes);
+
+    this->unusedAllocationIds.push_back(allocationId);
+}
+
+void MemoryRegistry::setPoolStats(const std::string& name, const MemoryPoolStats& stats)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->poolStats[name] = stats;
+}
+
+void MemoryRegistry::setFrameIdx(uint64_t frameIdx)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->frameIdx = frameIdx;
+}
+
+MemoryRegistry::UsageStats MemoryRegistry::getTagStats(MemoryTag tag) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->tagStats[static_cast<size_t>(tag)];
+}
+
+MemoryRegistry::UsageStats MemoryRegistry::getHeapStats(MemoryHeap heap) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->heapStats[static_cast<size_t>(heap)];
+}
+
+MemoryRegistry::UsageStats MemoryRegistry::getTotalStats() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->totalStats;
+}
+
+static nlohmann::json makeUsageJson(const MemoryRegistry::UsageStats& stats)
+{
+    return {
+        { "currentBytes", stats.currentBytes },
+        { "peakBytes", stats.peakBytes },
+        { "totalAllocatedBytes", stats.totalAllocatedBytes },
+        { "numLive", stats.numLive },
+        { "numAllocations", stats.numAllocations },
+        { "numFrees", stats.numFrees },
+    };
+}
+
+std::string MemoryRegistry::makeJsonReport() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    nlohmann::json report;
+    report["frameIdx"] = this->frameIdx;
+    report["total"] = makeUsageJson(this->totalStats);
+
+    nlohmann::json& heapsJson = report["heaps"];
+    for (size_t heapIdx = 0; heapIdx < this->heapStats.size(); ++heapIdx)
+    {
+        heapsJson[getMemoryHeapName(static_cast<MemoryHeap>(heapIdx))] = makeUsageJson(this->heapStats[heapIdx]);
+    }
+
+    nlohmann::json& tagsJson = report["tags"];
+    for (size_t tagIdx = 0; tagIdx < this->tagStats.size(); ++tagIdx)
+    {
+        tagsJson[getMemoryTagName(static_cast<MemoryTag>(tagIdx))] = makeUsageJson(this->tagStats[tagIdx]);
+    }
+
+    nlohmann::json& poolsJson = report["pools"];
+    poolsJson = nlohmann::json::object();
+    for (const auto& [name, stats] : this->poolStats)
+    {
+        // 0 when all free space is in one piece, approaching 1 as it gets split into many small ranges
+        const uint64_t freeBytes = stats.capacityBytes - stats.usedBytes;
+        const double fragmentation = freeBytes > 0 ? 1.0 - double(stats.largestFreeRangeBytes) / freeBytes : 0.0;
+
+        poolsJson[name] = {
+            { "capacityBytes", stats.capacityBytes },
+            { "usedBytes", stats.usedBytes },
+            { "peakUsedBytes", stats.peakUsedBytes },
+            { "freeBytes", freeBytes },
+            { "largestFreeRangeBytes", stats.largestFreeRangeBytes },
+            { "numAllocations", stats.numAllocations },
+            { "numFreeRanges", stats.numFreeRanges },
+            { "numResizes", stats.numResizes },
+            { "fragmentation", fragmentation },
+        };
+    }
+
+    std::vector<const Allocation*> liveAllocations;
+    for (const auto& allocation : this->allocations)
+    {
+        if (allocation.isLive)
+        {
+            liveAllocations.push_back(&allocation);
+        }
+    }
+
+    const size_t numReported = std::min<size_t>(liveAllocations.size(), NUM_LARGEST_REPORTED);
+    std::partial_sort(liveAllocations.begin(),
+                      liveAllocations.begin() + numReported,
+                      liveAllocations.end(),
+                      [](const Allocation* a, const Allocation* b) { return a->sizeBytes > b->sizeBytes; });
+
+    nlohmann::json& largestJson = report["largestAllocations"];
+    largestJson = nlohmann::json::array();
+    for (size_t idx = 0; idx < numReported; ++idx)
+    {
+        const Allocation& allocation = *liveAllocations[idx];
+        largestJson.push_back({
+            { "tag", getMemoryTagName(allocation.tag) },
+            { "heap", getMemoryHeapName(allocation.heap) },
+            { "sizeBytes", allocation.sizeBytes },
+            { "createdFrameIdx", allocation.createdFrameIdx },
+        });
+    }
+
+    return report.dump(4);
+}
+
+bool MemoryRegistry::writeJsonReport(const std::string& filePath) const
+{
+    std::ofstream file(filePath);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << this->makeJsonReport() << "\n";
+    return file.good();
+}
@@ -0,0 +1,134 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class MemoryTag : uint8_t
+{
+    VERTEX_POOL,
+    INDEX_POOL,
+    LIGHTS,
+    ACCELERATION_STRUCTURES,
+    SCRATCH,
+    UPLOAD,
+    READBACK,
+    INSTANCES,
+    MATERIALS,
+    TEXTURES,
+    RENDER_TARGETS,
+    SHADER_TABLE,
+    CONSTANTS,
+    OTHER,
+    COUNT
+};
+
+enum class MemoryHeap : uint8_t
+{
+    DEVICE,
+    UPLOAD,
+    READBACK,
+    COUNT
+};
+
+const char* getMemoryTagName(MemoryTag tag);
+const char* getMemoryHeapName(MemoryHeap heap);
+
+// Snapshot of a sub-allocating container (e.g. a ManagedBuffer), which the registry can't see into by itself.
+struct MemoryPoolStats
+{
+    uint64_t capacityBytes{ 0 };
+    uint64_t usedBytes{ 0 };
+    uint64_t peakUsedBytes{ 0 };
+    uint64_t largestFreeRangeBytes{ 0 };
+    uint32_t numAllocations{ 0 };
+    uint32_t numFreeRanges{ 0 };
+    // times the container replaced its backing resource to grow or shrink
+    uint32_t numResizes{ 0 };
+};
+
+// Keeps track of every GPU resource by tag and heap so that memory budgets for large scenes can be sized from real
+// numbers. Only bookkeeping happens here; the renderer registers resources as they're created and unregisters them
+// when they're destroyed. Thread safe, since resources can be released from wherever their last reference goes away.
+class MemoryRegistry
+{
+public:
+    static constexpr uint32_t INVALID_ALLOCATION_ID = ~0u;
+
+    struct UsageStats
+    {
+        uint64_t currentBytes{ 0 };
+        uint64_t peakBytes{ 0 };
+        uint64_t totalAllocatedBytes{ 0 };
+        uint32_t numLive{ 0 };
+        uint32_t numAllocations{ 0 };
+        uint32_t numFrees{ 0 };
+    };
+
+private:
+    // number of live allocations listed individually in the report
+    static constexpr uint32_t NUM_LARGEST_REPORTED = 16;
+
+    struct Allocation
+    {
+        uint64_t sizeBytes{ 0 };
+        uint64_t createdFrameIdx{ 0 };
+        MemoryTag tag{ MemoryTag::OTHER };
+        MemoryHeap heap{ MemoryHeap::DEVICE };
+        bool isLive{ false };
+    };
+
+    mutable std::mutex mutex;
+
+    std::vector<Allocation> allocations;
+    std::vector<uint32_t> unusedAllocationIds;
+
+    std::array<UsageStats, static_cast<size_t>(MemoryTag::COUNT)> tagStats{};
+    std::array<UsageStats, static_cast<size_t>(MemoryHeap::COUNT)> heapStats{};
+    UsageStats totalStats{};
+
+    std::map<std::string, MemoryPoolStats> poolStats;
+
+    uint64_t frameIdx{ 0 };
+
+    static void addUsage(UsageStats* stats, uint64_t sizeBytes);
+    static void removeUsage(UsageStats* stats, uint64_t sizeBytes);
+
+public:
+    uint32_t registerAllocation(MemoryTag tag, MemoryHeap heap, uint64_t sizeBytes);
+    void unregisterAllocation(uint32_t allocationId);
+
+    // replaces the previous snapshot for `name`
+    void setPoolStats(const std::string& name, const MemoryPoolStats& stats);
+
+    // allocations are stamped with the current frame so that the report shows how long they've been alive
+    void setFrameIdx(uint64_t frameIdx);
+
+    UsageStats getTagStats(MemoryTag tag) const;
+    UsageStats getHeapStats(MemoryHeap heap) const;
+    UsageStats getTotalStats() const;
+
+    std::string makeJsonReport() const;
+    bool writeJsonReport(const std::string& filePath) const;
+};
@@ -0,0 +1,256 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_optimizer.h"
+
+#include "hash.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace MeshOptimizer
+{
+
+static uint64_t hashVertex(const VertexStream* streams, uint32_t numStreams, uint32_t vertIdx)
+{
+    uint64_t hash = 0;
+    for (uint32_t streamIdx = 0; streamIdx < numStreams; ++streamIdx)
+    {
+        const VertexStream& stream = streams[streamIdx];
+        const uint8_t* data = static_cast<const uint8_t*>(stream.data);
+        hash = Hash::hashBytes(data + static_cast<uint64_t>(vertIdx) * stream.strideBytes, stream.strideBytes, hash);
+    }
+    return hash;
+}
+
+static bool areVertsEqual(const VertexStream* streams, uint32_t numStreams, uint32_t vertIdxA, uint32_t vertIdxB)
+{
+    for (uint32_t streamIdx = 0; streamIdx < numStreams; ++streamIdx)
+    {
+        const VertexStream& stream = streams[streamIdx];
+        const uint8_t* data = static_cast<const uint8_t*>(stream.data);
+        if (memcmp(data + static_cast<uint64_t>(vertIdxA) * stream.strideBytes,
+                   data + static_cast<uint64_t>(vertIdxB) * stream.strideBytes,
+                   stream.strideBytes) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t generateWeldRemap(const VertexStream* streams, uint32_t numStreams, uint32_t numVerts, uint32_t* outRemap)
+{
+    // open addressing at a load factor of at most 1/2, holding the first vertex of each group of identical ones
+    static constexpr uint32_t EMPTY = ~0u;
+    uint64_t tableSize = 1;
+    while (tableSize < static_cast<uint64_t>(numVerts) * 2)
+    {
+        tableSize *= 2;
+    }
+    const uint64_t mask = tableSize - 1;
+    std::vector<uint32_t> table(tableSize, EMPTY);
+
+    uint32_t numUniqueVerts = 0;
+    for (uint32_t vertIdx = 0; vertIdx < numVerts; ++vertIdx)
+    {
+        uint64_t slot = hashVertex(streams, numStreams, vertIdx) & mask;
+        while (true)
+        {
+            const uint32_t firstVertIdx = table[slot];
+            if (firstVertIdx == EMPTY)
+            {
+                table[slot] = vertIdx;
+                outRemap[vertIdx] = numUniqueVerts++;
+                break;
+            }
+            if (areVertsEqual(streams, numStreams, firstVertIdx, vertIdx))
+            {
+                outRemap[vertIdx] = outRemap[firstVertIdx];
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    return numUniqueVerts;
+}
+
+uint32_t generateFetchRemap(const uint32_t* idxs, uint32_t numIdxs, uint32_t numVerts, uint32_t* outRemap)
+{
+    std::fill(outRemap, outRemap + numVerts, REMAP_UNUSED);
+
+    uint32_t numUsedVerts = 0;
+    for (uint32_t i = 0; i < numIdxs; ++i)
+    {
+        if (outRemap[idxs[i]] == REMAP_UNUSED)
+        {
+            outRemap[idxs[i]] = numUsedVerts++;
+        }
+    }
+
+    return numUsedVerts;
+}
+
+void remapVertexStream(const VertexStream& stream, uint32_t numVerts, const uint32_t* remap, void* dst)
+{
+    const uint8_t* src = static_cast<const uint8_t*>(stream.data);
+    uint8_t* dstBytes = static_cast<uint8_t*>(dst);
+    for (uint32_t vertIdx = 0; vertIdx < numVerts; ++vertIdx)
+    {
+        if (remap[vertIdx] != REMAP_UNUSED)
+        {
+            memcpy(dstBytes + static_cast<uint64_t>(remap[vertIdx]) * stream.strideBytes,
+                   src + static_cast<uint64_t>(vertIdx) * stream.strideBytes,
+                   stream.strideBytes);
+        }
+    }
+}
+
+void remapIdxs(uint32_t* idxs, uint32_t numIdxs, const uint32_t* remap)
+{
+    for (uint32_t i = 0; i < numIdxs; ++i)
+    {
+        idxs[i] = remap[idxs[i]];
+    }
+}
+
+// spreads the low 10 bits of `x` out to every third bit
+static uint32_t spreadBits(uint32_t x)
+{
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+// triangle indices sorted along a Morton curve through their centroids, ties kept in storage order
+static std::vector<uint32_t> getMortonOrder(const uint32_t* idxs,
+                                            uint32_t numIdxs,
+                                            const float* positions,
+                                            uint32_t positionStrideBytes)
+{
+    const uint32_t numTris = numIdxs / 3;
+    const auto getPosition = [&](uint32_t vertIdx) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) +
+                                              static_cast<uint64_t>(vertIdx) * positionStrideBytes);
+    };
+
+    // centroids are kept as sums of three positions, since only their relative placement matters
+    std::vector<std::array<float, 3>> centroids(numTris);
+    std::array<float, 3> minCentroid;
+    std::array<float, 3> maxCentroid;
+    minCentroid.fill(std::numeric_limits<float>::max());
+    maxCentroid.fill(std::numeric_limits<float>::lowest());
+    for (uint32_t triIdx = 0; triIdx < numTris; ++triIdx)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float centroid = getPosition(idxs[triIdx * 3])[axis] + getPosition(idxs[triIdx * 3 + 1])[axis] +
+                                   getPosition(idxs[triIdx * 3 + 2])[axis];
+            centroids[triIdx][axis] = centroid;
+            minCentroid[axis] = std::min(minCentroid[axis], centroid);
+            maxCentroid[axis] = std::max(maxCentroid[axis], centroid);
+        }
+    }
+
+    std::vector<uint32_t> codes(numTris);
+    for (uint32_t triIdx = 0; triIdx < numTris; ++triIdx)
+    {
+        uint32_t code = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float extent = maxCentroid[axis] - minCentroid[axis];
+            const float normalized = extent > 0.f ? (centroids[triIdx][axis] - minCentroid[axis]) / extent : 0.f;
+            code |= spreadBits(static_cast<uint32_t>(normalized * 1023.f)) << axis;
+        }
+        codes[triIdx] = code;
+    }
+
+    std::vector<uint32_t> order(numTris);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return codes[a] < codes[b]; });
+    return order;
+}
+
+void reorderTrianglesSpatially(uint32_t* idxs, uint32_t numIdxs, const float* positions, uint32_t positionStrideBytes)
+{
+    const std::vector<uint32_t> order = getMortonOrder(idxs, numIdxs, positions, positionStrideBytes);
+
+    const std::vector<uint32_t> oldIdxs(idxs, idxs + order.size() * 3);
+    for (uint32_t triIdx = 0; triIdx < order.size(); ++triIdx)
+    {
+        memcpy(&idxs[triIdx * 3], &oldIdxs[order[triIdx] * 3], 3 * sizeof(uint32_t));
+    }
+}
+
+float computeFetchCost(const uint32_t* idxs,
+                       uint32_t numIdxs,
+                       const float* positions,
+                       uint32_t positionStrideBytes,
+                       uint32_t vertexSizeBytes)
+{
+    static constexpr uint32_t CACHE_LINE_BYTES = 64;
+    static constexpr uint32_t NUM_CACHE_LINES = 32;
+    // keeps index and vertex lines apart in the cache
+    static constexpr uint64_t VERTEX_LINE_TAG = 1ull << 63;
+
+    const std::vector<uint32_t> order = getMortonOrder(idxs, numIdxs, positions, positionStrideBytes);
+    if (order.empty())
+    {
+        return 0.f;
+    }
+
+    // most recently used line first
+    std::array<uint64_t, NUM_CACHE_LINES> cache;
+    cache.fill(~0ull);
+    uint64_t numMisses = 0;
+    const auto touchLine = [&](uint64_t line) {
+        const auto it = std::find(cache.begin(), cache.end(), line);
+        if (it == cache.end())
+        {
+            ++numMisses;
+            std::move_backward(cache.begin(), cache.end() - 1, cache.end());
+        }
+        else
+        {
+            std::move_backward(cache.begin(), it, it + 1);
+        }
+        cache[0] = line;
+    };
+
+    for (const uint32_t triIdx : order)
+    {
+        touchLine(static_cast<uint64_t>(triIdx) * 3 * sizeof(uint32_t) / CACHE_LINE_BYTES);
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const uint64_t vertOffsetBytes = static_cast<uint64_t>(idxs[triIdx * 3 + corner]) * vertexSizeBytes;
+            touchLine(VERTEX_LINE_TAG | (vertOffsetBytes / CACHE_LINE_BYTES));
+        }
+    }
+
+    return static_cast<float>(numMisses) / order.size();
+}
+
+} // namespace MeshOptimizer
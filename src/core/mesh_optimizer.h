@@ -0,0 +1,64 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Index and vertex stream optimizations for triangle meshes, independent of any vertex format. Vertices are described
+// by one or more tightly packed streams, and meshes are always indexed triangle lists with 32-bit indices.
+namespace MeshOptimizer
+{
+
+static constexpr uint32_t REMAP_UNUSED = ~0u;
+
+struct VertexStream
+{
+    const void* data;
+    uint32_t strideBytes;
+};
+
+// Gives every vertex the index of the first vertex whose bytes are identical in every stream, renumbered so that unique
+// vertices keep their original order. Returns the number of unique vertices.
+uint32_t generateWeldRemap(const VertexStream* streams, uint32_t numStreams, uint32_t numVerts, uint32_t* outRemap);
+
+// Renumbers vertices in the order in which the triangles first use them, so that nearby triangles fetch nearby
+// vertices. Vertices that aren't used by any triangle are mapped to REMAP_UNUSED. Returns the number of used vertices.
+uint32_t generateFetchRemap(const uint32_t* idxs, uint32_t numIdxs, uint32_t numVerts, uint32_t* outRemap);
+
+// Moves every vertex of `stream` to its remapped position in `dst`, which must not overlap the stream. Vertices mapped
+// to REMAP_UNUSED are dropped.
+void remapVertexStream(const VertexStream& stream, uint32_t numVerts, const uint32_t* remap, void* dst);
+void remapIdxs(uint32_t* idxs, uint32_t numIdxs, const uint32_t* remap);
+
+// Sorts triangles along a Morton curve through their centroids, so that triangles which are close in space, and are
+// therefore often hit by neighboring rays, are also close in the index buffer. `positions` are three floats per
+// vertex.
+void reorderTrianglesSpatially(uint32_t* idxs, uint32_t numIdxs, const float* positions, uint32_t positionStrideBytes);
+
+// A proxy for how well hit shaders' vertex and index fetches hit in cache: triangles are visited in Morton order of
+// their centroids, independently of the order they're stored in, and each visit touches the cache lines of its three
+// indices and vertices. Returns the average number of lines per triangle that miss a small LRU cache. A vertex is
+// `vertexSizeBytes` long in the attribute buffer that is being fetched from.
+float computeFetchCost(const uint32_t* idxs,
+                       uint32_t numIdxs,
+                       const float* positions,
+                       uint32_t positionStrideBytes,
+                       uint32_t vertexSizeBytes);
+
+} // namespace MeshOptimizer
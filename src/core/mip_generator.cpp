@@ -0,0 +1,321 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mip_generator.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define MIP_GENERATOR_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define MIP_GENERATOR_USE_SSE 0
+#endif
+
+namespace MipGenerator
+{
+
+// half width of the Kaiser filter and the window's shape parameter; the radius is in destination texels
+static constexpr float KAISER_RADIUS = 2.f;
+static constexpr float KAISER_ALPHA = 4.f;
+
+// rows per Parallel::forEach item, so that small levels don't pay for threads they can't use
+static constexpr uint32_t ROWS_PER_JOB = 16;
+
+static constexpr float PI = 3.14159265358979f;
+
+struct alignas(16) Texel
+{
+    float c[4];
+};
+
+// the source texels that make up each destination texel of one dimension
+struct Taps
+{
+    // taps of destination texel i are [firstTapIdxs[i], firstTapIdxs[i + 1])
+    std::vector<uint32_t> firstTapIdxs;
+    std::vector<uint32_t> srcIdxs;
+    std::vector<float> weights;
+};
+
+struct SrgbTables
+{
+    std::array<float, 256> toLinear;
+    // toLinear of the midpoints between consecutive bytes, so that linear values round to the nearest sRGB byte
+    std::array<float, 255> thresholds;
+};
+
+static float srgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static const SrgbTables& getSrgbTables()
+{
+    static const SrgbTables tables = []() {
+        SrgbTables newTables;
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            newTables.toLinear[i] = srgbToLinear(i / 255.f);
+        }
+        for (uint32_t i = 0; i < 255; ++i)
+        {
+            newTables.thresholds[i] = srgbToLinear((i + 0.5f) / 255.f);
+        }
+        return newTables;
+    }();
+    return tables;
+}
+
+// zeroth order modified Bessel function of the first kind
+static float besselI0(float x)
+{
+    float sum = 1.f;
+    float term = 1.f;
+    const float halfXSquared = 0.25f * x * x;
+    for (uint32_t k = 1; k < 32 && term > sum * 1e-7f; ++k)
+    {
+        term *= halfXSquared / static_cast<float>(k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static float sinc(float x)
+{
+    if (std::abs(x) < 1e-5f)
+    {
+        return 1.f;
+    }
+    return std::sin(PI * x) / (PI * x);
+}
+
+static Taps makeTaps(uint32_t srcSize, uint32_t dstSize, Filter filter)
+{
+    Taps taps;
+    taps.firstTapIdxs.reserve(dstSize + 1);
+
+    const float scale = static_cast<float>(srcSize) / dstSize;
+    const float kaiserNorm = 1.f / besselI0(KAISER_ALPHA);
+    for (uint32_t dstIdx = 0; dstIdx < dstSize; ++dstIdx)
+    {
+        const uint32_t firstTapIdx = static_cast<uint32_t>(taps.srcIdxs.size());
+        taps.firstTapIdxs.push_back(firstTapIdx);
+
+        if (filter == Filter::BOX)
+        {
+            const uint32_t srcIdx = std::min(dstIdx * 2, srcSize - 1);
+            const uint32_t srcIdx1 = std::min(dstIdx * 2 + 1, srcSize - 1);
+            taps.srcIdxs.push_back(srcIdx);
+            taps.weights.push_back(srcIdx1 == srcIdx ? 1.f : 0.5f);
+            if (srcIdx1 != srcIdx)
+            {
+                taps.srcIdxs.push_back(srcIdx1);
+                taps.weights.push_back(0.5f);
+            }
+            continue;
+        }
+
+        // edges are clamped, since there's no telling whether the texture tiles
+        const float center = (dstIdx + 0.5f) * scale - 0.5f;
+        const float radius = KAISER_RADIUS * scale;
+        const int32_t firstSrcIdx = static_cast<int32_t>(std::ceil(center - radius));
+        const int32_t lastSrcIdx = static_cast<int32_t>(std::floor(center + radius));
+        float weightSum = 0.f;
+        for (int32_t srcIdx = firstSrcIdx; srcIdx <= lastSrcIdx; ++srcIdx)
+        {
+            const float t = (srcIdx - center) / scale;
+            const float u = t / KAISER_RADIUS;
+            if (u * u >= 1.f)
+            {
+                continue;
+            }
+
+            const float weight = sinc(t) * besselI0(KAISER_ALPHA * std::sqrt(1.f - u * u)) * kaiserNorm;
+            taps.srcIdxs.push_back(static_cast<uint32_t>(std::clamp(srcIdx, 0, static_cast<int32_t>(srcSize) - 1)));
+            taps.weights.push_back(weight);
+            weightSum += weight;
+        }
+
+        for (uint32_t tapIdx = firstTapIdx; tapIdx < taps.weights.size(); ++tapIdx)
+        {
+            taps.weights[tapIdx] /= weightSum;
+        }
+    }
+    taps.firstTapIdxs.push_back(static_cast<uint32_t>(taps.srcIdxs.size()));
+
+    return taps;
+}
+
+// sums the taps' texels of `src`, `srcStride` texels apart, into `dst`
+static void filterTexel(const Taps& taps, uint32_t dstIdx, const Texel* src, size_t srcStride, Texel* dst)
+{
+    const uint32_t firstTapIdx = taps.firstTapIdxs[dstIdx];
+    const uint32_t endTapIdx = taps.firstTapIdxs[dstIdx + 1];
+
+#if MIP_GENERATOR_USE_SSE
+    __m128 sum = _mm_setzero_ps();
+    for (uint32_t tapIdx = firstTapIdx; tapIdx < endTapIdx; ++tapIdx)
+    {
+        const __m128 texel = _mm_load_ps(src[taps.srcIdxs[tapIdx] * srcStride].c);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps.weights[tapIdx]), texel));
+    }
+    _mm_store_ps(dst->c, sum);
+#else
+    Texel sum = {};
+    for (uint32_t tapIdx = firstTapIdx; tapIdx < endTapIdx; ++tapIdx)
+    {
+        const Texel& texel = src[taps.srcIdxs[tapIdx] * srcStride];
+        const float weight = taps.weights[tapIdx];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            sum.c[c] += weight * texel.c[c];
+        }
+    }
+    *dst = sum;
+#endif
+}
+
+static void clampTexel(Texel* texel)
+{
+#if MIP_GENERATOR_USE_SSE
+    const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_load_ps(texel->c), _mm_setzero_ps()), _mm_set1_ps(1.f));
+    _mm_store_ps(texel->c, clamped);
+#else
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        texel->c[c] = std::clamp(texel->c[c], 0.f, 1.f);
+    }
+#endif
+}
+
+static uint8_t unormToByte(float value)
+{
+    return static_cast<uint8_t>(value * 255.f + 0.5f);
+}
+
+static uint8_t linearToSrgbByte(float value, const SrgbTables& tables)
+{
+    return static_cast<uint8_t>(
+        std::lower_bound(tables.thresholds.begin(), tables.thresholds.end(), value) - tables.thresholds.begin());
+}
+
+static void forEachRowJob(uint32_t numRows, uint32_t numThreads, const std::function<void(uint32_t)>& fn)
+{
+    const uint32_t numJobs = (numRows + ROWS_PER_JOB - 1) / ROWS_PER_JOB;
+    Parallel::forEach(numJobs, numThreads, [&](uint32_t jobIdx) {
+        const uint32_t endRow = std::min((jobIdx + 1) * ROWS_PER_JOB, numRows);
+        for (uint32_t row = jobIdx * ROWS_PER_JOB; row < endRow; ++row)
+        {
+            fn(row);
+        }
+    });
+}
+
+uint32_t getNumMips(uint32_t width, uint32_t height)
+{
+    uint32_t numMips = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++numMips;
+    }
+    return numMips;
+}
+
+std::vector<MipLevel> generateMips(
+    const uint8_t* rgba, uint32_t width, uint32_t height, bool isSrgb, Filter filter, uint32_t numThreads)
+{
+    const SrgbTables& srgbTables = getSrgbTables();
+    const uint32_t numMips = getNumMips(width, height);
+
+    std::vector<MipLevel> mips;
+    mips.reserve(numMips);
+    mips.push_back({ std::vector<uint8_t>(rgba, rgba + static_cast<size_t>(width) * height * 4), width, height });
+
+    std::vector<Texel> level(static_cast<size_t>(width) * height);
+    forEachRowJob(height, numThreads, [&](uint32_t row) {
+        for (size_t texelIdx = static_cast<size_t>(row) * width; texelIdx < static_cast<size_t>(row + 1) * width;
+             ++texelIdx)
+        {
+            const uint8_t* srcTexel = rgba + texelIdx * 4;
+            Texel& texel = level[texelIdx];
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                texel.c[c] = isSrgb ? srgbTables.toLinear[srcTexel[c]] : srcTexel[c] / 255.f;
+            }
+            texel.c[3] = srcTexel[3] / 255.f;
+        }
+    });
+
+    std::vector<Texel> rowFiltered;
+    for (uint32_t mipIdx = 1; mipIdx < numMips; ++mipIdx)
+    {
+        const uint32_t srcWidth = mips.back().width;
+        const uint32_t srcHeight = mips.back().height;
+        const uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+        const uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+
+        const Taps xTaps = makeTaps(srcWidth, dstWidth, filter);
+        const Taps yTaps = makeTaps(srcHeight, dstHeight, filter);
+
+        // separable, so rows are filtered first, then columns of the result
+        rowFiltered.resize(static_cast<size_t>(dstWidth) * srcHeight);
+        forEachRowJob(srcHeight, numThreads, [&](uint32_t row) {
+            const Texel* srcRow = level.data() + static_cast<size_t>(row) * srcWidth;
+            Texel* dstRow = rowFiltered.data() + static_cast<size_t>(row) * dstWidth;
+            for (uint32_t x = 0; x < dstWidth; ++x)
+            {
+                filterTexel(xTaps, x, srcRow, 1, dstRow + x);
+            }
+        });
+
+        std::vector<Texel> nextLevel(static_cast<size_t>(dstWidth) * dstHeight);
+        MipLevel& mip = mips.emplace_back();
+        mip.texels.resize(nextLevel.size() * 4);
+        mip.width = dstWidth;
+        mip.height = dstHeight;
+
+        forEachRowJob(dstHeight, numThreads, [&](uint32_t row) {
+            for (uint32_t x = 0; x < dstWidth; ++x)
+            {
+                const size_t texelIdx = static_cast<size_t>(row) * dstWidth + x;
+                Texel& texel = nextLevel[texelIdx];
+                filterTexel(yTaps, row, rowFiltered.data() + x, dstWidth, &texel);
+                // clamped before the next level is filtered from it, so that Kaiser ringing doesn't build up
+                clampTexel(&texel);
+
+                uint8_t* dstTexel = mip.texels.data() + texelIdx * 4;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    dstTexel[c] = isSrgb ? linearToSrgbByte(texel.c[c], srgbTables) : unormToByte(texel.c[c]);
+                }
+                dstTexel[3] = unormToByte(texel.c[3]);
+            }
+        });
+
+        level = std::move(nextLevel);
+    }
+
+    return mips;
+}
+
+} // namespace MipGenerator
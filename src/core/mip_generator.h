@@ -0,0 +1,54 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Builds mip chains for RGBA8 images on the CPU. Texels are filtered as four floats in linear space, one SSE register
+// per texel where available, and each level is filtered from the previous one before it's rounded to 8 bits.
+namespace MipGenerator
+{
+
+enum class Filter
+{
+    // averages 2x2 texels; cheap, but aliases and blurs more
+    BOX,
+    // Kaiser-windowed sinc; keeps more detail without ringing much
+    KAISER,
+};
+
+struct MipLevel
+{
+    std::vector<uint8_t> texels;
+    uint32_t width;
+    uint32_t height;
+};
+
+// mip 0 through 1x1
+uint32_t getNumMips(uint32_t width, uint32_t height);
+
+// Returns every mip level of `rgba`, starting with a copy of it. Each level is half the size of the previous one,
+// rounded down and at least 1. sRGB images have their color channels converted to linear for filtering and back, while
+// alpha is always linear. Rows are filtered on up to `numThreads` threads (0 for Parallel::getDefaultNumThreads()); the
+// result is the same for any thread count.
+std::vector<MipLevel> generateMips(
+    const uint8_t* rgba, uint32_t width, uint32_t height, bool isSrgb, Filter filter, uint32_t numThreads);
+
+} // namespace MipGenerator
@@ -0,0 +1,184 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "paged_allocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+PagedAllocator::PagedAllocator(uint64_t pageSizeBytes, uint64_t alignmentBytes)
+    : pageSizeBytes(pageSizeBytes), alignmentBytes(alignmentBytes)
+{}
+
+uint32_t PagedAllocator::createPage(uint64_t sizeBytes, bool isDedicated)
+{
+    uint32_t pageIdx;
+    if (!this->unusedPageIdxs.empty())
+    {
+        pageIdx = this->unusedPageIdxs.back();
+        this->unusedPageIdxs.pop_back();
+    }
+    else
+    {
+        pageIdx = static_cast<uint32_t>(this->pages.size());
+        this->pages.emplace_back();
+    }
+
+    Page& page = this->pages[pageIdx];
+    page.allocator.init(sizeBytes);
+    page.numAllocations = 0;
+    page.isActive = true;
+    page.isDedicated = isDedicated;
+
+    ++this->stats.numPages;
+    this->stats.reservedBytes += sizeBytes;
+
+    return pageIdx;
+}
+
+PagedAllocator::Allocation PagedAllocator::allocate(uint64_t sizeBytes, uint32_t* outNewPageIdx)
+{
+    *outNewPageIdx = INVALID_PAGE_IDX;
+
+    // every page starts at offset 0 and every block size is a multiple of the alignment, so every offset is aligned
+    const uint64_t alignedSizeBytes = (sizeBytes + this->alignmentBytes - 1) & ~(this->alignmentBytes - 1);
+
+    uint32_t pageIdx = INVALID_PAGE_IDX;
+    TlsfAllocator::Allocation blockAllocation;
+
+    if (alignedSizeBytes <= this->pageSizeBytes)
+    {
+        for (uint32_t idx = 0; idx < this->pages.size(); ++idx)
+        {
+            Page& page = this->pages[idx];
+            if (!page.isActive || page.isDedicated || page.allocator.getFreeBytes() < alignedSizeBytes)
+            {
+                continue;
+            }
+
+            blockAllocation = page.allocator.allocate(alignedSizeBytes);
+            if (blockAllocation.isValid())
+            {
+                pageIdx = idx;
+                break;
+            }
+        }
+    }
+
+    if (pageIdx == INVALID_PAGE_IDX)
+    {
+        const bool isDedicated = alignedSizeBytes > this->pageSizeBytes;
+        pageIdx = this->createPage(isDedicated ? alignedSizeBytes : this->pageSizeBytes, isDedicated);
+        blockAllocation = this->pages[pageIdx].allocator.allocate(alignedSizeBytes);
+        *outNewPageIdx = pageIdx;
+    }
+
+    if (pageIdx == this->emptyPageIdx)
+    {
+        this->emptyPageIdx = INVALID_PAGE_IDX;
+    }
+
+    ++this->pages[pageIdx].numAllocations;
+    ++this->stats.numAllocations;
+    this->stats.usedBytes += blockAllocation.sizeBytes;
+    this->stats.peakUsedBytes = std::max(this->stats.peakUsedBytes, this->stats.usedBytes);
+
+    return { pageIdx, blockAllocation.offsetBytes, blockAllocation.sizeBytes, blockAllocation.blockIdx };
+}
+
+bool PagedAllocator::free(const Allocation& allocation)
+{
+#ifdef _DEBUG
+    if (allocation.pageIdx >= this->pages.size() || !this->pages[allocation.pageIdx].isActive)
+    {
+        throw std::runtime_error("Attempting to free PagedAllocator allocation from invalid page");
+    }
+#endif
+
+    Page& page = this->pages[allocation.pageIdx];
+    page.allocator.free(allocation.blockIdx);
+    --page.numAllocations;
+
+    --this->stats.numAllocations;
+    this->stats.usedBytes -= allocation.sizeBytes;
+
+    if (page.numAllocations > 0)
+    {
+        return false;
+    }
+
+    if (!page.isDedicated && this->emptyPageIdx == INVALID_PAGE_IDX)
+    {
+        this->emptyPageIdx = allocation.pageIdx;
+        return false;
+    }
+
+    page.isActive = false;
+    --this->stats.numPages;
+    this->stats.reservedBytes -= page.allocator.getSizeBytes();
+    this->unusedPageIdxs.push_back(allocation.pageIdx);
+    return true;
+}
+
+uint32_t PagedAllocator::getNumPageSlots() const
+{
+    return static_cast<uint32_t>(this->pages.size());
+}
+
+bool PagedAllocator::getIsPageActive(uint32_t pageIdx) const
+{
+    return this->pages[pageIdx].isActive;
+}
+
+uint64_t PagedAllocator::getPageSizeBytes(uint32_t pageIdx) const
+{
+    return this->pages[pageIdx].allocator.getSizeBytes();
+}
+
+uint64_t PagedAllocator::getLargestFreeSizeBytes() const
+{
+    uint64_t largestSizeBytes = 0;
+    for (const Page& page : this->pages)
+    {
+        if (page.isActive)
+        {
+            largestSizeBytes = std::max(largestSizeBytes, page.allocator.getLargestFreeSizeBytes());
+        }
+    }
+
+    return largestSizeBytes;
+}
+
+uint32_t PagedAllocator::getNumFreeRanges() const
+{
+    uint32_t numFreeRanges = 0;
+    for (const Page& page : this->pages)
+    {
+        if (page.isActive)
+        {
+            numFreeRanges += page.allocator.getNumFreeBlocks();
+        }
+    }
+
+    return numFreeRanges;
+}
+
+const PagedAllocator::Stats& PagedAllocator::getStats() const
+{
+    return this->stats;
+}
@@ -0,0 +1,97 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "tlsf_allocator.h"
+
+#include <cstdint>
+#include <vector>
+
+// Sub-allocates aligned ranges out of a growable set of fixed-size pages. Each page is managed by its own
+// TlsfAllocator; the owner is responsible for creating and releasing whatever backs a page (e.g. a GPU buffer) when
+// allocate() and free() report that the set of pages changed. Requests larger than a page get a dedicated page.
+class PagedAllocator
+{
+public:
+    static constexpr uint32_t INVALID_PAGE_IDX = ~0u;
+
+    struct Allocation
+    {
+        uint32_t pageIdx{ INVALID_PAGE_IDX };
+        uint64_t offsetBytes{ 0 };
+        uint64_t sizeBytes{ 0 };
+        uint32_t blockIdx{ TlsfAllocator::INVALID_BLOCK_IDX };
+
+        bool isValid() const
+        {
+            return this->pageIdx != INVALID_PAGE_IDX;
+        }
+    };
+
+    struct Stats
+    {
+        uint32_t numPages{ 0 };
+        uint32_t numAllocations{ 0 };
+        uint64_t reservedBytes{ 0 };
+        uint64_t usedBytes{ 0 };
+        uint64_t peakUsedBytes{ 0 };
+    };
+
+private:
+    struct Page
+    {
+        TlsfAllocator allocator{};
+        uint32_t numAllocations{ 0 };
+        bool isActive{ false };
+        bool isDedicated{ false };
+    };
+
+    const uint64_t pageSizeBytes;
+    const uint64_t alignmentBytes;
+
+    std::vector<Page> pages;
+    std::vector<uint32_t> unusedPageIdxs;
+
+    // a regular page that became empty and was kept instead of released, or INVALID_PAGE_IDX
+    uint32_t emptyPageIdx{ INVALID_PAGE_IDX };
+
+    Stats stats{};
+
+    uint32_t createPage(uint64_t sizeBytes, bool isDedicated);
+
+public:
+    PagedAllocator(uint64_t pageSizeBytes, uint64_t alignmentBytes);
+
+    // `outNewPageIdx` is set to the index of a newly created page, or INVALID_PAGE_IDX if an existing page was used
+    Allocation allocate(uint64_t sizeBytes, uint32_t* outNewPageIdx);
+
+    // Returns true if the allocation's page became empty and was released. One empty regular page is kept rather than
+    // released, however many pages there are, so that e.g. a TLAS rebuilt every frame doesn't recreate it each time.
+    bool free(const Allocation& allocation);
+
+    uint32_t getNumPageSlots() const;
+    bool getIsPageActive(uint32_t pageIdx) const;
+    uint64_t getPageSizeBytes(uint32_t pageIdx) const;
+
+    // across all active pages
+    uint64_t getLargestFreeSizeBytes() const;
+    uint32_t getNumFreeRanges() const;
+
+    const Stats& getStats() const;
+};
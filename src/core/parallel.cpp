@@ -0,0 +1,216 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Parallel
+{
+
+namespace
+{
+
+// one forEach() call, which the calling thread works on along with whichever pool workers join it
+struct Job
+{
+    const std::function<void(uint32_t)>* fn{ nullptr };
+    uint32_t numItems{ 0 };
+    uint32_t maxNumHelpers{ 0 };
+
+    std::atomic<uint32_t> nextItemIdx{ 0 };
+    std::atomic<bool> hasFailed{ false };
+    std::exception_ptr firstException;
+    std::mutex exceptionMutex;
+
+    // guarded by WorkerPool::mutex
+    uint32_t numHelpers{ 0 };
+    uint32_t numRunningHelpers{ 0 };
+
+    bool canBeJoined() const
+    {
+        return this->numHelpers < this->maxNumHelpers && !this->hasFailed.load(std::memory_order_relaxed) &&
+               this->nextItemIdx.load(std::memory_order_relaxed) < this->numItems;
+    }
+
+    void work()
+    {
+        while (!this->hasFailed.load(std::memory_order_relaxed))
+        {
+            const uint32_t itemIdx = this->nextItemIdx.fetch_add(1, std::memory_order_relaxed);
+            if (itemIdx >= this->numItems)
+            {
+                return;
+            }
+
+            try
+            {
+                (*this->fn)(itemIdx);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(this->exceptionMutex);
+                if (!this->firstException)
+                {
+                    this->firstException = std::current_exception();
+                }
+                this->hasFailed.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Threads that live for the rest of the process and help out with whatever jobs are running. The pool grows to the
+// largest thread count asked for so far and never shrinks. A caller only waits for items that a worker has already
+// started, so forEach() can be called from inside an item without deadlocking.
+class WorkerPool
+{
+private:
+    std::mutex mutex;
+    std::condition_variable jobAddedCv;
+    std::condition_variable helperFinishedCv;
+
+    std::vector<std::thread> workers;
+    std::vector<Job*> jobs;
+    bool isStopping{ false };
+
+    Job* findJoinableJob() const
+    {
+        for (Job* const job : this->jobs)
+        {
+            if (job->canBeJoined())
+            {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void runWorker()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true)
+        {
+            Job* job = nullptr;
+            this->jobAddedCv.wait(lock, [&] {
+                job = this->findJoinableJob();
+                return this->isStopping || job != nullptr;
+            });
+
+            if (this->isStopping)
+            {
+                return;
+            }
+
+            ++job->numHelpers;
+            ++job->numRunningHelpers;
+            lock.unlock();
+
+            job->work();
+
+            lock.lock();
+            --job->numRunningHelpers;
+            this->helperFinishedCv.notify_all();
+        }
+    }
+
+public:
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+        this->jobAddedCv.notify_all();
+
+        for (std::thread& worker : this->workers)
+        {
+            worker.join();
+        }
+    }
+
+    void run(Job& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            while (this->workers.size() < job.maxNumHelpers)
+            {
+                this->workers.emplace_back(&WorkerPool::runWorker, this);
+            }
+            this->jobs.push_back(&job);
+        }
+        this->jobAddedCv.notify_all();
+
+        job.work();
+
+        // once the job is out of the list no more workers can join it, so only the ones already in it are waited for
+        std::unique_lock<std::mutex> lock(this->mutex);
+        std::erase(this->jobs, &job);
+        this->helperFinishedCv.wait(lock, [&] { return job.numRunningHelpers == 0; });
+    }
+};
+
+WorkerPool& getWorkerPool()
+{
+    static WorkerPool workerPool;
+    return workerPool;
+}
+
+} // namespace
+
+uint32_t getDefaultNumThreads()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void forEach(uint32_t numItems, uint32_t numThreads, const std::function<void(uint32_t)>& fn)
+{
+    if (numThreads == 0)
+    {
+        numThreads = getDefaultNumThreads();
+    }
+    numThreads = std::min(numThreads, numItems);
+
+    if (numThreads <= 1)
+    {
+        for (uint32_t itemIdx = 0; itemIdx < numItems; ++itemIdx)
+        {
+            fn(itemIdx);
+        }
+        return;
+    }
+
+    Job job;
+    job.fn = &fn;
+    job.numItems = numItems;
+    job.maxNumHelpers = numThreads - 1;
+    getWorkerPool().run(job);
+
+    if (job.firstException)
+    {
+        std::rethrow_exception(job.firstException);
+    }
+}
+
+} // namespace Parallel
@@ -0,0 +1,39 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Runs independent work items on a pool of worker threads that is shared by every caller and kept alive between calls,
+// so that the many small passes of a scene load (decoding images, compressing textures, converting meshes) don't each
+// pay for starting threads.
+namespace Parallel
+{
+
+// at least 1, even if the platform can't tell
+uint32_t getDefaultNumThreads();
+
+// Calls `fn` once for every index in [0, numItems) and returns when all calls have finished. Items are handed out in
+// order to up to `numThreads` threads (0 for getDefaultNumThreads()), one of which is the calling thread, so `fn`
+// must only touch state that no other item touches. `fn` may call forEach() itself. If any call throws, the
+// remaining items are skipped and the first exception is rethrown here.
+void forEach(uint32_t numItems, uint32_t numThreads, const std::function<void(uint32_t)>& fn);
+
+} // namespace Parallel
@@ -0,0 +1,73 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "relocation_planner.h"
+
+namespace RelocationPlanner
+{
+
+std::vector<Relocation> planRelocations(TlsfAllocator& allocator, uint64_t maxMoveBytes)
+{
+    std::vector<Relocation> relocations;
+    if (!hasHoles(allocator))
+    {
+        return relocations;
+    }
+
+    uint64_t movedBytes = 0;
+    uint32_t blockIdx = allocator.getFirstBlockIdx();
+    while (blockIdx != TlsfAllocator::INVALID_BLOCK_IDX)
+    {
+        const TlsfAllocator::BlockInfo blockInfo = allocator.getBlockInfo(blockIdx);
+        const uint32_t nextIdx = blockInfo.nextPhysIdx;
+        if (!blockInfo.isFree || nextIdx == TlsfAllocator::INVALID_BLOCK_IDX)
+        {
+            blockIdx = nextIdx;
+            continue;
+        }
+
+        // adjacent free blocks are always merged, so the block after a free block is in use
+        const TlsfAllocator::BlockInfo nextInfo = allocator.getBlockInfo(nextIdx);
+        if (nextInfo.userData == TlsfAllocator::NO_USER_DATA)
+        {
+            blockIdx = nextIdx;
+            continue;
+        }
+
+        if (movedBytes > 0 && movedBytes + nextInfo.sizeBytes > maxMoveBytes)
+        {
+            break;
+        }
+
+        const uint64_t dstOffsetBytes = allocator.slideBlockDown(nextIdx);
+        relocations.push_back({ nextIdx, nextInfo.userData, nextInfo.offsetBytes, dstOffsetBytes, nextInfo.sizeBytes });
+        movedBytes += nextInfo.sizeBytes;
+
+        // the hole now sits right behind the moved block, possibly merged with the one after it
+        blockIdx = allocator.getBlockInfo(nextIdx).nextPhysIdx;
+    }
+
+    return relocations;
+}
+
+bool hasHoles(const TlsfAllocator& allocator)
+{
+    return allocator.getFreeBytes() > allocator.getTailFreeSizeBytes();
+}
+
+} // namespace RelocationPlanner
@@ -0,0 +1,49 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "tlsf_allocator.h"
+
+#include <cstdint>
+#include <vector>
+
+// Plans incremental defragmentation of a TlsfAllocator range. Nothing here touches the memory being managed; the
+// caller copies each relocation's bytes and updates whatever references the old offset.
+namespace RelocationPlanner
+{
+
+struct Relocation
+{
+    uint32_t blockIdx;
+    uint32_t userData;
+    uint64_t srcOffsetBytes;
+    uint64_t dstOffsetBytes;
+    uint64_t sizeBytes;
+};
+
+// Walks the range from the front and slides used blocks down into the holes in front of them until roughly
+// `maxMoveBytes` have been moved (at least one block is moved if any can be, even if it is larger than that). Blocks
+// whose user data is TlsfAllocator::NO_USER_DATA are treated as pinned and are never moved. The allocator is updated
+// immediately, so source and destination ranges of a single plan can overlap.
+std::vector<Relocation> planRelocations(TlsfAllocator& allocator, uint64_t maxMoveBytes);
+
+// true if the free space is split up into more than the free block at the end of the range
+bool hasHoles(const TlsfAllocator& allocator);
+
+} // namespace RelocationPlanner
@@ -0,0 +1,70 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+// FIFO of items that have to outlive GPU work, each tagged with the fence value that signals the work is done. Items
+// are handed back through drain() once the fence has been reached, in the order they were pushed.
+template<class T> class RetirementQueue
+{
+private:
+    struct Entry
+    {
+        uint64_t fenceValue;
+        T item;
+    };
+
+    std::deque<Entry> entries;
+
+public:
+    // fence values must not decrease between calls
+    void push(uint64_t fenceValue, T&& item)
+    {
+        this->entries.push_back({ fenceValue, std::move(item) });
+    }
+
+    // calls `retireFunc` on every item whose fence value is at most `completedFenceValue` and removes it
+    template<class Func> void drain(uint64_t completedFenceValue, Func&& retireFunc)
+    {
+        while (!this->entries.empty() && this->entries.front().fenceValue <= completedFenceValue)
+        {
+            retireFunc(this->entries.front().item);
+            this->entries.pop_front();
+        }
+    }
+
+    template<class Func> void drainAll(Func&& retireFunc)
+    {
+        this->drain(UINT64_MAX, retireFunc);
+    }
+
+    bool isEmpty() const
+    {
+        return this->entries.empty();
+    }
+
+    size_t getSize() const
+    {
+        return this->entries.size();
+    }
+};
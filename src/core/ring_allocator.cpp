@@ -0,0 +1,129 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ring_allocator.h"
+
+#include <algorithm>
+
+void RingAllocator::init(uint64_t sizeBytes)
+{
+    this->sizeBytes = sizeBytes;
+    this->usedBytes = 0;
+    this->pendingBytes = 0;
+    this->headBytes = 0;
+    this->tailBytes = 0;
+    this->submissions.clear();
+}
+
+uint64_t RingAllocator::allocate(uint64_t sizeBytes, uint64_t alignmentBytes)
+{
+    if (this->usedBytes == 0)
+    {
+        // nothing to wrap around, so start from the beginning to get the largest possible contiguous range
+        this->headBytes = 0;
+        this->tailBytes = 0;
+    }
+
+    const uint64_t alignedHeadBytes = (this->headBytes + alignmentBytes - 1) / alignmentBytes * alignmentBytes;
+
+    uint64_t offsetBytes;
+    if (this->headBytes > this->tailBytes || this->usedBytes == 0)
+    {
+        // free space is [head, size) followed by [0, tail)
+        if (alignedHeadBytes + sizeBytes <= this->sizeBytes)
+        {
+            offsetBytes = alignedHeadBytes;
+        }
+        else if (sizeBytes <= this->tailBytes)
+        {
+            offsetBytes = 0;
+        }
+        else
+        {
+            return INVALID_OFFSET;
+        }
+    }
+    else
+    {
+        // free space is [head, tail), or nothing if the ring is full
+        if (alignedHeadBytes + sizeBytes <= this->tailBytes && this->usedBytes < this->sizeBytes)
+        {
+            offsetBytes = alignedHeadBytes;
+        }
+        else
+        {
+            return INVALID_OFFSET;
+        }
+    }
+
+    // account for anything skipped at the end or for alignment so that reclaim() can give it back
+    const uint64_t skippedBytes =
+        (offsetBytes >= this->headBytes) ? (offsetBytes - this->headBytes) : (this->sizeBytes - this->headBytes);
+    this->usedBytes += skippedBytes + sizeBytes;
+    this->pendingBytes += skippedBytes + sizeBytes;
+    this->headBytes = offsetBytes + sizeBytes;
+
+    return offsetBytes;
+}
+
+void RingAllocator::submit(uint64_t fenceValue)
+{
+    if (this->pendingBytes == 0)
+    {
+        return;
+    }
+
+    this->submissions.push_back({ fenceValue, this->headBytes, this->pendingBytes });
+    this->pendingBytes = 0;
+}
+
+void RingAllocator::reclaim(uint64_t completedFenceValue)
+{
+    while (!this->submissions.empty() && this->submissions.front().fenceValue <= completedFenceValue)
+    {
+        const Submission& submission = this->submissions.front();
+        this->tailBytes = submission.endOffsetBytes;
+        this->usedBytes -= submission.sizeBytes;
+        this->submissions.pop_front();
+    }
+}
+
+uint64_t RingAllocator::getSizeBytes() const
+{
+    return this->sizeBytes;
+}
+
+uint64_t RingAllocator::getUsedBytes() const
+{
+    return this->usedBytes;
+}
+
+uint64_t RingAllocator::getLargestFreeSizeBytes() const
+{
+    if (this->usedBytes == 0)
+    {
+        return this->sizeBytes;
+    }
+
+    if (this->headBytes > this->tailBytes)
+    {
+        return std::max(this->sizeBytes - this->headBytes, this->tailBytes);
+    }
+
+    return this->usedBytes < this->sizeBytes ? this->tailBytes - this->headBytes : 0;
+}
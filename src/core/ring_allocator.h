@@ -0,0 +1,66 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Hands out offsets into a circular range. Allocations can't be freed individually; instead everything allocated
+// between two submit() calls is tagged with a fence value and released together once reclaim() sees that the fence has
+// been reached. Meant for transient data like upload staging that only lives until the GPU has consumed it.
+class RingAllocator
+{
+public:
+    static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+private:
+    struct Submission
+    {
+        uint64_t fenceValue;
+        uint64_t endOffsetBytes;
+        // includes space skipped for alignment and wrapping
+        uint64_t sizeBytes;
+    };
+
+    uint64_t sizeBytes{ 0 };
+    uint64_t usedBytes{ 0 };
+    uint64_t pendingBytes{ 0 };
+
+    // allocations live in [tailBytes, headBytes), wrapping around the end of the range
+    uint64_t headBytes{ 0 };
+    uint64_t tailBytes{ 0 };
+
+    std::deque<Submission> submissions;
+
+public:
+    void init(uint64_t sizeBytes);
+
+    // returns INVALID_OFFSET if there is no contiguous space left, in which case nothing changes
+    uint64_t allocate(uint64_t sizeBytes, uint64_t alignmentBytes);
+
+    // tags everything allocated since the last call with `fenceValue`
+    void submit(uint64_t fenceValue);
+    // releases all submissions whose fence value is at most `completedFenceValue`
+    void reclaim(uint64_t completedFenceValue);
+
+    uint64_t getSizeBytes() const;
+    uint64_t getUsedBytes() const;
+    // largest request that allocate() could currently satisfy without alignment
+    uint64_t getLargestFreeSizeBytes() const;
+};
@@ -0,0 +1,86 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scratch_planner.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ScratchPlanner
+{
+
+static uint64_t alignUp(uint64_t value, uint64_t alignmentBytes)
+{
+    return (value + alignmentBytes - 1) & ~(alignmentBytes - 1);
+}
+
+std::vector<Batch> planBatches(const std::vector<uint64_t>& scratchSizesBytes,
+                               uint64_t budgetBytes,
+                               uint64_t alignmentBytes)
+{
+    std::vector<uint32_t> buildIdxs(scratchSizesBytes.size());
+    std::iota(buildIdxs.begin(), buildIdxs.end(), 0);
+    std::stable_sort(buildIdxs.begin(), buildIdxs.end(), [&](uint32_t a, uint32_t b) {
+        return scratchSizesBytes[a] > scratchSizesBytes[b];
+    });
+
+    std::vector<Batch> batches;
+    for (const uint32_t buildIdx : buildIdxs)
+    {
+        const uint64_t sizeBytes = alignUp(scratchSizesBytes[buildIdx], alignmentBytes);
+
+        Batch* targetBatch = nullptr;
+        for (Batch& batch : batches)
+        {
+            if (batch.scratchSizeBytes + sizeBytes <= budgetBytes)
+            {
+                targetBatch = &batch;
+                break;
+            }
+        }
+
+        if (targetBatch == nullptr)
+        {
+            targetBatch = &batches.emplace_back();
+        }
+
+        targetBatch->placements.push_back({ buildIdx, targetBatch->scratchSizeBytes });
+        targetBatch->scratchSizeBytes += sizeBytes;
+    }
+
+    for (Batch& batch : batches)
+    {
+        std::sort(batch.placements.begin(), batch.placements.end(), [](const Placement& a, const Placement& b) {
+            return a.buildIdx < b.buildIdx;
+        });
+    }
+
+    return batches;
+}
+
+uint64_t getRequiredScratchSize(const std::vector<Batch>& batches)
+{
+    uint64_t maxSizeBytes = 0;
+    for (const Batch& batch : batches)
+    {
+        maxSizeBytes = std::max(batch.scratchSizeBytes, maxSizeBytes);
+    }
+    return maxSizeBytes;
+}
+
+} // namespace ScratchPlanner
@@ -0,0 +1,52 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Packs acceleration structure builds into batches whose scratch memory fits in a shared budget. Builds in the same
+// batch get disjoint scratch ranges, so they can be issued back-to-back and only need a barrier between batches.
+namespace ScratchPlanner
+{
+
+struct Placement
+{
+    uint32_t buildIdx;
+    uint64_t scratchOffsetBytes;
+};
+
+struct Batch
+{
+    std::vector<Placement> placements;
+    uint64_t scratchSizeBytes{ 0 };
+};
+
+// First-fit decreasing: builds are placed from largest to smallest scratch size into the first batch with room for
+// them. Each scratch range starts on a multiple of `alignmentBytes`, which must be a power of two. A build that needs
+// more than `budgetBytes` on its own gets a batch to itself. Batches are returned in the order they were opened and
+// placements within a batch are sorted by build index, so the plan only depends on the input sizes.
+std::vector<Batch> planBatches(const std::vector<uint64_t>& scratchSizesBytes,
+                               uint64_t budgetBytes,
+                               uint64_t alignmentBytes);
+
+// scratch size needed to execute every batch of the plan out of the same buffer
+uint64_t getRequiredScratchSize(const std::vector<Batch>& batches);
+
+} // namespace ScratchPlanner
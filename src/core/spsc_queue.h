@@ -0,0 +1,69 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+// Bounded lock-free queue for handing items from one producer thread to one consumer thread. Neither side ever blocks
+// or allocates, so a render loop can poll it every frame. One slot is always left empty to tell a full queue from an
+// empty one, so it holds up to CAPACITY - 1 items.
+template<class T, uint32_t CAPACITY> class SpscQueue
+{
+    static_assert(CAPACITY >= 2, "SpscQueue needs at least two slots");
+
+private:
+    std::array<T, CAPACITY> slots{};
+    // next slot to pop, only written by the consumer
+    std::atomic<uint32_t> head{ 0 };
+    // next slot to push, only written by the producer
+    std::atomic<uint32_t> tail{ 0 };
+
+public:
+    // producer only; `item` is left untouched if the queue is full
+    bool tryPush(T& item)
+    {
+        const uint32_t tail = this->tail.load(std::memory_order_relaxed);
+        const uint32_t nextTail = (tail + 1) % CAPACITY;
+        if (nextTail == this->head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        this->slots[tail] = std::move(item);
+        this->tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool tryPop(T* outItem)
+    {
+        const uint32_t head = this->head.load(std::memory_order_relaxed);
+        if (head == this->tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        *outItem = std::move(this->slots[head]);
+        this->head.store((head + 1) % CAPACITY, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,224 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "texture_processor.h"
+
+#include "chunk_file.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace TextureProcessor
+{
+
+// bump whenever the output for the same inputs changes, so that existing cache entries are ignored
+static constexpr uint32_t PROCESSOR_VERSION = 1;
+
+enum ChunkType : uint32_t
+{
+    HEADER,
+    DATA,
+};
+
+struct CacheHeader
+{
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t numMips;
+};
+
+// everything besides the texels that affects the output
+struct CacheKeyInputs
+{
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t usage;
+    uint32_t filter;
+    uint32_t compress;
+};
+
+static TextureFormat chooseFormat(TextureUsage usage, uint32_t width, uint32_t height, bool compress)
+{
+    const bool canCompress =
+        compress && width % BlockCompression::BLOCK_DIM == 0 && height % BlockCompression::BLOCK_DIM == 0;
+    if (usage == TextureUsage::NORMAL)
+    {
+        return canCompress ? TextureFormat::BC5 : TextureFormat::RGBA8;
+    }
+    return canCompress ? TextureFormat::BC7_SRGB : TextureFormat::RGBA8_SRGB;
+}
+
+bool isBlockCompressed(TextureFormat format)
+{
+    return format == TextureFormat::BC7_SRGB || format == TextureFormat::BC5;
+}
+
+MipLayout getMipLayout(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipIdx)
+{
+    MipLayout layout = {};
+    for (uint32_t i = 0; i <= mipIdx; ++i)
+    {
+        layout.offsetBytes += static_cast<uint64_t>(layout.rowSizeBytes) * layout.numRows;
+        layout.width = std::max(width >> i, 1u);
+        layout.height = std::max(height >> i, 1u);
+
+        if (isBlockCompressed(format))
+        {
+            constexpr uint32_t blockDim = BlockCompression::BLOCK_DIM;
+            layout.rowSizeBytes = (layout.width + blockDim - 1) / blockDim * BlockCompression::BLOCK_SIZE_BYTES;
+            layout.numRows = (layout.height + blockDim - 1) / blockDim;
+        }
+        else
+        {
+            layout.rowSizeBytes = layout.width * 4;
+            layout.numRows = layout.height;
+        }
+    }
+    return layout;
+}
+
+uint64_t getDataSizeBytes(TextureFormat format, uint32_t width, uint32_t height, uint32_t numMips)
+{
+    const MipLayout lastMipLayout = getMipLayout(format, width, height, numMips - 1);
+    return lastMipLayout.offsetBytes + static_cast<uint64_t>(lastMipLayout.rowSizeBytes) * lastMipLayout.numRows;
+}
+
+static std::string getCacheFilePathStr(const std::string& cacheDirPathStr, uint64_t key)
+{
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(cacheDirPathStr) / fileName).string();
+}
+
+static bool readCache(
+    const std::string& cacheFilePathStr, uint64_t key, uint32_t width, uint32_t height, ProcessedTexture* outTexture)
+{
+    ChunkFileReader reader;
+    if (!reader.open(cacheFilePathStr, key) || reader.getNumChunks() != 2)
+    {
+        return false;
+    }
+
+    std::vector<CacheHeader> header;
+    if (!reader.readChunk(HEADER, &header) || header.size() != 1)
+    {
+        return false;
+    }
+
+    const TextureFormat format = static_cast<TextureFormat>(header[0].format);
+    if (format > TextureFormat::BC5 || header[0].width != width || header[0].height != height ||
+        header[0].numMips != MipGenerator::getNumMips(width, height))
+    {
+        return false;
+    }
+
+    const uint64_t dataSizeBytes = getDataSizeBytes(format, width, height, header[0].numMips);
+    if (reader.getChunkSizeBytes(DATA) != dataSizeBytes)
+    {
+        return false;
+    }
+
+    outTexture->format = format;
+    outTexture->width = width;
+    outTexture->height = height;
+    outTexture->numMips = header[0].numMips;
+    outTexture->data.resize(dataSizeBytes);
+    return reader.readChunk(DATA, outTexture->data.data(), dataSizeBytes);
+}
+
+bool process(const uint8_t* rgba,
+             uint32_t width,
+             uint32_t height,
+             TextureUsage usage,
+             const Options& options,
+             ProcessedTexture* outTexture)
+{
+    const CacheKeyInputs keyInputs = {
+        .version = PROCESSOR_VERSION,
+        .width = width,
+        .height = height,
+        .usage = static_cast<uint32_t>(usage),
+        .filter = static_cast<uint32_t>(options.filter),
+        .compress = options.compress ? 1u : 0u,
+    };
+    const uint64_t key = Hash::hashBytes(
+        rgba, static_cast<uint64_t>(width) * height * 4, Hash::hashBytes(&keyInputs, sizeof(keyInputs)));
+
+    std::string cacheFilePathStr;
+    if (!options.cacheDirPathStr.empty())
+    {
+        cacheFilePathStr = getCacheFilePathStr(options.cacheDirPathStr, key);
+        if (readCache(cacheFilePathStr, key, width, height, outTexture))
+        {
+            return true;
+        }
+    }
+
+    const TextureFormat format = chooseFormat(usage, width, height, options.compress);
+    const std::vector<MipGenerator::MipLevel> mips = MipGenerator::generateMips(
+        rgba, width, height, usage == TextureUsage::COLOR, options.filter, options.numThreads);
+
+    ProcessedTexture& texture = *outTexture;
+    texture.format = format;
+    texture.width = width;
+    texture.height = height;
+    texture.numMips = static_cast<uint32_t>(mips.size());
+    texture.data.resize(getDataSizeBytes(format, width, height, texture.numMips));
+
+    for (uint32_t mipIdx = 0; mipIdx < texture.numMips; ++mipIdx)
+    {
+        const MipGenerator::MipLevel& mip = mips[mipIdx];
+        uint8_t* const dst = texture.data.data() + getMipLayout(format, width, height, mipIdx).offsetBytes;
+        if (isBlockCompressed(format))
+        {
+            const BlockCompression::Format blockFormat =
+                format == TextureFormat::BC5 ? BlockCompression::Format::BC5 : BlockCompression::Format::BC7;
+            BlockCompression::encodeImage(
+                blockFormat, mip.texels.data(), mip.width, mip.height, options.numThreads, dst);
+        }
+        else
+        {
+            memcpy(dst, mip.texels.data(), mip.texels.size());
+        }
+    }
+
+    // the cache is only an optimization, so failing to write it isn't an error
+    if (!cacheFilePathStr.empty())
+    {
+        const CacheHeader header = {
+            .format = static_cast<uint32_t>(format),
+            .width = width,
+            .height = height,
+            .numMips = texture.numMips,
+        };
+
+        ChunkFileWriter writer;
+        writer.addChunk(HEADER, &header, sizeof(header));
+        writer.addChunk(DATA, texture.data.data(), texture.data.size());
+        writer.write(cacheFilePathStr, key, options.numThreads);
+    }
+
+    return false;
+}
+
+} // namespace TextureProcessor
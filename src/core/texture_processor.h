@@ -0,0 +1,96 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "block_compression.h"
+#include "mip_generator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How a texture's texels are used, which decides how they're filtered and compressed.
+enum class TextureUsage : uint32_t
+{
+    // sRGB RGBA, compressed to BC7
+    COLOR,
+    // linear, with only red and green kept and compressed to BC5
+    NORMAL,
+};
+
+enum class TextureFormat : uint32_t
+{
+    RGBA8_SRGB,
+    RGBA8,
+    BC7_SRGB,
+    BC5,
+};
+
+struct ProcessedTexture
+{
+    TextureFormat format{ TextureFormat::RGBA8_SRGB };
+    uint32_t width{ 0 };
+    uint32_t height{ 0 };
+    uint32_t numMips{ 0 };
+    // every mip from the largest down, each one rows of texels or, for block compressed formats, rows of blocks
+    std::vector<uint8_t> data;
+};
+
+// Turns decoded RGBA8 images into a full mip chain in their GPU format. Results are kept in a content-addressed disk
+// cache, keyed by the source texels and everything that affects the output, so each image is only ever processed once.
+namespace TextureProcessor
+{
+
+struct Options
+{
+    MipGenerator::Filter filter{ MipGenerator::Filter::KAISER };
+    // D3D12 needs the top mip of a block compressed texture to be a whole number of blocks, so textures whose sizes
+    // aren't multiples of 4 stay uncompressed either way
+    bool compress{ true };
+    // 0 for Parallel::getDefaultNumThreads()
+    uint32_t numThreads{ 0 };
+    // where cached textures are kept; empty to neither read nor write the cache
+    std::string cacheDirPathStr{};
+};
+
+// where one mip of a ProcessedTexture lives in its data
+struct MipLayout
+{
+    uint64_t offsetBytes;
+    uint32_t width;
+    uint32_t height;
+    // a row of texels or blocks
+    uint32_t rowSizeBytes;
+    uint32_t numRows;
+};
+
+bool isBlockCompressed(TextureFormat format);
+MipLayout getMipLayout(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipIdx);
+uint64_t getDataSizeBytes(TextureFormat format, uint32_t width, uint32_t height, uint32_t numMips);
+
+// Processes `rgba` into `outTexture`, or reads it from the cache if it's already been processed with the same options.
+// Returns true if it came from the cache.
+bool process(const uint8_t* rgba,
+             uint32_t width,
+             uint32_t height,
+             TextureUsage usage,
+             const Options& options,
+             ProcessedTexture* outTexture);
+
+} // namespace TextureProcessor
@@ -0,0 +1,523 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+void TlsfAllocator::mappingInsert(uint64_t sizeBytes, uint32_t* fl, uint32_t* sl)
+{
+    if (sizeBytes < SL_COUNT)
+    {
+        *fl = 0;
+        *sl = static_cast<uint32_t>(sizeBytes);
+        return;
+    }
+
+    const uint32_t msb = std::bit_width(sizeBytes) - 1;
+    *fl = msb - SL_LOG2 + 1;
+    *sl = static_cast<uint32_t>(sizeBytes >> (msb - SL_LOG2)) - SL_COUNT;
+}
+
+bool TlsfAllocator::mappingSearch(uint64_t sizeBytes, uint32_t* fl, uint32_t* sl)
+{
+    // round up to the next second-level boundary so that every block in the resulting list is large enough
+    uint64_t roundedSizeBytes = sizeBytes;
+    if (sizeBytes >= SL_COUNT)
+    {
+        const uint32_t msb = std::bit_width(sizeBytes) - 1;
+        roundedSizeBytes += (uint64_t(1) << (msb - SL_LOG2)) - 1;
+        roundedSizeBytes &= ~((uint64_t(1) << (msb - SL_LOG2)) - 1);
+    }
+
+    // rounding wrapped around, so no block can ever be large enough
+    if (roundedSizeBytes < sizeBytes)
+    {
+        return false;
+    }
+
+    mappingInsert(roundedSizeBytes, fl, sl);
+    return true;
+}
+
+uint32_t TlsfAllocator::createBlock(uint64_t offsetBytes, uint64_t sizeBytes)
+{
+    uint32_t blockIdx;
+    if (!this->unusedBlockIdxs.empty())
+    {
+        blockIdx = this->unusedBlockIdxs.back();
+        this->unusedBlockIdxs.pop_back();
+        this->blocks[blockIdx] = {};
+    }
+    else
+    {
+        blockIdx = static_cast<uint32_t>(this->blocks.size());
+        this->blocks.emplace_back();
+    }
+
+    Block& block = this->blocks[blockIdx];
+    block.offsetBytes = offsetBytes;
+    block.sizeBytes = sizeBytes;
+    return blockIdx;
+}
+
+void TlsfAllocator::destroyBlock(uint32_t blockIdx)
+{
+    this->unusedBlockIdxs.push_back(blockIdx);
+}
+
+void TlsfAllocator::insertFreeBlock(uint32_t blockIdx)
+{
+    Block& block = this->blocks[blockIdx];
+
+    uint32_t fl, sl;
+    mappingInsert(block.sizeBytes, &fl, &sl);
+
+    const uint32_t headIdx = this->freeListHeads[fl][sl];
+    block.isFree = true;
+    block.prevFreeIdx = INVALID_BLOCK_IDX;
+    block.nextFreeIdx = headIdx;
+    if (headIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[headIdx].prevFreeIdx = blockIdx;
+    }
+
+    this->freeListHeads[fl][sl] = blockIdx;
+    this->flBitmap |= (1ull << fl);
+    this->slBitmaps[fl] |= (1u << sl);
+
+    ++this->numFreeBlocks;
+}
+
+void TlsfAllocator::removeFreeBlock(uint32_t blockIdx)
+{
+    Block& block = this->blocks[blockIdx];
+
+    uint32_t fl, sl;
+    mappingInsert(block.sizeBytes, &fl, &sl);
+
+    if (block.prevFreeIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[block.prevFreeIdx].nextFreeIdx = block.nextFreeIdx;
+    }
+    else
+    {
+        this->freeListHeads[fl][sl] = block.nextFreeIdx;
+        if (block.nextFreeIdx == INVALID_BLOCK_IDX)
+        {
+            this->slBitmaps[fl] &= ~(1u << sl);
+            if (this->slBitmaps[fl] == 0)
+            {
+                this->flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+
+    if (block.nextFreeIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[block.nextFreeIdx].prevFreeIdx = block.prevFreeIdx;
+    }
+
+    block.isFree = false;
+    block.prevFreeIdx = INVALID_BLOCK_IDX;
+    block.nextFreeIdx = INVALID_BLOCK_IDX;
+
+    --this->numFreeBlocks;
+}
+
+uint32_t TlsfAllocator::findSuitableBlock(uint64_t sizeBytes)
+{
+    uint32_t fl, sl;
+    if (mappingSearch(sizeBytes, &fl, &sl))
+    {
+        uint32_t slMap = this->slBitmaps[fl] & (~0u << sl);
+        if (slMap == 0)
+        {
+            const uint64_t flMap = (fl + 1 < FL_COUNT) ? (this->flBitmap & (~0ull << (fl + 1))) : 0;
+            if (flMap != 0)
+            {
+                fl = std::countr_zero(flMap);
+                slMap = this->slBitmaps[fl];
+            }
+        }
+
+        if (slMap != 0)
+        {
+            sl = std::countr_zero(slMap);
+            return this->freeListHeads[fl][sl];
+        }
+    }
+
+    // The rounded-up search skips the list that `sizeBytes` itself maps to, since not every block in it is large
+    // enough. Check only the head of that list rather than scanning it, which keeps allocation O(1) and still finds
+    // e.g. a buffer's single free block when the request fits it exactly. The cost is that a request can fail while
+    // a large enough block sits further down that list; callers handle that the same as running out of space.
+    mappingInsert(sizeBytes, &fl, &sl);
+    const uint32_t headIdx = this->freeListHeads[fl][sl];
+    if (headIdx != INVALID_BLOCK_IDX && this->blocks[headIdx].sizeBytes >= sizeBytes)
+    {
+        return headIdx;
+    }
+
+    return INVALID_BLOCK_IDX;
+}
+
+uint32_t TlsfAllocator::splitBlock(uint32_t blockIdx, uint64_t sizeBytes)
+{
+    const uint64_t remainderSizeBytes = this->blocks[blockIdx].sizeBytes - sizeBytes;
+    if (remainderSizeBytes < MIN_SPLIT_SIZE_BYTES)
+    {
+        return INVALID_BLOCK_IDX;
+    }
+
+    const uint32_t remainderIdx = this->createBlock(this->blocks[blockIdx].offsetBytes + sizeBytes, remainderSizeBytes);
+
+    // createBlock() may have reallocated the block vector, so don't hold references across it
+    Block& block = this->blocks[blockIdx];
+    Block& remainder = this->blocks[remainderIdx];
+
+    block.sizeBytes = sizeBytes;
+
+    remainder.prevPhysIdx = blockIdx;
+    remainder.nextPhysIdx = block.nextPhysIdx;
+    if (block.nextPhysIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[block.nextPhysIdx].prevPhysIdx = remainderIdx;
+    }
+    else
+    {
+        this->lastPhysIdx = remainderIdx;
+    }
+    block.nextPhysIdx = remainderIdx;
+
+    return remainderIdx;
+}
+
+void TlsfAllocator::mergeWithNext(uint32_t blockIdx)
+{
+    Block& block = this->blocks[blockIdx];
+    const uint32_t nextIdx = block.nextPhysIdx;
+    const Block& next = this->blocks[nextIdx];
+
+    block.sizeBytes += next.sizeBytes;
+    block.nextPhysIdx = next.nextPhysIdx;
+    if (next.nextPhysIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[next.nextPhysIdx].prevPhysIdx = blockIdx;
+    }
+    else
+    {
+        this->lastPhysIdx = blockIdx;
+    }
+
+    this->destroyBlock(nextIdx);
+}
+
+void TlsfAllocator::init(uint64_t sizeBytes)
+{
+    this->blocks.clear();
+    this->unusedBlockIdxs.clear();
+
+    this->flBitmap = 0;
+    this->slBitmaps.fill(0);
+    this->numFreeBlocks = 0;
+    for (auto& slHeads : this->freeListHeads)
+    {
+        slHeads.fill(INVALID_BLOCK_IDX);
+    }
+
+    this->sizeBytes = sizeBytes;
+    this->usedBytes = 0;
+    this->firstPhysIdx = INVALID_BLOCK_IDX;
+    this->lastPhysIdx = INVALID_BLOCK_IDX;
+
+    if (sizeBytes > 0)
+    {
+        this->firstPhysIdx = this->createBlock(0, sizeBytes);
+        this->lastPhysIdx = this->firstPhysIdx;
+        this->insertFreeBlock(this->lastPhysIdx);
+    }
+}
+
+TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t sizeBytes)
+{
+    if (sizeBytes == 0)
+    {
+        return {};
+    }
+
+    const uint32_t blockIdx = this->findSuitableBlock(sizeBytes);
+    if (blockIdx == INVALID_BLOCK_IDX)
+    {
+        return {};
+    }
+
+    this->removeFreeBlock(blockIdx);
+
+    const uint32_t remainderIdx = this->splitBlock(blockIdx, sizeBytes);
+    if (remainderIdx != INVALID_BLOCK_IDX)
+    {
+        this->insertFreeBlock(remainderIdx);
+    }
+
+    Block& block = this->blocks[blockIdx];
+    block.userData = NO_USER_DATA;
+    this->usedBytes += block.sizeBytes;
+
+    return { block.offsetBytes, block.sizeBytes, blockIdx };
+}
+
+void TlsfAllocator::free(uint32_t blockIdx)
+{
+#ifdef _DEBUG
+    if (blockIdx >= this->blocks.size() || this->blocks[blockIdx].isFree)
+    {
+        throw std::runtime_error("Attempting to free invalid TlsfAllocator block");
+    }
+#endif
+
+    this->usedBytes -= this->blocks[blockIdx].sizeBytes;
+
+    const uint32_t nextIdx = this->blocks[blockIdx].nextPhysIdx;
+    if (nextIdx != INVALID_BLOCK_IDX && this->blocks[nextIdx].isFree)
+    {
+        this->removeFreeBlock(nextIdx);
+        this->mergeWithNext(blockIdx);
+    }
+
+    const uint32_t prevIdx = this->blocks[blockIdx].prevPhysIdx;
+    if (prevIdx != INVALID_BLOCK_IDX && this->blocks[prevIdx].isFree)
+    {
+        this->removeFreeBlock(prevIdx);
+        this->mergeWithNext(prevIdx);
+        blockIdx = prevIdx;
+    }
+
+    this->insertFreeBlock(blockIdx);
+}
+
+void TlsfAllocator::grow(uint64_t newSizeBytes)
+{
+#ifdef _DEBUG
+    if (newSizeBytes < this->sizeBytes)
+    {
+        throw std::runtime_error("Attempting to grow TlsfAllocator to a smaller size");
+    }
+#endif
+
+    const uint64_t diffSizeBytes = newSizeBytes - this->sizeBytes;
+    if (diffSizeBytes == 0)
+    {
+        return;
+    }
+
+    const uint64_t oldSizeBytes = this->sizeBytes;
+    this->sizeBytes = newSizeBytes;
+
+    if (this->lastPhysIdx != INVALID_BLOCK_IDX && this->blocks[this->lastPhysIdx].isFree)
+    {
+        const uint32_t lastIdx = this->lastPhysIdx;
+        this->removeFreeBlock(lastIdx);
+        this->blocks[lastIdx].sizeBytes += diffSizeBytes;
+        this->insertFreeBlock(lastIdx);
+        return;
+    }
+
+    const uint32_t newIdx = this->createBlock(oldSizeBytes, diffSizeBytes);
+    this->blocks[newIdx].prevPhysIdx = this->lastPhysIdx;
+    if (this->lastPhysIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[this->lastPhysIdx].nextPhysIdx = newIdx;
+    }
+    else
+    {
+        this->firstPhysIdx = newIdx;
+    }
+    this->lastPhysIdx = newIdx;
+
+    this->insertFreeBlock(newIdx);
+}
+
+bool TlsfAllocator::shrink(uint64_t newSizeBytes)
+{
+    const uint64_t diffSizeBytes = this->sizeBytes - newSizeBytes;
+    if (newSizeBytes > this->sizeBytes || this->getTailFreeSizeBytes() < diffSizeBytes)
+    {
+        return false;
+    }
+
+    if (diffSizeBytes == 0)
+    {
+        return true;
+    }
+
+    const uint32_t lastIdx = this->lastPhysIdx;
+    this->removeFreeBlock(lastIdx);
+    this->sizeBytes = newSizeBytes;
+
+    if (this->blocks[lastIdx].sizeBytes > diffSizeBytes)
+    {
+        this->blocks[lastIdx].sizeBytes -= diffSizeBytes;
+        this->insertFreeBlock(lastIdx);
+        return true;
+    }
+
+    const uint32_t prevIdx = this->blocks[lastIdx].prevPhysIdx;
+    if (prevIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[prevIdx].nextPhysIdx = INVALID_BLOCK_IDX;
+    }
+    else
+    {
+        this->firstPhysIdx = INVALID_BLOCK_IDX;
+    }
+    this->lastPhysIdx = prevIdx;
+    this->destroyBlock(lastIdx);
+
+    return true;
+}
+
+uint64_t TlsfAllocator::slideBlockDown(uint32_t blockIdx)
+{
+    const uint32_t freeIdx = this->blocks[blockIdx].prevPhysIdx;
+
+#ifdef _DEBUG
+    if (this->blocks[blockIdx].isFree || freeIdx == INVALID_BLOCK_IDX || !this->blocks[freeIdx].isFree)
+    {
+        throw std::runtime_error("Attempting to slide TlsfAllocator block that has no free block in front of it");
+    }
+#endif
+
+    this->removeFreeBlock(freeIdx);
+
+    Block& block = this->blocks[blockIdx];
+    Block& freeBlock = this->blocks[freeIdx];
+
+    // swap the two blocks' physical positions: [prev] [free] [block] [next] -> [prev] [block] [free] [next]
+    const uint32_t prevIdx = freeBlock.prevPhysIdx;
+    const uint32_t nextIdx = block.nextPhysIdx;
+
+    block.offsetBytes = freeBlock.offsetBytes;
+    freeBlock.offsetBytes = block.offsetBytes + block.sizeBytes;
+
+    block.prevPhysIdx = prevIdx;
+    block.nextPhysIdx = freeIdx;
+    freeBlock.prevPhysIdx = blockIdx;
+    freeBlock.nextPhysIdx = nextIdx;
+
+    if (prevIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[prevIdx].nextPhysIdx = blockIdx;
+    }
+    else
+    {
+        this->firstPhysIdx = blockIdx;
+    }
+
+    if (nextIdx != INVALID_BLOCK_IDX)
+    {
+        this->blocks[nextIdx].prevPhysIdx = freeIdx;
+    }
+    else
+    {
+        this->lastPhysIdx = freeIdx;
+    }
+
+    if (nextIdx != INVALID_BLOCK_IDX && this->blocks[nextIdx].isFree)
+    {
+        this->removeFreeBlock(nextIdx);
+        this->mergeWithNext(freeIdx);
+    }
+
+    this->insertFreeBlock(freeIdx);
+
+    return this->blocks[blockIdx].offsetBytes;
+}
+
+void TlsfAllocator::setBlockUserData(uint32_t blockIdx, uint32_t userData)
+{
+    this->blocks[blockIdx].userData = userData;
+}
+
+uint32_t TlsfAllocator::getFirstBlockIdx() const
+{
+    return this->firstPhysIdx;
+}
+
+TlsfAllocator::BlockInfo TlsfAllocator::getBlockInfo(uint32_t blockIdx) const
+{
+    const Block& block = this->blocks[blockIdx];
+    return { block.offsetBytes, block.sizeBytes, block.nextPhysIdx, block.userData, block.isFree };
+}
+
+uint64_t TlsfAllocator::getSizeBytes() const
+{
+    return this->sizeBytes;
+}
+
+uint64_t TlsfAllocator::getUsedBytes() const
+{
+    return this->usedBytes;
+}
+
+uint64_t TlsfAllocator::getFreeBytes() const
+{
+    return this->sizeBytes - this->usedBytes;
+}
+
+uint64_t TlsfAllocator::getTailFreeSizeBytes() const
+{
+    if (this->lastPhysIdx == INVALID_BLOCK_IDX || !this->blocks[this->lastPhysIdx].isFree)
+    {
+        return 0;
+    }
+
+    return this->blocks[this->lastPhysIdx].sizeBytes;
+}
+
+uint32_t TlsfAllocator::getNumUsedBlocks() const
+{
+    return static_cast<uint32_t>(this->blocks.size() - this->unusedBlockIdxs.size()) - this->numFreeBlocks;
+}
+
+uint32_t TlsfAllocator::getNumFreeBlocks() const
+{
+    return this->numFreeBlocks;
+}
+
+uint64_t TlsfAllocator::getLargestFreeSizeBytes() const
+{
+    if (this->flBitmap == 0)
+    {
+        return 0;
+    }
+
+    const uint32_t fl = std::bit_width(this->flBitmap) - 1;
+    const uint32_t sl = std::bit_width(this->slBitmaps[fl]) - 1;
+
+    uint64_t largestSizeBytes = 0;
+    for (uint32_t blockIdx = this->freeListHeads[fl][sl]; blockIdx != INVALID_BLOCK_IDX;
+         blockIdx = this->blocks[blockIdx].nextFreeIdx)
+    {
+        largestSizeBytes = std::max(largestSizeBytes, this->blocks[blockIdx].sizeBytes);
+    }
+
+    return largestSizeBytes;
+}
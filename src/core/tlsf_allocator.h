@@ -0,0 +1,142 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit allocator ("TLSF: a New Dynamic Memory Allocator for Real-Time Systems", Masmano et al.,
+// 2004). It only hands out offsets into a range owned by someone else, so it works for GPU buffers as well as host
+// memory. Allocation and free are both O(1).
+class TlsfAllocator
+{
+public:
+    static constexpr uint64_t INVALID_OFFSET = ~0ull;
+    static constexpr uint32_t INVALID_BLOCK_IDX = ~0u;
+    static constexpr uint32_t NO_USER_DATA = ~0u;
+
+    struct Allocation
+    {
+        uint64_t offsetBytes{ INVALID_OFFSET };
+        uint64_t sizeBytes{ 0 };
+        uint32_t blockIdx{ INVALID_BLOCK_IDX };
+
+        bool isValid() const
+        {
+            return this->offsetBytes != INVALID_OFFSET;
+        }
+    };
+
+    struct BlockInfo
+    {
+        uint64_t offsetBytes;
+        uint64_t sizeBytes;
+        uint32_t nextPhysIdx;
+        uint32_t userData;
+        bool isFree;
+    };
+
+private:
+    static constexpr uint32_t SL_LOG2 = 4;
+    static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+
+    // leftovers smaller than this stay attached to the allocation instead of becoming their own free block
+    static constexpr uint32_t MIN_SPLIT_SIZE_BYTES = 16;
+
+    struct Block
+    {
+        uint64_t offsetBytes{ 0 };
+        uint64_t sizeBytes{ 0 };
+
+        uint32_t prevPhysIdx{ INVALID_BLOCK_IDX };
+        uint32_t nextPhysIdx{ INVALID_BLOCK_IDX };
+
+        // only valid while the block is free
+        uint32_t prevFreeIdx{ INVALID_BLOCK_IDX };
+        uint32_t nextFreeIdx{ INVALID_BLOCK_IDX };
+
+        uint32_t userData{ NO_USER_DATA };
+        bool isFree{ false };
+    };
+
+    std::vector<Block> blocks;
+    std::vector<uint32_t> unusedBlockIdxs;
+
+    uint64_t flBitmap{ 0 };
+    std::array<uint32_t, FL_COUNT> slBitmaps{};
+    std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> freeListHeads{};
+
+    uint32_t firstPhysIdx{ INVALID_BLOCK_IDX };
+    uint32_t lastPhysIdx{ INVALID_BLOCK_IDX };
+
+    uint32_t numFreeBlocks{ 0 };
+
+    uint64_t sizeBytes{ 0 };
+    uint64_t usedBytes{ 0 };
+
+    static void mappingInsert(uint64_t sizeBytes, uint32_t* fl, uint32_t* sl);
+    static bool mappingSearch(uint64_t sizeBytes, uint32_t* fl, uint32_t* sl);
+
+    uint32_t createBlock(uint64_t offsetBytes, uint64_t sizeBytes);
+    void destroyBlock(uint32_t blockIdx);
+
+    void insertFreeBlock(uint32_t blockIdx);
+    void removeFreeBlock(uint32_t blockIdx);
+    uint32_t findSuitableBlock(uint64_t sizeBytes);
+
+    // splits `blockIdx` so that it is `sizeBytes` long and returns the index of the remainder (or INVALID_BLOCK_IDX)
+    uint32_t splitBlock(uint32_t blockIdx, uint64_t sizeBytes);
+    // merges `nextIdx` into its physical predecessor `blockIdx`
+    void mergeWithNext(uint32_t blockIdx);
+
+public:
+    void init(uint64_t sizeBytes);
+
+    Allocation allocate(uint64_t sizeBytes);
+    void free(uint32_t blockIdx);
+
+    // appends [getSizeBytes(), newSizeBytes) as free space, merging it with a free block at the end if there is one
+    void grow(uint64_t newSizeBytes);
+    // removes [newSizeBytes, getSizeBytes()) from the end; fails if any of that range is in use
+    bool shrink(uint64_t newSizeBytes);
+
+    // Moves a used block down to the start of the free block physically in front of it and returns its new offset.
+    // The free space ends up behind the block. Only bookkeeping is updated; the caller has to move the actual data.
+    uint64_t slideBlockDown(uint32_t blockIdx);
+
+    // arbitrary per-block value for the owner of an allocation, reset to NO_USER_DATA whenever a block is allocated
+    void setBlockUserData(uint32_t blockIdx, uint32_t userData);
+
+    uint32_t getFirstBlockIdx() const;
+    BlockInfo getBlockInfo(uint32_t blockIdx) const;
+
+    uint64_t getSizeBytes() const;
+    uint64_t getUsedBytes() const;
+    uint64_t getFreeBytes() const;
+
+    // size of the free block touching the end of the range, or 0 if the last block is in use
+    uint64_t getTailFreeSizeBytes() const;
+
+    uint32_t getNumUsedBlocks() const;
+    uint32_t getNumFreeBlocks() const;
+    // only scans the free list of the largest size class, so this is cheap enough to call every frame
+    uint64_t getLargestFreeSizeBytes() const;
+};
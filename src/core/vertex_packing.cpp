@@ -0,0 +1,149 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace VertexPacking
+{
+
+static float signNotZero(float value)
+{
+    return value >= 0.f ? 1.f : -1.f;
+}
+
+static uint32_t floatToSnorm16(float value)
+{
+    const float scaled = std::round(std::clamp(value, -1.f, 1.f) * 32767.f);
+    return static_cast<uint32_t>(static_cast<int32_t>(scaled)) & 0xffff;
+}
+
+static float snorm16ToFloat(uint32_t bits)
+{
+    const int16_t value = static_cast<int16_t>(bits & 0xffff);
+    return std::max(value / 32767.f, -1.f);
+}
+
+uint32_t packOctahedralNormal(float x, float y, float z)
+{
+    const float invL1Norm = 1.f / (std::abs(x) + std::abs(y) + std::abs(z));
+    float u = x * invL1Norm;
+    float v = y * invL1Norm;
+
+    // fold the lower hemisphere over the diagonals
+    if (z < 0.f)
+    {
+        const float foldedU = (1.f - std::abs(v)) * signNotZero(u);
+        const float foldedV = (1.f - std::abs(u)) * signNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    return floatToSnorm16(u) | (floatToSnorm16(v) << 16);
+}
+
+void unpackOctahedralNormal(uint32_t packed, float* outXyz)
+{
+    float x = snorm16ToFloat(packed);
+    float y = snorm16ToFloat(packed >> 16);
+    const float z = 1.f - std::abs(x) - std::abs(y);
+
+    const float t = std::max(-z, 0.f);
+    x += x >= 0.f ? -t : t;
+    y += y >= 0.f ? -t : t;
+
+    const float invLength = 1.f / std::sqrt(x * x + y * y + z * z);
+    outXyz[0] = x * invLength;
+    outXyz[1] = y * invLength;
+    outXyz[2] = z * invLength;
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t absBits = bits & 0x7fffffff;
+
+    // infinity or NaN, keeping NaNs quiet
+    if (absBits >= 0x7f800000)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0));
+    }
+
+    // at least halfway between the largest half (65504) and 65536
+    if (absBits >= 0x477ff000)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00);
+    }
+
+    // below the smallest normal half (2^-14), so the result is denormal in units of 2^-24; this scaling is exact and
+    // the default rounding mode rounds to nearest even, possibly up to the smallest normal half
+    if (absBits < 0x38800000)
+    {
+        const float scaled = std::abs(value) * 16777216.f;
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(scaled)));
+    }
+
+    // rebias the exponent from 127 to 15 and round the mantissa, letting a carry bump the exponent
+    uint32_t half = (absBits - 0x38000000) >> 13;
+    const uint32_t remainder = absBits & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        ++half;
+    }
+
+    return static_cast<uint16_t>(sign | half);
+}
+
+float halfToFloat(uint16_t half)
+{
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+
+    if (exponent == 0)
+    {
+        const float magnitude = mantissa / 16777216.f;
+        return sign ? -magnitude : magnitude;
+    }
+
+    const uint32_t bits = exponent == 0x1f ? (sign | 0x7f800000 | (mantissa << 13))
+                                           : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint32_t packHalf2(float x, float y)
+{
+    return floatToHalf(x) | (static_cast<uint32_t>(floatToHalf(y)) << 16);
+}
+
+void unpackHalf2(uint32_t packed, float* outXy)
+{
+    outXy[0] = halfToFloat(static_cast<uint16_t>(packed & 0xffff));
+    outXy[1] = halfToFloat(static_cast<uint16_t>(packed >> 16));
+}
+
+} // namespace VertexPacking
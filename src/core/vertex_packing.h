@@ -0,0 +1,40 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Host-side encoders for the packed vertex attribute formats, matching the decoders in shaders/util/packing.slang.
+namespace VertexPacking
+{
+
+// Octahedral encoding into two snorm16s, x in the low half. The input doesn't have to be normalized, but it must not be
+// zero. Decoded normals are within about 0.05 degrees of the original direction.
+uint32_t packOctahedralNormal(float x, float y, float z);
+void unpackOctahedralNormal(uint32_t packed, float* outXyz);
+
+// IEEE half precision with round-to-nearest-even. Values too large for a half become infinity.
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t half);
+
+// x in the low half
+uint32_t packHalf2(float x, float y);
+void unpackHalf2(uint32_t packed, float* outXy);
+
+} // namespace VertexPacking
@@ -12,6 +12,7 @@ int main()
         {
             if (msg.message == WM_QUIT)
             {
+                Renderer::shutdown();
                 return 0;
             }
 
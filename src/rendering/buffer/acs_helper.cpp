@@ -21,7 +21,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "buffer_helper.h"
 #include "managed_buffer.h"
 #include "to_free_list.h"
+#include "upload_ring.h"
 #include "rendering/renderer.h"
+#include "core/scratch_planner.h"
 #include "util/util.h"
 
 namespace AcsHelper
@@ -29,59 +31,85 @@ namespace AcsHelper
 
 static ComPtr<ID3D12Resource> sharedAcsScratchBuffer = nullptr;
 static uint64_t sharedAsScratchSize = 0;
+static uint64_t scratchBudgetBytes = 64ull * 1024 * 1024;
 
-ComPtr<ID3D12Resource> makeAcsBuffer(uint32_t sizeBytes, D3D12_RESOURCE_STATES initialState)
+static AcsPool acsPool;
+
+ComPtr<ID3D12Resource> makeAcsBuffer(uint64_t sizeBytes, D3D12_RESOURCE_STATES initialState)
 {
-    return BufferHelper::createBasicBuffer(
-        sizeBytes, &DEFAULT_HEAP, initialState, { .resourceFlags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS });
+    return BufferHelper::createBasicBuffer(sizeBytes,
+                                           &DEFAULT_HEAP,
+                                           initialState,
+                                           MemoryTag::SCRATCH,
+                                           { .resourceFlags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS });
 }
 
 struct AcsBuildInfo
 {
-    D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc; // optional, used only for BLAS
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs; // used only for BLAS
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs;
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
-    ComPtr<ID3D12Resource>* outAcs;
+    AcsPoolSection* outAcs;
 };
 
+void ensureSharedScratchSize(ToFreeList& toFreeList, uint64_t scratchSize)
+{
+    if (scratchSize <= sharedAsScratchSize)
+    {
+        return;
+    }
+
+    if (sharedAcsScratchBuffer)
+    {
+        toFreeList.pushResource(sharedAcsScratchBuffer, false);
+    }
+
+    sharedAcsScratchBuffer = makeAcsBuffer(scratchSize, D3D12_RESOURCE_STATE_COMMON);
+    sharedAsScratchSize = scratchSize;
+}
+
 void makeAccelerationStructures(ID3D12GraphicsCommandList4* cmdList,
                                 ToFreeList& toFreeList,
                                 const std::vector<AcsBuildInfo>& buildInfos)
 {
-    uint64_t maxScratchSize = 0;
-    for (const auto& buildInfo : buildInfos)
+    if (buildInfos.empty())
     {
-        maxScratchSize = std::max(buildInfo.prebuildInfo.ScratchDataSizeInBytes, maxScratchSize);
+        return;
     }
 
-    if (maxScratchSize > sharedAsScratchSize)
+    std::vector<uint64_t> scratchSizes;
+    scratchSizes.reserve(buildInfos.size());
+    for (const auto& buildInfo : buildInfos)
     {
-        if (sharedAcsScratchBuffer)
-        {
-            toFreeList.pushResource(sharedAcsScratchBuffer, false);
-        }
-
-        sharedAcsScratchBuffer = makeAcsBuffer(maxScratchSize, D3D12_RESOURCE_STATE_COMMON);
-        sharedAsScratchSize = maxScratchSize;
+        scratchSizes.push_back(buildInfo.prebuildInfo.ScratchDataSizeInBytes);
     }
 
-    for (uint32_t i = 0; i < buildInfos.size(); ++i)
+    const std::vector<ScratchPlanner::Batch> batches = ScratchPlanner::planBatches(
+        scratchSizes, scratchBudgetBytes, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+
+    ensureSharedScratchSize(toFreeList, ScratchPlanner::getRequiredScratchSize(batches));
+
+    const D3D12_GPU_VIRTUAL_ADDRESS scratchAddress = sharedAcsScratchBuffer->GetGPUVirtualAddress();
+    for (uint32_t batchIdx = 0; batchIdx < batches.size(); ++batchIdx)
     {
-        const auto& buildInfo = buildInfos[i];
+        // builds within a batch use disjoint scratch ranges and don't depend on each other
+        for (const ScratchPlanner::Placement& placement : batches[batchIdx].placements)
+        {
+            const auto& buildInfo = buildInfos[placement.buildIdx];
 
-        *buildInfo.outAcs = makeAcsBuffer(buildInfo.prebuildInfo.ResultDataMaxSizeInBytes,
-                                          D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
+            *buildInfo.outAcs = acsPool.allocate(buildInfo.prebuildInfo.ResultDataMaxSizeInBytes);
 
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {
-            .DestAccelerationStructureData = (*buildInfo.outAcs)->GetGPUVirtualAddress(),
-            .Inputs = buildInfo.inputs,
-            .ScratchAccelerationStructureData = sharedAcsScratchBuffer->GetGPUVirtualAddress()
-        };
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {
+                .DestAccelerationStructureData = buildInfo.outAcs->getGpuAddress(),
+                .Inputs = buildInfo.inputs,
+                .ScratchAccelerationStructureData = scratchAddress + placement.scratchOffsetBytes
+            };
 
-        cmdList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+            cmdList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+        }
 
-        // The caller is responsible for enforcing a barrier for the last build if necessary.
-        if (i < buildInfos.size() - 1)
+        // The caller is responsible for enforcing a barrier for the last batch if necessary.
+        if (batchIdx < batches.size() - 1)
         {
             BufferHelper::uavBarrier(cmdList, sharedAcsScratchBuffer.Get());
         }
@@ -89,38 +117,55 @@ void makeAccelerationStructures(ID3D12GraphicsCommandList4* cmdList,
 }
 
 void makeBlasBuildInfo(AcsBuildInfo* buildInfo,
-                       ComPtr<ID3D12Resource>* outBlas,
-                       ManagedBufferSection vertsBufferSection,
-                       ManagedBufferSection idxsBufferSection)
+                       AcsPoolSection* outBlas,
+                       const UploadRingSection& positionsBufferSection,
+                       const UploadRingSection& idxsBufferSection,
+                       DXGI_FORMAT idxFormat,
+                       const std::vector<GeometryRange>& ranges,
+                       bool preferFastBuild,
+                       bool allowCompaction)
 {
-    const bool hasIdxs = (idxsBufferSection.sizeBytes > 0);
-
-    buildInfo->geometryDesc = {
-        .Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
-        .Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE,
-
-        .Triangles = {
-            .Transform3x4 = 0,
-            .IndexFormat = hasIdxs ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_UNKNOWN,
-            .VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT,
-            .IndexCount = Util::convertByteSizeToCount<uint32_t>(idxsBufferSection.sizeBytes),
-            .VertexCount = Util::convertByteSizeToCount<Vertex>(vertsBufferSection.sizeBytes),
-            .IndexBuffer = hasIdxs ? idxsBufferSection.getBuffer()->getBufferGpuAddress() + idxsBufferSection.offsetBytes : 0,
-            .VertexBuffer = {
-                .StartAddress = vertsBufferSection.getBuffer()->getBufferGpuAddress() + vertsBufferSection.offsetBytes,
-                .StrideInBytes = sizeof(Vertex),
+    const uint64_t idxSizeBytes = idxFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    buildInfo->geometryDescs.reserve(ranges.size());
+    for (const GeometryRange& range : ranges)
+    {
+        const bool hasIdxs = range.numIdxs > 0;
+
+        buildInfo->geometryDescs.push_back({
+            .Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
+            .Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE,
+
+            .Triangles = {
+                .Transform3x4 = 0,
+                .IndexFormat = hasIdxs ? idxFormat : DXGI_FORMAT_UNKNOWN,
+                .VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT,
+                .IndexCount = range.numIdxs,
+                .VertexCount = range.numVerts,
+                .IndexBuffer = hasIdxs ? idxsBufferSection.getGpuAddress() + range.firstIdx * idxSizeBytes : 0,
+                .VertexBuffer = {
+                    .StartAddress =
+                        positionsBufferSection.getGpuAddress() + range.firstVert * sizeof(DirectX::XMFLOAT3),
+                    .StrideInBytes = sizeof(DirectX::XMFLOAT3),
+                },
             },
-        },
-    };
+        });
+    }
 
     buildInfo->inputs = {
         .Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
-        .Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
-        .NumDescs = 1,
+        .Flags = preferFastBuild ? D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD
+                                 : D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
+        .NumDescs = static_cast<uint32_t>(buildInfo->geometryDescs.size()),
         .DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY,
-        .pGeometryDescs = &buildInfo->geometryDesc,
+        .pGeometryDescs = buildInfo->geometryDescs.data(),
     };
 
+    if (allowCompaction)
+    {
+        buildInfo->inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+    }
+
     Renderer::device->GetRaytracingAccelerationStructurePrebuildInfo(&buildInfo->inputs, &buildInfo->prebuildInfo);
 
     buildInfo->outAcs = outBlas;
@@ -128,88 +173,84 @@ void makeBlasBuildInfo(AcsBuildInfo* buildInfo,
 
 void makeBlases(ID3D12GraphicsCommandList4* cmdList,
                 ToFreeList& toFreeList,
+                UploadRing& uploadRing,
                 const std::vector<BlasBuildInputs>& allInputs)
 {
-    ManagedBuffer vertsUploadBuffer{
-        &UPLOAD_HEAP,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        false /*isResizable*/,
-        true /*isMapped*/,
-    };
-    ManagedBuffer idxsUploadBuffer{
-        &UPLOAD_HEAP,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        false /*isResizable*/,
-        true /*isMapped*/,
-    };
-
-    uint32_t vertBufferTotalSizeBytes = 0;
-    uint32_t idxBufferTotalSizeBytes = 0;
-    for (const auto& inputs : allInputs)
-    {
-        vertBufferTotalSizeBytes += Util::getVectorSizeBytes(*inputs.host_verts);
-        if (inputs.host_idxs)
-        {
-            idxBufferTotalSizeBytes += Util::getVectorSizeBytes(*inputs.host_idxs);
-        }
-    }
-
-    vertsUploadBuffer.init(vertBufferTotalSizeBytes);
-    const bool anyHasIdxs = (idxBufferTotalSizeBytes > 0);
-    if (anyHasIdxs)
-    {
-        idxsUploadBuffer.init(idxBufferTotalSizeBytes);
-    }
-
     std::vector<AcsBuildInfo> buildInfos;
     buildInfos.reserve(allInputs.size());
 
     for (const auto& inputs : allInputs)
     {
-        const ManagedBufferSection vertsUploadBufferSection =
-            vertsUploadBuffer.copyFromHostVector(cmdList, toFreeList, *inputs.host_verts);
+        const StagedGeometryStreams* staged = inputs.staged;
 
-        if (inputs.dev_verts)
+        const UploadRingSection positionsUploadSection =
+            staged ? staged->positions : uploadRing.copyFromHostVector(toFreeList, *inputs.host_positions);
+
+        if ((staged || inputs.host_vertAttribs) && inputs.dev_vertAttribs)
+        {
+            const UploadRingSection vertAttribsUploadSection =
+                staged ? staged->vertAttribs : uploadRing.copyFromHostVector(toFreeList, *inputs.host_vertAttribs);
+            inputs.outGeoWrapper->vertAttribsBufferSection =
+                inputs.dev_vertAttribs->copyFromDeviceBuffer(cmdList,
+                                                             toFreeList,
+                                                             vertAttribsUploadSection.buffer,
+                                                             vertAttribsUploadSection.sizeBytes,
+                                                             vertAttribsUploadSection.offsetBytes);
+        }
+
+        UploadRingSection idxsUploadSection = {};
+        DXGI_FORMAT idxFormat = DXGI_FORMAT_R32_UINT;
+        if (staged)
+        {
+            idxsUploadSection = staged->idxs;
+            idxFormat = staged->idxFormat;
+        }
+        else if (inputs.host_idxs16)
+        {
+            idxsUploadSection = uploadRing.copyFromHostVector(toFreeList, *inputs.host_idxs16);
+            idxFormat = DXGI_FORMAT_R16_UINT;
+        }
+        else if (inputs.host_idxs)
         {
-            inputs.outGeoWrapper->vertsBufferSection = inputs.dev_verts->copyFromManagedBuffer(
-                cmdList, toFreeList, vertsUploadBuffer, vertsUploadBufferSection);
+            idxsUploadSection = uploadRing.copyFromHostVector(toFreeList, *inputs.host_idxs);
         }
 
-        ManagedBufferSection idxsUploadBufferSection = {};
-        if (inputs.host_idxs)
+        if (idxsUploadSection.sizeBytes > 0 && inputs.dev_idxs)
         {
-            idxsUploadBufferSection = idxsUploadBuffer.copyFromHostVector(cmdList, toFreeList, *inputs.host_idxs);
+            inputs.outGeoWrapper->idxsBufferSection =
+                inputs.dev_idxs->copyFromDeviceBuffer(cmdList,
+                                                      toFreeList,
+                                                      idxsUploadSection.buffer,
+                                                      idxsUploadSection.sizeBytes,
+                                                      idxsUploadSection.offsetBytes);
+        }
 
-            if (inputs.dev_idxs)
-            {
-                inputs.outGeoWrapper->idxsBufferSection = inputs.dev_idxs->copyFromManagedBuffer(
-                    cmdList, toFreeList, idxsUploadBuffer, idxsUploadBufferSection);
-            }
+        std::vector<GeometryRange> wholeRange;
+        if (inputs.ranges == nullptr)
+        {
+            wholeRange.push_back({
+                .numVerts = static_cast<uint32_t>(inputs.host_positions->size()),
+                .numIdxs = inputs.host_idxs ? static_cast<uint32_t>(inputs.host_idxs->size()) : 0,
+            });
         }
 
         buildInfos.emplace_back();
         makeBlasBuildInfo(&buildInfos.back(),
                           &inputs.outGeoWrapper->dev_blas,
-                          vertsUploadBufferSection,
-                          idxsUploadBufferSection);
+                          positionsUploadSection,
+                          idxsUploadSection,
+                          idxFormat,
+                          inputs.ranges ? *inputs.ranges : wholeRange,
+                          inputs.preferFastBuild,
+                          inputs.allowCompaction);
     }
 
     makeAccelerationStructures(cmdList, toFreeList, buildInfos);
-
-    toFreeList.pushManagedBuffer(&vertsUploadBuffer);
-    if (anyHasIdxs)
-    {
-        toFreeList.pushManagedBuffer(&idxsUploadBuffer);
-    }
 }
 
-void makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const TlasBuildInputs& inputs)
+D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS makeTlasInputs(const TlasBuildInputs& inputs, bool allowUpdates)
 {
-    AcsBuildInfo buildInfo;
-
-    const bool allowUpdates = (inputs.updateScratchSizePtr != nullptr);
-
-    buildInfo.inputs = {
+    return {
         .Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL,
         .Flags = allowUpdates ? D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE
                               : D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
@@ -217,6 +258,15 @@ void makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const
         .DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY,
         .InstanceDescs = inputs.dev_instanceDescs->GetGPUVirtualAddress(),
     };
+}
+
+void makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const TlasBuildInputs& inputs)
+{
+    AcsBuildInfo buildInfo;
+
+    const bool allowUpdates = (inputs.updateScratchSizePtr != nullptr);
+
+    buildInfo.inputs = makeTlasInputs(inputs, allowUpdates);
 
     Renderer::device->GetRaytracingAccelerationStructurePrebuildInfo(&buildInfo.inputs, &buildInfo.prebuildInfo);
 
@@ -230,4 +280,53 @@ void makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const
     makeAccelerationStructures(cmdList, toFreeList, { buildInfo });
 }
 
+void updateTlas(ID3D12GraphicsCommandList4* cmdList,
+                ToFreeList& toFreeList,
+                const TlasBuildInputs& inputs,
+                uint64_t updateScratchSize)
+{
+    ensureSharedScratchSize(toFreeList, updateScratchSize);
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS tlasInputs = makeTlasInputs(inputs, true /*allowUpdates*/);
+    tlasInputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+
+    const D3D12_GPU_VIRTUAL_ADDRESS tlasAddress = inputs.outTlas->getGpuAddress();
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {
+        .DestAccelerationStructureData = tlasAddress,
+        .Inputs = tlasInputs,
+        .SourceAccelerationStructureData = tlasAddress,
+        .ScratchAccelerationStructureData = sharedAcsScratchBuffer->GetGPUVirtualAddress()
+    };
+
+    cmdList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+}
+
+AcsPoolSection compactBlas(ID3D12GraphicsCommandList4* cmdList,
+                           const AcsPoolSection& blas,
+                           uint64_t compactedSizeBytes)
+{
+    const AcsPoolSection compactedBlas = acsPool.allocate(compactedSizeBytes);
+
+    cmdList->CopyRaytracingAccelerationStructure(compactedBlas.getGpuAddress(),
+                                                 blas.getGpuAddress(),
+                                                 D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+    return compactedBlas;
+}
+
+void setScratchBudgetBytes(uint64_t budgetBytes)
+{
+    scratchBudgetBytes = budgetBytes;
+}
+
+const PagedAllocator::Stats& getAcsPoolStats()
+{
+    return acsPool.getStats();
+}
+
+void reportMemoryPools(MemoryRegistry& memoryRegistry)
+{
+    memoryRegistry.setPoolStats("accelerationStructures", acsPool.getPoolStats());
+}
+
 } // namespace AcsHelper
@@ -22,45 +22,95 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <vector>
 
+#include "acs_pool.h"
 #include "managed_buffer.h"
+#include "staging_buffer.h"
 
 class ToFreeList;
+class UploadRing;
 
 namespace AcsHelper
 {
 
 struct GeometryWrapper
 {
-    ComPtr<ID3D12Resource> dev_blas{ nullptr };
+    AcsPoolSection dev_blas{};
 
-    ManagedBufferSection vertsBufferSection{};
+    ManagedBufferSection vertAttribsBufferSection{};
     ManagedBufferSection idxsBufferSection{};
 };
 
+// A range of a BLAS's vertices and indices that becomes one of its geometry descs, and therefore one GeometryIndex()
+// in hit shaders. Indices are relative to `firstVert`; a range with no indices is a plain triangle list.
+struct GeometryRange
+{
+    uint32_t firstVert{ 0 };
+    uint32_t numVerts{ 0 };
+    uint32_t firstIdx{ 0 };
+    uint32_t numIdxs{ 0 };
+};
+
 struct BlasBuildInputs
 {
-    const std::vector<Vertex>* host_verts{ nullptr };
+    const std::vector<DirectX::XMFLOAT3>* host_positions{ nullptr };
+    // not needed for the build, only copied to `dev_vertAttribs` if both are set
+    const std::vector<VertexAttributes>* host_vertAttribs{ nullptr };
     const std::vector<uint32_t>* host_idxs{ nullptr };
-
-    ManagedBuffer* dev_verts{ nullptr };
+    // used instead of host_idxs if set; may end with a padding index, so this needs `ranges`
+    const std::vector<uint16_t>* host_idxs16{ nullptr };
+    // if null, the whole of host_positions and host_idxs is a single geometry
+    const std::vector<GeometryRange>* ranges{ nullptr };
+    // Used instead of all of the host vectors if set, in which case `ranges` is needed. Staged streams are already in
+    // upload memory, so they're read in place rather than copied to the UploadRing first.
+    const StagedGeometryStreams* staged{ nullptr };
+
+    ManagedBuffer* dev_vertAttribs{ nullptr };
     ManagedBuffer* dev_idxs{ nullptr };
 
     GeometryWrapper* outGeoWrapper{ nullptr };
+
+    // PREFER_FAST_BUILD instead of PREFER_FAST_TRACE, for geometry that is replaced often
+    bool preferFastBuild{ false };
+    // lets BlasCompactor shrink the BLAS later, at the cost of a slightly slower build
+    bool allowCompaction{ false };
 };
 
 void makeBlases(ID3D12GraphicsCommandList4* cmdList,
                 ToFreeList& toFreeList,
+                UploadRing& uploadRing,
                 const std::vector<BlasBuildInputs>& allInputs);
 
 struct TlasBuildInputs
 {
     ID3D12Resource* dev_instanceDescs{ nullptr };
     uint32_t numInstances{ 0 };
-    uint32_t* updateScratchSizePtr{ nullptr };
+    // if set, the TLAS is built with ALLOW_UPDATE and this receives the scratch size needed by updateTlas()
+    uint64_t* updateScratchSizePtr{ nullptr };
 
-    ComPtr<ID3D12Resource>* outTlas{ nullptr };
+    AcsPoolSection* outTlas{ nullptr };
 };
 
 void makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const TlasBuildInputs& inputs);
 
+// Refits `*inputs.outTlas` in place. It must have been built by makeTlas() with `updateScratchSizePtr` set and the
+// same number of instances; only the instance descs' contents may change. The caller needs a UAV barrier afterwards.
+void updateTlas(ID3D12GraphicsCommandList4* cmdList,
+                ToFreeList& toFreeList,
+                const TlasBuildInputs& inputs,
+                uint64_t updateScratchSize);
+
+// Copies a BLAS built with `allowCompaction` into a new section of `compactedSizeBytes`, as reported by its compacted
+// size postbuild info. The caller frees the old section and needs a UAV barrier before the new one is used.
+AcsPoolSection compactBlas(ID3D12GraphicsCommandList4* cmdList,
+                           const AcsPoolSection& blas,
+                           uint64_t compactedSizeBytes);
+
+// Builds submitted together share one scratch buffer, split into disjoint ranges so that independent builds only need
+// a barrier between batches. This caps the scratch memory of a batch; a single build that needs more gets its own
+// batch, and the scratch buffer grows to fit it.
+void setScratchBudgetBytes(uint64_t budgetBytes);
+
+const PagedAllocator::Stats& getAcsPoolStats();
+void reportMemoryPools(MemoryRegistry& memoryRegistry);
+
 }  // namespace AcsHelper
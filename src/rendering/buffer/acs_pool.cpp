@@ -0,0 +1,113 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "acs_pool.h"
+
+#include "buffer_helper.h"
+#include "rendering/dxr_common.h"
+
+#include <stdexcept>
+
+bool AcsPoolSection::isValid() const
+{
+    return this->allocation.isValid();
+}
+
+AcsPool* AcsPoolSection::getPool() const
+{
+    return this->pool;
+}
+
+ID3D12Resource* AcsPoolSection::getBuffer() const
+{
+    return this->pool->getPageBuffer(this->allocation.pageIdx);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS AcsPoolSection::getGpuAddress() const
+{
+    return this->getBuffer()->GetGPUVirtualAddress() + this->allocation.offsetBytes;
+}
+
+uint64_t AcsPoolSection::getSizeBytes() const
+{
+    return this->allocation.sizeBytes;
+}
+
+AcsPoolSection AcsPool::allocate(uint64_t sizeBytes)
+{
+    uint32_t newPageIdx;
+    AcsPoolSection section;
+    section.pool = this;
+    section.allocation = this->allocator.allocate(sizeBytes, &newPageIdx);
+
+    if (newPageIdx != PagedAllocator::INVALID_PAGE_IDX)
+    {
+        if (newPageIdx >= this->dev_pages.size())
+        {
+            this->dev_pages.resize(newPageIdx + 1);
+        }
+
+        this->dev_pages[newPageIdx] =
+            BufferHelper::createBasicBuffer(this->allocator.getPageSizeBytes(newPageIdx),
+                                            &DEFAULT_HEAP,
+                                            D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
+                                            MemoryTag::ACCELERATION_STRUCTURES,
+                                            { .resourceFlags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS });
+    }
+
+    return section;
+}
+
+void AcsPool::freeSection(const AcsPoolSection& section)
+{
+#ifdef _DEBUG
+    if (section.pool != this)
+    {
+        throw std::runtime_error("Attempting to free AcsPoolSection from wrong AcsPool");
+    }
+#endif
+
+    // sections are only freed once the GPU is done with them, so the page can be released right away
+    if (this->allocator.free(section.allocation))
+    {
+        this->dev_pages[section.allocation.pageIdx] = nullptr;
+    }
+}
+
+ID3D12Resource* AcsPool::getPageBuffer(uint32_t pageIdx) const
+{
+    return this->dev_pages[pageIdx].Get();
+}
+
+const PagedAllocator::Stats& AcsPool::getStats() const
+{
+    return this->allocator.getStats();
+}
+
+MemoryPoolStats AcsPool::getPoolStats() const
+{
+    const PagedAllocator::Stats& stats = this->allocator.getStats();
+    return {
+        .capacityBytes = stats.reservedBytes,
+        .usedBytes = stats.usedBytes,
+        .peakUsedBytes = stats.peakUsedBytes,
+        .largestFreeRangeBytes = this->allocator.getLargestFreeSizeBytes(),
+        .numAllocations = stats.numAllocations,
+        .numFreeRanges = this->allocator.getNumFreeRanges(),
+    };
+}
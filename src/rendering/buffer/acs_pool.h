@@ -0,0 +1,66 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/memory_registry.h"
+#include "core/paged_allocator.h"
+#include "rendering/dxr_includes.h"
+
+#include <vector>
+
+class AcsPool;
+
+struct AcsPoolSection
+{
+    friend class AcsPool;
+
+private:
+    AcsPool* pool{ nullptr };
+    PagedAllocator::Allocation allocation{};
+
+public:
+    bool isValid() const;
+
+    AcsPool* getPool() const;
+    ID3D12Resource* getBuffer() const;
+    D3D12_GPU_VIRTUAL_ADDRESS getGpuAddress() const;
+    uint64_t getSizeBytes() const;
+};
+
+// Places acceleration structures in large shared buffers instead of giving each one its own committed resource.
+class AcsPool
+{
+    friend class ToFreeList;
+
+private:
+    static constexpr uint32_t PAGE_SIZE_BYTES = 32 * 1024 * 1024;
+
+    PagedAllocator allocator{ PAGE_SIZE_BYTES, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT };
+    std::vector<ComPtr<ID3D12Resource>> dev_pages;
+
+    void freeSection(const AcsPoolSection& section);
+
+public:
+    AcsPoolSection allocate(uint64_t sizeBytes);
+
+    ID3D12Resource* getPageBuffer(uint32_t pageIdx) const;
+
+    const PagedAllocator::Stats& getStats() const;
+    MemoryPoolStats getPoolStats() const;
+};
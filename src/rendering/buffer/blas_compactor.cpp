@@ -0,0 +1,150 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "blas_compactor.h"
+
+#include "acs_helper.h"
+#include "buffer_helper.h"
+#include "to_free_list.h"
+#include "rendering/dxr_common.h"
+
+#include <cstring>
+
+void BlasCompactor::queueSizeQueries(ID3D12GraphicsCommandList4* cmdList,
+                                     ToFreeList& toFreeList,
+                                     std::vector<Request>&& requests)
+{
+    if (requests.empty())
+    {
+        return;
+    }
+
+    const uint64_t sizesSizeBytes = requests.size() * sizeof(uint64_t);
+
+    // postbuild info can only be written to a UAV, so it takes a trip through a device buffer
+    ComPtr<ID3D12Resource> dev_sizes =
+        BufferHelper::createBasicBuffer(sizesSizeBytes,
+                                        &DEFAULT_HEAP,
+                                        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                        MemoryTag::SCRATCH,
+                                        { .resourceFlags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS });
+    toFreeList.pushResource(dev_sizes, false);
+
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> blasAddresses;
+    blasAddresses.reserve(requests.size());
+    for (const Request& request : requests)
+    {
+        blasAddresses.push_back(request.blas.getGpuAddress());
+    }
+
+    const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfoDesc = {
+        .DestBuffer = dev_sizes->GetGPUVirtualAddress(),
+        .InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE,
+    };
+    cmdList->EmitRaytracingAccelerationStructurePostbuildInfo(
+        &postbuildInfoDesc, static_cast<UINT>(blasAddresses.size()), blasAddresses.data());
+
+    QueryBatch& batch = this->queryBatches.emplace_back();
+    batch.dev_readback = BufferHelper::createBasicBuffer(
+        sizesSizeBytes, &READBACK_HEAP, D3D12_RESOURCE_STATE_COPY_DEST, MemoryTag::READBACK);
+    batch.requests = std::move(requests);
+
+    BufferHelper::stateTransitionResourceBarrier(
+        cmdList, dev_sizes.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    cmdList->CopyBufferRegion(batch.dev_readback.Get(), 0, dev_sizes.Get(), 0, sizesSizeBytes);
+}
+
+void BlasCompactor::submit(uint64_t fenceValue)
+{
+    for (QueryBatch& batch : this->queryBatches)
+    {
+        if (!batch.isSubmitted)
+        {
+            batch.fenceValue = fenceValue;
+            batch.isSubmitted = true;
+        }
+    }
+}
+
+void BlasCompactor::reclaim(uint64_t completedFenceValue)
+{
+    // batches are submitted in order, so the completed ones are all at the front
+    auto firstPendingBatchIt = this->queryBatches.begin();
+    for (; firstPendingBatchIt != this->queryBatches.end(); ++firstPendingBatchIt)
+    {
+        QueryBatch& batch = *firstPendingBatchIt;
+        if (!batch.isSubmitted || batch.fenceValue > completedFenceValue)
+        {
+            break;
+        }
+
+        const D3D12_RANGE readRange = { 0, batch.requests.size() * sizeof(uint64_t) };
+        void* host_sizes;
+        batch.dev_readback->Map(0, &readRange, &host_sizes);
+
+        for (uint32_t requestIdx = 0; requestIdx < batch.requests.size(); ++requestIdx)
+        {
+            Result& result = this->readyResults.emplace_back();
+            result.request = batch.requests[requestIdx];
+            memcpy(&result.compactedSizeBytes,
+                   static_cast<const uint8_t*>(host_sizes) + requestIdx * sizeof(uint64_t),
+                   sizeof(uint64_t));
+        }
+
+        const D3D12_RANGE writtenRange = { 0, 0 };
+        batch.dev_readback->Unmap(0, &writtenRange);
+    }
+
+    this->queryBatches.erase(this->queryBatches.begin(), firstPendingBatchIt);
+}
+
+std::vector<BlasCompactor::Result> BlasCompactor::takeReadyResults()
+{
+    return std::move(this->readyResults);
+}
+
+AcsPoolSection BlasCompactor::compact(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const Result& result)
+{
+    const AcsPoolSection& blas = result.request.blas;
+    const AcsPoolSection compactedBlas = AcsHelper::compactBlas(cmdList, blas, result.compactedSizeBytes);
+
+    ++this->stats.numCompacted;
+    this->stats.originalBytes += blas.getSizeBytes();
+    this->stats.compactedBytes += compactedBlas.getSizeBytes();
+
+    toFreeList.pushAcsPoolSection(blas);
+    return compactedBlas;
+}
+
+void BlasCompactor::clear(ToFreeList& toFreeList)
+{
+    // queries that are still in flight write to their readback buffers until the GPU catches up
+    for (const QueryBatch& batch : this->queryBatches)
+    {
+        toFreeList.pushResource(batch.dev_readback, false);
+    }
+
+    this->queryBatches.clear();
+    this->readyResults.clear();
+}
+
+const BlasCompactor::Stats& BlasCompactor::getStats() const
+{
+    return this->stats;
+}
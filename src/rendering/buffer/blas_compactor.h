@@ -0,0 +1,91 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "acs_pool.h"
+#include "rendering/dxr_includes.h"
+
+#include <vector>
+
+class ToFreeList;
+
+// Shrinks BLASes that were built with AcsHelper::BlasBuildInputs::allowCompaction. Each one goes through
+//   build -> query (compacted size copied to a readback buffer) -> compact (once the query's fence has completed, copy
+//   into a right-sized section) -> retire (the original section goes to a ToFreeList)
+// Only the owner of a BLAS knows whether it's still in use by the time its size is known, so the owner picks up the
+// results of takeReadyResults() and decides which ones to pass to compact().
+class BlasCompactor
+{
+public:
+    struct Request
+    {
+        uint32_t ownerId;
+        // tells BLASes apart when an owner ID is reused after its previous BLAS was freed
+        uint64_t buildIdx;
+        AcsPoolSection blas;
+    };
+
+    struct Result
+    {
+        Request request;
+        uint64_t compactedSizeBytes;
+    };
+
+    struct Stats
+    {
+        uint32_t numCompacted{ 0 };
+        uint64_t originalBytes{ 0 };
+        uint64_t compactedBytes{ 0 };
+    };
+
+private:
+    struct QueryBatch
+    {
+        std::vector<Request> requests;
+        ComPtr<ID3D12Resource> dev_readback{ nullptr };
+        uint64_t fenceValue{ 0 };
+        bool isSubmitted{ false };
+    };
+
+    std::vector<QueryBatch> queryBatches;
+    std::vector<Result> readyResults;
+
+    Stats stats{};
+
+public:
+    // Records compacted size queries for BLASes whose builds were recorded earlier in `cmdList`. There has to be a UAV
+    // barrier between those builds and this call.
+    void queueSizeQueries(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, std::vector<Request>&& requests);
+
+    void submit(uint64_t fenceValue);
+    // reads back the sizes of all queries whose fence has completed
+    void reclaim(uint64_t completedFenceValue);
+
+    std::vector<Result> takeReadyResults();
+
+    // Returns the compacted copy of `result`'s BLAS and retires the original through `toFreeList`. The caller needs a
+    // UAV barrier before using the new BLAS.
+    AcsPoolSection compact(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, const Result& result);
+
+    // drops every query, for when all BLASes are being freed anyway
+    void clear(ToFreeList& toFreeList);
+
+    const Stats& getStats() const;
+};
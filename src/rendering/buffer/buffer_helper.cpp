@@ -21,12 +21,77 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "rendering/dxr_common.h"
 #include "rendering/renderer.h"
 
+#include <atomic>
+
 namespace BufferHelper
 {
 
+// {5B1C6A3E-8F2D-4C71-9A4E-1D62B73F90C5}
+static const GUID MEMORY_TRACKER_GUID = {
+    0x5b1c6a3e, 0x8f2d, 0x4c71, { 0x9a, 0x4e, 0x1d, 0x62, 0xb7, 0x3f, 0x90, 0xc5 }
+};
+
+// Attached to a resource as private data. D3D12 releases it when the resource itself is destroyed, which is the only
+// point where we know that the last ComPtr to the resource is gone.
+class MemoryTracker final : public IUnknown
+{
+private:
+    std::atomic<ULONG> refCount{ 1 };
+    const uint32_t allocationId;
+
+public:
+    MemoryTracker(uint32_t allocationId)
+        : allocationId(allocationId)
+    {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (riid == __uuidof(IUnknown))
+        {
+            *ppvObject = static_cast<IUnknown*>(this);
+            this->AddRef();
+            return S_OK;
+        }
+
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++this->refCount;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG newRefCount = --this->refCount;
+        if (newRefCount == 0)
+        {
+            getMemoryRegistry().unregisterAllocation(this->allocationId);
+            delete this;
+        }
+
+        return newRefCount;
+    }
+};
+
+static MemoryHeap getMemoryHeap(D3D12_HEAP_TYPE heapType)
+{
+    switch (heapType)
+    {
+    case D3D12_HEAP_TYPE_UPLOAD:
+        return MemoryHeap::UPLOAD;
+    case D3D12_HEAP_TYPE_READBACK:
+        return MemoryHeap::READBACK;
+    default:
+        return MemoryHeap::DEVICE;
+    }
+}
+
 ComPtr<ID3D12Resource> createBasicBuffer(uint64_t width,
                                          const D3D12_HEAP_PROPERTIES* heapProperties,
                                          D3D12_RESOURCE_STATES initialResourceState,
+                                         MemoryTag tag,
                                          BufferCreationFlags optionalFlags)
 {
     ComPtr<ID3D12Resource> dev_buffer;
@@ -39,9 +104,34 @@ ComPtr<ID3D12Resource> createBasicBuffer(uint64_t width,
                                                             initialResourceState,
                                                             nullptr,
                                                             IID_PPV_ARGS(&dev_buffer)));
+    trackResource(dev_buffer.Get(), tag);
     return dev_buffer;
 }
 
+void trackResource(ID3D12Resource* resource, MemoryTag tag)
+{
+    // committed resources take up whole pages, so this can be larger than the requested size
+    const D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+    const uint64_t sizeBytes = Renderer::device->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+
+    D3D12_HEAP_PROPERTIES heapProperties{};
+    resource->GetHeapProperties(&heapProperties, nullptr);
+
+    const uint32_t allocationId =
+        getMemoryRegistry().registerAllocation(tag, getMemoryHeap(heapProperties.Type), sizeBytes);
+
+    MemoryTracker* tracker = new MemoryTracker(allocationId);
+    resource->SetPrivateDataInterface(MEMORY_TRACKER_GUID, tracker);
+    tracker->Release();
+}
+
+MemoryRegistry& getMemoryRegistry()
+{
+    // never destroyed, since globals holding resources may be destroyed after it during shutdown
+    static MemoryRegistry* memoryRegistry = new MemoryRegistry();
+    return *memoryRegistry;
+}
+
 void stateTransitionResourceBarrier(ID3D12GraphicsCommandList* cmdList,
                                     ID3D12Resource* resource,
                                     D3D12_RESOURCE_STATES stateBefore,
@@ -85,11 +175,11 @@ void copyResource(ID3D12GraphicsCommandList* cmdList,
 void copyBufferRegion(ID3D12GraphicsCommandList* cmdList,
                       ID3D12Resource* destBuffer,
                       D3D12_RESOURCE_STATES destState,
-                      uint32_t destOffsetBytes,
+                      uint64_t destOffsetBytes,
                       ID3D12Resource* srcBuffer,
                       D3D12_RESOURCE_STATES srcState,
-                      uint32_t srcOffsetBytes,
-                      uint32_t sizeBytes)
+                      uint64_t srcOffsetBytes,
+                      uint64_t sizeBytes)
 {
     stateTransitionResourceBarrier(cmdList, srcBuffer, srcState, D3D12_RESOURCE_STATE_COPY_SOURCE);
     stateTransitionResourceBarrier(cmdList, destBuffer, destState, D3D12_RESOURCE_STATE_COPY_DEST);
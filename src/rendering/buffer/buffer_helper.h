@@ -18,6 +18,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "core/memory_registry.h"
 #include "rendering/dxr_includes.h"
 
 namespace BufferHelper
@@ -32,8 +33,15 @@ struct BufferCreationFlags
 ComPtr<ID3D12Resource> createBasicBuffer(uint64_t width,
                                          const D3D12_HEAP_PROPERTIES* heapProperties,
                                          D3D12_RESOURCE_STATES initialResourceState,
+                                         MemoryTag tag,
                                          BufferCreationFlags optionalFlags = {});
 
+// Registers a committed resource with the memory registry until the resource is destroyed. createBasicBuffer() does
+// this already; anything created directly through the device (e.g. textures) has to call it by itself.
+void trackResource(ID3D12Resource* resource, MemoryTag tag);
+
+MemoryRegistry& getMemoryRegistry();
+
 void stateTransitionResourceBarrier(ID3D12GraphicsCommandList* cmdList,
                                     ID3D12Resource* resource,
                                     D3D12_RESOURCE_STATES stateBefore,
@@ -50,10 +58,10 @@ void copyResource(ID3D12GraphicsCommandList* cmdList,
 void copyBufferRegion(ID3D12GraphicsCommandList* cmdList,
                       ID3D12Resource* destBuffer,
                       D3D12_RESOURCE_STATES destState,
-                      uint32_t destOffsetBytes,
+                      uint64_t destOffsetBytes,
                       ID3D12Resource* srcBuffer,
                       D3D12_RESOURCE_STATES srcState,
-                      uint32_t srcOffsetBytes,
-                      uint32_t sizeBytes);
+                      uint64_t srcOffsetBytes,
+                      uint64_t sizeBytes);
 
 } // namespace BufferHelper
@@ -21,9 +21,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "buffer_helper.h"
 #include "to_free_list.h"
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
-ManagedBufferSection::ManagedBufferSection(ManagedBuffer* buffer, uint32_t offsetBytes, uint32_t sizeBytes)
+ManagedBufferSection::ManagedBufferSection(ManagedBuffer* buffer, uint64_t offsetBytes, uint64_t sizeBytes)
     : buffer(buffer), offsetBytes(offsetBytes), sizeBytes(sizeBytes)
 {}
 
@@ -39,12 +41,14 @@ ManagedBuffer* ManagedBufferSection::getBuffer() const
 ManagedBuffer::ManagedBuffer(const D3D12_HEAP_PROPERTIES* heapProperties,
                              const D3D12_RESOURCE_STATES initialResourceState,
                              const bool isResizable,
-                             const bool isMapped)
+                             const bool isMapped,
+                             const MemoryTag tag,
+                             const GrowthPolicy& growthPolicy)
     : heapProperties(heapProperties), initialResourceState(initialResourceState), isResizable(isResizable),
-      isMapped(isMapped)
+      isMapped(isMapped), tag(tag), growthPolicy(growthPolicy)
 {}
 
-void ManagedBuffer::init(uint32_t sizeBytes)
+void ManagedBuffer::init(uint64_t sizeBytes)
 {
 #ifdef _DEBUG
     if (sizeBytes == 0)
@@ -53,8 +57,10 @@ void ManagedBuffer::init(uint32_t sizeBytes)
     }
 #endif
 
-    this->dev_buffer = BufferHelper::createBasicBuffer(sizeBytes, this->heapProperties, this->initialResourceState);
+    this->dev_buffer =
+        BufferHelper::createBasicBuffer(sizeBytes, this->heapProperties, this->initialResourceState, this->tag);
     this->bufferSizeBytes = sizeBytes;
+    this->minSizeBytes = sizeBytes;
 
     this->freeAll();
 
@@ -66,8 +72,8 @@ void ManagedBuffer::init(uint32_t sizeBytes)
 
 void ManagedBuffer::freeAll()
 {
-    this->freeSectionList.clear();
-    this->freeSectionList.push_back({ this, 0, this->bufferSizeBytes });
+    this->allocator.init(this->bufferSizeBytes);
+    ++this->generation;
 }
 
 void ManagedBuffer::map()
@@ -80,30 +86,19 @@ void ManagedBuffer::unmap()
     this->dev_buffer->Unmap(0, nullptr);
 }
 
-// TODO: keep a persistent rotating pointer into freeSectionList to avoid biasing towards beginning of list for new
-// uploads? (issue #12)
 ManagedBufferSection ManagedBuffer::findFreeSection(ID3D12GraphicsCommandList* cmdList,
                                                     ToFreeList& toFreeList,
-                                                    uint32_t sizeBytes)
+                                                    uint64_t sizeBytes)
 {
-    for (auto it = this->freeSectionList.begin(); it != this->freeSectionList.end(); ++it)
+    const TlsfAllocator::Allocation allocation = this->allocator.allocate(sizeBytes);
+    if (allocation.isValid())
     {
-        if (it->sizeBytes >= sizeBytes)
-        {
-            uint32_t resultOffsetBytes = it->offsetBytes;
-
-            if (it->sizeBytes == sizeBytes)
-            {
-                this->freeSectionList.erase(it);
-            }
-            else
-            {
-                it->offsetBytes += sizeBytes;
-                it->sizeBytes -= sizeBytes;
-            }
-
-            return { this, resultOffsetBytes, sizeBytes };
-        }
+        this->peakUsedBytes = std::max(this->peakUsedBytes, this->allocator.getUsedBytes());
+
+        ManagedBufferSection section{ this, allocation.offsetBytes, sizeBytes };
+        section.allocatorBlockIdx = allocation.blockIdx;
+        section.generation = this->generation;
+        return section;
     }
 
 #ifdef _DEBUG
@@ -113,34 +108,16 @@ ManagedBufferSection ManagedBuffer::findFreeSection(ID3D12GraphicsCommandList* c
     }
 #endif
 
-    bool useBackFreeSection = false;
-    uint32_t backSizeBytes = 0;
-    if (!this->freeSectionList.empty())
-    {
-        const auto& backSection = this->freeSectionList.back();
-        if (backSection.offsetBytes + backSection.sizeBytes == this->bufferSizeBytes)
-        {
-            useBackFreeSection = true;
-            backSizeBytes = backSection.sizeBytes;
-        }
-    }
-
-    const uint32_t minNewSizeBytes = this->bufferSizeBytes + sizeBytes - backSizeBytes;
-    uint32_t newSizeBytes = 1;
-    while (newSizeBytes < minNewSizeBytes)
-    {
-        newSizeBytes *= 2;
-    }
+    // the free block at the end (if any) will be merged with the newly added space
+    const uint64_t minNewSizeBytes = this->bufferSizeBytes + sizeBytes - this->allocator.getTailFreeSizeBytes();
+    const uint64_t newSizeBytes = this->growthPolicy.getGrownSize(this->bufferSizeBytes, minNewSizeBytes);
 
-    this->resize(cmdList, toFreeList, newSizeBytes, useBackFreeSection);
+    this->resize(cmdList, toFreeList, newSizeBytes);
 
     return findFreeSection(cmdList, toFreeList, sizeBytes);
 }
 
-void ManagedBuffer::resize(ID3D12GraphicsCommandList* cmdList,
-                           ToFreeList& toFreeList,
-                           uint32_t newSizeBytes,
-                           bool useBackFreeSection)
+void ManagedBuffer::resize(ID3D12GraphicsCommandList* cmdList, ToFreeList& toFreeList, uint64_t newSizeBytes)
 {
 #ifdef _DEBUG
     if (this->isMapped)
@@ -150,9 +127,10 @@ void ManagedBuffer::resize(ID3D12GraphicsCommandList* cmdList,
 #endif
 
     ID3D12Resource* dev_oldBuffer = toFreeList.pushResource(this->dev_buffer, false);
-    const uint32_t oldSizeBytes = this->bufferSizeBytes;
+    const uint64_t oldSizeBytes = this->bufferSizeBytes;
 
-    this->dev_buffer = BufferHelper::createBasicBuffer(newSizeBytes, this->heapProperties, this->initialResourceState);
+    this->dev_buffer =
+        BufferHelper::createBasicBuffer(newSizeBytes, this->heapProperties, this->initialResourceState, this->tag);
     this->bufferSizeBytes = newSizeBytes;
 
     BufferHelper::copyBufferRegion(cmdList,
@@ -164,22 +142,134 @@ void ManagedBuffer::resize(ID3D12GraphicsCommandList* cmdList,
                                    0,
                                    oldSizeBytes);
 
-    const uint32_t diffSizeBytes = newSizeBytes - oldSizeBytes;
+    this->allocator.grow(newSizeBytes);
+    ++this->numResizes;
+}
+
+void ManagedBuffer::shrinkIfMostlyEmpty(ID3D12GraphicsCommandList* cmdList, ToFreeList& toFreeList)
+{
+    // Leave the shrunk buffer at most half full so that it doesn't immediately have to grow again. Only the free space
+    // at the end can be cut off, so this relies on compaction having moved everything down first.
+    const uint64_t usedEndBytes = this->bufferSizeBytes - this->allocator.getTailFreeSizeBytes();
+    uint64_t newSizeBytes = this->bufferSizeBytes;
+    while (newSizeBytes / 2 >= this->minSizeBytes && usedEndBytes <= newSizeBytes / 4)
+    {
+        newSizeBytes /= 2;
+    }
+
+    if (newSizeBytes == this->bufferSizeBytes)
+    {
+        return;
+    }
+
+    ID3D12Resource* dev_oldBuffer = toFreeList.pushResource(this->dev_buffer, false);
+
+    this->dev_buffer =
+        BufferHelper::createBasicBuffer(newSizeBytes, this->heapProperties, this->initialResourceState, this->tag);
+    this->bufferSizeBytes = newSizeBytes;
+
+    if (usedEndBytes > 0)
+    {
+        BufferHelper::copyBufferRegion(cmdList,
+                                       this->dev_buffer.Get(),
+                                       this->initialResourceState,
+                                       0,
+                                       dev_oldBuffer,
+                                       this->initialResourceState,
+                                       0,
+                                       usedEndBytes);
+    }
+
+    this->allocator.shrink(newSizeBytes);
+    ++this->numResizes;
+}
+
+void ManagedBuffer::copyRelocations(ID3D12GraphicsCommandList* cmdList,
+                                    ToFreeList& toFreeList,
+                                    const std::vector<RelocationPlanner::Relocation>& relocations)
+{
+    uint64_t totalSizeBytes = 0;
+    for (const auto& relocation : relocations)
+    {
+        totalSizeBytes += relocation.sizeBytes;
+    }
+
+    if (totalSizeBytes > this->relocationScratchSizeBytes)
+    {
+        if (this->dev_relocationScratchBuffer != nullptr)
+        {
+            toFreeList.pushResource(this->dev_relocationScratchBuffer, false);
+        }
+
+        this->dev_relocationScratchBuffer =
+            BufferHelper::createBasicBuffer(totalSizeBytes,
+                                            this->heapProperties,
+                                            D3D12_RESOURCE_STATE_COPY_DEST,
+                                            MemoryTag::SCRATCH);
+        this->relocationScratchSizeBytes = totalSizeBytes;
+    }
+
+    ID3D12Resource* dev_scratch = this->dev_relocationScratchBuffer.Get();
+
+    // first gather every moved range into the scratch buffer, then scatter them back out to their new offsets
+    BufferHelper::stateTransitionResourceBarrier(
+        cmdList, this->dev_buffer.Get(), this->initialResourceState, D3D12_RESOURCE_STATE_COPY_SOURCE);
 
-    if (useBackFreeSection)
+    uint64_t scratchOffsetBytes = 0;
+    for (const auto& relocation : relocations)
     {
-        this->freeSectionList.back().sizeBytes += diffSizeBytes;
+        cmdList->CopyBufferRegion(
+            dev_scratch, scratchOffsetBytes, this->dev_buffer.Get(), relocation.srcOffsetBytes, relocation.sizeBytes);
+        scratchOffsetBytes += relocation.sizeBytes;
     }
-    else
+
+    BufferHelper::stateTransitionResourceBarrier(
+        cmdList, this->dev_buffer.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+    BufferHelper::stateTransitionResourceBarrier(
+        cmdList, dev_scratch, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    scratchOffsetBytes = 0;
+    for (const auto& relocation : relocations)
     {
-        this->freeSectionList.push_back({ this, oldSizeBytes, diffSizeBytes });
+        cmdList->CopyBufferRegion(
+            this->dev_buffer.Get(), relocation.dstOffsetBytes, dev_scratch, scratchOffsetBytes, relocation.sizeBytes);
+        scratchOffsetBytes += relocation.sizeBytes;
     }
+
+    BufferHelper::stateTransitionResourceBarrier(
+        cmdList, this->dev_buffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, this->initialResourceState);
+    BufferHelper::stateTransitionResourceBarrier(
+        cmdList, dev_scratch, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+}
+
+std::vector<RelocationPlanner::Relocation> ManagedBuffer::compact(ID3D12GraphicsCommandList* cmdList,
+                                                                  ToFreeList& toFreeList,
+                                                                  uint64_t maxMoveBytes)
+{
+#ifdef _DEBUG
+    if (this->isMapped || !this->isResizable)
+    {
+        throw std::runtime_error("Attempting to compact mapped or non-resizable ManagedBuffer");
+    }
+#endif
+
+    const std::vector<RelocationPlanner::Relocation> relocations =
+        RelocationPlanner::planRelocations(this->allocator, maxMoveBytes);
+
+    if (!relocations.empty())
+    {
+        this->copyRelocations(cmdList, toFreeList, relocations);
+    }
+
+    this->shrinkIfMostlyEmpty(cmdList, toFreeList);
+
+    return relocations;
 }
 
 ManagedBufferSection ManagedBuffer::copyFromHostBuffer(ID3D12GraphicsCommandList* cmdList,
                                                        ToFreeList& toFreeList,
                                                        const void* host_srcBuffer,
-                                                       uint32_t sizeBytes)
+                                                       uint64_t sizeBytes)
 {
 #ifdef _DEBUG
     if (!this->isMapped)
@@ -198,8 +288,8 @@ ManagedBufferSection ManagedBuffer::copyFromHostBuffer(ID3D12GraphicsCommandList
 ManagedBufferSection ManagedBuffer::copyFromDeviceBuffer(ID3D12GraphicsCommandList* cmdList,
                                                          ToFreeList& toFreeList,
                                                          ID3D12Resource* dev_srcBuffer,
-                                                         uint32_t srcSizeBytes,
-                                                         uint32_t srcOffsetBytes)
+                                                         uint64_t srcSizeBytes,
+                                                         uint64_t srcOffsetBytes)
 {
     const auto& freeSection = this->findFreeSection(cmdList, toFreeList, srcSizeBytes);
 
@@ -236,36 +326,29 @@ void ManagedBuffer::freeSection(ManagedBufferSection section)
     }
 #endif
 
-    auto it = this->freeSectionList.begin();
-    for (; it != this->freeSectionList.end(); ++it)
+    if (section.generation != this->generation)
     {
-        if (section.offsetBytes + section.sizeBytes < it->offsetBytes)
-        {
-            break;
-        }
+        return;
     }
 
-    auto inserted = this->freeSectionList.insert(it, section);
+    this->allocator.free(section.allocatorBlockIdx);
+}
 
-    // try merging with previous
-    if (inserted != this->freeSectionList.begin())
+void ManagedBuffer::setSectionOwner(const ManagedBufferSection& section, uint32_t ownerId)
+{
+#ifdef _DEBUG
+    if (section.getBuffer() != this)
     {
-        auto prev = std::prev(inserted);
-        if (prev->offsetBytes + prev->sizeBytes == inserted->offsetBytes)
-        {
-            prev->sizeBytes += inserted->sizeBytes;
-            this->freeSectionList.erase(inserted);
-            inserted = prev;
-        }
+        throw std::runtime_error("Attempting to set owner of ManagedBufferSection from wrong ManagedBuffer");
     }
+#endif
 
-    // try merging with next
-    auto next = std::next(inserted);
-    if (next != this->freeSectionList.end() && inserted->offsetBytes + inserted->sizeBytes == next->offsetBytes)
+    if (section.generation != this->generation)
     {
-        inserted->sizeBytes += next->sizeBytes;
-        this->freeSectionList.erase(next);
+        return;
     }
+
+    this->allocator.setBlockUserData(section.allocatorBlockIdx, ownerId);
 }
 
 ID3D12Resource* ManagedBuffer::getBuffer() const
@@ -278,7 +361,20 @@ D3D12_GPU_VIRTUAL_ADDRESS ManagedBuffer::getBufferGpuAddress() const
     return this->dev_buffer->GetGPUVirtualAddress();
 }
 
-uint32_t ManagedBuffer::getSizeBytes() const
+uint64_t ManagedBuffer::getSizeBytes() const
 {
     return this->bufferSizeBytes;
 }
+
+MemoryPoolStats ManagedBuffer::getPoolStats() const
+{
+    return {
+        .capacityBytes = this->bufferSizeBytes,
+        .usedBytes = this->allocator.getUsedBytes(),
+        .peakUsedBytes = this->peakUsedBytes,
+        .largestFreeRangeBytes = this->allocator.getLargestFreeSizeBytes(),
+        .numAllocations = this->allocator.getNumUsedBlocks(),
+        .numFreeRanges = this->allocator.getNumFreeBlocks(),
+        .numResizes = this->numResizes,
+    };
+}
@@ -18,25 +18,31 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "core/growth_policy.h"
+#include "core/memory_registry.h"
+#include "core/relocation_planner.h"
+#include "core/tlsf_allocator.h"
 #include "rendering/dxr_includes.h"
 #include "util/util.h"
 
-#include <list>
-
 class ToFreeList;
 
 class ManagedBuffer;
 
 struct ManagedBufferSection
 {
+    friend class ManagedBuffer;
+
 private:
     ManagedBuffer* buffer;
+    uint32_t allocatorBlockIdx{ TlsfAllocator::INVALID_BLOCK_IDX };
+    uint32_t generation{ 0 };
 
 public:
-    uint32_t offsetBytes;
-    uint32_t sizeBytes;
+    uint64_t offsetBytes;
+    uint64_t sizeBytes;
 
-    ManagedBufferSection(ManagedBuffer* buffer, uint32_t offsetBytes, uint32_t sizeBytes);
+    ManagedBufferSection(ManagedBuffer* buffer, uint64_t offsetBytes, uint64_t sizeBytes);
     ManagedBufferSection();
 
     ManagedBuffer* getBuffer() const;
@@ -46,27 +52,44 @@ class ManagedBuffer
 {
     friend class ToFreeList;
 
+public:
+    static constexpr uint32_t NO_OWNER = TlsfAllocator::NO_USER_DATA;
+
 private:
     const D3D12_HEAP_PROPERTIES* heapProperties;
     const D3D12_RESOURCE_STATES initialResourceState;
 
     const bool isResizable;
     const bool isMapped;
+    const MemoryTag tag;
+    const GrowthPolicy growthPolicy;
 
     void* host_buffer{ nullptr };
     ComPtr<ID3D12Resource> dev_buffer{ nullptr };
-    uint32_t bufferSizeBytes{ 0 };
+    uint64_t bufferSizeBytes{ 0 };
+    // compact() won't shrink the buffer below its initial size
+    uint64_t minSizeBytes{ 0 };
+    uint64_t peakUsedBytes{ 0 };
+    uint32_t numResizes{ 0 };
+
+    TlsfAllocator allocator;
+    // bumped by freeAll() so that sections from before it are ignored when they're freed later
+    uint32_t generation{ 0 };
 
-    std::list<ManagedBufferSection> freeSectionList;
+    // staging area for compact() so that overlapping moves don't need to be ordered
+    ComPtr<ID3D12Resource> dev_relocationScratchBuffer{ nullptr };
+    uint64_t relocationScratchSizeBytes{ 0 };
 
     ManagedBufferSection findFreeSection(ID3D12GraphicsCommandList* cmdList,
                                          ToFreeList& toFreeList,
-                                         uint32_t sizeBytes);
+                                         uint64_t sizeBytes);
     // resize() works only for non-mapped buffers
-    void resize(ID3D12GraphicsCommandList* cmdList,
-                ToFreeList& toFreeList,
-                uint32_t newSizeBytes,
-                bool useBackFreeSection);
+    void resize(ID3D12GraphicsCommandList* cmdList, ToFreeList& toFreeList, uint64_t newSizeBytes);
+    void shrinkIfMostlyEmpty(ID3D12GraphicsCommandList* cmdList, ToFreeList& toFreeList);
+
+    void copyRelocations(ID3D12GraphicsCommandList* cmdList,
+                         ToFreeList& toFreeList,
+                         const std::vector<RelocationPlanner::Relocation>& relocations);
 
     void freeSection(ManagedBufferSection section);
 
@@ -74,9 +97,11 @@ public:
     ManagedBuffer(const D3D12_HEAP_PROPERTIES* heapProperties,
                   const D3D12_RESOURCE_STATES initialResourceState,
                   const bool isResizable,
-                  const bool isMapped);
+                  const bool isMapped,
+                  const MemoryTag tag,
+                  const GrowthPolicy& growthPolicy = {});
 
-    void init(uint32_t sizeBytes);
+    void init(uint64_t sizeBytes);
 
     void freeAll();
 
@@ -86,7 +111,7 @@ public:
     ManagedBufferSection copyFromHostBuffer(ID3D12GraphicsCommandList* cmdList,
                                             ToFreeList& toFreeList,
                                             const void* host_srcBuffer,
-                                            uint32_t sizeBytes);
+                                            uint64_t sizeBytes);
     template<typename T>
     inline ManagedBufferSection copyFromHostVector(ID3D12GraphicsCommandList* cmdList,
                                                    ToFreeList& toFreeList,
@@ -101,14 +126,26 @@ public:
     ManagedBufferSection copyFromDeviceBuffer(ID3D12GraphicsCommandList* cmdList,
                                               ToFreeList& toFreeList,
                                               ID3D12Resource* dev_srcBuffer,
-                                              uint32_t sizeBytes,
-                                              uint32_t offsetBytes = 0);
+                                              uint64_t sizeBytes,
+                                              uint64_t offsetBytes = 0);
     ManagedBufferSection copyFromManagedBuffer(ID3D12GraphicsCommandList* cmdList,
                                                ToFreeList& toFreeList,
                                                const ManagedBuffer& srcBuffer,
                                                ManagedBufferSection srcBufferSection);
 
+    // Only sections with an owner are moved by compact(), which reports the owner back so it can patch its offsets.
+    void setSectionOwner(const ManagedBufferSection& section, uint32_t ownerId);
+
+    // Moves up to about `maxMoveBytes` of owned sections down into free space and shrinks the buffer if most of it is
+    // unused. The returned relocations are already recorded on `cmdList`; existing ManagedBufferSections for the moved
+    // ranges are stale and have to be updated by the owners. Works only for non-mapped, resizable buffers.
+    std::vector<RelocationPlanner::Relocation> compact(ID3D12GraphicsCommandList* cmdList,
+                                                       ToFreeList& toFreeList,
+                                                       uint64_t maxMoveBytes);
+
     ID3D12Resource* getBuffer() const;
     D3D12_GPU_VIRTUAL_ADDRESS getBufferGpuAddress() const;
-    uint32_t getSizeBytes() const;
+    uint64_t getSizeBytes() const;
+
+    MemoryPoolStats getPoolStats() const;
 };
@@ -18,39 +18,75 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "core/interval_set.h"
+#include "core/memory_registry.h"
 #include "rendering/buffer/buffer_helper.h"
 #include "rendering/buffer/to_free_list.h"
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+struct MappedArrayStats
+{
+    uint64_t numUploads{ 0 };
+    uint64_t numCopies{ 0 };
+    uint64_t uploadedBytes{ 0 };
+    // what uploading a single range spanning all dirty elements would have cost
+    uint64_t singleRangeBytes{ 0 };
+
+    uint64_t numResizes{ 0 };
+    // bytes moved from the old device buffer to the new one on resize, which don't have to be uploaded again
+    uint64_t residentCopiedBytes{ 0 };
+};
+
 template<class T> class MappedArray
 {
 private:
+    // dirty ranges closer than this are uploaded with one copy, since each copy has a fixed cost
+    static constexpr uint32_t MERGE_GAP_BYTES = 1024;
+
     uint32_t size;
+    // one past the highest index ever accessed
+    uint32_t highWaterSize{ 0 };
+    MemoryTag tag{ MemoryTag::OTHER };
     T* host_buffer{ nullptr };
     ComPtr<ID3D12Resource> upload_buffer{ nullptr };
     ComPtr<ID3D12Resource> dev_buffer{ nullptr };
 
-    uint32_t dirtyBeginIdx{ 0 };
-    uint32_t dirtyEndIdx{ 0 };
+    IntervalSet dirtyIdxs;
 
-    void setNotDirty()
-    {
-        this->dirtyBeginIdx = this->size;
-        this->dirtyEndIdx = 0;
-    }
+    // device buffer from before the last resize whose first `residentSize` elements still need to be copied over
+    ComPtr<ID3D12Resource> dev_residentBuffer{ nullptr };
+    uint32_t residentSize{ 0 };
 
-public:
-    void init(uint32_t size)
+    MappedArrayStats stats{};
+
+    void createBuffers(uint32_t size)
     {
         this->size = size;
-        const uint32_t sizeBytes = sizeof(T) * size;
+        const uint64_t sizeBytes = sizeof(T) * size;
 
-        upload_buffer = BufferHelper::createBasicBuffer(sizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ);
+        upload_buffer =
+            BufferHelper::createBasicBuffer(sizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ, this->tag);
         upload_buffer->Map(0, nullptr, reinterpret_cast<void**>(&host_buffer));
 
-        dev_buffer =
-            BufferHelper::createBasicBuffer(sizeBytes, &DEFAULT_HEAP, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        dev_buffer = BufferHelper::createBasicBuffer(
+            sizeBytes, &DEFAULT_HEAP, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, this->tag);
+    }
 
-        this->setNotDirty();
+public:
+    void init(uint32_t size, MemoryTag tag)
+    {
+        this->tag = tag;
+        this->createBuffers(size);
+        this->highWaterSize = 0;
+
+        this->dirtyIdxs.setMergeGap(MERGE_GAP_BYTES / sizeof(T));
+        this->dirtyIdxs.clear();
+
+        this->dev_residentBuffer = nullptr;
+        this->residentSize = 0;
     }
 
     T& operator[](uint32_t idx)
@@ -58,53 +94,129 @@ public:
 #ifdef _DEBUG
         if (idx >= this->size)
         {
-            throw std::exception("MappedArray access out of bounds");
+            throw std::runtime_error("MappedArray access out of bounds");
         }
 #endif
 
-        this->dirtyBeginIdx = std::min(this->dirtyBeginIdx, idx);
-        this->dirtyEndIdx = std::max(this->dirtyEndIdx, idx + 1);
+        this->dirtyIdxs.add(idx);
+        this->highWaterSize = std::max(this->highWaterSize, idx + 1);
         return host_buffer[idx];
     }
 
-    void copyFromUploadBufferIfDirty(ID3D12GraphicsCommandList* cmdList)
+    void copyFromUploadBufferIfDirty(ID3D12GraphicsCommandList* cmdList, ToFreeList& toFreeList)
     {
-        if (!this->getIsDirty())
+        if (!this->getIsDirty() && this->dev_residentBuffer == nullptr)
         {
             return;
         }
 
-        const uint32_t startBytes = sizeof(T) * this->dirtyBeginIdx;
-        const uint32_t sizeBytes = sizeof(T) * (this->dirtyEndIdx - this->dirtyBeginIdx);
-
         BufferHelper::stateTransitionResourceBarrier(cmdList,
                                                      this->dev_buffer.Get(),
                                                      D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
                                                      D3D12_RESOURCE_STATE_COPY_DEST);
-        cmdList->CopyBufferRegion(this->dev_buffer.Get(), startBytes, this->upload_buffer.Get(), startBytes, sizeBytes);
+
+        const std::vector<IntervalSet::Interval>& intervals = this->dirtyIdxs.getIntervals();
+
+        // Only resident elements that aren't about to be uploaded are copied, since copies into the same buffer aren't
+        // ordered without a barrier in between and a stale resident copy could otherwise land after a dirty one.
+        if (this->dev_residentBuffer != nullptr)
+        {
+            BufferHelper::stateTransitionResourceBarrier(cmdList,
+                                                         this->dev_residentBuffer.Get(),
+                                                         D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                                         D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+            const auto copyResidentRange = [&](uint32_t begin, uint32_t end) {
+                end = std::min(end, this->residentSize);
+                if (end <= begin)
+                {
+                    return;
+                }
+
+                const uint64_t startBytes = sizeof(T) * begin;
+                const uint64_t sizeBytes = sizeof(T) * (end - begin);
+                cmdList->CopyBufferRegion(
+                    this->dev_buffer.Get(), startBytes, this->dev_residentBuffer.Get(), startBytes, sizeBytes);
+
+                this->stats.residentCopiedBytes += sizeBytes;
+            };
+
+            uint32_t begin = 0;
+            for (const auto& interval : intervals)
+            {
+                copyResidentRange(begin, interval.begin);
+                begin = interval.end;
+            }
+            copyResidentRange(begin, this->residentSize);
+
+            toFreeList.pushResource(this->dev_residentBuffer, false);
+            this->dev_residentBuffer = nullptr;
+            this->residentSize = 0;
+        }
+
+        for (const auto& interval : intervals)
+        {
+            const uint64_t startBytes = sizeof(T) * interval.begin;
+            const uint64_t sizeBytes = sizeof(T) * (interval.end - interval.begin);
+            cmdList->CopyBufferRegion(
+                this->dev_buffer.Get(), startBytes, this->upload_buffer.Get(), startBytes, sizeBytes);
+
+            this->stats.uploadedBytes += sizeBytes;
+        }
+
         BufferHelper::stateTransitionResourceBarrier(cmdList,
                                                      this->dev_buffer.Get(),
                                                      D3D12_RESOURCE_STATE_COPY_DEST,
                                                      D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
-        this->setNotDirty();
+        if (!intervals.empty())
+        {
+            ++this->stats.numUploads;
+            this->stats.numCopies += intervals.size();
+            this->stats.singleRangeBytes += sizeof(T) * (intervals.back().end - intervals.front().begin);
+        }
+
+        this->dirtyIdxs.clear();
     }
 
+    // Existing elements are copied on the device the next time the array is uploaded, so only elements that were
+    // already dirty (or are written afterwards) go over the bus. New elements start out uninitialized.
     void resize(ToFreeList& toFreeList, uint32_t newSize)
     {
-        uint32_t oldSize = this->size;
+        const uint32_t oldSize = this->size;
         T* host_oldBuffer = this->host_buffer;
 
         toFreeList.pushResource(this->upload_buffer, true);
-        toFreeList.pushResource(this->dev_buffer, false);
 
-        this->init(newSize);
+        // if a copy is already pending, the current device buffer never received any data and can be dropped
+        if (this->dev_residentBuffer == nullptr)
+        {
+            this->dev_residentBuffer = this->dev_buffer;
+            this->residentSize = oldSize;
+        }
+        else
+        {
+            toFreeList.pushResource(this->dev_buffer, false);
+        }
+        this->residentSize = std::min(this->residentSize, newSize);
+
+        this->createBuffers(newSize);
 
         const uint32_t copyCount = std::min(oldSize, newSize);
         memcpy(this->host_buffer, host_oldBuffer, sizeof(T) * copyCount);
 
-        this->dirtyBeginIdx = 0;
-        this->dirtyEndIdx = newSize;
+        this->dirtyIdxs.clip(newSize);
+        this->highWaterSize = std::min(this->highWaterSize, newSize);
+
+        ++this->stats.numResizes;
+    }
+
+    void reserve(ToFreeList& toFreeList, uint32_t minSize)
+    {
+        if (minSize > this->size)
+        {
+            this->resize(toFreeList, minSize);
+        }
     }
 
     inline uint32_t getSize() const
@@ -114,7 +226,28 @@ public:
 
     inline bool getIsDirty() const
     {
-        return this->dirtyBeginIdx <= this->dirtyEndIdx;
+        return !this->dirtyIdxs.isEmpty();
+    }
+
+    inline const MappedArrayStats& getStats() const
+    {
+        return this->stats;
+    }
+
+    // elements aren't allocated individually, so everything up to the high-water mark counts as used
+    MemoryPoolStats getPoolStats() const
+    {
+        const uint64_t capacityBytes = sizeof(T) * this->size;
+        const uint64_t usedBytes = sizeof(T) * this->highWaterSize;
+        return {
+            .capacityBytes = capacityBytes,
+            .usedBytes = usedBytes,
+            .peakUsedBytes = usedBytes,
+            .largestFreeRangeBytes = capacityBytes - usedBytes,
+            .numAllocations = this->highWaterSize,
+            .numFreeRanges = usedBytes < capacityBytes ? 1u : 0u,
+            .numResizes = static_cast<uint32_t>(this->stats.numResizes),
+        };
     }
 
     inline ID3D12Resource* getUploadBuffer() const
@@ -0,0 +1,76 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "staging_buffer.h"
+
+#include "buffer_helper.h"
+#include "rendering/dxr_common.h"
+
+#include <stdexcept>
+
+uint64_t StagingBuffer::getSectionSizeBytes(uint64_t sizeBytes)
+{
+    return (sizeBytes + SECTION_ALIGNMENT_BYTES - 1) / SECTION_ALIGNMENT_BYTES * SECTION_ALIGNMENT_BYTES;
+}
+
+void StagingBuffer::init(uint64_t sizeBytes)
+{
+    this->sizeBytes = sizeBytes;
+    this->usedBytes = 0;
+
+    if (sizeBytes == 0)
+    {
+        this->dev_buffer = nullptr;
+        this->host_buffer = nullptr;
+        return;
+    }
+
+    this->dev_buffer =
+        BufferHelper::createBasicBuffer(sizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ, MemoryTag::UPLOAD);
+    // never unmapped, since releasing a mapped resource is fine and geometries release it one after another
+    this->dev_buffer->Map(0, nullptr, reinterpret_cast<void**>(&this->host_buffer));
+}
+
+UploadRingSection StagingBuffer::allocate(uint64_t sizeBytes)
+{
+    const uint64_t sectionSizeBytes = getSectionSizeBytes(sizeBytes);
+    if (this->usedBytes + sectionSizeBytes > this->sizeBytes)
+    {
+        throw std::runtime_error("StagingBuffer out of space");
+    }
+
+    const uint64_t offsetBytes = this->usedBytes;
+    this->usedBytes += sectionSizeBytes;
+
+    return {
+        .buffer = this->dev_buffer.Get(),
+        .host_ptr = this->host_buffer + offsetBytes,
+        .offsetBytes = offsetBytes,
+        .sizeBytes = sizeBytes,
+    };
+}
+
+const ComPtr<ID3D12Resource>& StagingBuffer::getBuffer() const
+{
+    return this->dev_buffer;
+}
+
+uint64_t StagingBuffer::getSizeBytes() const
+{
+    return this->sizeBytes;
+}
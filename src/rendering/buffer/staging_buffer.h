@@ -0,0 +1,64 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "upload_ring.h"
+#include "rendering/dxr_includes.h"
+
+#include <cstdint>
+
+// Vertex and index streams that a loader wrote straight into a StagingBuffer, which BLAS builds and device buffer
+// copies read from directly instead of going through host vectors and an UploadRing.
+struct StagedGeometryStreams
+{
+    // keeps the staging buffer alive until every geometry staged in it has been uploaded
+    ComPtr<ID3D12Resource> buffer{ nullptr };
+
+    UploadRingSection positions{};
+    UploadRingSection vertAttribs{};
+    // 16-bit index streams are padded to a multiple of 4 bytes, like Geometry::host_idxs16
+    UploadRingSection idxs{};
+    DXGI_FORMAT idxFormat{ DXGI_FORMAT_R32_UINT };
+};
+
+// A persistently mapped upload heap buffer sized up front for one batch of data, usually a whole loaded scene. Unlike
+// UploadRing, it can be created and filled on any thread and isn't tied to a frame; it's released once nothing
+// references it anymore.
+class StagingBuffer
+{
+private:
+    ComPtr<ID3D12Resource> dev_buffer{ nullptr };
+    uint8_t* host_buffer{ nullptr };
+    uint64_t sizeBytes{ 0 };
+    uint64_t usedBytes{ 0 };
+
+public:
+    // every section is aligned to this, so getSectionSizeBytes() can be summed to size the buffer
+    static constexpr uint64_t SECTION_ALIGNMENT_BYTES = 16;
+
+    static uint64_t getSectionSizeBytes(uint64_t sizeBytes);
+
+    void init(uint64_t sizeBytes);
+
+    // `sizeBytes` must fit in what's left of the size passed to init()
+    UploadRingSection allocate(uint64_t sizeBytes);
+
+    const ComPtr<ID3D12Resource>& getBuffer() const;
+    uint64_t getSizeBytes() const;
+};
@@ -18,6 +18,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "to_free_list.h"
 
+#include "acs_pool.h"
 #include "managed_buffer.h"
 #include "rendering/scene/scene.h"
 
@@ -38,19 +39,62 @@ void ToFreeList::pushManagedBufferSection(const ManagedBufferSection& bufferSect
     managedBufferSections.push_back(bufferSection);
 }
 
-void ToFreeList::pushInstance(Instance* instance)
+void ToFreeList::pushAcsPoolSection(const AcsPoolSection& acsPoolSection)
+{
+    acsPoolSections.push_back(acsPoolSection);
+}
+
+void ToFreeList::pushGeometry(Geometry* geometry)
 {
-    if (instance->geoWrapper.dev_blas)
+    if (geometry->isQueuedForBlasBuild)
+    {
+        std::erase(geometry->scene->geometriesReadyForBlasBuild, geometry);
+        geometry->isQueuedForBlasBuild = false;
+    }
+
+    if (geometry->geoWrapper.dev_blas.isValid())
     {
-        this->pushResource(instance->geoWrapper.dev_blas, false);
+        this->pushAcsPoolSection(geometry->geoWrapper.dev_blas);
     }
-    if (instance->geoWrapper.vertsBufferSection.sizeBytes > 0)
+    // sections are pinned while waiting to be freed so that compaction doesn't try to patch a deleted geometry
+    if (geometry->geoWrapper.vertAttribsBufferSection.sizeBytes > 0)
     {
-        this->pushManagedBufferSection(instance->geoWrapper.vertsBufferSection);
+        const ManagedBufferSection& section = geometry->geoWrapper.vertAttribsBufferSection;
+        section.getBuffer()->setSectionOwner(section, ManagedBuffer::NO_OWNER);
+        this->pushManagedBufferSection(section);
     }
-    if (instance->geoWrapper.idxsBufferSection.sizeBytes > 0)
+    if (geometry->geoWrapper.idxsBufferSection.sizeBytes > 0)
     {
-        this->pushManagedBufferSection(instance->geoWrapper.idxsBufferSection);
+        const ManagedBufferSection& section = geometry->geoWrapper.idxsBufferSection;
+        section.getBuffer()->setSectionOwner(section, ManagedBuffer::NO_OWNER);
+        this->pushManagedBufferSection(section);
+    }
+    if (geometry->geometryDatasBufferSection.sizeBytes > 0)
+    {
+        this->pushManagedBufferSection(geometry->geometryDatasBufferSection);
+    }
+
+    geometries.push_back(geometry);
+    geometry->isScheduledForDeletion = true;
+}
+
+void ToFreeList::pushInstance(Instance* instance)
+{
+    std::erase(instance->scene->pendingInstances, instance);
+    // marks the TLAS dirty
+    if (instance->instanceDescIdx != Instance::INSTANCE_DESC_IDX_INVALID)
+    {
+        instance->scene->removeInstanceFromTlas(instance);
+    }
+
+    Geometry* geometry = instance->geometry;
+    if (geometry != nullptr)
+    {
+        std::erase(geometry->instances, instance);
+        if (geometry->instances.empty())
+        {
+            this->pushGeometry(geometry);
+        }
     }
 
     if (instance->areaLightsBufferSection.sizeBytes > 0)
@@ -60,7 +104,6 @@ void ToFreeList::pushInstance(Instance* instance)
 
     instances.push_back(instance);
     instance->isScheduledForDeletion = true;
-    instance->scene->isTlasDirty = true;
 }
 
 void ToFreeList::freeAll()
@@ -84,9 +127,21 @@ void ToFreeList::freeAll()
     }
     managedBufferSections.clear();
 
+    for (const auto& acsPoolSection : acsPoolSections)
+    {
+        acsPoolSection.getPool()->freeSection(acsPoolSection);
+    }
+    acsPoolSections.clear();
+
     for (Instance* instance : instances)
     {
         instance->scene->freeInstance(instance);
     }
     instances.clear();
+
+    for (Geometry* geometry : geometries)
+    {
+        geometry->scene->freeGeometry(geometry);
+    }
+    geometries.clear();
 }
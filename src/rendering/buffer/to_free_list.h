@@ -22,8 +22,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <vector>
 
+struct AcsPoolSection;
 class ManagedBuffer;
 class ManagedBufferSection;
+class Geometry;
 class Instance;
 class Scene;
 
@@ -34,9 +36,13 @@ private:
     std::vector<ComPtr<ID3D12Resource>> mappedResources;
 
     std::vector<ManagedBufferSection> managedBufferSections;
+    std::vector<AcsPoolSection> acsPoolSections;
 
+    std::vector<Geometry*> geometries;
     std::vector<Instance*> instances;
 
+    void pushGeometry(Geometry* geometry);
+
 public:
     // The caller is responsible for nulling the ComPtr if necessary.
     ID3D12Resource* pushResource(const ComPtr<ID3D12Resource>& resource, bool isMapped);
@@ -45,6 +51,9 @@ public:
     void pushManagedBuffer(const ManagedBuffer* buffer);
     void pushManagedBufferSection(const ManagedBufferSection& bufferSection);
 
+    void pushAcsPoolSection(const AcsPoolSection& acsPoolSection);
+
+    // also frees the instance's geometry if no other instance uses it
     void pushInstance(Instance* instance);
 
     void freeAll();
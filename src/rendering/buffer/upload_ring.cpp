@@ -0,0 +1,106 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "upload_ring.h"
+
+#include "buffer_helper.h"
+#include "to_free_list.h"
+#include "rendering/dxr_common.h"
+
+#include <algorithm>
+#include <cstring>
+
+D3D12_GPU_VIRTUAL_ADDRESS UploadRingSection::getGpuAddress() const
+{
+    return this->buffer->GetGPUVirtualAddress() + this->offsetBytes;
+}
+
+void UploadRing::init(uint64_t sizeBytes)
+{
+    this->dev_buffer =
+        BufferHelper::createBasicBuffer(sizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ, MemoryTag::UPLOAD);
+    this->dev_buffer->Map(0, nullptr, &this->host_buffer);
+
+    this->allocator.init(sizeBytes);
+}
+
+void UploadRing::grow(ToFreeList& toFreeList, uint64_t minSizeBytes)
+{
+    // always grow by at least one step, since the ring can be too fragmented even if it's large enough
+    const uint64_t newSizeBytes = this->growthPolicy.getGrownSize(
+        this->allocator.getSizeBytes(), std::max(minSizeBytes, this->allocator.getSizeBytes() + 1));
+
+    // sections handed out earlier still point into the old buffer, which is unmapped and released once it's safe
+    toFreeList.pushResource(this->dev_buffer, true);
+
+    this->init(newSizeBytes);
+    ++this->numResizes;
+}
+
+UploadRingSection UploadRing::allocate(ToFreeList& toFreeList, uint64_t sizeBytes, uint64_t alignmentBytes)
+{
+    uint64_t offsetBytes = this->allocator.allocate(sizeBytes, alignmentBytes);
+    if (offsetBytes == RingAllocator::INVALID_OFFSET)
+    {
+        this->grow(toFreeList, sizeBytes);
+        offsetBytes = this->allocator.allocate(sizeBytes, alignmentBytes);
+    }
+
+    this->peakUsedBytes = std::max(this->peakUsedBytes, this->allocator.getUsedBytes());
+
+    return {
+        .buffer = this->dev_buffer.Get(),
+        .host_ptr = static_cast<uint8_t*>(this->host_buffer) + offsetBytes,
+        .offsetBytes = offsetBytes,
+        .sizeBytes = sizeBytes,
+    };
+}
+
+UploadRingSection UploadRing::copyFromHostBuffer(ToFreeList& toFreeList,
+                                                 const void* host_srcBuffer,
+                                                 uint64_t sizeBytes,
+                                                 uint64_t alignmentBytes)
+{
+    const UploadRingSection section = this->allocate(toFreeList, sizeBytes, alignmentBytes);
+    memcpy(section.host_ptr, host_srcBuffer, sizeBytes);
+    return section;
+}
+
+void UploadRing::submit(uint64_t fenceValue)
+{
+    this->allocator.submit(fenceValue);
+}
+
+void UploadRing::reclaim(uint64_t completedFenceValue)
+{
+    this->allocator.reclaim(completedFenceValue);
+}
+
+MemoryPoolStats UploadRing::getPoolStats() const
+{
+    const uint64_t largestFreeSizeBytes = this->allocator.getLargestFreeSizeBytes();
+    const uint64_t freeBytes = this->allocator.getSizeBytes() - this->allocator.getUsedBytes();
+    return {
+        .capacityBytes = this->allocator.getSizeBytes(),
+        .usedBytes = this->allocator.getUsedBytes(),
+        .peakUsedBytes = this->peakUsedBytes,
+        .largestFreeRangeBytes = largestFreeSizeBytes,
+        .numFreeRanges = freeBytes == 0 ? 0u : (largestFreeSizeBytes < freeBytes ? 2u : 1u),
+        .numResizes = this->numResizes,
+    };
+}
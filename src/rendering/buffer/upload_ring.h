@@ -0,0 +1,82 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/growth_policy.h"
+#include "core/memory_registry.h"
+#include "core/ring_allocator.h"
+#include "rendering/dxr_includes.h"
+#include "util/util.h"
+
+#include <vector>
+
+class ToFreeList;
+
+struct UploadRingSection
+{
+    ID3D12Resource* buffer{ nullptr };
+    void* host_ptr{ nullptr };
+    uint64_t offsetBytes{ 0 };
+    uint64_t sizeBytes{ 0 };
+
+    D3D12_GPU_VIRTUAL_ADDRESS getGpuAddress() const;
+};
+
+// Persistently mapped upload heap buffer for staging data that is copied to the GPU once. Space is recycled once the
+// fence passed to submit() has completed, so steady-state uploads don't create any resources.
+class UploadRing
+{
+private:
+    ComPtr<ID3D12Resource> dev_buffer{ nullptr };
+    void* host_buffer{ nullptr };
+
+    RingAllocator allocator;
+    GrowthPolicy growthPolicy{};
+
+    uint64_t peakUsedBytes{ 0 };
+    uint32_t numResizes{ 0 };
+
+    void grow(ToFreeList& toFreeList, uint64_t minSizeBytes);
+
+public:
+    void init(uint64_t sizeBytes);
+
+    // Sections stay valid until the fence of the next submit() completes. If the ring is out of space, it is replaced
+    // by a larger one and the old buffer is kept alive through `toFreeList`.
+    UploadRingSection allocate(ToFreeList& toFreeList, uint64_t sizeBytes, uint64_t alignmentBytes);
+
+    UploadRingSection copyFromHostBuffer(ToFreeList& toFreeList,
+                                         const void* host_srcBuffer,
+                                         uint64_t sizeBytes,
+                                         uint64_t alignmentBytes);
+    template<typename T>
+    inline UploadRingSection copyFromHostVector(ToFreeList& toFreeList, const std::vector<T>& host_srcVector)
+    {
+        return this->copyFromHostBuffer(toFreeList,
+                                        static_cast<const void*>(host_srcVector.data()),
+                                        Util::getVectorSizeBytes(host_srcVector),
+                                        alignof(T));
+    }
+
+    void submit(uint64_t fenceValue);
+    void reclaim(uint64_t completedFenceValue);
+
+    // growth shows up here as numResizes, along with the peak usage that the initial size should be tuned to
+    MemoryPoolStats getPoolStats() const;
+};
@@ -26,12 +26,13 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 // t#
 #define REGISTER_RAYTRACING_ACS 0
-#define REGISTER_VERTS 1
+#define REGISTER_VERT_ATTRIBS 1
 #define REGISTER_IDXS 2
 #define REGISTER_INSTANCE_DATAS 3
 #define REGISTER_MATERIALS 4
 #define REGISTER_AREA_LIGHTS 5
 #define REGISTER_AREA_LIGHT_SAMPLING_STRUCTURE 6
+#define REGISTER_GEOMETRY_DATAS 7
 
 // b#
 #define REGISTER_GLOBAL_PARAMS 0
@@ -41,6 +42,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 // =============================================
 
 #define MAX_NUM_TEXTURES 8
+// twice the textures a scene can have, so that a new scene's textures get descriptors no frame in flight still reads
+#define NUM_TEXTURE_DESCRIPTORS (2 * MAX_NUM_TEXTURES)
 
 // u#
 #define REGISTER_RENDER_TARGET 0
@@ -29,19 +29,42 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define float3 DirectX::XMFLOAT3
 #endif // !_hlsl
 
-struct Vertex
+// Vertices are split into a float3 position stream, which is all that BLAS builds read, and these attributes for hit
+// shaders. See core/vertex_packing.h for the encodings.
+struct VertexAttributes
 {
-    float3 pos;
-    float3 nor; // TODO: pack into one? uint
-    float2 uv; // TODO: pack into one uint
+    uint packedNormal; // octahedral, two snorm16s
+    uint packedUv; // two halfs
 };
 
+#define IDX_FORMAT_32 0
+#define IDX_FORMAT_16 1
+
 struct InstanceData
 {
-    uint vertBufferOffset;
+    // both in elements rather than bytes so that buffers past 4 GB stay addressable; idxBufferOffset is always in
+    // 32-bit words, even for 16-bit indices
+    uint vertAttribsBufferOffset;
+    uint idxBufferOffset;
+    // index of the GeometryData for GeometryIndex() 0 of this instance's BLAS
+    uint geometryDataOffset;
+    uint idxFormat; // IDX_FORMAT_32 or IDX_FORMAT_16
+};
+
+// one per geometry desc of a BLAS, indexed by InstanceData::geometryDataOffset + GeometryIndex()
+struct GeometryData
+{
+    // relative to the instance's vertAttribsBufferOffset and idxBufferOffset, in elements of the instance's idxFormat
+    uint vertOffset;
     uint hasIdxs;
-    uint idxBufferByteOffset;
+    uint idxOffset;
     uint materialId;
+
+    // see Geometry::addPart()
+    float uvScaleLog2;
+    uint pad0;
+    uint pad1;
+    uint pad2;
 };
 
 #define MATERIAL_ID_INVALID ~0u
@@ -121,7 +144,7 @@ struct AreaLight
     float rcpArea;
 
     float3 normal_WS;
-    uint pad0;
+    uint geometryIdx;
 };
 
 struct CameraParams
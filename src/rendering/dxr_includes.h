@@ -18,14 +18,19 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <DirectXMath.h>
+
+#ifdef BIOMEINATOR_NULL_DEVICE
+#include "rendering/null/null_d3d12.h"
+#else
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 
-#include <DirectXMath.h>
 #include <Windows.h>
 #include <d3d12.h>
 #include <dxgi1_4.h>
 #include <wrl/client.h>
+#endif
 
 
 using Microsoft::WRL::ComPtr;
@@ -0,0 +1,909 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+// CPU-only stand-in for the parts of Windows, WRL and D3D12 that the scene and buffer code use. Selected by
+// dxr_includes.h when BIOMEINATOR_NULL_DEVICE is defined so that code can run headless (e.g. on Linux, under
+// sanitizers or in benchmarks). Resources live in host memory and command lists record their commands until
+// NullDevice::executeCommandList() replays them. Types and signatures mirror the real headers so that the same code
+// compiles against both; only what's actually used is declared here.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ----------------------------------------------------------------------------------------------------
+// Windows and COM
+// ----------------------------------------------------------------------------------------------------
+
+typedef int32_t HRESULT;
+typedef int32_t BOOL;
+typedef uint8_t BYTE;
+typedef uint16_t UINT16;
+typedef uint32_t UINT;
+typedef uint32_t ULONG;
+typedef uint64_t UINT64;
+typedef uint64_t SIZE_T;
+typedef float FLOAT;
+
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000E)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define STDMETHODCALLTYPE
+
+#ifndef _MSC_VER
+#define __debugbreak() __builtin_trap()
+#endif
+
+struct GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+};
+
+typedef GUID IID;
+typedef const GUID& REFGUID;
+typedef const IID& REFIID;
+
+inline bool operator==(const GUID& a, const GUID& b)
+{
+    return a.Data1 == b.Data1 && a.Data2 == b.Data2 && a.Data3 == b.Data3 &&
+           std::equal(std::begin(a.Data4), std::end(a.Data4), std::begin(b.Data4));
+}
+
+struct IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+};
+
+namespace NullD3D12
+{
+
+// Interfaces get made-up IIDs; all that matters is that each type's IID is distinct and stable within a run.
+GUID makeUniqueIid();
+
+template<typename T> REFIID getIid()
+{
+    static const GUID iid = makeUniqueIid();
+    return iid;
+}
+
+template<typename T> void** getPpvArgs(T** pp)
+{
+    static_assert(std::is_base_of_v<IUnknown, T>, "IID_PPV_ARGS requires a COM interface");
+    return reinterpret_cast<void**>(pp);
+}
+
+} // namespace NullD3D12
+
+// only the type form of __uuidof is supported
+#define __uuidof(type) NullD3D12::getIid<type>()
+#define IID_PPV_ARGS(ppType)                                                                                           \
+    NullD3D12::getIid<std::remove_reference_t<decltype(**(ppType))>>(), NullD3D12::getPpvArgs(ppType)
+
+namespace Microsoft::WRL
+{
+
+template<typename T> class ComPtr
+{
+    template<typename U> friend class ComPtr;
+
+private:
+    T* ptr{ nullptr };
+
+    void internalAddRef() const
+    {
+        if (this->ptr != nullptr)
+        {
+            this->ptr->AddRef();
+        }
+    }
+
+    void internalRelease()
+    {
+        T* oldPtr = this->ptr;
+        this->ptr = nullptr;
+        if (oldPtr != nullptr)
+        {
+            oldPtr->Release();
+        }
+    }
+
+public:
+    ComPtr() = default;
+
+    ComPtr(std::nullptr_t)
+    {}
+
+    template<typename U> ComPtr(U* other)
+        : ptr(other)
+    {
+        this->internalAddRef();
+    }
+
+    ComPtr(const ComPtr& other)
+        : ptr(other.ptr)
+    {
+        this->internalAddRef();
+    }
+
+    template<typename U> ComPtr(const ComPtr<U>& other)
+        : ptr(other.ptr)
+    {
+        this->internalAddRef();
+    }
+
+    ComPtr(ComPtr&& other) noexcept
+        : ptr(std::exchange(other.ptr, nullptr))
+    {}
+
+    ~ComPtr()
+    {
+        this->internalRelease();
+    }
+
+    ComPtr& operator=(const ComPtr& other)
+    {
+        ComPtr(other).Swap(*this);
+        return *this;
+    }
+
+    ComPtr& operator=(ComPtr&& other) noexcept
+    {
+        ComPtr(std::move(other)).Swap(*this);
+        return *this;
+    }
+
+    ComPtr& operator=(std::nullptr_t)
+    {
+        this->internalRelease();
+        return *this;
+    }
+
+    void Swap(ComPtr& other)
+    {
+        std::swap(this->ptr, other.ptr);
+    }
+
+    T* Get() const
+    {
+        return this->ptr;
+    }
+
+    T* operator->() const
+    {
+        return this->ptr;
+    }
+
+    T* const* GetAddressOf() const
+    {
+        return &this->ptr;
+    }
+
+    T** GetAddressOf()
+    {
+        return &this->ptr;
+    }
+
+    T** ReleaseAndGetAddressOf()
+    {
+        this->internalRelease();
+        return &this->ptr;
+    }
+
+    // WRL returns a proxy here; releasing up front is what it does when the proxy is used as an out parameter
+    T** operator&()
+    {
+        return this->ReleaseAndGetAddressOf();
+    }
+
+    void Reset()
+    {
+        this->internalRelease();
+    }
+
+    void Attach(T* other)
+    {
+        this->internalRelease();
+        this->ptr = other;
+    }
+
+    T* Detach()
+    {
+        return std::exchange(this->ptr, nullptr);
+    }
+
+    template<typename U> HRESULT As(ComPtr<U>* other) const
+    {
+        return this->ptr->QueryInterface(__uuidof(U), reinterpret_cast<void**>(other->ReleaseAndGetAddressOf()));
+    }
+
+    explicit operator bool() const
+    {
+        return this->ptr != nullptr;
+    }
+
+    bool operator==(std::nullptr_t) const
+    {
+        return this->ptr == nullptr;
+    }
+
+    template<typename U> bool operator==(const ComPtr<U>& other) const
+    {
+        return this->ptr == other.ptr;
+    }
+};
+
+} // namespace Microsoft::WRL
+
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE)                                                                           \
+    constexpr ENUMTYPE operator|(ENUMTYPE a, ENUMTYPE b)                                                               \
+    {                                                                                                                  \
+        return ENUMTYPE(std::underlying_type_t<ENUMTYPE>(a) | std::underlying_type_t<ENUMTYPE>(b));                    \
+    }                                                                                                                  \
+    constexpr ENUMTYPE& operator|=(ENUMTYPE& a, ENUMTYPE b)                                                            \
+    {                                                                                                                  \
+        return a = a | b;                                                                                              \
+    }                                                                                                                  \
+    constexpr ENUMTYPE operator&(ENUMTYPE a, ENUMTYPE b)                                                               \
+    {                                                                                                                  \
+        return ENUMTYPE(std::underlying_type_t<ENUMTYPE>(a) & std::underlying_type_t<ENUMTYPE>(b));                    \
+    }                                                                                                                  \
+    constexpr ENUMTYPE& operator&=(ENUMTYPE& a, ENUMTYPE b)                                                            \
+    {                                                                                                                  \
+        return a = a & b;                                                                                              \
+    }                                                                                                                  \
+    constexpr ENUMTYPE operator~(ENUMTYPE a)                                                                           \
+    {                                                                                                                  \
+        return ENUMTYPE(~std::underlying_type_t<ENUMTYPE>(a));                                                         \
+    }
+
+// ----------------------------------------------------------------------------------------------------
+// DXGI
+// ----------------------------------------------------------------------------------------------------
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+    DXGI_FORMAT_R32G32B32_FLOAT = 6,
+    DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+    DXGI_FORMAT_R32G32_FLOAT = 16,
+    DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+    DXGI_FORMAT_R32_FLOAT = 41,
+    DXGI_FORMAT_R32_UINT = 42,
+    DXGI_FORMAT_R16_UINT = 57,
+    DXGI_FORMAT_BC5_UNORM = 83,
+    DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+};
+
+struct DXGI_SAMPLE_DESC
+{
+    UINT Count;
+    UINT Quality;
+};
+
+// ----------------------------------------------------------------------------------------------------
+// D3D12 enums and structs
+// ----------------------------------------------------------------------------------------------------
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+#define D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT 256
+#define D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT 16
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 512
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+#define D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING 0x1688
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+
+enum D3D12_HEAP_TYPE
+{
+    D3D12_HEAP_TYPE_DEFAULT = 1,
+    D3D12_HEAP_TYPE_UPLOAD = 2,
+    D3D12_HEAP_TYPE_READBACK = 3,
+    D3D12_HEAP_TYPE_CUSTOM = 4,
+};
+
+enum D3D12_CPU_PAGE_PROPERTY
+{
+    D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+};
+
+enum D3D12_MEMORY_POOL
+{
+    D3D12_MEMORY_POOL_UNKNOWN = 0,
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+    D3D12_HEAP_TYPE Type;
+    D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+    D3D12_MEMORY_POOL MemoryPoolPreference;
+    UINT CreationNodeMask;
+    UINT VisibleNodeMask;
+};
+
+enum D3D12_HEAP_FLAGS
+{
+    D3D12_HEAP_FLAG_NONE = 0,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_HEAP_FLAGS)
+
+enum D3D12_RESOURCE_STATES
+{
+    D3D12_RESOURCE_STATE_COMMON = 0,
+    D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+    D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+    D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+    D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+    D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+    D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+    D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE = 0x400000,
+    D3D12_RESOURCE_STATE_GENERIC_READ = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800,
+    D3D12_RESOURCE_STATE_PRESENT = 0,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_STATES)
+
+enum D3D12_RESOURCE_DIMENSION
+{
+    D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+    D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+    D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+    D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+    D3D12_RESOURCE_DIMENSION_TEXTURE3D = 4,
+};
+
+enum D3D12_TEXTURE_LAYOUT
+{
+    D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+    D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+    D3D12_RESOURCE_FLAG_NONE = 0,
+    D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+    D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+    D3D12_RESOURCE_FLAG_RAYTRACING_ACCELERATION_STRUCTURE = 0x1000,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_FLAGS)
+
+struct D3D12_RESOURCE_DESC
+{
+    D3D12_RESOURCE_DIMENSION Dimension;
+    UINT64 Alignment;
+    UINT64 Width;
+    UINT Height;
+    UINT16 DepthOrArraySize;
+    UINT16 MipLevels;
+    DXGI_FORMAT Format;
+    DXGI_SAMPLE_DESC SampleDesc;
+    D3D12_TEXTURE_LAYOUT Layout;
+    D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO
+{
+    UINT64 SizeInBytes;
+    UINT64 Alignment;
+};
+
+struct D3D12_CLEAR_VALUE;
+
+struct D3D12_RANGE
+{
+    SIZE_T Begin;
+    SIZE_T End;
+};
+
+struct D3D12_BOX
+{
+    UINT left;
+    UINT top;
+    UINT front;
+    UINT right;
+    UINT bottom;
+    UINT back;
+};
+
+class ID3D12Resource;
+
+enum D3D12_RESOURCE_BARRIER_TYPE
+{
+    D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+    D3D12_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+    D3D12_RESOURCE_BARRIER_TYPE_UAV = 2,
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+    D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_BARRIER_FLAGS)
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+    ID3D12Resource* pResource;
+    UINT Subresource;
+    D3D12_RESOURCE_STATES StateBefore;
+    D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+    ID3D12Resource* pResourceBefore;
+    ID3D12Resource* pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+    ID3D12Resource* pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+    D3D12_RESOURCE_BARRIER_TYPE Type;
+    D3D12_RESOURCE_BARRIER_FLAGS Flags;
+    union
+    {
+        D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+        D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+        D3D12_RESOURCE_UAV_BARRIER UAV;
+    };
+};
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE
+{
+    D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0,
+    D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER = 1,
+    D3D12_DESCRIPTOR_HEAP_TYPE_RTV = 2,
+    D3D12_DESCRIPTOR_HEAP_TYPE_DSV = 3,
+};
+
+enum D3D12_DESCRIPTOR_HEAP_FLAGS
+{
+    D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0,
+    D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 0x1,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_DESCRIPTOR_HEAP_FLAGS)
+
+struct D3D12_DESCRIPTOR_HEAP_DESC
+{
+    D3D12_DESCRIPTOR_HEAP_TYPE Type;
+    UINT NumDescriptors;
+    D3D12_DESCRIPTOR_HEAP_FLAGS Flags;
+    UINT NodeMask;
+};
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE
+{
+    SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+    UINT64 ptr;
+};
+
+enum D3D12_SRV_DIMENSION
+{
+    D3D12_SRV_DIMENSION_UNKNOWN = 0,
+    D3D12_SRV_DIMENSION_BUFFER = 1,
+    D3D12_SRV_DIMENSION_TEXTURE2D = 4,
+    D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE = 11,
+};
+
+struct D3D12_TEX2D_SRV
+{
+    UINT MostDetailedMip;
+    UINT MipLevels;
+    UINT PlaneSlice;
+    FLOAT ResourceMinLODClamp;
+};
+
+struct D3D12_SHADER_RESOURCE_VIEW_DESC
+{
+    DXGI_FORMAT Format;
+    D3D12_SRV_DIMENSION ViewDimension;
+    UINT Shader4ComponentMapping;
+    union
+    {
+        D3D12_TEX2D_SRV Texture2D;
+    };
+};
+
+struct D3D12_SUBRESOURCE_FOOTPRINT
+{
+    DXGI_FORMAT Format;
+    UINT Width;
+    UINT Height;
+    UINT Depth;
+    UINT RowPitch;
+};
+
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT
+{
+    UINT64 Offset;
+    D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+};
+
+enum D3D12_TEXTURE_COPY_TYPE
+{
+    D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX = 0,
+    D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT = 1,
+};
+
+struct D3D12_TEXTURE_COPY_LOCATION
+{
+    ID3D12Resource* pResource;
+    D3D12_TEXTURE_COPY_TYPE Type;
+    union
+    {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint;
+        UINT SubresourceIndex;
+    };
+};
+
+enum D3D12_RAYTRACING_GEOMETRY_TYPE
+{
+    D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES = 0,
+    D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS = 1,
+};
+
+enum D3D12_RAYTRACING_GEOMETRY_FLAGS
+{
+    D3D12_RAYTRACING_GEOMETRY_FLAG_NONE = 0,
+    D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE = 0x1,
+    D3D12_RAYTRACING_GEOMETRY_FLAG_NO_DUPLICATE_ANYHIT_INVOCATION = 0x2,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RAYTRACING_GEOMETRY_FLAGS)
+
+struct D3D12_GPU_VIRTUAL_ADDRESS_AND_STRIDE
+{
+    D3D12_GPU_VIRTUAL_ADDRESS StartAddress;
+    UINT64 StrideInBytes;
+};
+
+struct D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC
+{
+    D3D12_GPU_VIRTUAL_ADDRESS Transform3x4;
+    DXGI_FORMAT IndexFormat;
+    DXGI_FORMAT VertexFormat;
+    UINT IndexCount;
+    UINT VertexCount;
+    D3D12_GPU_VIRTUAL_ADDRESS IndexBuffer;
+    D3D12_GPU_VIRTUAL_ADDRESS_AND_STRIDE VertexBuffer;
+};
+
+struct D3D12_RAYTRACING_AABB
+{
+    FLOAT MinX;
+    FLOAT MinY;
+    FLOAT MinZ;
+    FLOAT MaxX;
+    FLOAT MaxY;
+    FLOAT MaxZ;
+};
+
+struct D3D12_RAYTRACING_GEOMETRY_AABBS_DESC
+{
+    UINT64 AABBCount;
+    D3D12_GPU_VIRTUAL_ADDRESS_AND_STRIDE AABBs;
+};
+
+struct D3D12_RAYTRACING_GEOMETRY_DESC
+{
+    D3D12_RAYTRACING_GEOMETRY_TYPE Type;
+    D3D12_RAYTRACING_GEOMETRY_FLAGS Flags;
+    union
+    {
+        D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC Triangles;
+        D3D12_RAYTRACING_GEOMETRY_AABBS_DESC AABBs;
+    };
+};
+
+enum D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL = 0,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL = 1,
+};
+
+enum D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE = 0,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE = 0x1,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION = 0x2,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE = 0x4,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD = 0x8,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_MINIMIZE_MEMORY = 0x10,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE = 0x20,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS)
+
+enum D3D12_ELEMENTS_LAYOUT
+{
+    D3D12_ELEMENTS_LAYOUT_ARRAY = 0,
+    D3D12_ELEMENTS_LAYOUT_ARRAY_OF_POINTERS = 1,
+};
+
+struct D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE Type;
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS Flags;
+    UINT NumDescs;
+    D3D12_ELEMENTS_LAYOUT DescsLayout;
+    union
+    {
+        D3D12_GPU_VIRTUAL_ADDRESS InstanceDescs;
+        const D3D12_RAYTRACING_GEOMETRY_DESC* pGeometryDescs;
+        const D3D12_RAYTRACING_GEOMETRY_DESC* const* ppGeometryDescs;
+    };
+};
+
+struct D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO
+{
+    UINT64 ResultDataMaxSizeInBytes;
+    UINT64 ScratchDataSizeInBytes;
+    UINT64 UpdateScratchDataSizeInBytes;
+};
+
+struct D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC
+{
+    D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData;
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS Inputs;
+    D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData;
+    D3D12_GPU_VIRTUAL_ADDRESS ScratchAccelerationStructureData;
+};
+
+enum D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_TYPE
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE = 0,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_TOOLS_VISUALIZATION = 1,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION = 2,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE = 3,
+};
+
+struct D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC
+{
+    D3D12_GPU_VIRTUAL_ADDRESS DestBuffer;
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_TYPE InfoType;
+};
+
+struct D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC
+{
+    UINT64 CompactedSizeInBytes;
+};
+
+struct D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE_DESC
+{
+    UINT64 CurrentSizeInBytes;
+};
+
+enum D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE = 0,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT = 1,
+};
+
+enum D3D12_RAYTRACING_INSTANCE_FLAGS
+{
+    D3D12_RAYTRACING_INSTANCE_FLAG_NONE = 0,
+    D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_CULL_DISABLE = 0x1,
+    D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE = 0x2,
+    D3D12_RAYTRACING_INSTANCE_FLAG_FORCE_OPAQUE = 0x4,
+    D3D12_RAYTRACING_INSTANCE_FLAG_FORCE_NON_OPAQUE = 0x8,
+};
+DEFINE_ENUM_FLAG_OPERATORS(D3D12_RAYTRACING_INSTANCE_FLAGS)
+
+struct D3D12_RAYTRACING_INSTANCE_DESC
+{
+    FLOAT Transform[3][4];
+    UINT InstanceID : 24;
+    UINT InstanceMask : 8;
+    UINT InstanceContributionToHitGroupIndex : 24;
+    UINT Flags : 8;
+    D3D12_GPU_VIRTUAL_ADDRESS AccelerationStructure;
+};
+
+// ----------------------------------------------------------------------------------------------------
+// D3D12 interfaces
+// ----------------------------------------------------------------------------------------------------
+
+class ID3D12Object : public IUnknown
+{
+private:
+    std::atomic<ULONG> refCount{ 1 };
+    std::vector<std::pair<GUID, IUnknown*>> privateDataInterfaces;
+
+protected:
+    ID3D12Object() = default;
+    virtual ~ID3D12Object();
+
+public:
+    ID3D12Object(const ID3D12Object&) = delete;
+    ID3D12Object& operator=(const ID3D12Object&) = delete;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override;
+    ULONG STDMETHODCALLTYPE AddRef() override;
+    ULONG STDMETHODCALLTYPE Release() override;
+
+    HRESULT SetPrivateDataInterface(REFGUID guid, const IUnknown* pData);
+    HRESULT SetName(const wchar_t* name);
+};
+
+class ID3D12Resource : public ID3D12Object
+{
+    friend class ID3D12Device5;
+    friend class ID3D12GraphicsCommandList;
+    friend class ID3D12GraphicsCommandList4;
+    friend struct NullDeviceState;
+
+private:
+    D3D12_RESOURCE_DESC desc;
+    D3D12_HEAP_PROPERTIES heapProperties;
+    D3D12_HEAP_FLAGS heapFlags;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress{ 0 };
+
+    std::vector<uint8_t> data;
+
+    // tracked while command lists execute, which is also where barriers are validated
+    D3D12_RESOURCE_STATES state;
+    bool isStatePromoted{ false };
+
+    ID3D12Resource(const D3D12_HEAP_PROPERTIES& heapProperties,
+                   D3D12_HEAP_FLAGS heapFlags,
+                   const D3D12_RESOURCE_DESC& desc,
+                   D3D12_RESOURCE_STATES initialState,
+                   uint64_t sizeBytes);
+    ~ID3D12Resource() override;
+
+public:
+    HRESULT Map(UINT subresource, const D3D12_RANGE* pReadRange, void** ppData);
+    void Unmap(UINT subresource, const D3D12_RANGE* pWrittenRange);
+
+    D3D12_RESOURCE_DESC GetDesc() const;
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const;
+    HRESULT GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags) const;
+};
+
+class ID3D12DescriptorHeap : public ID3D12Object
+{
+    friend class ID3D12Device5;
+
+private:
+    D3D12_DESCRIPTOR_HEAP_DESC desc;
+    uint64_t baseHandle;
+
+    ID3D12DescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc, uint64_t baseHandle);
+
+public:
+    D3D12_DESCRIPTOR_HEAP_DESC GetDesc() const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() const;
+};
+
+class ID3D12GraphicsCommandList : public ID3D12Object
+{
+    friend struct NullDeviceState;
+
+protected:
+    std::vector<std::function<void()>> recordedCommands;
+    // keeps everything referenced by recorded commands alive until they have run, like the real API requires
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> referencedResources;
+    bool isClosed{ false };
+
+    void record(std::function<void()>&& command);
+    void reference(ID3D12Resource* resource);
+
+    ID3D12GraphicsCommandList() = default;
+
+public:
+    HRESULT Close();
+
+    void ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers);
+
+    void CopyBufferRegion(ID3D12Resource* pDstBuffer,
+                          UINT64 dstOffset,
+                          ID3D12Resource* pSrcBuffer,
+                          UINT64 srcOffset,
+                          UINT64 numBytes);
+    void CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource);
+    void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst,
+                           UINT dstX,
+                           UINT dstY,
+                           UINT dstZ,
+                           const D3D12_TEXTURE_COPY_LOCATION* pSrc,
+                           const D3D12_BOX* pSrcBox);
+};
+
+class ID3D12GraphicsCommandList4 : public ID3D12GraphicsCommandList
+{
+    friend struct NullDeviceState;
+
+private:
+    ID3D12GraphicsCommandList4() = default;
+
+public:
+    void BuildRaytracingAccelerationStructure(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* pDesc,
+        UINT numPostbuildInfoDescs,
+        const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pPostbuildInfoDescs);
+
+    void EmitRaytracingAccelerationStructurePostbuildInfo(
+        const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pDesc,
+        UINT numSourceAccelerationStructures,
+        const D3D12_GPU_VIRTUAL_ADDRESS* pSourceAccelerationStructureData);
+
+    void CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS destAccelerationStructureData,
+                                             D3D12_GPU_VIRTUAL_ADDRESS sourceAccelerationStructureData,
+                                             D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode);
+};
+
+class ID3D12Device5 : public ID3D12Object
+{
+    friend struct NullDeviceState;
+
+private:
+    ID3D12Device5() = default;
+
+public:
+    HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties,
+                                    D3D12_HEAP_FLAGS heapFlags,
+                                    const D3D12_RESOURCE_DESC* pDesc,
+                                    D3D12_RESOURCE_STATES initialResourceState,
+                                    const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+                                    REFIID riidResource,
+                                    void** ppvResource);
+
+    HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap);
+    UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const;
+    void CreateShaderResourceView(ID3D12Resource* pResource,
+                                  const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+                                  D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor);
+
+    D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT visibleMask,
+                                                             UINT numResourceDescs,
+                                                             const D3D12_RESOURCE_DESC* pResourceDescs) const;
+
+    void GetRaytracingAccelerationStructurePrebuildInfo(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* pDesc,
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* pInfo) const;
+};
@@ -0,0 +1,1197 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "null_device.h"
+
+#include "rendering/dxr_common.h"
+#include "rendering/renderer.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// renderer.cpp owns these on Windows; headless builds don't compile it
+namespace Renderer
+{
+
+ComPtr<ID3D12Device5> device;
+
+ComPtr<ID3D12DescriptorHeap> sharedHeap;
+
+} // namespace Renderer
+
+static constexpr uint64_t GPU_ADDRESS_BASE = 0x100000000ull;
+static constexpr uint64_t DESCRIPTOR_HANDLE_BASE = 0x10000ull;
+static constexpr UINT DESCRIPTOR_HANDLE_INCREMENT_SIZE = 32;
+static constexpr uint32_t NUM_SHARED_HEAP_DESCRIPTORS = 1024;
+
+// Written to the start of every acceleration structure so that later builds, updates and TLAS instances can check
+// that they point at something real. Sizes are rough per-element estimates in the range of what desktop drivers
+// report; only their relative magnitudes matter to the code using them.
+struct NullAccelerationStructureHeader
+{
+    static constexpr uint32_t MAGIC = 0x4e554c41; // "NULA"
+
+    uint32_t magic;
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE type;
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags;
+    uint32_t numElements;
+    uint64_t sizeBytes;
+    uint64_t compactedSizeBytes;
+};
+
+static constexpr uint64_t AS_HEADER_SIZE_BYTES = 256;
+static constexpr uint64_t BLAS_BYTES_PER_TRIANGLE = 96;
+static constexpr uint64_t BLAS_COMPACTED_BYTES_PER_TRIANGLE = 56;
+static constexpr uint64_t TLAS_BYTES_PER_INSTANCE = 128;
+static constexpr uint64_t SCRATCH_BYTES_PER_ELEMENT = 64;
+static constexpr uint64_t UPDATE_SCRATCH_BYTES_PER_ELEMENT = 32;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+struct NullDeviceState
+{
+    std::recursive_mutex mutex;
+
+    // buffers by GPU address, for resolving the addresses that DXR builds and TLAS instances refer to
+    std::map<D3D12_GPU_VIRTUAL_ADDRESS, ID3D12Resource*> buffersByAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS nextGpuAddress{ GPU_ADDRESS_BASE };
+    uint64_t nextDescriptorHandle{ DESCRIPTOR_HANDLE_BASE };
+
+    NullDevice::Stats stats{};
+
+    // [begin, end) byte ranges that buffer copies wrote to each resource since its last barrier; D3D12 doesn't order
+    // copies into the same resource without one in between, so these must not overlap
+    std::unordered_map<ID3D12Resource*, std::vector<std::pair<uint64_t, uint64_t>>> unorderedCopyWrites;
+
+    // the last fence value of work reading each descriptor, as told by NullDevice::useDescriptor()
+    std::unordered_map<uint64_t, uint64_t> descriptorFenceValues;
+    uint64_t completedFenceValue{ 0 };
+
+    struct ResolvedAddress
+    {
+        ID3D12Resource* resource{ nullptr };
+        uint64_t offsetBytes{ 0 };
+    };
+
+    void reportError(const char* format, ...)
+    {
+        std::lock_guard lock(this->mutex);
+        ++this->stats.numValidationErrors;
+
+        va_list args;
+        va_start(args, format);
+        fprintf(stderr, "NullDevice: ");
+        vfprintf(stderr, format, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+    }
+
+    // `sizeBytes` bytes starting at `address` must lie within a single live buffer
+    ResolvedAddress resolveAddress(D3D12_GPU_VIRTUAL_ADDRESS address, uint64_t sizeBytes, const char* usage)
+    {
+        auto it = this->buffersByAddress.upper_bound(address);
+        if (it != this->buffersByAddress.begin())
+        {
+            --it;
+            ID3D12Resource* resource = it->second;
+            const uint64_t offsetBytes = address - resource->gpuAddress;
+            if (offsetBytes + sizeBytes <= resource->data.size())
+            {
+                return { resource, offsetBytes };
+            }
+        }
+
+        this->reportError("%s at 0x%llx (%llu bytes) is not inside a live buffer",
+                          usage,
+                          static_cast<unsigned long long>(address),
+                          static_cast<unsigned long long>(sizeBytes));
+        return {};
+    }
+
+    void requireState(ID3D12Resource* resource, D3D12_RESOURCE_STATES requiredState, const char* usage)
+    {
+        if ((resource->state & requiredState) == requiredState)
+        {
+            return;
+        }
+
+        // buffers can be used in any state straight out of COMMON; textures only for reads and copies
+        const bool canPromote = resource->desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ||
+                                (requiredState & ~(D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+                                                   D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+                                                   D3D12_RESOURCE_STATE_COPY_DEST |
+                                                   D3D12_RESOURCE_STATE_COPY_SOURCE)) == 0;
+        if (resource->state == D3D12_RESOURCE_STATE_COMMON && canPromote)
+        {
+            resource->state = requiredState;
+            resource->isStatePromoted = true;
+            return;
+        }
+
+        this->reportError("%s needs state 0x%x but the resource is in state 0x%x",
+                          usage,
+                          static_cast<unsigned int>(requiredState),
+                          static_cast<unsigned int>(resource->state));
+    }
+
+    static void getPrebuildInfo(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs,
+                                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* prebuildInfo,
+                                uint64_t* numElements,
+                                uint64_t* compactedSizeBytes)
+    {
+        uint64_t bytesPerElement;
+        uint64_t compactedBytesPerElement;
+        if (inputs.Type == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL)
+        {
+            *numElements = inputs.NumDescs;
+            bytesPerElement = TLAS_BYTES_PER_INSTANCE;
+            compactedBytesPerElement = TLAS_BYTES_PER_INSTANCE;
+        }
+        else
+        {
+            *numElements = 0;
+            for (uint32_t geoIdx = 0; geoIdx < inputs.NumDescs; ++geoIdx)
+            {
+                const D3D12_RAYTRACING_GEOMETRY_DESC& geoDesc = inputs.DescsLayout == D3D12_ELEMENTS_LAYOUT_ARRAY
+                                                                    ? inputs.pGeometryDescs[geoIdx]
+                                                                    : *inputs.ppGeometryDescs[geoIdx];
+                if (geoDesc.Type == D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+                {
+                    const D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC& tris = geoDesc.Triangles;
+                    *numElements += (tris.IndexFormat == DXGI_FORMAT_UNKNOWN ? tris.VertexCount : tris.IndexCount) / 3;
+                }
+                else
+                {
+                    *numElements += geoDesc.AABBs.AABBCount;
+                }
+            }
+
+            bytesPerElement = BLAS_BYTES_PER_TRIANGLE;
+            compactedBytesPerElement = BLAS_COMPACTED_BYTES_PER_TRIANGLE;
+        }
+
+        const uint64_t alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
+        prebuildInfo->ResultDataMaxSizeInBytes =
+            alignUp(AS_HEADER_SIZE_BYTES + *numElements * bytesPerElement, alignment);
+        prebuildInfo->ScratchDataSizeInBytes = alignUp(*numElements * SCRATCH_BYTES_PER_ELEMENT + 1, alignment);
+        prebuildInfo->UpdateScratchDataSizeInBytes =
+            alignUp(*numElements * UPDATE_SCRATCH_BYTES_PER_ELEMENT + 1, alignment);
+        *compactedSizeBytes = alignUp(AS_HEADER_SIZE_BYTES + *numElements * compactedBytesPerElement, alignment);
+    }
+
+    static uint32_t getBytesPerPixel(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return 16;
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+            return 12;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return 8;
+        case DXGI_FORMAT_R16_UINT:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    // block compressed formats are stored as rows of 4x4 texel blocks; other formats count as 1x1 blocks
+    struct BlockInfo
+    {
+        uint32_t dim;
+        uint32_t sizeBytes;
+    };
+
+    static BlockInfo getBlockInfo(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return { 4, 16 };
+        default:
+            return { 1, getBytesPerPixel(format) };
+        }
+    }
+
+    // `width` and `height` are in texels, rounded up to whole blocks
+    struct SubresourceLayout
+    {
+        uint64_t offsetBytes;
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitchBytes;
+    };
+
+    // textures are stored tightly packed, one mip after the other
+    static SubresourceLayout getSubresourceLayout(const D3D12_RESOURCE_DESC& desc, uint32_t subresource)
+    {
+        const BlockInfo block = getBlockInfo(desc.Format);
+        const uint32_t numMips = std::max<uint32_t>(desc.MipLevels, 1);
+
+        SubresourceLayout layout{};
+        for (uint32_t mipIdx = 0; mipIdx <= std::min(subresource, numMips - 1); ++mipIdx)
+        {
+            layout.offsetBytes += static_cast<uint64_t>(layout.rowPitchBytes) * (layout.height / block.dim);
+            layout.width = static_cast<uint32_t>(
+                alignUp(std::max<uint32_t>(static_cast<uint32_t>(desc.Width >> mipIdx), 1), block.dim));
+            layout.height = static_cast<uint32_t>(alignUp(std::max<uint32_t>(desc.Height >> mipIdx, 1), block.dim));
+            layout.rowPitchBytes = layout.width / block.dim * block.sizeBytes;
+        }
+
+        return layout;
+    }
+
+    static uint64_t getResourceSizeBytes(const D3D12_RESOURCE_DESC& desc)
+    {
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            return desc.Width;
+        }
+
+        const uint32_t numMips = std::max<uint32_t>(desc.MipLevels, 1);
+        const SubresourceLayout lastMip = getSubresourceLayout(desc, numMips - 1);
+        const uint64_t bytesPerSlice = lastMip.offsetBytes + static_cast<uint64_t>(lastMip.rowPitchBytes) *
+                                                                 (lastMip.height / getBlockInfo(desc.Format).dim);
+        return bytesPerSlice * std::max<uint32_t>(desc.DepthOrArraySize, 1);
+    }
+
+    void executeBarrier(const D3D12_RESOURCE_BARRIER& barrier)
+    {
+        ++this->stats.numBarriers;
+
+        if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_UAV && barrier.UAV.pResource == nullptr)
+        {
+            this->unorderedCopyWrites.clear();
+        }
+        else if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_UAV)
+        {
+            this->unorderedCopyWrites.erase(barrier.UAV.pResource);
+        }
+
+        if (barrier.Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+        {
+            return;
+        }
+
+        this->unorderedCopyWrites.erase(barrier.Transition.pResource);
+
+        ID3D12Resource* resource = barrier.Transition.pResource;
+        if (resource->state == D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE)
+        {
+            this->reportError("acceleration structure buffers must stay in the acceleration structure state");
+        }
+        else if (resource->state != barrier.Transition.StateBefore)
+        {
+            this->reportError("transition barrier expects state 0x%x but the resource is in state 0x%x",
+                              static_cast<unsigned int>(barrier.Transition.StateBefore),
+                              static_cast<unsigned int>(resource->state));
+        }
+
+        resource->state = barrier.Transition.StateAfter;
+        resource->isStatePromoted = false;
+    }
+
+    void executeCopy(ID3D12Resource* dst, uint64_t dstOffset, ID3D12Resource* src, uint64_t srcOffset, uint64_t size)
+    {
+        this->requireState(src, D3D12_RESOURCE_STATE_COPY_SOURCE, "copy source");
+        this->requireState(dst, D3D12_RESOURCE_STATE_COPY_DEST, "copy destination");
+
+        if (srcOffset + size > src->data.size() || dstOffset + size > dst->data.size())
+        {
+            this->reportError("copy of %llu bytes is out of range", static_cast<unsigned long long>(size));
+            return;
+        }
+
+        if (src == dst && srcOffset < dstOffset + size && dstOffset < srcOffset + size)
+        {
+            this->reportError("copy source and destination overlap");
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t>>& writes = this->unorderedCopyWrites[dst];
+        for (const auto& [writeBegin, writeEnd] : writes)
+        {
+            if (dstOffset < writeEnd && writeBegin < dstOffset + size)
+            {
+                this->reportError("copies write overlapping ranges of a resource without a barrier in between");
+                break;
+            }
+        }
+        writes.emplace_back(dstOffset, dstOffset + size);
+
+        memmove(dst->data.data() + dstOffset, src->data.data() + srcOffset, size);
+
+        ++this->stats.numCopies;
+        this->stats.numBytesCopied += size;
+    }
+
+    void executeTextureCopy(const D3D12_TEXTURE_COPY_LOCATION& dst,
+                            UINT dstX,
+                            UINT dstY,
+                            const D3D12_TEXTURE_COPY_LOCATION& src)
+    {
+        this->requireState(src.pResource, D3D12_RESOURCE_STATE_COPY_SOURCE, "texture copy source");
+        this->requireState(dst.pResource, D3D12_RESOURCE_STATE_COPY_DEST, "texture copy destination");
+
+        // one side is a placed footprint in a buffer and the other a texture subresource
+        const bool isUpload = src.Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        const D3D12_TEXTURE_COPY_LOCATION& bufferLocation = isUpload ? src : dst;
+        const D3D12_TEXTURE_COPY_LOCATION& textureLocation = isUpload ? dst : src;
+        if (bufferLocation.Type != D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT ||
+            textureLocation.Type != D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
+        {
+            this->reportError("texture copies must be between a placed footprint and a subresource");
+            return;
+        }
+
+        ID3D12Resource* texture = textureLocation.pResource;
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = bufferLocation.PlacedFootprint;
+        const SubresourceLayout layout = getSubresourceLayout(texture->desc, textureLocation.SubresourceIndex);
+        const BlockInfo block = getBlockInfo(texture->desc.Format);
+        if (dstX % block.dim != 0 || dstY % block.dim != 0 || footprint.Footprint.Width % block.dim != 0 ||
+            footprint.Footprint.Height % block.dim != 0)
+        {
+            this->reportError("block compressed texture copies must cover whole blocks");
+            return;
+        }
+
+        const uint64_t rowSizeBytes = static_cast<uint64_t>(footprint.Footprint.Width / block.dim) * block.sizeBytes;
+        const uint32_t numRows = footprint.Footprint.Height / block.dim;
+
+        if (dstX + footprint.Footprint.Width > layout.width || dstY + footprint.Footprint.Height > layout.height ||
+            footprint.Offset + static_cast<uint64_t>(footprint.Footprint.RowPitch) * (numRows - 1) + rowSizeBytes >
+                bufferLocation.pResource->data.size())
+        {
+            this->reportError("texture copy is out of range");
+            return;
+        }
+
+        for (uint32_t row = 0; row < numRows; ++row)
+        {
+            uint8_t* bufferRow =
+                bufferLocation.pResource->data.data() + footprint.Offset + row * footprint.Footprint.RowPitch;
+            uint8_t* textureRow = texture->data.data() + layout.offsetBytes +
+                                  static_cast<uint64_t>(dstY / block.dim + row) * layout.rowPitchBytes +
+                                  dstX / block.dim * block.sizeBytes;
+            if (isUpload)
+            {
+                memcpy(textureRow, bufferRow, rowSizeBytes);
+            }
+            else
+            {
+                memcpy(bufferRow, textureRow, rowSizeBytes);
+            }
+        }
+
+        ++this->stats.numCopies;
+        this->stats.numBytesCopied += rowSizeBytes * numRows;
+    }
+
+    NullAccelerationStructureHeader* resolveAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS address, const char* usage)
+    {
+        const ResolvedAddress resolved = this->resolveAddress(address, sizeof(NullAccelerationStructureHeader), usage);
+        if (resolved.resource == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto header =
+            reinterpret_cast<NullAccelerationStructureHeader*>(resolved.resource->data.data() + resolved.offsetBytes);
+        if (header->magic != NullAccelerationStructureHeader::MAGIC)
+        {
+            this->reportError("%s at 0x%llx does not hold a built acceleration structure",
+                              usage,
+                              static_cast<unsigned long long>(address));
+            return nullptr;
+        }
+
+        return header;
+    }
+
+    void executeBuild(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC& desc,
+                      const std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geoDescs,
+                      const std::vector<D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC>& postbuildDescs)
+    {
+        ++this->stats.numAccelerationStructureBuilds;
+
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = desc.Inputs;
+        const bool isTlas = inputs.Type == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+        if (!isTlas)
+        {
+            inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            inputs.pGeometryDescs = geoDescs.data();
+        }
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+        uint64_t numElements;
+        uint64_t compactedSizeBytes;
+        getPrebuildInfo(inputs, &prebuildInfo, &numElements, &compactedSizeBytes);
+
+        const bool isUpdate = (inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE) != 0;
+        if (isUpdate)
+        {
+            ++this->stats.numAccelerationStructureUpdates;
+
+            const NullAccelerationStructureHeader* source =
+                this->resolveAccelerationStructure(desc.SourceAccelerationStructureData, "update source");
+            if (source != nullptr &&
+                (source->type != inputs.Type || source->numElements != numElements ||
+                 (source->buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE) == 0))
+            {
+                this->reportError("update source was not built with ALLOW_UPDATE and the same inputs");
+            }
+        }
+
+        const uint64_t scratchSizeBytes =
+            isUpdate ? prebuildInfo.UpdateScratchDataSizeInBytes : prebuildInfo.ScratchDataSizeInBytes;
+        const ResolvedAddress scratch =
+            this->resolveAddress(desc.ScratchAccelerationStructureData, scratchSizeBytes, "build scratch");
+        if (scratch.resource != nullptr)
+        {
+            this->requireState(scratch.resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "build scratch");
+        }
+
+        if (isTlas)
+        {
+            const uint64_t instanceDescsSizeBytes = numElements * sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+            const ResolvedAddress instanceDescs =
+                this->resolveAddress(inputs.InstanceDescs, instanceDescsSizeBytes, "TLAS instance descs");
+            if (instanceDescs.resource != nullptr)
+            {
+                this->requireState(
+                    instanceDescs.resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, "TLAS instance descs");
+
+                const auto instances = reinterpret_cast<const D3D12_RAYTRACING_INSTANCE_DESC*>(
+                    instanceDescs.resource->data.data() + instanceDescs.offsetBytes);
+                for (uint64_t instanceIdx = 0; instanceIdx < numElements; ++instanceIdx)
+                {
+                    // a null address marks an inactive instance
+                    const D3D12_GPU_VIRTUAL_ADDRESS blasAddress = instances[instanceIdx].AccelerationStructure;
+                    if (blasAddress != 0)
+                    {
+                        const NullAccelerationStructureHeader* blas =
+                            this->resolveAccelerationStructure(blasAddress, "TLAS instance BLAS");
+                        if (blas != nullptr && blas->type != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL)
+                        {
+                            this->reportError("TLAS instance %llu does not point at a BLAS",
+                                              static_cast<unsigned long long>(instanceIdx));
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (const D3D12_RAYTRACING_GEOMETRY_DESC& geoDesc : geoDescs)
+            {
+                if (geoDesc.Type != D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+                {
+                    continue;
+                }
+
+                const D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC& tris = geoDesc.Triangles;
+                this->resolveAddress(tris.VertexBuffer.StartAddress,
+                                     (tris.VertexCount - 1) * tris.VertexBuffer.StrideInBytes + 3 * sizeof(float),
+                                     "BLAS vertex buffer");
+                if (tris.IndexFormat != DXGI_FORMAT_UNKNOWN)
+                {
+                    const uint64_t indexSizeBytes = tris.IndexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+                    this->resolveAddress(tris.IndexBuffer, tris.IndexCount * indexSizeBytes, "BLAS index buffer");
+                }
+            }
+        }
+
+        const ResolvedAddress dest = this->resolveAddress(desc.DestAccelerationStructureData,
+                                                          prebuildInfo.ResultDataMaxSizeInBytes,
+                                                          "build destination");
+        if (dest.resource != nullptr)
+        {
+            if (dest.resource->state != D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE)
+            {
+                this->reportError("build destination is not an acceleration structure buffer");
+            }
+
+            const NullAccelerationStructureHeader header = {
+                .magic = NullAccelerationStructureHeader::MAGIC,
+                .type = inputs.Type,
+                .buildFlags = inputs.Flags & ~D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE,
+                .numElements = static_cast<uint32_t>(numElements),
+                .sizeBytes = prebuildInfo.ResultDataMaxSizeInBytes,
+                .compactedSizeBytes = compactedSizeBytes,
+            };
+            memcpy(dest.resource->data.data() + dest.offsetBytes, &header, sizeof(header));
+        }
+
+        if (!postbuildDescs.empty())
+        {
+            const D3D12_GPU_VIRTUAL_ADDRESS destAddress = desc.DestAccelerationStructureData;
+            for (const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC& postbuildDesc : postbuildDescs)
+            {
+                this->executeEmitPostbuildInfo(postbuildDesc, { destAddress });
+            }
+        }
+    }
+
+    void executeEmitPostbuildInfo(const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC& desc,
+                                  const std::vector<D3D12_GPU_VIRTUAL_ADDRESS>& sourceAddresses)
+    {
+        const uint64_t sizeBytes = sourceAddresses.size() * sizeof(uint64_t);
+        const ResolvedAddress dest = this->resolveAddress(desc.DestBuffer, sizeBytes, "postbuild info destination");
+        if (dest.resource == nullptr)
+        {
+            return;
+        }
+
+        this->requireState(dest.resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "postbuild info destination");
+        if (desc.DestBuffer % sizeof(uint64_t) != 0)
+        {
+            this->reportError("postbuild info destination must be 8 byte aligned");
+        }
+
+        for (size_t sourceIdx = 0; sourceIdx < sourceAddresses.size(); ++sourceIdx)
+        {
+            const NullAccelerationStructureHeader* source =
+                this->resolveAccelerationStructure(sourceAddresses[sourceIdx], "postbuild info source");
+            if (source == nullptr)
+            {
+                continue;
+            }
+
+            uint64_t value = source->sizeBytes;
+            if (desc.InfoType == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE)
+            {
+                if ((source->buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION) == 0)
+                {
+                    this->reportError("compacted size queried for a structure built without ALLOW_COMPACTION");
+                }
+
+                value = source->compactedSizeBytes;
+            }
+
+            memcpy(dest.resource->data.data() + dest.offsetBytes + sourceIdx * sizeof(uint64_t), &value, sizeof(value));
+        }
+    }
+
+    void executeAccelerationStructureCopy(D3D12_GPU_VIRTUAL_ADDRESS destAddress,
+                                          D3D12_GPU_VIRTUAL_ADDRESS sourceAddress,
+                                          D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode)
+    {
+        const NullAccelerationStructureHeader* source =
+            this->resolveAccelerationStructure(sourceAddress, "copy source");
+        if (source == nullptr)
+        {
+            return;
+        }
+
+        NullAccelerationStructureHeader header = *source;
+        if (mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT)
+        {
+            if ((header.buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION) == 0)
+            {
+                this->reportError("compacting a structure built without ALLOW_COMPACTION");
+            }
+
+            header.sizeBytes = header.compactedSizeBytes;
+        }
+
+        const ResolvedAddress dest = this->resolveAddress(destAddress, header.sizeBytes, "copy destination");
+        if (dest.resource == nullptr)
+        {
+            return;
+        }
+
+        if (dest.resource->state != D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE)
+        {
+            this->reportError("copy destination is not an acceleration structure buffer");
+        }
+
+        if (destAddress % D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT != 0)
+        {
+            this->reportError("copy destination is not aligned to the acceleration structure alignment");
+        }
+
+        memcpy(dest.resource->data.data() + dest.offsetBytes, &header, sizeof(header));
+
+        ++this->stats.numCopies;
+        this->stats.numBytesCopied += header.sizeBytes;
+    }
+
+    template<typename T> static ComPtr<T> makeObject(T* object)
+    {
+        ComPtr<T> ptr;
+        ptr.Attach(object);
+        return ptr;
+    }
+
+    static ComPtr<ID3D12Device5> makeDevice()
+    {
+        return makeObject(new ID3D12Device5());
+    }
+
+    static ComPtr<ID3D12GraphicsCommandList4> makeCommandList()
+    {
+        return makeObject(new ID3D12GraphicsCommandList4());
+    }
+
+    static void executeCommandList(NullDeviceState& state, ID3D12GraphicsCommandList4* cmdList);
+};
+
+static NullDeviceState& getState()
+{
+    // never destroyed, since resources held by globals may be released after it during shutdown
+    static NullDeviceState* state = new NullDeviceState();
+    return *state;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// COM
+// ----------------------------------------------------------------------------------------------------
+
+namespace NullD3D12
+{
+
+GUID makeUniqueIid()
+{
+    static std::atomic<uint32_t> nextIid{ 1 };
+    return { .Data1 = nextIid++ };
+}
+
+} // namespace NullD3D12
+
+ID3D12Object::~ID3D12Object()
+{
+    for (const auto& [guid, privateData] : this->privateDataInterfaces)
+    {
+        privateData->Release();
+    }
+}
+
+HRESULT ID3D12Object::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (riid == __uuidof(IUnknown))
+    {
+        *ppvObject = static_cast<IUnknown*>(this);
+        this->AddRef();
+        return S_OK;
+    }
+
+    *ppvObject = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG ID3D12Object::AddRef()
+{
+    return ++this->refCount;
+}
+
+ULONG ID3D12Object::Release()
+{
+    const ULONG newRefCount = --this->refCount;
+    if (newRefCount == 0)
+    {
+        delete this;
+    }
+
+    return newRefCount;
+}
+
+HRESULT ID3D12Object::SetPrivateDataInterface(REFGUID guid, const IUnknown* pData)
+{
+    IUnknown* data = const_cast<IUnknown*>(pData);
+    if (data != nullptr)
+    {
+        data->AddRef();
+    }
+
+    for (auto& [existingGuid, existingData] : this->privateDataInterfaces)
+    {
+        if (existingGuid == guid)
+        {
+            existingData->Release();
+            existingData = data;
+            return S_OK;
+        }
+    }
+
+    if (data != nullptr)
+    {
+        this->privateDataInterfaces.emplace_back(guid, data);
+    }
+
+    return S_OK;
+}
+
+HRESULT ID3D12Object::SetName(const wchar_t* name)
+{
+    return S_OK;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ID3D12Resource
+// ----------------------------------------------------------------------------------------------------
+
+ID3D12Resource::ID3D12Resource(const D3D12_HEAP_PROPERTIES& heapProperties,
+                               D3D12_HEAP_FLAGS heapFlags,
+                               const D3D12_RESOURCE_DESC& desc,
+                               D3D12_RESOURCE_STATES initialState,
+                               uint64_t sizeBytes)
+    : desc(desc), heapProperties(heapProperties), heapFlags(heapFlags), data(sizeBytes), state(initialState)
+{
+    if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        return;
+    }
+
+    NullDeviceState& nullState = getState();
+    std::lock_guard lock(nullState.mutex);
+
+    this->gpuAddress = nullState.nextGpuAddress;
+    nullState.nextGpuAddress += alignUp(std::max<uint64_t>(sizeBytes, 1), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    nullState.buffersByAddress[this->gpuAddress] = this;
+}
+
+ID3D12Resource::~ID3D12Resource()
+{
+    if (this->gpuAddress == 0)
+    {
+        return;
+    }
+
+    NullDeviceState& nullState = getState();
+    std::lock_guard lock(nullState.mutex);
+    nullState.buffersByAddress.erase(this->gpuAddress);
+}
+
+HRESULT ID3D12Resource::Map(UINT subresource, const D3D12_RANGE* pReadRange, void** ppData)
+{
+    if (this->heapProperties.Type != D3D12_HEAP_TYPE_UPLOAD && this->heapProperties.Type != D3D12_HEAP_TYPE_READBACK)
+    {
+        getState().reportError("only upload and readback resources can be mapped");
+        return E_INVALIDARG;
+    }
+
+    if (ppData != nullptr)
+    {
+        *ppData = this->data.data();
+    }
+
+    return S_OK;
+}
+
+void ID3D12Resource::Unmap(UINT subresource, const D3D12_RANGE* pWrittenRange)
+{}
+
+D3D12_RESOURCE_DESC ID3D12Resource::GetDesc() const
+{
+    return this->desc;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ID3D12Resource::GetGPUVirtualAddress() const
+{
+    return this->gpuAddress;
+}
+
+HRESULT ID3D12Resource::GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags) const
+{
+    if (pHeapProperties != nullptr)
+    {
+        *pHeapProperties = this->heapProperties;
+    }
+
+    if (pHeapFlags != nullptr)
+    {
+        *pHeapFlags = this->heapFlags;
+    }
+
+    return S_OK;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ID3D12DescriptorHeap
+// ----------------------------------------------------------------------------------------------------
+
+ID3D12DescriptorHeap::ID3D12DescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc, uint64_t baseHandle)
+    : desc(desc), baseHandle(baseHandle)
+{}
+
+D3D12_DESCRIPTOR_HEAP_DESC ID3D12DescriptorHeap::GetDesc() const
+{
+    return this->desc;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ID3D12DescriptorHeap::GetCPUDescriptorHandleForHeapStart() const
+{
+    return { .ptr = this->baseHandle };
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE ID3D12DescriptorHeap::GetGPUDescriptorHandleForHeapStart() const
+{
+    return { .ptr = this->baseHandle };
+}
+
+// ----------------------------------------------------------------------------------------------------
+// command lists
+// ----------------------------------------------------------------------------------------------------
+
+void ID3D12GraphicsCommandList::record(std::function<void()>&& command)
+{
+    if (this->isClosed)
+    {
+        getState().reportError("recording into a closed command list");
+    }
+
+    this->recordedCommands.push_back(std::move(command));
+}
+
+void ID3D12GraphicsCommandList::reference(ID3D12Resource* resource)
+{
+    this->referencedResources.emplace_back(resource);
+}
+
+HRESULT ID3D12GraphicsCommandList::Close()
+{
+    this->isClosed = true;
+    return S_OK;
+}
+
+void ID3D12GraphicsCommandList::ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers)
+{
+    for (UINT barrierIdx = 0; barrierIdx < numBarriers; ++barrierIdx)
+    {
+        const D3D12_RESOURCE_BARRIER barrier = pBarriers[barrierIdx];
+        if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+        {
+            this->reference(barrier.Transition.pResource);
+        }
+
+        this->record([barrier]() { getState().executeBarrier(barrier); });
+    }
+}
+
+void ID3D12GraphicsCommandList::CopyBufferRegion(ID3D12Resource* pDstBuffer,
+                                                 UINT64 dstOffset,
+                                                 ID3D12Resource* pSrcBuffer,
+                                                 UINT64 srcOffset,
+                                                 UINT64 numBytes)
+{
+    this->reference(pDstBuffer);
+    this->reference(pSrcBuffer);
+    this->record([=]() { getState().executeCopy(pDstBuffer, dstOffset, pSrcBuffer, srcOffset, numBytes); });
+}
+
+void ID3D12GraphicsCommandList::CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource)
+{
+    this->reference(pDstResource);
+    this->reference(pSrcResource);
+    this->record([=]() {
+        NullDeviceState& state = getState();
+        if (pDstResource->data.size() != pSrcResource->data.size())
+        {
+            state.reportError("CopyResource between resources of different sizes");
+        }
+
+        const uint64_t sizeBytes = std::min(pDstResource->data.size(), pSrcResource->data.size());
+        state.executeCopy(pDstResource, 0, pSrcResource, 0, sizeBytes);
+    });
+}
+
+void ID3D12GraphicsCommandList::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst,
+                                                  UINT dstX,
+                                                  UINT dstY,
+                                                  UINT dstZ,
+                                                  const D3D12_TEXTURE_COPY_LOCATION* pSrc,
+                                                  const D3D12_BOX* pSrcBox)
+{
+    if (dstZ != 0 || pSrcBox != nullptr)
+    {
+        getState().reportError("CopyTextureRegion only supports whole 2D footprints");
+        return;
+    }
+
+    const D3D12_TEXTURE_COPY_LOCATION dst = *pDst;
+    const D3D12_TEXTURE_COPY_LOCATION src = *pSrc;
+    this->reference(dst.pResource);
+    this->reference(src.pResource);
+    this->record([=]() { getState().executeTextureCopy(dst, dstX, dstY, src); });
+}
+
+void ID3D12GraphicsCommandList4::BuildRaytracingAccelerationStructure(
+    const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* pDesc,
+    UINT numPostbuildInfoDescs,
+    const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pPostbuildInfoDescs)
+{
+    // geometry descs are read at record time, everything behind GPU addresses at execution time
+    const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = *pDesc;
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geoDescs;
+    if (desc.Inputs.Type == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL)
+    {
+        geoDescs.reserve(desc.Inputs.NumDescs);
+        for (uint32_t geoIdx = 0; geoIdx < desc.Inputs.NumDescs; ++geoIdx)
+        {
+            geoDescs.push_back(desc.Inputs.DescsLayout == D3D12_ELEMENTS_LAYOUT_ARRAY
+                                   ? desc.Inputs.pGeometryDescs[geoIdx]
+                                   : *desc.Inputs.ppGeometryDescs[geoIdx]);
+        }
+    }
+
+    std::vector<D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC> postbuildDescs(
+        pPostbuildInfoDescs, pPostbuildInfoDescs + numPostbuildInfoDescs);
+
+    this->record([desc, geoDescs = std::move(geoDescs), postbuildDescs = std::move(postbuildDescs)]() {
+        getState().executeBuild(desc, geoDescs, postbuildDescs);
+    });
+}
+
+void ID3D12GraphicsCommandList4::EmitRaytracingAccelerationStructurePostbuildInfo(
+    const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pDesc,
+    UINT numSourceAccelerationStructures,
+    const D3D12_GPU_VIRTUAL_ADDRESS* pSourceAccelerationStructureData)
+{
+    const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC desc = *pDesc;
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> sourceAddresses(
+        pSourceAccelerationStructureData, pSourceAccelerationStructureData + numSourceAccelerationStructures);
+    this->record([desc, sourceAddresses = std::move(sourceAddresses)]() {
+        getState().executeEmitPostbuildInfo(desc, sourceAddresses);
+    });
+}
+
+void ID3D12GraphicsCommandList4::CopyRaytracingAccelerationStructure(
+    D3D12_GPU_VIRTUAL_ADDRESS destAccelerationStructureData,
+    D3D12_GPU_VIRTUAL_ADDRESS sourceAccelerationStructureData,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode)
+{
+    this->record([=]() {
+        getState().executeAccelerationStructureCopy(
+            destAccelerationStructureData, sourceAccelerationStructureData, mode);
+    });
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ID3D12Device5
+// ----------------------------------------------------------------------------------------------------
+
+HRESULT ID3D12Device5::CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties,
+                                               D3D12_HEAP_FLAGS heapFlags,
+                                               const D3D12_RESOURCE_DESC* pDesc,
+                                               D3D12_RESOURCE_STATES initialResourceState,
+                                               const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+                                               REFIID riidResource,
+                                               void** ppvResource)
+{
+    NullDeviceState& state = getState();
+
+    if (!(riidResource == __uuidof(ID3D12Resource)))
+    {
+        return E_NOINTERFACE;
+    }
+
+    if ((pHeapProperties->Type == D3D12_HEAP_TYPE_UPLOAD &&
+         initialResourceState != D3D12_RESOURCE_STATE_GENERIC_READ) ||
+        (pHeapProperties->Type == D3D12_HEAP_TYPE_READBACK && initialResourceState != D3D12_RESOURCE_STATE_COPY_DEST))
+    {
+        state.reportError("upload resources must start in GENERIC_READ and readback resources in COPY_DEST");
+        return E_INVALIDARG;
+    }
+
+    if (initialResourceState == D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE &&
+        (pDesc->Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) == 0)
+    {
+        state.reportError("acceleration structure buffers must allow unordered access");
+        return E_INVALIDARG;
+    }
+
+    *ppvResource = new ID3D12Resource(
+        *pHeapProperties, heapFlags, *pDesc, initialResourceState, NullDeviceState::getResourceSizeBytes(*pDesc));
+    return S_OK;
+}
+
+HRESULT ID3D12Device5::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc,
+                                            REFIID riid,
+                                            void** ppvHeap)
+{
+    if (!(riid == __uuidof(ID3D12DescriptorHeap)))
+    {
+        return E_NOINTERFACE;
+    }
+
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+
+    *ppvHeap = new ID3D12DescriptorHeap(*pDescriptorHeapDesc, state.nextDescriptorHandle);
+    state.nextDescriptorHandle +=
+        static_cast<uint64_t>(pDescriptorHeapDesc->NumDescriptors) * DESCRIPTOR_HANDLE_INCREMENT_SIZE;
+    return S_OK;
+}
+
+UINT ID3D12Device5::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const
+{
+    return DESCRIPTOR_HANDLE_INCREMENT_SIZE;
+}
+
+void ID3D12Device5::CreateShaderResourceView(ID3D12Resource* pResource,
+                                             const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+                                             D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+
+    const auto it = state.descriptorFenceValues.find(destDescriptor.ptr);
+    if (it != state.descriptorFenceValues.end() && it->second > state.completedFenceValue)
+    {
+        state.reportError("rewriting descriptor 0x%llx, which work up to fence %llu may still read",
+                          static_cast<unsigned long long>(destDescriptor.ptr),
+                          static_cast<unsigned long long>(it->second));
+    }
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO ID3D12Device5::GetResourceAllocationInfo(
+    UINT visibleMask,
+    UINT numResourceDescs,
+    const D3D12_RESOURCE_DESC* pResourceDescs) const
+{
+    uint64_t sizeBytes = 0;
+    for (UINT descIdx = 0; descIdx < numResourceDescs; ++descIdx)
+    {
+        sizeBytes += alignUp(NullDeviceState::getResourceSizeBytes(pResourceDescs[descIdx]),
+                             D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    }
+
+    return { .SizeInBytes = sizeBytes, .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+}
+
+void ID3D12Device5::GetRaytracingAccelerationStructurePrebuildInfo(
+    const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* pDesc,
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* pInfo) const
+{
+    uint64_t numElements;
+    uint64_t compactedSizeBytes;
+    NullDeviceState::getPrebuildInfo(*pDesc, pInfo, &numElements, &compactedSizeBytes);
+}
+
+// ----------------------------------------------------------------------------------------------------
+// NullDevice
+// ----------------------------------------------------------------------------------------------------
+
+void NullDeviceState::executeCommandList(NullDeviceState& state, ID3D12GraphicsCommandList4* cmdList)
+{
+    if (!cmdList->isClosed)
+    {
+        state.reportError("executing a command list that was not closed");
+    }
+
+    {
+        std::lock_guard lock(state.mutex);
+
+        for (const std::function<void()>& command : cmdList->recordedCommands)
+        {
+            command();
+        }
+        state.unorderedCopyWrites.clear();
+
+        ++state.stats.numCommandListsExecuted;
+    }
+
+    // dropping the references can destroy resources, which takes the lock itself
+    cmdList->recordedCommands.clear();
+    cmdList->referencedResources.clear();
+    cmdList->isClosed = false;
+}
+
+namespace NullDevice
+{
+
+void init()
+{
+    Renderer::device = NullDeviceState::makeDevice();
+
+    const D3D12_DESCRIPTOR_HEAP_DESC sharedHeapDesc = {
+        .Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+        .NumDescriptors = NUM_SHARED_HEAP_DESCRIPTORS,
+        .Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
+    };
+    CHECK_HRESULT(Renderer::device->CreateDescriptorHeap(&sharedHeapDesc, IID_PPV_ARGS(&Renderer::sharedHeap)));
+
+    resetFences();
+}
+
+void shutdown()
+{
+    Renderer::sharedHeap = nullptr;
+    Renderer::device = nullptr;
+}
+
+ComPtr<ID3D12GraphicsCommandList4> createCommandList()
+{
+    return NullDeviceState::makeCommandList();
+}
+
+void executeCommandList(ID3D12GraphicsCommandList4* cmdList)
+{
+    NullDeviceState::executeCommandList(getState(), cmdList);
+}
+
+Stats getStats()
+{
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+    return state.stats;
+}
+
+void resetStats()
+{
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+    state.stats = {};
+}
+
+void useDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE descriptor, uint64_t fenceValue)
+{
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+    uint64_t& descriptorFenceValue = state.descriptorFenceValues[descriptor.ptr];
+    descriptorFenceValue = std::max(fenceValue, descriptorFenceValue);
+}
+
+void completeFence(uint64_t fenceValue)
+{
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+    state.completedFenceValue = std::max(fenceValue, state.completedFenceValue);
+}
+
+void resetFences()
+{
+    NullDeviceState& state = getState();
+    std::lock_guard lock(state.mutex);
+    state.descriptorFenceValues.clear();
+    state.completedFenceValue = 0;
+}
+
+} // namespace NullDevice
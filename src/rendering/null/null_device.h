@@ -0,0 +1,64 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "rendering/dxr_includes.h"
+
+#include <cstdint>
+
+// Entry points for driving the null device, which stand in for the swap chain, queue and fence handling that
+// renderer.cpp does on Windows.
+namespace NullDevice
+{
+
+struct Stats
+{
+    uint64_t numCommandListsExecuted{ 0 };
+    uint64_t numBarriers{ 0 };
+    uint64_t numCopies{ 0 };
+    uint64_t numBytesCopied{ 0 };
+    uint64_t numAccelerationStructureBuilds{ 0 };
+    // builds with PERFORM_UPDATE, also counted in numAccelerationStructureBuilds
+    uint64_t numAccelerationStructureUpdates{ 0 };
+    // misuse that the D3D12 debug layer would also catch (mismatched barriers, out of range addresses, etc.)
+    uint64_t numValidationErrors{ 0 };
+};
+
+// creates Renderer::device and Renderer::sharedHeap
+void init();
+void shutdown();
+
+Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList4> createCommandList();
+
+// Runs everything recorded into `cmdList` in order, as if it had been submitted and waited on. The list must be
+// closed; it is reset and ready for recording again afterwards.
+void executeCommandList(ID3D12GraphicsCommandList4* cmdList);
+
+Stats getStats();
+void resetStats();
+
+// Stand-ins for binding descriptors and waiting on a fence. A descriptor that work up to `fenceValue` reads can't be
+// rewritten until completeFence() has reached that value; on a real queue, doing so would need a full wait first.
+void useDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE descriptor, uint64_t fenceValue);
+void completeFence(uint64_t fenceValue);
+// forgets every use of descriptors, as if the queue had drained, so that fence values can start over
+void resetFences();
+
+} // namespace NullDevice
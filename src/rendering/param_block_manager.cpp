@@ -24,8 +24,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 void ParamBlockManager::init()
 {
     constexpr uint32_t bufferSize = sizeof(CameraParams) + sizeof(SceneParams);
-    this->dev_paramBuffer =
-        BufferHelper::createBasicBuffer(bufferSize, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ);
+    this->dev_paramBuffer = BufferHelper::createBasicBuffer(
+        bufferSize, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ, MemoryTag::CONSTANTS);
     this->dev_paramBuffer->Map(0, nullptr, &this->host_paramBuffer);
 
     uint8_t* hostBufferStartPtr = static_cast<uint8_t*>(this->host_paramBuffer);
@@ -27,10 +27,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "buffer/buffer_helper.h"
 #include "buffer/managed_buffer.h"
 #include "buffer/to_free_list.h"
+#include "buffer/upload_ring.h"
 #include "common/common_hitgroups.h"
 #include "common/common_registers.h"
+#include "core/retirement_queue.h"
+#include "scene/async_scene_loader.h"
 #include "scene/camera.h"
-#include "scene/gltf_loader.h"
 #include "scene/scene.h"
 
 #include <chrono>
@@ -41,6 +43,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <algorithm>
 #include <vector>
 #include <cstdio>
+#include <string>
 #include <shlobj.h>
 
 #include "slang/slang.h"
@@ -63,6 +66,7 @@ void compileShadersAndInitPipeline();
 
 void beginFrame();
 void submitCmd();
+void waitForFence(uint64_t fenceValue);
 
 constexpr uint32_t NUM_FRAMES_IN_FLIGHT = 3;
 
@@ -71,7 +75,7 @@ struct FrameContext
     uint64_t fenceValue{ 0 };
 
     ComPtr<ID3D12CommandAllocator> cmdAlloc{ nullptr };
-    ToFreeList toFreeList{};
+    UploadRing uploadRing{};
 
     ParamBlockManager paramBlockManager{};
 };
@@ -79,6 +83,11 @@ struct FrameContext
 FrameContext frameCtxs[NUM_FRAMES_IN_FLIGHT];
 uint32_t frameCtxIdx = 0;
 uint64_t nextFenceValue = 1;
+
+// Collects everything released since the last submission. It's tagged with the next submission's fence value, since
+// the GPU may use these until all work submitted so far has completed.
+ToFreeList toFreeList{};
+RetirementQueue<ToFreeList> retirementQueue{};
 HANDLE fenceEvent;
 HANDLE frameLatencyWaitable;
 
@@ -90,6 +99,7 @@ Camera camera;
 ComPtr<ID3D12GraphicsCommandList4> cmdList;
 
 Scene scene;
+AsyncSceneLoader asyncSceneLoader;
 
 void init()
 {
@@ -100,6 +110,7 @@ void init()
     for (auto& frame : frameCtxs)
     {
         frame.paramBlockManager.init();
+        frame.uploadRing.init(4 * 1024 * 1024 /*bytes*/);
     }
 
     camera.init(XMConvertToRadians(defaultFovYDegrees));
@@ -111,6 +122,7 @@ void init()
     }
 
     scene.init();
+    asyncSceneLoader.init(&scene);
 
     initRootSignature();
     compileShadersAndInitPipeline();
@@ -118,8 +130,7 @@ void init()
 
 void loadGltf(const std::string& filePathStr)
 {
-    flush();
-    GltfLoader::loadGltf(filePathStr, scene);
+    asyncSceneLoader.requestLoad(filePathStr);
 }
 
 ComPtr<IDXGIFactory4> factory;
@@ -201,7 +212,7 @@ void initRenderTarget()
 
     D3D12_DESCRIPTOR_HEAP_DESC sharedHeapDesc = {
         .Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
-        .NumDescriptors = MAX_NUM_TEXTURES + 1,
+        .NumDescriptors = NUM_TEXTURE_DESCRIPTORS + 1,
         .Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE
     };
     device->CreateDescriptorHeap(&sharedHeapDesc, IID_PPV_ARGS(&sharedHeap));
@@ -222,7 +233,8 @@ void resize()
     const uint32_t width = std::max<uint32_t>(rect.right - rect.left, 1);
     const uint32_t height = std::max<uint32_t>(rect.bottom - rect.top, 1);
 
-    flush();
+    // ResizeBuffers() requires that no queued work still references the back buffers
+    waitForFence(nextFenceValue - 1);
 
     swapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, swapChainFlags);
     swapChain->SetMaximumFrameLatency(NUM_FRAMES_IN_FLIGHT - 1);
@@ -230,6 +242,7 @@ void resize()
 
     if (renderTarget)
     {
+        toFreeList.pushResource(renderTarget, false);
         renderTarget.Reset();
     }
 
@@ -249,6 +262,7 @@ void resize()
                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
                                     nullptr,
                                     IID_PPV_ARGS(&renderTarget));
+    BufferHelper::trackResource(renderTarget.Get(), MemoryTag::RENDER_TARGETS);
 
     const D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
         .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
@@ -256,7 +270,7 @@ void resize()
     };
     const uint32_t descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     const D3D12_CPU_DESCRIPTOR_HANDLE uavHandle = { sharedHeap->GetCPUDescriptorHandleForHeapStart().ptr +
-                                                    MAX_NUM_TEXTURES * descriptorSize };
+                                                    NUM_TEXTURE_DESCRIPTORS * descriptorSize };
     device->CreateUnorderedAccessView(renderTarget.Get(), nullptr, &uavDesc, uavHandle);
 }
 
@@ -277,9 +291,10 @@ enum class Param
     SHARED_HEAP,
     GLOBAL_PARAMS,
     RAYTRACING_ACS,
-    VERTS,
+    VERT_ATTRIBS,
     IDXS,
     INSTANCE_DATAS,
+    GEOMETRY_DATAS,
     MATERIALS,
     AREA_LIGHTS,
     AREA_LIGHT_SAMPLING_STRUCTURE,
@@ -299,12 +314,12 @@ void initRootSignature()
         .NumDescriptors = 1,
         .BaseShaderRegister = REGISTER_RENDER_TARGET,
         .RegisterSpace = REGISTER_SPACE_TEXTURES,
-        .OffsetInDescriptorsFromTableStart = MAX_NUM_TEXTURES,
+        .OffsetInDescriptorsFromTableStart = NUM_TEXTURE_DESCRIPTORS,
     });
 
     descriptorRanges.push_back({
         .RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
-        .NumDescriptors = MAX_NUM_TEXTURES,
+        .NumDescriptors = NUM_TEXTURE_DESCRIPTORS,
         .BaseShaderRegister = REGISTER_TEXTURES,
         .RegisterSpace = REGISTER_SPACE_TEXTURES,
         .Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE,
@@ -336,10 +351,10 @@ void initRootSignature()
         },
     };
 
-    params[PARAM_IDX(VERTS)] = {
+    params[PARAM_IDX(VERT_ATTRIBS)] = {
         .ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV,
         .Descriptor = {
-            .ShaderRegister = REGISTER_VERTS,
+            .ShaderRegister = REGISTER_VERT_ATTRIBS,
             .RegisterSpace = REGISTER_SPACE_BUFFERS,
         },
     };
@@ -360,6 +375,14 @@ void initRootSignature()
         },
     };
 
+    params[PARAM_IDX(GEOMETRY_DATAS)] = {
+        .ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV,
+        .Descriptor = {
+            .ShaderRegister = REGISTER_GEOMETRY_DATAS,
+            .RegisterSpace = REGISTER_SPACE_BUFFERS,
+        },
+    };
+
     params[PARAM_IDX(MATERIALS)] = {
         .ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV,
         .Descriptor = {
@@ -391,6 +414,8 @@ void initRootSignature()
         .AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
         .AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
         .AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        // left at 0, this would clamp every texture to its top mip
+        .MaxLOD = D3D12_FLOAT32_MAX,
         .ShaderRegister = REGISTER_TEX_SAMPLER,
         .RegisterSpace = REGISTER_SPACE_TEXTURES,
     });
@@ -650,8 +675,8 @@ void compileShadersAndInitPipeline()
 
     const uint32_t shaderIdsSizeBytes =
         2 * D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT + NUM_HIT_GROUPS * D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-    dev_shaderIds =
-        BufferHelper::createBasicBuffer(shaderIdsSizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ);
+    dev_shaderIds = BufferHelper::createBasicBuffer(
+        shaderIdsSizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ, MemoryTag::SHADER_TABLE);
 
     ComPtr<ID3D12StateObjectProperties> props;
     pso.As(&props);
@@ -714,6 +739,37 @@ void updateFps(double deltaTime)
     }
 }
 
+// creates Documents/biomeinator/<subdirName> if necessary
+static std::filesystem::path getOutputDir(const char* subdirName)
+{
+    wchar_t docPath[MAX_PATH];
+    if (!SUCCEEDED(SHGetFolderPathW(nullptr, CSIDL_PERSONAL, nullptr, SHGFP_TYPE_CURRENT, docPath)))
+    {
+        throw std::runtime_error("Failed to get documents directory");
+    }
+
+    const std::filesystem::path dir = std::filesystem::path(docPath) / L"biomeinator" / subdirName;
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+static std::string makeTimestampFileName(const char* extension)
+{
+    SYSTEMTIME st{};
+    GetLocalTime(&st);
+    char fileName[64];
+    sprintf_s(fileName,
+              "%04d.%02d.%02d_%02d-%02d-%02d.%s",
+              st.wYear,
+              st.wMonth,
+              st.wDay,
+              st.wHour,
+              st.wMinute,
+              st.wSecond,
+              extension);
+    return fileName;
+}
+
 struct ScreenshotRequest
 {
     bool active{ false };
@@ -748,7 +804,7 @@ void captureQueuedScreenshot()
     const uint32_t readbackSizeBytes = screenshotRequest.rowPitchBytesAligned * height;
 
     screenshotRequest.readbackBuffer = BufferHelper::createBasicBuffer(
-        readbackSizeBytes, &READBACK_HEAP, D3D12_RESOURCE_STATE_COPY_DEST);
+        readbackSizeBytes, &READBACK_HEAP, D3D12_RESOURCE_STATE_COPY_DEST, MemoryTag::READBACK);
 
     D3D12_TEXTURE_COPY_LOCATION srcLocation = {
         .pResource = renderTarget.Get(),
@@ -783,7 +839,8 @@ void captureQueuedScreenshot()
 
 void finalizeQueuedScreenshot()
 {
-    flush();
+    // only the frame that copied into the readback buffer needs to be done
+    waitForFence(nextFenceValue - 1);
 
     std::vector<uint8_t> pixels(screenshotRequest.width * screenshotRequest.height * 4);
     uint8_t* mapped = nullptr;
@@ -796,22 +853,7 @@ void finalizeQueuedScreenshot()
     }
     screenshotRequest.readbackBuffer->Unmap(0, nullptr);
 
-    wchar_t docPath[MAX_PATH];
-    if (!SUCCEEDED(SHGetFolderPathW(nullptr, CSIDL_PERSONAL, nullptr, SHGFP_TYPE_CURRENT, docPath)))
-    {
-        throw std::runtime_error("Failed to get screenshots directory");
-    }
-
-    const std::filesystem::path dir = std::filesystem::path(docPath) / L"biomeinator" / "screenshots";
-    std::filesystem::create_directories(dir);
-
-    SYSTEMTIME st{};
-    GetLocalTime(&st);
-    char fileName[64];
-    sprintf_s(
-        fileName, "%04d.%02d.%02d_%02d-%02d-%02d.png", st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
-
-    const std::filesystem::path path = dir / fileName;
+    const std::filesystem::path path = getOutputDir("screenshots") / makeTimestampFileName("png");
     stbi_write_png(path.string().c_str(),
                    screenshotRequest.width,
                    screenshotRequest.height,
@@ -823,6 +865,33 @@ void finalizeQueuedScreenshot()
     screenshotRequest.active = false;
 }
 
+void writeMemoryReport()
+{
+    MemoryRegistry& memoryRegistry = BufferHelper::getMemoryRegistry();
+    scene.reportMemoryPools(memoryRegistry);
+    AcsHelper::reportMemoryPools(memoryRegistry);
+    for (uint32_t ctxIdx = 0; ctxIdx < NUM_FRAMES_IN_FLIGHT; ++ctxIdx)
+    {
+        memoryRegistry.setPoolStats("uploadRing" + std::to_string(ctxIdx), frameCtxs[ctxIdx].uploadRing.getPoolStats());
+    }
+
+    const std::filesystem::path path = getOutputDir("memory_reports") / makeTimestampFileName("json");
+    if (memoryRegistry.writeJsonReport(path.string()))
+    {
+        printf("Wrote memory report to %s\n", path.string().c_str());
+    }
+    else
+    {
+        printf("Failed to write memory report to %s\n", path.string().c_str());
+    }
+}
+
+void toggleBlasCompaction()
+{
+    scene.setBlasCompactionEnabled(!scene.getBlasCompactionEnabled());
+    printf("BLAS compaction %s for newly built BLASes\n", scene.getBlasCompactionEnabled() ? "enabled" : "disabled");
+}
+
 void render()
 {
     const auto currentTimePoint = std::chrono::high_resolution_clock::now();
@@ -835,10 +904,12 @@ void render()
     camera.processPlayerInput(WindowManager::getPlayerInput(), deltaTime);
     camera.copyParamsTo(paramBlockManager.cameraParams);
     paramBlockManager.sceneParams->frameNumber = frameNumber;
+    BufferHelper::getMemoryRegistry().setFrameIdx(frameNumber);
 
     beginFrame();
 
-    scene.update(cmdList.Get(), frameCtx.toFreeList);
+    scene.setViewerPos(camera.getPos());
+    scene.update(cmdList.Get(), toFreeList, frameCtx.uploadRing);
 
     paramBlockManager.sceneParams->numAreaLights = scene.getNumAreaLights();
 
@@ -853,9 +924,10 @@ void render()
         cmdList->SetComputeRootDescriptorTable(PARAM_IDX(SHARED_HEAP), sharedHeap->GetGPUDescriptorHandleForHeapStart());
         cmdList->SetComputeRootConstantBufferView(PARAM_IDX(GLOBAL_PARAMS), paramBlockManager.getDevBuffer()->GetGPUVirtualAddress());
         cmdList->SetComputeRootShaderResourceView(PARAM_IDX(RAYTRACING_ACS), scene.getDevTlasAddress());
-        cmdList->SetComputeRootShaderResourceView(PARAM_IDX(VERTS), scene.getDevVertsBufferAddress());
+        cmdList->SetComputeRootShaderResourceView(PARAM_IDX(VERT_ATTRIBS), scene.getDevVertAttribsBufferAddress());
         cmdList->SetComputeRootShaderResourceView(PARAM_IDX(IDXS), scene.getDevIdxsBufferAddress());
         cmdList->SetComputeRootShaderResourceView(PARAM_IDX(INSTANCE_DATAS), scene.getDevInstanceDatasAddress());
+        cmdList->SetComputeRootShaderResourceView(PARAM_IDX(GEOMETRY_DATAS), scene.getDevGeometryDatasBufferAddress());
         cmdList->SetComputeRootShaderResourceView(PARAM_IDX(MATERIALS), scene.getDevMaterialsAddress());
         cmdList->SetComputeRootShaderResourceView(PARAM_IDX(AREA_LIGHTS), scene.getDevAreaLightsBufferAddress());
         cmdList->SetComputeRootShaderResourceView(PARAM_IDX(AREA_LIGHT_SAMPLING_STRUCTURE), scene.getDevAreaLightSamplingStructureAddress());
@@ -888,6 +960,11 @@ void render()
     const uint64_t fenceValue = nextFenceValue++;
     cmdQueue->Signal(fence.Get(), fenceValue);
     frameCtx.fenceValue = fenceValue;
+    frameCtx.uploadRing.submit(fenceValue);
+    scene.submit(fenceValue);
+
+    retirementQueue.push(fenceValue, std::move(toFreeList));
+    toFreeList = {};
 
     swapChain->Present(1, 0);
 
@@ -918,7 +995,10 @@ void beginFrame()
     WaitForSingleObject(frameLatencyWaitable, INFINITE);
     waitForFence(frame.fenceValue);
 
-    frame.toFreeList.freeAll();
+    const uint64_t completedFenceValue = fence->GetCompletedValue();
+    retirementQueue.drain(completedFenceValue, [](ToFreeList& retiredList) { retiredList.freeAll(); });
+    frame.uploadRing.reclaim(frame.fenceValue);
+    scene.reclaim(completedFenceValue);
     frame.cmdAlloc->Reset();
     cmdList->Reset(frame.cmdAlloc.Get(), nullptr);
 }
@@ -936,11 +1016,23 @@ void flush()
 
     waitForFence(fenceValue);
 
+    retirementQueue.drainAll([](ToFreeList& retiredList) { retiredList.freeAll(); });
+    toFreeList.freeAll();
+
     for (auto& frame : frameCtxs)
     {
         frame.fenceValue = 0;
-        frame.toFreeList.freeAll();
+        frame.uploadRing.reclaim(fenceValue);
     }
+
+    scene.reclaim(fenceValue);
+}
+
+void shutdown()
+{
+    asyncSceneLoader.shutdown();
+    flush();
+    writeMemoryReport();
 }
 
 } // namespace Renderer
@@ -27,6 +27,7 @@ namespace Renderer
 
 void init();
 
+// loads the file in the background; the current scene stays up until the new one replaces it
 void loadGltf(const std::string& filePathStr);
 
 void resize();
@@ -37,6 +38,15 @@ void flush();
 
 void queueScreenshot();
 
+// writes a JSON summary of GPU memory usage to Documents/biomeinator/memory_reports
+void writeMemoryReport();
+
+// BLASes built while this is on are shrunk to their compacted size a few frames later
+void toggleBlasCompaction();
+
+// waits for the GPU to go idle; call before exiting
+void shutdown();
+
 extern ComPtr<ID3D12Device5> device;
 
 extern ComPtr<ID3D12DescriptorHeap> sharedHeap;
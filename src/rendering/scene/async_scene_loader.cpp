@@ -0,0 +1,93 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "async_scene_loader.h"
+
+#include "gltf_loader.h"
+#include "scene.h"
+
+#include <chrono>
+#include <memory>
+
+void AsyncSceneLoader::init(Scene* scene)
+{
+    this->scene = scene;
+    this->isShuttingDown = false;
+    this->workerThread = std::thread(&AsyncSceneLoader::runWorker, this);
+}
+
+void AsyncSceneLoader::requestLoad(const std::string& filePathStr)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requestedFilePathStr = filePathStr;
+        this->hasRequest = true;
+    }
+    this->requestCondition.notify_one();
+}
+
+void AsyncSceneLoader::shutdown()
+{
+    if (!this->workerThread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->isShuttingDown = true;
+    }
+    this->requestCondition.notify_one();
+
+    this->workerThread.join();
+}
+
+void AsyncSceneLoader::runWorker()
+{
+    while (true)
+    {
+        std::string filePathStr;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->requestCondition.wait(lock, [this]() { return this->hasRequest || this->isShuttingDown; });
+            if (this->isShuttingDown)
+            {
+                return;
+            }
+
+            filePathStr = std::move(this->requestedFilePathStr);
+            this->hasRequest = false;
+        }
+
+        std::unique_ptr<LoadedScene> loadedScene = std::make_unique<LoadedScene>();
+        if (!GltfLoader::loadGltf(filePathStr, loadedScene.get()))
+        {
+            continue;
+        }
+
+        // the queue only fills up if several loads finish before the render loop gets to them
+        while (!this->scene->queueLoadedScene(loadedScene))
+        {
+            if (this->isShuttingDown)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
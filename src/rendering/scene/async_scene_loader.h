@@ -0,0 +1,56 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Scene;
+
+// Loads glTF files on a worker thread and hands them to a scene with Scene::queueLoadedScene(), so the render loop
+// keeps running and showing the old scene while a file is parsed and converted. Only the latest request counts: one
+// that is made while another is still waiting replaces it.
+class AsyncSceneLoader
+{
+private:
+    Scene* scene{ nullptr };
+    std::thread workerThread;
+
+    std::mutex mutex;
+    std::condition_variable requestCondition;
+    // guarded by `mutex`
+    std::string requestedFilePathStr;
+    bool hasRequest{ false };
+
+    // also read without the lock while waiting for room in the scene's queue
+    std::atomic<bool> isShuttingDown{ false };
+
+    void runWorker();
+
+public:
+    void init(Scene* scene);
+
+    void requestLoad(const std::string& filePathStr);
+
+    // waits for a load that has already started to finish, and drops a request that hasn't
+    void shutdown();
+};
@@ -121,3 +121,8 @@ void Camera::copyParamsTo(CameraParams* dest) const
 {
     memcpy(dest, &this->params, sizeof(CameraParams));
 }
+
+const DirectX::XMFLOAT3& Camera::getPos() const
+{
+    return this->params.pos_WS;
+}
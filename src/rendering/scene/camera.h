@@ -44,6 +44,7 @@ public:
     void init(float defaultFovYRadians);
 
     void copyParamsTo(CameraParams* dest) const;
+    const DirectX::XMFLOAT3& getPos() const;
 
     void processPlayerInput(const PlayerInput& input, double deltaTime);
 };
@@ -25,29 +25,254 @@ on a specific subset of glTF files and is not guaranteed to work for files outsi
 
 #include "tinygltf/tiny_gltf.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <numeric>
 #include <string>
 
-#include "rendering/buffer/to_free_list.h"
+#include "core/hash.h"
+#include "core/mesh_optimizer.h"
+#include "core/parallel.h"
+#include "core/texture_processor.h"
+#include "core/vertex_packing.h"
 #include "rendering/common/common_structs.h"
-#include "scene.h"
+#include "scene_cache.h"
 
 using namespace tinygltf;
 
 namespace GltfLoader
 {
 
-void loadGltf(const std::string& filePathStr, ::Scene& scene)
+// bump whenever the loader's output changes, so that existing scene caches are ignored
+static constexpr uint32_t CACHE_VERSION = 4;
+// scenes loaded with and without mesh optimization are cached separately
+static constexpr uint32_t CACHE_VERSION_OPTIMIZED_BIT = 1u << 31;
+
+static std::string getTextureCacheDirPathStr()
+{
+    return (std::filesystem::path(CMAKE_BINARY_DIR) / "texture_cache").string();
+}
+
+static std::string getCachePathStr(const std::string& filePathStr)
+{
+    const std::string absolutePathStr = std::filesystem::absolute(filePathStr).string();
+
+    char fileName[32];
+    snprintf(fileName,
+             sizeof(fileName),
+             "%016llx.bin",
+             static_cast<unsigned long long>(Hash::hashBytes(absolutePathStr.data(), absolutePathStr.size())));
+    return (std::filesystem::path(CMAKE_BINARY_DIR) / "scene_cache" / fileName).string();
+}
+
+// Reads one element of a float accessor or, with KHR_mesh_quantization, an integer one. Normalized integers are mapped
+// to [0, 1] or [-1, 1]; other integers are converted as is, since their dequantization is part of the node transform.
+static void readFloats(const unsigned char* data, const Accessor& accessor, int numComponents, float* out)
+{
+    for (int c = 0; c < numComponents; ++c)
+    {
+        switch (accessor.componentType)
+        {
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+        {
+            const int8_t value = reinterpret_cast<const int8_t*>(data)[c];
+            out[c] = accessor.normalized ? std::max(value / 127.f, -1.f) : value;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        {
+            const uint8_t value = reinterpret_cast<const uint8_t*>(data)[c];
+            out[c] = accessor.normalized ? value / 255.f : value;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+        {
+            const int16_t value = reinterpret_cast<const int16_t*>(data)[c];
+            out[c] = accessor.normalized ? std::max(value / 32767.f, -1.f) : value;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        {
+            const uint16_t value = reinterpret_cast<const uint16_t*>(data)[c];
+            out[c] = accessor.normalized ? value / 65535.f : value;
+            break;
+        }
+        default:
+            out[c] = reinterpret_cast<const float*>(data)[c];
+            break;
+        }
+    }
+}
+
+// Hit shaders start from this to pick texture mips. Degenerate parts, and parts without UVs, get 0.
+static float computeUvScaleLog2(const std::vector<DirectX::XMFLOAT3>& positions,
+                                const std::vector<VertexAttributes>& vertAttribs,
+                                const std::vector<uint32_t>& idxs)
+{
+    const bool hasIdxs = !idxs.empty();
+    const size_t numTris = hasIdxs ? idxs.size() / 3 : positions.size() / 3;
+
+    double objectArea = 0.0;
+    double uvArea = 0.0;
+    for (size_t triIdx = 0; triIdx < numTris; ++triIdx)
+    {
+        uint32_t triVertIdxs[3];
+        DirectX::XMFLOAT2 uvs[3];
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            triVertIdxs[i] = hasIdxs ? idxs[triIdx * 3 + i] : static_cast<uint32_t>(triIdx * 3 + i);
+            VertexPacking::unpackHalf2(vertAttribs[triVertIdxs[i]].packedUv, &uvs[i].x);
+        }
+
+        const DirectX::XMVECTOR pos0 = DirectX::XMLoadFloat3(&positions[triVertIdxs[0]]);
+        const DirectX::XMVECTOR pos1 = DirectX::XMLoadFloat3(&positions[triVertIdxs[1]]);
+        const DirectX::XMVECTOR pos2 = DirectX::XMLoadFloat3(&positions[triVertIdxs[2]]);
+        const DirectX::XMVECTOR cross =
+            DirectX::XMVector3Cross(DirectX::XMVectorSubtract(pos1, pos0), DirectX::XMVectorSubtract(pos2, pos0));
+        objectArea += 0.5 * DirectX::XMVectorGetX(DirectX::XMVector3Length(cross));
+
+        const float uvCross =
+            (uvs[1].x - uvs[0].x) * (uvs[2].y - uvs[0].y) - (uvs[2].x - uvs[0].x) * (uvs[1].y - uvs[0].y);
+        uvArea += 0.5 * std::abs(uvCross);
+    }
+
+    if (objectArea <= 0.0 || uvArea <= 0.0)
+    {
+        return 0.f;
+    }
+    return static_cast<float>(0.5 * std::log2(uvArea / objectArea));
+}
+
+static void remapPartVerts(std::vector<DirectX::XMFLOAT3>* positions,
+                           std::vector<VertexAttributes>* vertAttribs,
+                           std::vector<uint32_t>* idxs,
+                           const std::vector<uint32_t>& remap,
+                           uint32_t newNumVerts)
+{
+    std::vector<DirectX::XMFLOAT3> newPositions(newNumVerts);
+    std::vector<VertexAttributes> newVertAttribs(newNumVerts);
+    const uint32_t numVerts = static_cast<uint32_t>(positions->size());
+    MeshOptimizer::remapVertexStream(
+        { positions->data(), sizeof(DirectX::XMFLOAT3) }, numVerts, remap.data(), newPositions.data());
+    MeshOptimizer::remapVertexStream(
+        { vertAttribs->data(), sizeof(VertexAttributes) }, numVerts, remap.data(), newVertAttribs.data());
+    MeshOptimizer::remapIdxs(idxs->data(), static_cast<uint32_t>(idxs->size()), remap.data());
+
+    *positions = std::move(newPositions);
+    *vertAttribs = std::move(newVertAttribs);
+}
+
+static float computePartFetchCost(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& idxs)
+{
+    return MeshOptimizer::computeFetchCost(idxs.data(),
+                                           static_cast<uint32_t>(idxs.size()),
+                                           &positions.data()->x,
+                                           sizeof(DirectX::XMFLOAT3),
+                                           sizeof(VertexAttributes));
+}
+
+// Welds vertices whose converted position and attributes are identical, which also turns a plain triangle list into
+// an indexed one, then sorts the triangles spatially and renumbers the vertices in the order the triangles use them.
+// Fetch costs are only measured if their outputs are given, since that sorts the part twice more.
+static void optimizePart(std::vector<DirectX::XMFLOAT3>* positions,
+                         std::vector<VertexAttributes>* vertAttribs,
+                         std::vector<uint32_t>* idxs,
+                         float* outFetchCostBefore,
+                         float* outFetchCostAfter)
+{
+    const uint32_t numVerts = static_cast<uint32_t>(positions->size());
+    if (idxs->empty())
+    {
+        idxs->resize(numVerts / 3 * 3);
+        std::iota(idxs->begin(), idxs->end(), 0);
+    }
+    if (idxs->empty())
+    {
+        return;
+    }
+
+    if (outFetchCostBefore != nullptr)
+    {
+        *outFetchCostBefore = computePartFetchCost(*positions, *idxs);
+    }
+
+    const MeshOptimizer::VertexStream streams[] = {
+        { positions->data(), sizeof(DirectX::XMFLOAT3) },
+        { vertAttribs->data(), sizeof(VertexAttributes) },
+    };
+    std::vector<uint32_t> remap(numVerts);
+    const uint32_t numUniqueVerts = MeshOptimizer::generateWeldRemap(streams, 2, numVerts, remap.data());
+    remapPartVerts(positions, vertAttribs, idxs, remap, numUniqueVerts);
+
+    const uint32_t numIdxs = static_cast<uint32_t>(idxs->size());
+    MeshOptimizer::reorderTrianglesSpatially(idxs->data(), numIdxs, &positions->data()->x, sizeof(DirectX::XMFLOAT3));
+
+    const uint32_t numUsedVerts =
+        MeshOptimizer::generateFetchRemap(idxs->data(), numIdxs, numUniqueVerts, remap.data());
+    remapPartVerts(positions, vertAttribs, idxs, remap, numUsedVerts);
+
+    if (outFetchCostAfter != nullptr)
+    {
+        *outFetchCostAfter = computePartFetchCost(*positions, *idxs);
+    }
+}
+
+bool loadGltf(const std::string& filePathStr, LoadedScene* outScene, const LoadOptions& options)
 {
     printf("Loading GLTF file: %s\n", filePathStr.c_str());
 
-    scene.clear();
+    const auto startTime = std::chrono::steady_clock::now();
+    const uint32_t numThreads = options.numThreads > 0 ? options.numThreads : Parallel::getDefaultNumThreads();
+    const bool optimizeMeshes = options.optimizeMeshes;
+
+    const auto getElapsedMs = [&]() {
+        return static_cast<long long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime)
+                .count());
+    };
+
+    const std::string cachePathStr = getCachePathStr(filePathStr);
+    const uint32_t cacheVersion = optimizeMeshes ? CACHE_VERSION | CACHE_VERSION_OPTIMIZED_BIT : CACHE_VERSION;
+    if (options.useCaches &&
+        SceneCache::load(cachePathStr, filePathStr, cacheVersion, numThreads, options.stageStreams, outScene))
+    {
+        printf("Loaded from scene cache in %lld ms on %u threads\n", getElapsedMs(), numThreads);
+        return true;
+    }
+
+    LoadedScene& scene = *outScene;
+    scene = LoadedScene{};
+    // relative to the file's directory, for the scene cache
+    std::vector<std::string> dependencyPathStrs;
 
     tinygltf::Model model;
     tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
 
+    // tinygltf would decode images one after another while parsing, so they're only collected here and decoded in
+    // parallel afterwards
+    std::vector<std::vector<unsigned char>> encodedImages;
+    const auto collectImage = [&](Image*,
+                                  const int imageIdx,
+                                  std::string*,
+                                  std::string*,
+                                  int,
+                                  int,
+                                  const unsigned char* bytes,
+                                  int size,
+                                  void*) {
+        if (static_cast<size_t>(imageIdx) >= encodedImages.size())
+        {
+            encodedImages.resize(imageIdx + 1);
+        }
+        encodedImages[imageIdx].assign(bytes, bytes + size);
+        return true;
+    };
+    loader.SetImageLoader(collectImage, nullptr);
+
     const bool isGlb = std::filesystem::path(filePathStr).extension() == ".glb";
     const bool loaded = isGlb ? loader.LoadBinaryFromFile(&model, &err, &warn, filePathStr)
                               : loader.LoadASCIIFromFile(&model, &err, &warn, filePathStr);
@@ -63,20 +288,107 @@ void loadGltf(const std::string& filePathStr, ::Scene& scene)
     if (!loaded)
     {
         printf("Failed to load glTF file\n");
-        return;
+        return false;
     }
 
-    std::vector<uint32_t> textureIds;
-    textureIds.reserve(model.images.size());
-    for (tinygltf::Image& image : model.images)
+    encodedImages.resize(model.images.size());
+    std::vector<std::string> imageErrs(model.images.size());
+    Parallel::forEach(static_cast<uint32_t>(model.images.size()), numThreads, [&](uint32_t imageIdx) {
+        const std::vector<unsigned char>& bytes = encodedImages[imageIdx];
+        if (bytes.empty())
+        {
+            return;
+        }
+
+        std::string imageWarn;
+        tinygltf::LoadImageData(&model.images[imageIdx],
+                                imageIdx,
+                                &imageErrs[imageIdx],
+                                &imageWarn,
+                                0,
+                                0,
+                                bytes.data(),
+                                static_cast<int>(bytes.size()),
+                                nullptr);
+    });
+    encodedImages.clear();
+
+    for (const tinygltf::Buffer& buffer : model.buffers)
     {
-        textureIds.push_back(scene.addTexture(std::move(image.image), image.width, image.height));
+        std::string decodedUri;
+        if (!buffer.uri.empty() && !IsDataURI(buffer.uri) && URIDecode(buffer.uri, &decodedUri, nullptr))
+        {
+            dependencyPathStrs.push_back(decodedUri);
+        }
+    }
+
+    for (uint32_t imageIdx = 0; imageIdx < model.images.size(); ++imageIdx)
+    {
+        if (!imageErrs[imageIdx].empty())
+        {
+            printf("glTF error: %s\n", imageErrs[imageIdx].c_str());
+        }
+
+        tinygltf::Image& image = model.images[imageIdx];
+        std::string decodedUri;
+        if (!image.uri.empty() && !IsDataURI(image.uri) && URIDecode(image.uri, &decodedUri, nullptr))
+        {
+            dependencyPathStrs.push_back(decodedUri);
+        }
     }
 
-    ToFreeList toFreeList;
+    // one texture after another, each spread over every thread, since a scene often has a few large textures that
+    // dwarf the rest
+    const auto textureStartTime = std::chrono::steady_clock::now();
+    const TextureProcessor::Options textureOptions = {
+        .numThreads = numThreads,
+        .cacheDirPathStr = options.useCaches ? getTextureCacheDirPathStr() : std::string(),
+    };
+    uint32_t numCachedTextures = 0;
+    scene.textures.resize(model.images.size());
+    for (uint32_t imageIdx = 0; imageIdx < model.images.size(); ++imageIdx)
+    {
+        tinygltf::Image& image = model.images[imageIdx];
+        std::vector<unsigned char>& texels = image.image;
+        uint32_t width = static_cast<uint32_t>(image.width);
+        uint32_t height = static_cast<uint32_t>(image.height);
+
+        // images are always decoded to RGBA, but 16-bit ones keep their precision, which textures don't need
+        if (image.bits == 16)
+        {
+            for (size_t i = 0; i < texels.size() / 2; ++i)
+            {
+                texels[i] = texels[i * 2 + 1];
+            }
+            texels.resize(texels.size() / 2);
+        }
+
+        // images that failed to decode become opaque white, so that materials can still refer to them
+        if (width == 0 || height == 0 || texels.size() != static_cast<size_t>(width) * height * 4)
+        {
+            texels.assign(4, 255);
+            width = height = 1;
+        }
+
+        // only base color textures are read so far
+        if (TextureProcessor::process(
+                texels.data(), width, height, TextureUsage::COLOR, textureOptions, &scene.textures[imageIdx]))
+        {
+            ++numCachedTextures;
+        }
+        texels = {};
+    }
+    if (!model.images.empty())
+    {
+        printf("Processed %zu textures (%u from texture cache) in %lld ms\n",
+               model.images.size(),
+               numCachedTextures,
+               static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::steady_clock::now() - textureStartTime)
+                                          .count()));
+    }
 
-    std::vector<uint32_t> materialIds;
-    materialIds.reserve(model.materials.size());
+    scene.materials.reserve(model.materials.size());
     std::vector<bool> materialIsEmissive;
     materialIsEmissive.reserve(model.materials.size());
     for (const tinygltf::Material& gltfMat : model.materials)
@@ -132,14 +444,14 @@ void loadGltf(const std::string& filePathStr, ::Scene& scene)
                 {
                     const int texIdx = gltfMat.pbrMetallicRoughness.baseColorTexture.index;
 
-                    if (texIdx < model.textures.size())
+                    if (texIdx >= 0 && static_cast<size_t>(texIdx) < model.textures.size())
                     {
                         const int imgIdx = model.textures[texIdx].source;
 
-                        if (imgIdx >= 0 && imgIdx < textureIds.size())
+                        if (imgIdx >= 0 && static_cast<size_t>(imgIdx) < scene.textures.size())
 
                         {
-                            material.baseColorTextureId = textureIds[imgIdx];
+                            material.baseColorTextureId = imgIdx;
                             hasDiffuse = true;
                         }
                     }
@@ -190,8 +502,7 @@ void loadGltf(const std::string& filePathStr, ::Scene& scene)
         material.setHasDiffuse(hasDiffuse);
         material.setHasSpecularReflection(hasSpecularReflection);
 
-        const uint32_t id = scene.addMaterial(toFreeList, &material);
-        materialIds.push_back(id);
+        scene.materials.push_back(material);
         materialIsEmissive.push_back(material.emissiveStrength > 0.f);
     }
 
@@ -214,6 +525,11 @@ void loadGltf(const std::string& filePathStr, ::Scene& scene)
         case TINYGLTF_COMPONENT_TYPE_FLOAT:
             componentSize = 4;
             break;
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            componentSize = 1;
+            break;
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
             componentSize = 2;
             break;
@@ -244,6 +560,277 @@ void loadGltf(const std::string& filePathStr, ::Scene& scene)
         return componentSize * static_cast<size_t>(numComponents);
     };
 
+    const auto getMaterialIdx = [&](const Primitive& prim) -> uint32_t {
+        if (prim.material >= 0 && static_cast<size_t>(prim.material) < scene.materials.size())
+        {
+            return static_cast<uint32_t>(prim.material);
+        }
+        return MATERIAL_ID_INVALID;
+    };
+
+    const auto isMaterialEmissive = [&](const Primitive& prim) -> bool {
+        return prim.material >= 0 && static_cast<uint32_t>(prim.material) < materialIsEmissive.size() &&
+               materialIsEmissive[prim.material];
+    };
+
+    // Each mesh becomes one geometry with a part per primitive, so that it gets a single BLAS and TLAS instance per
+    // node. Nodes that reference the same mesh share its geometry. Primitives are converted and optimized on their own,
+    // since optimizing changes their vertex counts, and then copied into their geometry.
+    struct PartJob
+    {
+        uint32_t geometryIdx;
+        const Primitive* prim;
+        uint32_t partIdx;
+
+        std::vector<DirectX::XMFLOAT3> positions{};
+        std::vector<VertexAttributes> vertAttribs{};
+        // empty for a plain triangle list
+        std::vector<uint32_t> idxs{};
+
+        uint32_t numSourceVerts{ 0 };
+        // see MeshOptimizer::computeFetchCost(), only set if meshes are optimized and their stats printed
+        float fetchCostBefore{ 0.f };
+        float fetchCostAfter{ 0.f };
+
+        // see Geometry::addPart()
+        float uvScaleLog2{ 0.f };
+
+        // in object space, so every instance of the geometry can share them
+        std::vector<AreaLightInputs> areaLights{};
+    };
+
+    static constexpr uint32_t GEOMETRY_IDX_INVALID = ~0u;
+    std::vector<uint32_t> meshGeometryIdxs(model.meshes.size(), GEOMETRY_IDX_INVALID);
+    std::vector<uint32_t> geometryFirstPartJobIdxs;
+    std::vector<PartJob> partJobs;
+
+    for (const Node& node : model.nodes)
+    {
+        if (node.mesh < 0 || meshGeometryIdxs[node.mesh] != GEOMETRY_IDX_INVALID)
+        {
+            continue;
+        }
+
+        const uint32_t geometryIdx = static_cast<uint32_t>(scene.geometries.size());
+        meshGeometryIdxs[node.mesh] = geometryIdx;
+        geometryFirstPartJobIdxs.push_back(static_cast<uint32_t>(partJobs.size()));
+        scene.geometries.emplace_back();
+
+        const Mesh& mesh = model.meshes[node.mesh];
+        for (uint32_t partIdx = 0; partIdx < mesh.primitives.size(); ++partIdx)
+        {
+            partJobs.push_back({ .geometryIdx = geometryIdx, .prim = &mesh.primitives[partIdx], .partIdx = partIdx });
+        }
+    }
+    geometryFirstPartJobIdxs.push_back(static_cast<uint32_t>(partJobs.size()));
+
+    Parallel::forEach(static_cast<uint32_t>(partJobs.size()), numThreads, [&](uint32_t jobIdx) {
+        PartJob& job = partJobs[jobIdx];
+        const Primitive& prim = *job.prim;
+
+        const Accessor& posAccessor = model.accessors[prim.attributes.find("POSITION")->second];
+        const Accessor& norAccessor = model.accessors[prim.attributes.find("NORMAL")->second];
+        const Accessor* uvAccessor = nullptr;
+        const auto uvIt = prim.attributes.find("TEXCOORD_0");
+        if (uvIt != prim.attributes.end())
+        {
+            uvAccessor = &model.accessors[uvIt->second];
+        }
+        const Accessor* idxAccessor = prim.indices >= 0 ? &model.accessors[prim.indices] : nullptr;
+
+        const size_t vertCount = posAccessor.count;
+        const size_t idxCount = idxAccessor ? idxAccessor->count : 0;
+
+        const unsigned char* posData = readAccessorData(posAccessor);
+        const unsigned char* norData = readAccessorData(norAccessor);
+        const unsigned char* uvData = uvAccessor ? readAccessorData(*uvAccessor) : nullptr;
+
+        const size_t posStride = getStride(posAccessor);
+        const size_t norStride = getStride(norAccessor);
+        const size_t uvStride = uvAccessor ? getStride(*uvAccessor) : 0;
+
+        // attributes go straight from the accessors' formats to the packed ones
+        job.positions.resize(vertCount);
+        job.vertAttribs.resize(vertCount);
+        for (size_t v = 0; v < vertCount; ++v)
+        {
+            readFloats(posData + posStride * v, posAccessor, 3, &job.positions[v].x);
+
+            float n[3];
+            readFloats(norData + norStride * v, norAccessor, 3, n);
+
+            float uv[2] = { 0.f, 0.f };
+            if (uvAccessor)
+            {
+                readFloats(uvData + uvStride * v, *uvAccessor, 2, uv);
+            }
+
+            job.vertAttribs[v] = {
+                .packedNormal = VertexPacking::packOctahedralNormal(n[0], n[1], n[2]),
+                .packedUv = VertexPacking::packHalf2(uv[0], uv[1]),
+            };
+        }
+
+        if (idxAccessor)
+        {
+            const unsigned char* idxData = readAccessorData(*idxAccessor);
+            const size_t idxStride = getStride(*idxAccessor);
+
+            job.idxs.resize(idxCount);
+            for (size_t i = 0; i < idxCount; ++i)
+            {
+                uint32_t idx = 0;
+                switch (idxAccessor->componentType)
+                {
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                    idx = *(reinterpret_cast<const uint8_t*>(idxData + idxStride * i));
+                    break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                    idx = *(reinterpret_cast<const uint16_t*>(idxData + idxStride * i));
+                    break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+                    idx = *(reinterpret_cast<const uint32_t*>(idxData + idxStride * i));
+                    break;
+                default:
+                    break;
+                }
+                job.idxs[i] = idx;
+            }
+        }
+
+        job.numSourceVerts = static_cast<uint32_t>(vertCount);
+        if (optimizeMeshes)
+        {
+            optimizePart(&job.positions,
+                         &job.vertAttribs,
+                         &job.idxs,
+                         options.printOptimizerStats ? &job.fetchCostBefore : nullptr,
+                         options.printOptimizerStats ? &job.fetchCostAfter : nullptr);
+        }
+
+        job.uvScaleLog2 = computeUvScaleLog2(job.positions, job.vertAttribs, job.idxs);
+
+        // read after optimizing, so that triangle indices match the final order
+        if (!isMaterialEmissive(prim))
+        {
+            return;
+        }
+
+        const bool hasIdxs = !job.idxs.empty();
+        const uint32_t triCount = static_cast<uint32_t>(hasIdxs ? job.idxs.size() / 3 : job.positions.size() / 3);
+        for (uint32_t triIdx = 0; triIdx < triCount; ++triIdx)
+        {
+            uint32_t i0 = triIdx * 3;
+            uint32_t i1 = i0 + 1;
+            uint32_t i2 = i0 + 2;
+            if (hasIdxs)
+            {
+                i0 = job.idxs[i0];
+                i1 = job.idxs[i1];
+                i2 = job.idxs[i2];
+            }
+
+            job.areaLights.push_back({
+                .pos0 = job.positions[i0],
+                .pos1 = job.positions[i1],
+                .pos2 = job.positions[i2],
+                .geometryIdx = job.partIdx,
+                .triangleIdx = triIdx,
+            });
+        }
+    });
+
+    // Part sizes are final once they're optimized, so the streams are allocated here, in upload memory unless host
+    // streams were asked for, and each part goes straight into them. The staging buffer needs every size up front.
+    for (uint32_t geometryIdx = 0; geometryIdx < scene.geometries.size(); ++geometryIdx)
+    {
+        LoadedGeometry& geometry = scene.geometries[geometryIdx];
+        const uint32_t endPartJobIdx = geometryFirstPartJobIdxs[geometryIdx + 1];
+        for (uint32_t jobIdx = geometryFirstPartJobIdxs[geometryIdx]; jobIdx < endPartJobIdx; ++jobIdx)
+        {
+            const PartJob& job = partJobs[jobIdx];
+            geometry.addPart(static_cast<uint32_t>(job.positions.size()),
+                             static_cast<uint32_t>(job.idxs.size()),
+                             getMaterialIdx(*job.prim),
+                             job.uvScaleLog2);
+        }
+        geometry.narrowIdxFormat();
+    }
+
+    if (options.stageStreams)
+    {
+        scene.initStagingBuffer();
+        for (LoadedGeometry& geometry : scene.geometries)
+        {
+            geometry.allocateStagedStreams(scene.stagingBuffer);
+        }
+    }
+    else
+    {
+        for (LoadedGeometry& geometry : scene.geometries)
+        {
+            geometry.allocateHostStreams();
+        }
+    }
+
+    Parallel::forEach(static_cast<uint32_t>(scene.geometries.size()), numThreads, [&](uint32_t geometryIdx) {
+        LoadedGeometry& geometry = scene.geometries[geometryIdx];
+        DirectX::XMFLOAT3* positions = geometry.getPositions();
+        VertexAttributes* vertAttribs = geometry.getVertAttribs();
+        void* idxs = geometry.getIdxs();
+
+        const uint32_t endPartJobIdx = geometryFirstPartJobIdxs[geometryIdx + 1];
+        for (uint32_t jobIdx = geometryFirstPartJobIdxs[geometryIdx]; jobIdx < endPartJobIdx; ++jobIdx)
+        {
+            PartJob& job = partJobs[jobIdx];
+            const AcsHelper::GeometryRange& range = geometry.partRanges[job.partIdx];
+            std::copy(job.positions.begin(), job.positions.end(), positions + range.firstVert);
+            std::copy(job.vertAttribs.begin(), job.vertAttribs.end(), vertAttribs + range.firstVert);
+            if (geometry.idxFormat == IDX_FORMAT_16)
+            {
+                std::transform(job.idxs.begin(),
+                               job.idxs.end(),
+                               static_cast<uint16_t*>(idxs) + range.firstIdx,
+                               [](uint32_t idx) { return static_cast<uint16_t>(idx); });
+            }
+            else
+            {
+                std::copy(job.idxs.begin(), job.idxs.end(), static_cast<uint32_t*>(idxs) + range.firstIdx);
+            }
+            geometry.areaLights.insert(geometry.areaLights.end(), job.areaLights.begin(), job.areaLights.end());
+
+            job.positions = {};
+            job.vertAttribs = {};
+            job.idxs = {};
+        }
+    });
+
+    if (optimizeMeshes && options.printOptimizerStats)
+    {
+        uint64_t numSourceVerts = 0;
+        uint64_t numVerts = 0;
+        uint64_t numTris = 0;
+        double fetchCostBefore = 0.0;
+        double fetchCostAfter = 0.0;
+        for (const PartJob& job : partJobs)
+        {
+            const AcsHelper::GeometryRange& range = scene.geometries[job.geometryIdx].partRanges[job.partIdx];
+            const uint32_t partNumTris = range.numIdxs / 3;
+            numSourceVerts += job.numSourceVerts;
+            numVerts += range.numVerts;
+            numTris += partNumTris;
+            fetchCostBefore += job.fetchCostBefore * partNumTris;
+            fetchCostAfter += job.fetchCostAfter * partNumTris;
+        }
+
+        printf("Optimized meshes: %llu -> %llu vertices, %.2f -> %.2f cache lines fetched per hit triangle\n",
+               static_cast<unsigned long long>(numSourceVerts),
+               static_cast<unsigned long long>(numVerts),
+               numTris > 0 ? fetchCostBefore / numTris : 0.0,
+               numTris > 0 ? fetchCostAfter / numTris : 0.0);
+    }
+
+    // instances are added in node order, so the scene comes out the same for any thread count
     for (const Node& node : model.nodes)
     {
         if (node.mesh < 0)
@@ -287,119 +874,25 @@ void loadGltf(const std::string& filePathStr, ::Scene& scene)
             }
         }
 
-        const Mesh& mesh = model.meshes[node.mesh];
-        for (const Primitive& prim : mesh.primitives)
-        {
-            Instance* instance = scene.requestNewInstance(toFreeList);
-
-            uint32_t matId = MATERIAL_ID_INVALID;
-            if (prim.material >= 0 && static_cast<size_t>(prim.material) < materialIds.size())
-            {
-                matId = materialIds[prim.material];
-            }
-            instance->setMaterialId(matId);
-
-            const Accessor& posAccessor = model.accessors[prim.attributes.find("POSITION")->second];
-            const Accessor& norAccessor = model.accessors[prim.attributes.find("NORMAL")->second];
-            const Accessor* uvAccessor = nullptr;
-            const auto uvIt = prim.attributes.find("TEXCOORD_0");
-            if (uvIt != prim.attributes.end())
-            {
-                uvAccessor = &model.accessors[uvIt->second];
-            }
-
-            const size_t vertCount = posAccessor.count;
-            instance->host_verts.resize(vertCount);
-
-            const unsigned char* posData = readAccessorData(posAccessor);
-            const unsigned char* norData = readAccessorData(norAccessor);
-            const unsigned char* uvData = uvAccessor ? readAccessorData(*uvAccessor) : nullptr;
-
-            const size_t posStride = getStride(posAccessor);
-            const size_t norStride = getStride(norAccessor);
-            const size_t uvStride = uvAccessor ? getStride(*uvAccessor) : 0;
-
-            for (size_t v = 0; v < vertCount; ++v)
-            {
-                const float* p = reinterpret_cast<const float*>(posData + posStride * v);
-                const float* n = reinterpret_cast<const float*>(norData + norStride * v);
-
-                DirectX::XMFLOAT2 uv = { 0.f, 0.f };
-                if (uvAccessor)
-                {
-                    const float* uvf = reinterpret_cast<const float*>(uvData + uvStride * v);
-                    uv = { uvf[0], uvf[1] };
-                }
-
-                instance->host_verts[v] = { { p[0], p[1], p[2] }, { n[0], n[1], n[2] }, uv };
-            }
-
-            if (prim.indices >= 0)
-            {
-                const Accessor& idxAccessor = model.accessors[prim.indices];
-                const unsigned char* idxData = readAccessorData(idxAccessor);
-                const size_t idxCount = idxAccessor.count;
-                instance->host_idxs.resize(idxCount);
-
-                const size_t idxStride = getStride(idxAccessor);
-
-                for (size_t i = 0; i < idxCount; ++i)
-                {
-                    uint32_t idx = 0;
-                    switch (idxAccessor.componentType)
-                    {
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-                        idx = *(reinterpret_cast<const uint8_t*>(idxData + idxStride * i));
-                        break;
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-                        idx = *(reinterpret_cast<const uint16_t*>(idxData + idxStride * i));
-                        break;
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-                        idx = *(reinterpret_cast<const uint32_t*>(idxData + idxStride * i));
-                        break;
-                    default:
-                        break;
-                    }
-                    instance->host_idxs[i] = idx;
-                }
-            }
-
-            DirectX::XMStoreFloat3x4(&instance->transform, transform);
-
-            const bool isEmissive = prim.material >= 0 &&
-                                    static_cast<uint32_t>(prim.material) < materialIsEmissive.size() &&
-                                    materialIsEmissive[prim.material];
-            if (isEmissive)
-            {
-                const uint32_t triCount =
-                    instance->host_idxs.empty() ? instance->host_verts.size() / 3 : instance->host_idxs.size() / 3;
-                for (uint32_t triIdx = 0; triIdx < triCount; ++triIdx)
-                {
-                    uint32_t i0 = triIdx * 3;
-                    uint32_t i1 = i0 + 1;
-                    uint32_t i2 = i0 + 2;
-                    if (!instance->host_idxs.empty())
-                    {
-                        i0 = instance->host_idxs[i0];
-                        i1 = instance->host_idxs[i1];
-                        i2 = instance->host_idxs[i2];
-                    }
+        LoadedInstance& instance = scene.instances.emplace_back();
+        instance.geometryIdx = meshGeometryIdxs[node.mesh];
+        DirectX::XMStoreFloat3x4(&instance.transform, transform);
+    }
 
-                    const AreaLightInputs lightInputs = {
-                        .pos0 = instance->host_verts[i0].pos,
-                        .pos1 = instance->host_verts[i1].pos,
-                        .pos2 = instance->host_verts[i2].pos,
-                        .triangleIdx = triIdx,
-                    };
-                    instance->addAreaLight(lightInputs);
-                }
-            }
+    printf("Loaded %u instances sharing %zu geometries in %lld ms on %u threads\n",
+           static_cast<uint32_t>(scene.instances.size()),
+           scene.geometries.size(),
+           getElapsedMs(),
+           numThreads);
 
-            scene.markInstanceReadyForBlasBuild(instance);
-        }
+    // reads the streams back from wherever they were written, once each
+    if (options.useCaches &&
+        !SceneCache::write(scene, dependencyPathStrs, cachePathStr, filePathStr, cacheVersion, numThreads))
+    {
+        printf("Failed to write scene cache: %s\n", cachePathStr.c_str());
     }
 
-    toFreeList.freeAll();
+    return true;
 }
 
 } // namespace GltfLoader
@@ -18,13 +18,33 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
-#include <string>
+#include "loaded_scene.h"
 
-class Scene;
+#include <cstdint>
+#include <string>
 
 namespace GltfLoader
 {
 
-void loadGltf(const std::string& filePathStr, ::Scene& scene);
+struct LoadOptions
+{
+    // images are decoded and primitives converted on up to this many threads (0 for one per hardware thread); the
+    // resulting scene is the same for any thread count
+    uint32_t numThreads{ 0 };
+    // welds identical vertices and reorders each primitive's triangles and vertices for locality (see MeshOptimizer)
+    bool optimizeMeshes{ true };
+    // prints how many vertices welding removed and MeshOptimizer::computeFetchCost() before and after optimizing, which
+    // costs two more sorts of every part
+    bool printOptimizerStats{ false };
+    // reads and writes the scene and texture caches; off for measuring loads from scratch
+    bool useCaches{ true };
+    // Hands vertex and index streams over already in upload memory (see StagingBuffer). Off, they stay in host vectors
+    // that Scene copies through its UploadRing on the render thread, which is only useful for comparing the two.
+    bool stageStreams{ true };
+};
+
+// Loads the file into `outScene` without touching any Scene or GPU state, so it can run on any thread. Returns false if
+// the file couldn't be loaded.
+bool loadGltf(const std::string& filePathStr, LoadedScene* outScene, const LoadOptions& options = {});
 
 } // namespace GltfLoader
@@ -0,0 +1,154 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "loaded_scene.h"
+
+AcsHelper::GeometryRange LoadedGeometry::addPart(uint32_t numVerts,
+                                                 uint32_t numIdxs,
+                                                 uint32_t materialIdx,
+                                                 float uvScaleLog2)
+{
+    const AcsHelper::GeometryRange range = {
+        .firstVert = this->numVerts,
+        .numVerts = numVerts,
+        .firstIdx = this->numIdxs,
+        .numIdxs = numIdxs,
+    };
+
+    this->numVerts += numVerts;
+    this->numIdxs += numIdxs;
+
+    this->partRanges.push_back(range);
+    this->partMaterialIdxs.push_back(materialIdx);
+    this->partUvScaleLog2s.push_back(uvScaleLog2);
+
+    return range;
+}
+
+void LoadedGeometry::narrowIdxFormat()
+{
+    for (const AcsHelper::GeometryRange& range : this->partRanges)
+    {
+        // indices are relative to the part's first vertex
+        if (range.numVerts > UINT16_MAX + 1)
+        {
+            return;
+        }
+    }
+
+    this->idxFormat = IDX_FORMAT_16;
+}
+
+void LoadedGeometry::allocateHostStreams()
+{
+    this->positions.resize(this->numVerts);
+    this->vertAttribs.resize(this->numVerts);
+    if (this->idxFormat == IDX_FORMAT_16)
+    {
+        this->idxs16.resize(this->numIdxs);
+    }
+    else
+    {
+        this->idxs.resize(this->numIdxs);
+    }
+}
+
+// keeps sections in the index buffer 4-byte aligned so that idxBufferOffset can count 32-bit words
+static uint64_t getStagedIdxsSizeBytes(uint32_t numIdxs, uint32_t idxFormat)
+{
+    return idxFormat == IDX_FORMAT_16 ? (numIdxs + 1) / 2 * 2 * sizeof(uint16_t) : numIdxs * sizeof(uint32_t);
+}
+
+uint64_t LoadedGeometry::getStagingSizeBytes() const
+{
+    return StagingBuffer::getSectionSizeBytes(this->numVerts * sizeof(DirectX::XMFLOAT3)) +
+           StagingBuffer::getSectionSizeBytes(this->numVerts * sizeof(VertexAttributes)) +
+           StagingBuffer::getSectionSizeBytes(getStagedIdxsSizeBytes(this->numIdxs, this->idxFormat));
+}
+
+void LoadedGeometry::allocateStagedStreams(StagingBuffer& stagingBuffer)
+{
+    this->staged.buffer = stagingBuffer.getBuffer();
+    this->staged.positions = stagingBuffer.allocate(this->numVerts * sizeof(DirectX::XMFLOAT3));
+    this->staged.vertAttribs = stagingBuffer.allocate(this->numVerts * sizeof(VertexAttributes));
+    this->staged.idxs = stagingBuffer.allocate(getStagedIdxsSizeBytes(this->numIdxs, this->idxFormat));
+    this->staged.idxFormat = this->idxFormat == IDX_FORMAT_16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+    if (this->idxFormat == IDX_FORMAT_16 && this->numIdxs % 2 != 0)
+    {
+        static_cast<uint16_t*>(this->staged.idxs.host_ptr)[this->numIdxs] = 0;
+    }
+}
+
+bool LoadedGeometry::isStaged() const
+{
+    return this->staged.buffer != nullptr;
+}
+
+DirectX::XMFLOAT3* LoadedGeometry::getPositions()
+{
+    return this->isStaged() ? static_cast<DirectX::XMFLOAT3*>(this->staged.positions.host_ptr) : this->positions.data();
+}
+
+const DirectX::XMFLOAT3* LoadedGeometry::getPositions() const
+{
+    return const_cast<LoadedGeometry*>(this)->getPositions();
+}
+
+VertexAttributes* LoadedGeometry::getVertAttribs()
+{
+    return this->isStaged() ? static_cast<VertexAttributes*>(this->staged.vertAttribs.host_ptr)
+                            : this->vertAttribs.data();
+}
+
+const VertexAttributes* LoadedGeometry::getVertAttribs() const
+{
+    return const_cast<LoadedGeometry*>(this)->getVertAttribs();
+}
+
+void* LoadedGeometry::getIdxs()
+{
+    if (this->isStaged())
+    {
+        return this->staged.idxs.host_ptr;
+    }
+
+    return this->idxFormat == IDX_FORMAT_16 ? static_cast<void*>(this->idxs16.data())
+                                            : static_cast<void*>(this->idxs.data());
+}
+
+const void* LoadedGeometry::getIdxs() const
+{
+    return const_cast<LoadedGeometry*>(this)->getIdxs();
+}
+
+uint64_t LoadedGeometry::getIdxsSizeBytes() const
+{
+    return this->numIdxs * (this->idxFormat == IDX_FORMAT_16 ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+void LoadedScene::initStagingBuffer()
+{
+    uint64_t sizeBytes = 0;
+    for (const LoadedGeometry& geometry : this->geometries)
+    {
+        sizeBytes += geometry.getStagingSizeBytes();
+    }
+
+    this->stagingBuffer.init(sizeBytes);
+}
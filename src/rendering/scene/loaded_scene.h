@@ -0,0 +1,117 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/texture_processor.h"
+#include "rendering/buffer/acs_helper.h"
+#include "rendering/buffer/staging_buffer.h"
+#include "rendering/common/common_structs.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+struct AreaLightInputs
+{
+    DirectX::XMFLOAT3 pos0;
+    DirectX::XMFLOAT3 pos1;
+    DirectX::XMFLOAT3 pos2;
+    uint32_t geometryIdx;
+    uint32_t triangleIdx;
+};
+
+// The contents of a Geometry, moved into one when the scene is added. Parts are added first, then their vertex and
+// index streams are allocated either in host memory or straight in a StagingBuffer, and filled in through
+// getPositions(), getVertAttribs() and getIdxs().
+struct LoadedGeometry
+{
+    std::vector<AcsHelper::GeometryRange> partRanges;
+    // indices into LoadedScene::materials, or MATERIAL_ID_INVALID
+    std::vector<uint32_t> partMaterialIdxs;
+    // see Geometry::addPart()
+    std::vector<float> partUvScaleLog2s;
+    uint32_t numVerts{ 0 };
+    uint32_t numIdxs{ 0 };
+    // must be set before the streams are allocated
+    uint32_t idxFormat{ IDX_FORMAT_32 };
+
+    // from allocateHostStreams(); both vertex streams have the same length, and idxs16 is used instead of idxs if
+    // idxFormat is IDX_FORMAT_16
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<VertexAttributes> vertAttribs;
+    std::vector<uint32_t> idxs;
+    std::vector<uint16_t> idxs16;
+
+    // from allocateStagedStreams()
+    StagedGeometryStreams staged;
+
+    // in object space and grouped by part, in part order; every instance of the geometry gets all of them
+    std::vector<AreaLightInputs> areaLights;
+
+    // Like Geometry::addPart(), but the part's vertices and indices only get room once the streams are allocated.
+    AcsHelper::GeometryRange addPart(uint32_t numVerts, uint32_t numIdxs, uint32_t materialIdx, float uvScaleLog2);
+
+    // Switches to IDX_FORMAT_16 if every part has at most 65,536 vertices, halving the index buffer memory and upload
+    // size. Call once all parts have been added.
+    void narrowIdxFormat();
+
+    void allocateHostStreams();
+
+    // what allocateStagedStreams() takes up in a StagingBuffer
+    uint64_t getStagingSizeBytes() const;
+    void allocateStagedStreams(StagingBuffer& stagingBuffer);
+
+    // Whichever streams were allocated. Staged streams are write-combined upload memory on most GPUs, so they should be
+    // written in order and read back as little as possible. getIdxs() points to uint16_t or uint32_t depending on
+    // idxFormat.
+    bool isStaged() const;
+    DirectX::XMFLOAT3* getPositions();
+    const DirectX::XMFLOAT3* getPositions() const;
+    VertexAttributes* getVertAttribs();
+    const VertexAttributes* getVertAttribs() const;
+    void* getIdxs();
+    const void* getIdxs() const;
+    // leaves out the padding index that staged 16-bit streams can have
+    uint64_t getIdxsSizeBytes() const;
+};
+
+struct LoadedInstance
+{
+    uint32_t geometryIdx;
+    DirectX::XMFLOAT3X4 transform;
+};
+
+// Everything a loader produces, independent of any Scene so that it can be built on a worker thread and handed over
+// with Scene::queueLoadedScene(). Scene ids are only handed out when it's added, so materials refer to textures
+// (through baseColorTextureId), geometries to materials and instances to geometries by their index in here.
+struct LoadedScene
+{
+    std::vector<ProcessedTexture> textures;
+    std::vector<Material> materials;
+    std::vector<LoadedGeometry> geometries;
+    std::vector<LoadedInstance> instances;
+
+    // holds the staged streams of all geometries
+    StagingBuffer stagingBuffer;
+
+    // Sizes stagingBuffer for every geometry. Geometries then allocate their streams in it with
+    // LoadedGeometry::allocateStagedStreams().
+    void initStagingBuffer();
+};
@@ -21,17 +21,109 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "rendering/buffer/acs_helper.h"
 #include "rendering/buffer/buffer_helper.h"
 #include "rendering/buffer/to_free_list.h"
+#include "rendering/buffer/upload_ring.h"
 #include "rendering/dxr_common.h"
 #include "rendering/renderer.h"
+#include "core/build_scheduler.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 
 using namespace DirectX;
 
+Geometry::Geometry(Scene* scene, uint32_t id)
+    : scene(scene), id(id)
+{}
+
+uint32_t Geometry::getId() const
+{
+    return this->id;
+}
+
+uint32_t Geometry::getNumInstances() const
+{
+    return static_cast<uint32_t>(this->instances.size());
+}
+
+AcsHelper::GeometryRange Geometry::addPart(uint32_t numVerts, uint32_t numIdxs, uint32_t materialId, float uvScaleLog2)
+{
+    const AcsHelper::GeometryRange range = {
+        .firstVert = static_cast<uint32_t>(this->host_positions.size()),
+        .numVerts = numVerts,
+        .firstIdx = static_cast<uint32_t>(this->host_idxs.size()),
+        .numIdxs = numIdxs,
+    };
+
+    this->host_positions.resize(this->host_positions.size() + numVerts);
+    this->host_vertAttribs.resize(this->host_vertAttribs.size() + numVerts);
+    this->host_idxs.resize(this->host_idxs.size() + numIdxs);
+
+    this->partRanges.push_back(range);
+    this->partMaterialIds.push_back(materialId);
+    this->partUvScaleLog2s.push_back(uvScaleLog2);
+
+    return range;
+}
+
+uint32_t Geometry::getNumParts() const
+{
+    return static_cast<uint32_t>(this->partRanges.size());
+}
+
+const AcsHelper::GeometryRange& Geometry::getPartRange(uint32_t partIdx) const
+{
+    return this->partRanges[partIdx];
+}
+
+uint32_t Geometry::getPartMaterialId(uint32_t partIdx) const
+{
+    return this->partMaterialIds[partIdx];
+}
+
+uint32_t Geometry::getNumTriangles() const
+{
+    uint32_t numTriangles = 0;
+    for (const AcsHelper::GeometryRange& range : this->partRanges)
+    {
+        numTriangles += (range.numIdxs > 0 ? range.numIdxs : range.numVerts) / 3;
+    }
+    return numTriangles;
+}
+
+void Geometry::setUsage(GeometryUsage usage)
+{
+    this->usage = usage;
+}
+
+GeometryUsage Geometry::getUsage() const
+{
+    return this->usage;
+}
+
 Instance::Instance(Scene* scene, uint32_t id)
     : scene(scene), id(id)
 {}
 
+void Instance::setGeometry(Geometry* geometry)
+{
+#if _DEBUG
+    if (this->geometry != nullptr)
+    {
+        throw std::runtime_error("Attempting to replace the Geometry of an Instance");
+    }
+#endif
+
+    this->geometry = geometry;
+    geometry->instances.push_back(this);
+}
+
+Geometry* Instance::getGeometry() const
+{
+    return this->geometry;
+}
+
 void Instance::addAreaLight(const AreaLightInputs& lightInputs)
 {
 #if _DEBUG
@@ -46,6 +138,7 @@ void Instance::addAreaLight(const AreaLightInputs& lightInputs)
     AreaLight& light = this->host_areaLights.back();
 
     light.instanceId = this->id;
+    light.geometryIdx = lightInputs.geometryIdx;
     light.triangleIdx = lightInputs.triangleIdx;
 
     const DirectX::XMFLOAT3X4& xf = this->transform;
@@ -78,76 +171,171 @@ void Instance::addAreaLight(const AreaLightInputs& lightInputs)
     light.rcpArea = area > 0.f ? (1.f / area) : 0.f;
 }
 
-uint32_t Instance::getId() const
+void Instance::setTransform(const DirectX::XMFLOAT3X4& transform)
 {
-    return this->id;
+#if _DEBUG
+    if (this->areaLightsBufferSection.sizeBytes > 0)
+    {
+        throw std::runtime_error("Attempting to move Instance whose AreaLights have already been uploaded");
+    }
+#endif
+
+    this->transform = transform;
+
+    if (this->instanceDescIdx == INSTANCE_DESC_IDX_INVALID || this->isTransformDirty)
+    {
+        return;
+    }
+
+    this->isTransformDirty = true;
+    this->scene->hasMovingInstances = true;
+    this->scene->instancesWithDirtyTransform.push_back(this);
 }
 
-void Instance::setMaterialId(uint32_t id)
+const DirectX::XMFLOAT3X4& Instance::getTransform() const
 {
-    this->materialId = id;
+    return this->transform;
+}
+
+uint32_t Instance::getId() const
+{
+    return this->id;
 }
 
 void Scene::init()
 {
     // these resources can be dynamically resized later
-    this->managedVertsBuffer.init(512 /*bytes*/);
+    this->managedVertAttribsBuffer.init(256 /*bytes*/);
     this->managedIdxsBuffer.init(128 /*bytes*/);
 
     this->maxNumInstances = 1;
-    this->mappedInstanceDescsArray.init(this->maxNumInstances);
-    this->mappedInstanceDatasArray.init(this->maxNumInstances);
+    this->mappedInstanceDescsArray.init(this->maxNumInstances, MemoryTag::INSTANCES);
+    this->mappedInstanceDatasArray.init(this->maxNumInstances, MemoryTag::INSTANCES);
+    this->managedGeometryDatasBuffer.init(256 /*bytes*/);
     for (int instanceIdx = 0; instanceIdx < this->maxNumInstances; ++instanceIdx)
     {
         availableInstanceIds.push(instanceIdx);
     }
 
-    this->mappedMaterialsArray.init(1);
+    this->mappedMaterialsArray.init(1, MemoryTag::MATERIALS);
 
     this->managedAreaLightsBuffer.init(512 /*bytes*/);
-    this->areaLightSamplingStructure.init(1);
+    this->areaLightSamplingStructure.init(1, MemoryTag::LIGHTS);
+
+    // handed out from the back, lowest first
+    for (uint32_t textureId = NUM_TEXTURE_DESCRIPTORS; textureId > 0; --textureId)
+    {
+        this->availableTextureIds.push_back(textureId - 1);
+    }
 }
 
-void Scene::clear()
+void Scene::clear(ToFreeList& toFreeList)
 {
-    this->managedVertsBuffer.freeAll();
+    this->managedVertAttribsBuffer.freeAll();
     this->managedIdxsBuffer.freeAll();
+    this->managedGeometryDatasBuffer.freeAll();
 
-    this->instances.clear();
-    this->instancesReadyForBlasBuild.clear();
+    // instances that are already waiting in a ToFreeList are left for it to free
+    for (auto it = this->instances.begin(); it != this->instances.end();)
+    {
+        const Instance* instance = it->second.get();
+        if (instance->isScheduledForDeletion)
+        {
+            ++it;
+            continue;
+        }
+
+        it = this->instances.erase(it);
+    }
+
+    for (auto it = this->geometries.begin(); it != this->geometries.end();)
+    {
+        Geometry* geometry = it->second.get();
+        if (geometry->isScheduledForDeletion)
+        {
+            ++it;
+            continue;
+        }
+
+        if (geometry->geoWrapper.dev_blas.isValid())
+        {
+            toFreeList.pushAcsPoolSection(geometry->geoWrapper.dev_blas);
+        }
+
+        it = this->geometries.erase(it);
+    }
+
+    this->pendingInstances.clear();
+    this->geometriesReadyForBlasBuild.clear();
     this->availableInstanceIds = {};
     for (uint32_t instanceIdx = 0; instanceIdx < this->maxNumInstances; ++instanceIdx)
     {
-        this->availableInstanceIds.push(instanceIdx);
+        if (!this->instances.contains(instanceIdx))
+        {
+            this->availableInstanceIds.push(instanceIdx);
+        }
     }
 
     this->nextMaterialIdx = 0;
 
+    this->blasCompactor.clear(toFreeList);
+
     this->isTlasDirty = false;
-    this->dev_tlas = nullptr;
+    this->isTlasRefittable = false;
+    this->hasMovingInstances = false;
+    this->instancesWithDirtyTransform.clear();
+    this->tlasInstances.clear();
+    if (this->dev_tlas.isValid())
+    {
+        toFreeList.pushAcsPoolSection(this->dev_tlas);
+        this->dev_tlas = {};
+    }
 
-    this->textures.fill(nullptr);
-    this->nextTextureId = 0;
+    for (const uint32_t textureId : this->usedTextureIds)
+    {
+        ComPtr<ID3D12Resource>& texture = this->textures[textureId];
+        if (texture != nullptr)
+        {
+            toFreeList.pushResource(texture, false);
+            texture = nullptr;
+        }
+        this->releasedTextureIds.push_back(textureId);
+    }
+    this->usedTextureIds.clear();
     this->pendingTextures.clear();
 
-    this->numAreaLights = 0;
+    this->host_areaLightSamplingStructure.clear();
+    this->areaLightSamplingIdxs.clear();
     this->managedAreaLightsBuffer.freeAll();
 }
 
-Instance* Scene::requestNewInstance(ToFreeList& toFreeList)
+void Scene::growMaxNumInstances(ToFreeList& toFreeList, uint32_t newMaxNumInstances)
 {
-    if (this->availableInstanceIds.empty())
+    const uint32_t oldMaxNumInstances = this->maxNumInstances;
+
+    this->maxNumInstances = newMaxNumInstances;
+    this->mappedInstanceDescsArray.resize(toFreeList, this->maxNumInstances);
+    this->mappedInstanceDatasArray.resize(toFreeList, this->maxNumInstances);
+
+    for (uint32_t instanceIdx = oldMaxNumInstances; instanceIdx < this->maxNumInstances; ++instanceIdx)
     {
-        const uint32_t oldMaxNumInstances = this->maxNumInstances;
+        this->availableInstanceIds.push(instanceIdx);
+    }
+}
 
-        this->maxNumInstances *= 2;
-        this->mappedInstanceDescsArray.resize(toFreeList, this->maxNumInstances);
-        this->mappedInstanceDatasArray.resize(toFreeList, this->maxNumInstances);
+void Scene::reserveInstances(ToFreeList& toFreeList, uint32_t numInstances)
+{
+    if (numInstances > this->maxNumInstances)
+    {
+        this->growMaxNumInstances(toFreeList, numInstances);
+    }
+}
 
-        for (int instanceIdx = oldMaxNumInstances; instanceIdx < this->maxNumInstances; ++instanceIdx)
-        {
-            this->availableInstanceIds.push(instanceIdx);
-        }
+Instance* Scene::requestNewInstance(ToFreeList& toFreeList)
+{
+    if (this->availableInstanceIds.empty())
+    {
+        this->growMaxNumInstances(toFreeList, this->maxNumInstances * 2);
     }
 
     const uint32_t id = this->availableInstanceIds.front();
@@ -161,17 +349,59 @@ Instance* Scene::requestNewInstance(ToFreeList& toFreeList)
     return newInstancePtr;
 }
 
-void Scene::markInstanceReadyForBlasBuild(Instance* instance)
+void Scene::markInstanceReady(Instance* instance)
 {
-    this->instancesReadyForBlasBuild.push_back(instance);
+    Geometry* geometry = instance->geometry;
+
+#if _DEBUG
+    if (geometry == nullptr)
+    {
+        throw std::runtime_error("Attempting to mark Instance with no Geometry as ready");
+    }
+#endif
+
+    if (!geometry->geoWrapper.dev_blas.isValid() && !geometry->isQueuedForBlasBuild)
+    {
+        geometry->isQueuedForBlasBuild = true;
+        this->geometriesReadyForBlasBuild.push_back(geometry);
+    }
+
+    this->pendingInstances.push_back(instance);
+}
+
+Geometry* Scene::requestNewGeometry()
+{
+    const uint32_t id = this->nextGeometryId++;
+
+    // can't use make_unique() here since the constructor is private and accessed through friend relationship
+    std::unique_ptr<Geometry> newGeometry = std::unique_ptr<Geometry>(new Geometry(this, id));
+    Geometry* newGeometryPtr = newGeometry.get();
+    this->geometries.emplace(id, std::move(newGeometry));
+
+    return newGeometryPtr;
 }
 
 void Scene::freeInstance(Instance* instance)
 {
+    if (instance->isTransformDirty)
+    {
+        std::erase(this->instancesWithDirtyTransform, instance);
+    }
+
     this->availableInstanceIds.push(instance->id);
     this->instances.erase(instance->id);
 }
 
+void Scene::freeGeometry(Geometry* geometry)
+{
+    this->geometries.erase(geometry->id);
+}
+
+void Scene::reserveMaterials(ToFreeList& toFreeList, uint32_t numMaterials)
+{
+    this->mappedMaterialsArray.reserve(toFreeList, numMaterials);
+}
+
 uint32_t Scene::addMaterial(ToFreeList& toFreeList, const Material* material)
 {
     if (this->nextMaterialIdx >= this->mappedMaterialsArray.getSize())
@@ -185,254 +415,726 @@ uint32_t Scene::addMaterial(ToFreeList& toFreeList, const Material* material)
     return materialIdx;
 }
 
-uint32_t Scene::addTexture(std::vector<uint8_t>&& data, uint32_t width, uint32_t height)
+static DXGI_FORMAT getDxgiFormat(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::RGBA8:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case TextureFormat::BC7_SRGB:
+        return DXGI_FORMAT_BC7_UNORM_SRGB;
+    case TextureFormat::BC5:
+        return DXGI_FORMAT_BC5_UNORM;
+    default:
+        return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    }
+}
+
+static D3D12_CPU_DESCRIPTOR_HANDLE getTextureDescriptorHandle(uint32_t textureId)
+{
+    const uint32_t descriptorSize =
+        Renderer::device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return { Renderer::sharedHeap->GetCPUDescriptorHandleForHeapStart().ptr + descriptorSize * textureId };
+}
+
+uint32_t Scene::addTexture(ProcessedTexture&& texture)
 {
-    if (this->nextTextureId >= MAX_NUM_TEXTURES)
+    if (this->usedTextureIds.size() >= MAX_NUM_TEXTURES || this->availableTextureIds.empty())
     {
         throw std::runtime_error("Scene out of texture slots");
     }
 
-    const uint32_t id = this->nextTextureId++;
-    this->pendingTextures.push_back({ std::move(data), width, height, id });
+    const uint32_t id = this->availableTextureIds.back();
+    this->availableTextureIds.pop_back();
+    this->usedTextureIds.push_back(id);
+
+    D3D12_RESOURCE_DESC texDesc = {};
+    texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    texDesc.Width = texture.width;
+    texDesc.Height = texture.height;
+    texDesc.DepthOrArraySize = 1;
+    texDesc.MipLevels = static_cast<UINT16>(texture.numMips);
+    texDesc.Format = getDxgiFormat(texture.format);
+    texDesc.SampleDesc = NO_AA;
+
+    // Created and described right away, since frames may read the descriptor as soon as materials use this ID. The
+    // texture is zeroed until uploadPendingTextures() gets to it, so it reads as black until then.
+    ComPtr<ID3D12Resource>& dev_texture = this->textures[id];
+    CHECK_HRESULT(Renderer::device->CreateCommittedResource(&DEFAULT_HEAP,
+                                                            D3D12_HEAP_FLAG_NONE,
+                                                            &texDesc,
+                                                            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                                            nullptr,
+                                                            IID_PPV_ARGS(&dev_texture)));
+    BufferHelper::trackResource(dev_texture.Get(), MemoryTag::TEXTURES);
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {
+        .Format = texDesc.Format,
+        .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+        .Texture2D = {
+            .MipLevels = texture.numMips,
+        },
+    };
+    Renderer::device->CreateShaderResourceView(dev_texture.Get(), &srvDesc, getTextureDescriptorHandle(id));
+
+    this->pendingTextures.push_back({ std::move(texture), id });
     return id;
 }
 
-void Scene::update(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
+void Scene::setTextureUploadBudget(uint64_t numBytes)
+{
+    this->textureUploadBudgetBytes = numBytes;
+}
+
+bool Scene::queueLoadedScene(std::unique_ptr<LoadedScene>& loadedScene)
 {
-    this->isTlasDirty |= this->makeQueuedBlases(cmdList, toFreeList);
+    return this->loadedSceneQueue.tryPush(loadedScene);
+}
+
+void Scene::replaceWithLoadedScene(ToFreeList& toFreeList, LoadedScene&& loadedScene)
+{
+    this->clear(toFreeList);
+
+    std::vector<uint32_t> textureIds;
+    textureIds.reserve(loadedScene.textures.size());
+    for (ProcessedTexture& texture : loadedScene.textures)
+    {
+        textureIds.push_back(this->addTexture(std::move(texture)));
+    }
+
+    std::vector<uint32_t> materialIds;
+    materialIds.reserve(loadedScene.materials.size());
+    this->reserveMaterials(toFreeList, static_cast<uint32_t>(loadedScene.materials.size()));
+    for (Material& material : loadedScene.materials)
+    {
+        if (material.baseColorTextureId != TEXTURE_ID_INVALID)
+        {
+            material.baseColorTextureId = textureIds[material.baseColorTextureId];
+        }
+        materialIds.push_back(this->addMaterial(toFreeList, &material));
+    }
+
+    // the loaded vectors are moved rather than copied, so the frame that swaps the scene in doesn't touch vertex data
+    std::vector<Geometry*> geometries;
+    geometries.reserve(loadedScene.geometries.size());
+    for (LoadedGeometry& loadedGeometry : loadedScene.geometries)
+    {
+        Geometry* const geometry = this->requestNewGeometry();
+        geometry->partRanges = std::move(loadedGeometry.partRanges);
+        geometry->partMaterialIds.reserve(loadedGeometry.partMaterialIdxs.size());
+        for (const uint32_t materialIdx : loadedGeometry.partMaterialIdxs)
+        {
+            geometry->partMaterialIds.push_back(materialIdx != MATERIAL_ID_INVALID ? materialIds[materialIdx]
+                                                                                   : MATERIAL_ID_INVALID);
+        }
+        geometry->partUvScaleLog2s = std::move(loadedGeometry.partUvScaleLog2s);
+
+        geometry->host_positions = std::move(loadedGeometry.positions);
+        geometry->host_vertAttribs = std::move(loadedGeometry.vertAttribs);
+        geometry->host_idxs = std::move(loadedGeometry.idxs);
+        geometry->host_idxs16 = std::move(loadedGeometry.idxs16);
+        geometry->stagedStreams = std::move(loadedGeometry.staged);
+        geometry->idxFormat = loadedGeometry.idxFormat;
+
+        geometries.push_back(geometry);
+    }
+
+    this->reserveInstances(toFreeList, static_cast<uint32_t>(loadedScene.instances.size()));
+    for (const LoadedInstance& loadedInstance : loadedScene.instances)
+    {
+        Instance* instance = this->requestNewInstance(toFreeList);
+        instance->setGeometry(geometries[loadedInstance.geometryIdx]);
+        instance->setTransform(loadedInstance.transform);
+
+        for (const AreaLightInputs& lightInputs : loadedScene.geometries[loadedInstance.geometryIdx].areaLights)
+        {
+            instance->addAreaLight(lightInputs);
+        }
+
+        this->markInstanceReady(instance);
+    }
+}
+
+void Scene::update(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing)
+{
+    // only the newest of the loaded scenes is worth adding
+    std::unique_ptr<LoadedScene> loadedScene;
+    while (this->loadedSceneQueue.tryPop(&loadedScene))
+    {
+        this->nextLoadedScene = std::move(loadedScene);
+    }
+
+    // The current scene stays as is until the loaded one's textures can get IDs whose descriptors frames in flight
+    // don't read anymore. A scene with too many textures is let through so that addTexture() reports it.
+    if (this->nextLoadedScene != nullptr &&
+        this->availableTextureIds.size() >= std::min<size_t>(this->nextLoadedScene->textures.size(), MAX_NUM_TEXTURES))
+    {
+        this->replaceWithLoadedScene(toFreeList, std::move(*this->nextLoadedScene));
+        this->nextLoadedScene = nullptr;
+    }
+
+    this->compactGeometryBuffers(cmdList, toFreeList);
+
+    this->isTlasDirty |= this->compactBlases(cmdList, toFreeList);
+    this->makeQueuedBlases(cmdList, toFreeList, uploadRing);
+    this->isTlasDirty |= this->addPendingInstances(cmdList, toFreeList, uploadRing);
 
-    this->mappedInstanceDescsArray.copyFromUploadBufferIfDirty(cmdList);
-    this->mappedInstanceDatasArray.copyFromUploadBufferIfDirty(cmdList);
+    // TLAS builds and refits read the device copy of the instance descs, so moves have to be in it by then; reading the
+    // mapped upload buffer would race frames still in flight
+    const bool hasDirtyTransforms = !this->instancesWithDirtyTransform.empty();
+    this->writeDirtyTransforms();
 
-    this->mappedMaterialsArray.copyFromUploadBufferIfDirty(cmdList);
+    this->mappedInstanceDescsArray.copyFromUploadBufferIfDirty(cmdList, toFreeList);
+    this->mappedInstanceDatasArray.copyFromUploadBufferIfDirty(cmdList, toFreeList);
+
+    this->mappedMaterialsArray.copyFromUploadBufferIfDirty(cmdList, toFreeList);
 
     if (!this->pendingTextures.empty())
     {
-        this->uploadPendingTextures(cmdList, toFreeList);
+        this->uploadPendingTextures(cmdList, toFreeList, uploadRing);
+    }
+
+    if (!this->isTlasDirty && hasDirtyTransforms &&
+        (!this->isTlasRefittable || this->numTlasRefitsSinceRebuild >= MAX_TLAS_REFITS_BEFORE_REBUILD))
+    {
+        this->isTlasDirty = true;
     }
 
     if (this->isTlasDirty)
     {
         this->makeTlas(cmdList, toFreeList);
     }
+    else if (hasDirtyTransforms)
+    {
+        this->refitTlas(cmdList, toFreeList);
+    }
 
-    this->areaLightSamplingStructure.copyFromUploadBufferIfDirty(cmdList);
+    this->areaLightSamplingStructure.copyFromUploadBufferIfDirty(cmdList, toFreeList);
 }
 
-bool Scene::makeQueuedBlases(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
+void Scene::submit(uint64_t fenceValue)
 {
-    if (this->instancesReadyForBlasBuild.empty())
+    this->blasCompactor.submit(fenceValue);
+
+    if (!this->releasedTextureIds.empty())
     {
-        return false;
+        this->retiringTextureIds.push(fenceValue, std::move(this->releasedTextureIds));
+        this->releasedTextureIds = {};
     }
+}
 
-    std::vector<AcsHelper::BlasBuildInputs> allBlasInputs;
+void Scene::reclaim(uint64_t completedFenceValue)
+{
+    this->blasCompactor.reclaim(completedFenceValue);
+
+    this->retiringTextureIds.drain(completedFenceValue, [this](std::vector<uint32_t>& textureIds) {
+        this->availableTextureIds.insert(this->availableTextureIds.end(), textureIds.rbegin(), textureIds.rend());
+    });
+}
+
+void Scene::setBlasCompactionEnabled(bool isEnabled)
+{
+    this->isBlasCompactionEnabled = isEnabled;
+}
+
+bool Scene::getBlasCompactionEnabled() const
+{
+    return this->isBlasCompactionEnabled;
+}
+
+void Scene::setBlasBuildBudget(uint64_t numTriangles)
+{
+    this->blasBuildBudgetTriangles = numTriangles;
+}
+
+void Scene::setViewerPos(const DirectX::XMFLOAT3& pos_WS)
+{
+    this->viewerPos_WS = pos_WS;
+}
+
+void Scene::compactGeometryBuffers(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
+{
+    // section owners are geometry IDs
+    for (const auto& relocation :
+         this->managedVertAttribsBuffer.compact(cmdList, toFreeList, MAX_COMPACTION_BYTES_PER_FRAME))
+    {
+        Geometry* geometry = this->geometries.at(relocation.userData).get();
+        geometry->geoWrapper.vertAttribsBufferSection.offsetBytes = relocation.dstOffsetBytes;
+        for (const Instance* instance : geometry->instances)
+        {
+            this->mappedInstanceDatasArray[instance->id].vertAttribsBufferOffset =
+                Util::convertByteSizeToCount<VertexAttributes>(relocation.dstOffsetBytes);
+        }
+    }
+
+    for (const auto& relocation : this->managedIdxsBuffer.compact(cmdList, toFreeList, MAX_COMPACTION_BYTES_PER_FRAME))
+    {
+        Geometry* geometry = this->geometries.at(relocation.userData).get();
+        geometry->geoWrapper.idxsBufferSection.offsetBytes = relocation.dstOffsetBytes;
+        for (const Instance* instance : geometry->instances)
+        {
+            this->mappedInstanceDatasArray[instance->id].idxBufferOffset =
+                Util::convertByteSizeToCount<uint32_t>(relocation.dstOffsetBytes);
+        }
+    }
+}
+
+void Scene::makeQueuedBlases(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing)
+{
+    if (this->geometriesReadyForBlasBuild.empty())
+    {
+        return;
+    }
+
+    std::vector<BuildScheduler::Candidate> candidates;
+    candidates.reserve(this->geometriesReadyForBlasBuild.size());
+    const XMVECTOR viewerPos = XMLoadFloat3(&this->viewerPos_WS);
+    for (const Geometry* const geometry : this->geometriesReadyForBlasBuild)
+    {
+        // instances of a geometry can be spread out, so the closest one decides
+        float minDistanceSq = std::numeric_limits<float>::max();
+        for (const Instance* const instance : geometry->instances)
+        {
+            const DirectX::XMFLOAT3X4& xf = instance->transform;
+            const XMVECTOR instancePos = XMVectorSet(xf.m[0][3], xf.m[1][3], xf.m[2][3], 0.f);
+            const float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(instancePos, viewerPos)));
+            minDistanceSq = std::min(distanceSq, minDistanceSq);
+        }
+
+        candidates.push_back({ .cost = geometry->getNumTriangles(), .priority = minDistanceSq });
+    }
 
-    uint32_t numNewAreaLights = 0;
+    std::vector<Geometry*> geometriesToBuild;
+    for (const uint32_t candidateIdx : BuildScheduler::selectBuilds(candidates, this->blasBuildBudgetTriangles))
+    {
+        geometriesToBuild.push_back(this->geometriesReadyForBlasBuild[candidateIdx]);
+    }
+
+    std::vector<AcsHelper::BlasBuildInputs> allBlasInputs;
 
-    for (Instance* const instance : instancesReadyForBlasBuild)
+    for (Geometry* const geometry : geometriesToBuild)
     {
         AcsHelper::BlasBuildInputs blasInputs;
 
-        blasInputs.host_verts = &instance->host_verts;
-        blasInputs.dev_verts = &managedVertsBuffer;
+        blasInputs.host_positions = &geometry->host_positions;
+        blasInputs.host_vertAttribs = &geometry->host_vertAttribs;
+        blasInputs.dev_vertAttribs = &managedVertAttribsBuffer;
+
+        if (geometry->stagedStreams.buffer != nullptr)
+        {
+            blasInputs.staged = &geometry->stagedStreams;
+            blasInputs.dev_idxs = &managedIdxsBuffer;
+        }
+        else if (geometry->host_idxs16.size() > 0)
+        {
+            // keeps sections in the index buffer 4-byte aligned so that idxBufferOffset can count 32-bit words
+            if (geometry->host_idxs16.size() % 2 != 0)
+            {
+                geometry->host_idxs16.push_back(0);
+            }
 
-        if (instance->host_idxs.size() > 0)
+            blasInputs.host_idxs16 = &geometry->host_idxs16;
+            blasInputs.dev_idxs = &managedIdxsBuffer;
+        }
+        else if (geometry->host_idxs.size() > 0)
         {
-            blasInputs.host_idxs = &instance->host_idxs;
+            blasInputs.host_idxs = &geometry->host_idxs;
             blasInputs.dev_idxs = &managedIdxsBuffer;
         }
+        blasInputs.ranges = &geometry->partRanges;
 
-        blasInputs.outGeoWrapper = &instance->geoWrapper;
+        blasInputs.outGeoWrapper = &geometry->geoWrapper;
+        blasInputs.preferFastBuild = geometry->usage == GeometryUsage::DYNAMIC;
+        blasInputs.allowCompaction = this->isBlasCompactionEnabled && !blasInputs.preferFastBuild;
 
         allBlasInputs.push_back(blasInputs);
-
-        numNewAreaLights += instance->host_areaLights.size();
     }
 
-    ManagedBuffer areaLightsUploadBuffer{
-        &UPLOAD_HEAP,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        false /*isResizable*/,
-        true /*isMapped*/,
-    };
-    if (numNewAreaLights > 0)
+    AcsHelper::makeBlases(cmdList, toFreeList, uploadRing, allBlasInputs);
+
+    BufferHelper::uavBarrier(cmdList, nullptr);
+
+    std::vector<BlasCompactor::Request> compactionRequests;
+    for (uint32_t buildIdx = 0; buildIdx < geometriesToBuild.size(); ++buildIdx)
     {
-        areaLightsUploadBuffer.init(numNewAreaLights * sizeof(AreaLight));
+        Geometry* const geometry = geometriesToBuild[buildIdx];
+        geometry->blasBuildIdx = this->nextBlasBuildIdx++;
+        geometry->isQueuedForBlasBuild = false;
+
+        if (allBlasInputs[buildIdx].allowCompaction)
+        {
+            compactionRequests.push_back({
+                .ownerId = geometry->id,
+                .buildIdx = geometry->blasBuildIdx,
+                .blas = geometry->geoWrapper.dev_blas,
+            });
+        }
+
+        // BLASes are built from the upload buffers, so these sections can be moved around without rebuilding anything
+        this->managedVertAttribsBuffer.setSectionOwner(geometry->geoWrapper.vertAttribsBufferSection, geometry->id);
+        if (geometry->geoWrapper.idxsBufferSection.sizeBytes > 0)
+        {
+            this->managedIdxsBuffer.setSectionOwner(geometry->geoWrapper.idxsBufferSection, geometry->id);
+        }
+
+        // the memory is released rather than just cleared, since a geometry is never uploaded twice
+        geometry->host_positions = {};
+        geometry->host_vertAttribs = {};
+        geometry->host_idxs = {};
+        geometry->host_idxs16 = {};
+        if (geometry->stagedStreams.buffer != nullptr)
+        {
+            // the staging buffer itself is released once every geometry staged in it has been uploaded
+            toFreeList.pushResource(geometry->stagedStreams.buffer, false);
+            geometry->stagedStreams = {};
+        }
+
+        std::vector<GeometryData> geometryDatas;
+        geometryDatas.reserve(geometry->partRanges.size());
+        for (uint32_t partIdx = 0; partIdx < geometry->partRanges.size(); ++partIdx)
+        {
+            const AcsHelper::GeometryRange& range = geometry->partRanges[partIdx];
+            geometryDatas.push_back({
+                .vertOffset = range.firstVert,
+                .hasIdxs = range.numIdxs > 0,
+                .idxOffset = range.firstIdx,
+                .materialId = geometry->partMaterialIds[partIdx],
+                .uvScaleLog2 = geometry->partUvScaleLog2s[partIdx],
+                .pad0 = 0,
+                .pad1 = 0,
+                .pad2 = 0,
+            });
+        }
+
+        const UploadRingSection geometryDatasUploadSection = uploadRing.copyFromHostVector(toFreeList, geometryDatas);
+        geometry->geometryDatasBufferSection =
+            this->managedGeometryDatasBuffer.copyFromDeviceBuffer(cmdList,
+                                                                  toFreeList,
+                                                                  geometryDatasUploadSection.buffer,
+                                                                  geometryDatasUploadSection.sizeBytes,
+                                                                  geometryDatasUploadSection.offsetBytes);
     }
 
-    AcsHelper::makeBlases(cmdList, toFreeList, allBlasInputs);
+    this->blasCompactor.queueSizeQueries(cmdList, toFreeList, std::move(compactionRequests));
 
-    BufferHelper::uavBarrier(cmdList, nullptr);
+    std::erase_if(this->geometriesReadyForBlasBuild,
+                  [](const Geometry* geometry) { return !geometry->isQueuedForBlasBuild; });
+}
 
-    for (const auto instance : this->instancesReadyForBlasBuild)
+bool Scene::addPendingInstances(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing)
+{
+    if (this->pendingInstances.empty())
     {
-        InstanceData& data = this->mappedInstanceDatasArray[instance->id];
-        data.vertBufferOffset =
-            instance->geoWrapper.vertsBufferSection.offsetBytes / static_cast<uint32_t>(sizeof(Vertex));
-        data.hasIdxs = instance->geoWrapper.idxsBufferSection.sizeBytes > 0;
-        data.idxBufferByteOffset = instance->geoWrapper.idxsBufferSection.offsetBytes;
-        data.materialId = instance->materialId;
+        return false;
+    }
+
+    bool addedAny = false;
+    for (Instance* const instance : this->pendingInstances)
+    {
+        // instances stay out of the TLAS until their BLAS has been built
+        if (!instance->geometry->geoWrapper.dev_blas.isValid())
+        {
+            continue;
+        }
 
-        instance->host_verts.clear();
-        instance->host_idxs.clear();
+        addedAny = true;
+        instance->isReady = true;
+
+        InstanceData& data = this->mappedInstanceDatasArray[instance->id];
+        const AcsHelper::GeometryWrapper& geoWrapper = instance->geometry->geoWrapper;
+        data.vertAttribsBufferOffset =
+            Util::convertByteSizeToCount<VertexAttributes>(geoWrapper.vertAttribsBufferSection.offsetBytes);
+        data.idxBufferOffset = Util::convertByteSizeToCount<uint32_t>(geoWrapper.idxsBufferSection.offsetBytes);
+        data.idxFormat = instance->geometry->idxFormat;
+        data.geometryDataOffset = Util::convertByteSizeToCount<GeometryData>(
+            instance->geometry->geometryDatasBufferSection.offsetBytes);
 
         if (!instance->host_areaLights.empty())
         {
-            ManagedBufferSection areaLightsUploadBufferSection =
-                areaLightsUploadBuffer.copyFromHostVector(cmdList, toFreeList, instance->host_areaLights);
-            instance->areaLightsBufferSection = this->managedAreaLightsBuffer.copyFromManagedBuffer(
-                cmdList, toFreeList, areaLightsUploadBuffer, areaLightsUploadBufferSection);
+            const UploadRingSection areaLightsUploadSection =
+                uploadRing.copyFromHostVector(toFreeList, instance->host_areaLights);
+            instance->areaLightsBufferSection =
+                this->managedAreaLightsBuffer.copyFromDeviceBuffer(cmdList,
+                                                                   toFreeList,
+                                                                   areaLightsUploadSection.buffer,
+                                                                   areaLightsUploadSection.sizeBytes,
+                                                                   areaLightsUploadSection.offsetBytes);
 
             instance->host_areaLights.clear();
         }
-    }
 
-    if (numNewAreaLights > 0)
-    {
-        toFreeList.pushManagedBuffer(&areaLightsUploadBuffer);
+        this->addInstanceToTlas(toFreeList, instance);
     }
 
-    this->instancesReadyForBlasBuild.clear();
-    return true;
+    std::erase_if(this->pendingInstances, [](const Instance* instance) { return instance->isReady; });
+    return addedAny;
 }
 
-void Scene::makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
+bool Scene::compactBlases(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
 {
-    if (this->dev_tlas)
+    const std::vector<BlasCompactor::Result> results = this->blasCompactor.takeReadyResults();
+    if (results.empty())
     {
-        toFreeList.pushResource(this->dev_tlas, false);
+        return false;
     }
 
-    uint32_t nextInstanceDescIdx = 0;
-    uint32_t nextAreaLightSamplingIdx = 0;
-    for (const auto& [instanceId, instance] : this->instances)
+    bool hasCompacted = false;
+    for (const BlasCompactor::Result& result : results)
     {
-        if (instance->isScheduledForDeletion)
+        // the geometry may have been freed while the size was being read back
+        const auto geometryIt = this->geometries.find(result.request.ownerId);
+        if (geometryIt == this->geometries.end())
         {
             continue;
         }
 
-        D3D12_RAYTRACING_INSTANCE_DESC& instanceDesc = this->mappedInstanceDescsArray[nextInstanceDescIdx++];
-        memcpy(instanceDesc.Transform, &instance->transform, sizeof(XMFLOAT3X4));
-        instanceDesc.InstanceID = instanceId;
-        instanceDesc.InstanceMask = 1;
-        instanceDesc.AccelerationStructure = instance->geoWrapper.dev_blas->GetGPUVirtualAddress();
+        Geometry* geometry = geometryIt->second.get();
+        if (geometry->isScheduledForDeletion || geometry->blasBuildIdx != result.request.buildIdx ||
+            result.compactedSizeBytes >= result.request.blas.getSizeBytes())
+        {
+            continue;
+        }
 
-        if (instance->areaLightsBufferSection.sizeBytes > 0)
+        geometry->geoWrapper.dev_blas = this->blasCompactor.compact(cmdList, toFreeList, result);
+        for (const Instance* const instance : geometry->instances)
         {
-            const uint32_t instanceNumAreaLights = instance->areaLightsBufferSection.sizeBytes / sizeof(AreaLight);
-            uint32_t instanceAreaLightIdx = instance->areaLightsBufferSection.offsetBytes / sizeof(AreaLight);
-            for (uint32_t idx = 0; idx < instanceNumAreaLights; ++idx)
+            if (instance->instanceDescIdx != Instance::INSTANCE_DESC_IDX_INVALID)
             {
-                if (nextAreaLightSamplingIdx >= this->areaLightSamplingStructure.getSize())
-                {
-                    this->areaLightSamplingStructure.resize(toFreeList, this->areaLightSamplingStructure.getSize() * 2);
-                }
-
-                this->areaLightSamplingStructure[nextAreaLightSamplingIdx++] = instanceAreaLightIdx++;
+                this->mappedInstanceDescsArray[instance->instanceDescIdx].AccelerationStructure =
+                    geometry->geoWrapper.dev_blas.getGpuAddress();
             }
         }
+
+        hasCompacted = true;
+    }
+
+    if (!hasCompacted)
+    {
+        return false;
+    }
+
+    BufferHelper::uavBarrier(cmdList, nullptr);
+
+    return true;
+}
+
+void Scene::writeInstanceDesc(const Instance* instance)
+{
+    D3D12_RAYTRACING_INSTANCE_DESC& instanceDesc = this->mappedInstanceDescsArray[instance->instanceDescIdx];
+    instanceDesc = {};
+    memcpy(instanceDesc.Transform, &instance->transform, sizeof(XMFLOAT3X4));
+    instanceDesc.InstanceID = instance->id;
+    instanceDesc.InstanceMask = 1;
+    instanceDesc.AccelerationStructure = instance->geometry->geoWrapper.dev_blas.getGpuAddress();
+}
+
+void Scene::addInstanceToTlas(ToFreeList& toFreeList, Instance* instance)
+{
+    instance->instanceDescIdx = static_cast<uint32_t>(this->tlasInstances.size());
+    this->tlasInstances.push_back(instance);
+    this->writeInstanceDesc(instance);
+
+    const uint32_t instanceNumAreaLights =
+        Util::convertByteSizeToCount<AreaLight>(instance->areaLightsBufferSection.sizeBytes);
+    const uint32_t firstAreaLightIdx =
+        Util::convertByteSizeToCount<AreaLight>(instance->areaLightsBufferSection.offsetBytes);
+    for (uint32_t areaLightIdx = firstAreaLightIdx; areaLightIdx < firstAreaLightIdx + instanceNumAreaLights;
+         ++areaLightIdx)
+    {
+        const uint32_t samplingIdx = static_cast<uint32_t>(this->host_areaLightSamplingStructure.size());
+        if (samplingIdx >= this->areaLightSamplingStructure.getSize())
+        {
+            this->areaLightSamplingStructure.resize(toFreeList, this->areaLightSamplingStructure.getSize() * 2);
+        }
+
+        if (areaLightIdx >= this->areaLightSamplingIdxs.size())
+        {
+            this->areaLightSamplingIdxs.resize(areaLightIdx + 1);
+        }
+
+        this->host_areaLightSamplingStructure.push_back(areaLightIdx);
+        this->areaLightSamplingIdxs[areaLightIdx] = samplingIdx;
+        this->areaLightSamplingStructure[samplingIdx] = areaLightIdx;
+    }
+}
+
+void Scene::removeInstanceFromTlas(Instance* instance)
+{
+    const uint32_t instanceDescIdx = instance->instanceDescIdx;
+    Instance* const lastInstance = this->tlasInstances.back();
+    if (lastInstance != instance)
+    {
+        this->tlasInstances[instanceDescIdx] = lastInstance;
+        lastInstance->instanceDescIdx = instanceDescIdx;
+        this->writeInstanceDesc(lastInstance);
+    }
+    this->tlasInstances.pop_back();
+
+    instance->instanceDescIdx = Instance::INSTANCE_DESC_IDX_INVALID;
+    if (instance->isTransformDirty)
+    {
+        std::erase(this->instancesWithDirtyTransform, instance);
+        instance->isTransformDirty = false;
+    }
+
+    const uint32_t instanceNumAreaLights =
+        Util::convertByteSizeToCount<AreaLight>(instance->areaLightsBufferSection.sizeBytes);
+    const uint32_t firstAreaLightIdx =
+        Util::convertByteSizeToCount<AreaLight>(instance->areaLightsBufferSection.offsetBytes);
+    for (uint32_t areaLightIdx = firstAreaLightIdx; areaLightIdx < firstAreaLightIdx + instanceNumAreaLights;
+         ++areaLightIdx)
+    {
+        const uint32_t samplingIdx = this->areaLightSamplingIdxs[areaLightIdx];
+        const uint32_t lastAreaLightIdx = this->host_areaLightSamplingStructure.back();
+        if (lastAreaLightIdx != areaLightIdx)
+        {
+            this->host_areaLightSamplingStructure[samplingIdx] = lastAreaLightIdx;
+            this->areaLightSamplingIdxs[lastAreaLightIdx] = samplingIdx;
+            this->areaLightSamplingStructure[samplingIdx] = lastAreaLightIdx;
+        }
+        this->host_areaLightSamplingStructure.pop_back();
+    }
+
+    this->isTlasDirty = true;
+}
+
+void Scene::writeDirtyTransforms()
+{
+    for (Instance* const instance : this->instancesWithDirtyTransform)
+    {
+        D3D12_RAYTRACING_INSTANCE_DESC& instanceDesc = this->mappedInstanceDescsArray[instance->instanceDescIdx];
+        memcpy(instanceDesc.Transform, &instance->transform, sizeof(XMFLOAT3X4));
+        instance->isTransformDirty = false;
+    }
+    this->instancesWithDirtyTransform.clear();
+}
+
+void Scene::makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
+{
+    if (this->dev_tlas.isValid())
+    {
+        toFreeList.pushAcsPoolSection(this->dev_tlas);
     }
 
-    this->numAreaLights = nextAreaLightSamplingIdx;
+    const uint32_t numInstances = static_cast<uint32_t>(this->tlasInstances.size());
 
     AcsHelper::TlasBuildInputs inputs;
-    inputs.dev_instanceDescs = this->mappedInstanceDescsArray.getUploadBuffer(); // TODO: test if this crashes with default heap buffer
-    inputs.numInstances = nextInstanceDescIdx;
+    inputs.dev_instanceDescs = this->mappedInstanceDescsArray.getBuffer();
+    inputs.numInstances = numInstances;
+    inputs.updateScratchSizePtr = this->hasMovingInstances ? &this->tlasUpdateScratchSize : nullptr;
     inputs.outTlas = &this->dev_tlas;
 
     AcsHelper::makeTlas(cmdList, toFreeList, inputs);
     this->isTlasDirty = false;
 
-    BufferHelper::uavBarrier(cmdList, this->dev_tlas.Get());
+    this->isTlasRefittable = this->hasMovingInstances;
+    this->numTlasInstances = numInstances;
+    this->numTlasRefitsSinceRebuild = 0;
+
+    BufferHelper::uavBarrier(cmdList, this->dev_tlas.getBuffer());
 }
 
-void Scene::uploadPendingTextures(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
+void Scene::refitTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList)
 {
-    const uint32_t descriptorSize =
-        Renderer::device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    const D3D12_CPU_DESCRIPTOR_HANDLE heapCpuHandle =
-        Renderer::sharedHeap->GetCPUDescriptorHandleForHeapStart();
+    AcsHelper::TlasBuildInputs inputs;
+    inputs.dev_instanceDescs = this->mappedInstanceDescsArray.getBuffer();
+    inputs.numInstances = this->numTlasInstances;
+    inputs.outTlas = &this->dev_tlas;
+
+    AcsHelper::updateTlas(cmdList, toFreeList, inputs, this->tlasUpdateScratchSize);
+    ++this->numTlasRefitsSinceRebuild;
+
+    BufferHelper::uavBarrier(cmdList, this->dev_tlas.getBuffer());
+}
 
+void Scene::uploadPendingTextures(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing)
+{
+    // in the order they were added, so that the selected textures are the first few
+    std::vector<BuildScheduler::Candidate> candidates;
+    candidates.reserve(this->pendingTextures.size());
     for (const auto& pendingTex : this->pendingTextures)
     {
-        D3D12_RESOURCE_DESC texDesc = {};
-        texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-        texDesc.Width = pendingTex.width;
-        texDesc.Height = pendingTex.height;
-        texDesc.DepthOrArraySize = 1;
-        texDesc.MipLevels = 1;
-        texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-        texDesc.SampleDesc = NO_AA;
-
-        ComPtr<ID3D12Resource> dev_texture;
-        CHECK_HRESULT(Renderer::device->CreateCommittedResource(&DEFAULT_HEAP,
-                                                                D3D12_HEAP_FLAG_NONE,
-                                                                &texDesc,
-                                                                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-                                                                nullptr,
-                                                                IID_PPV_ARGS(&dev_texture)));
-
-        const uint32_t rowPitchBytes = pendingTex.width * 4;
-        const uint32_t rowPitchBytesAligned =
-            (rowPitchBytes + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
-        const uint32_t uploadSizeBytes = rowPitchBytesAligned * pendingTex.height;
-
-        ComPtr<ID3D12Resource> dev_uploadBuffer =
-            BufferHelper::createBasicBuffer(uploadSizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ);
-        uint8_t* host_uploadBuffer = nullptr;
-        dev_uploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&host_uploadBuffer));
-
-        for (uint32_t row = 0; row < pendingTex.height; ++row)
-        {
-            const uint8_t* srcPtr = pendingTex.data.data() + rowPitchBytes * row;
-            uint8_t* destPtr = host_uploadBuffer + rowPitchBytesAligned * row;
-            memcpy(destPtr, srcPtr, rowPitchBytes);
-        }
+        candidates.push_back({ .cost = pendingTex.texture.data.size(),
+                               .priority = static_cast<float>(candidates.size()) });
+    }
+    const size_t numTexturesToUpload = BuildScheduler::selectBuilds(candidates, this->textureUploadBudgetBytes).size();
 
-        D3D12_SUBRESOURCE_FOOTPRINT footprint = {};
-        footprint.Format = texDesc.Format;
-        footprint.Width = pendingTex.width;
-        footprint.Height = pendingTex.height;
-        footprint.Depth = 1;
-        footprint.RowPitch = rowPitchBytesAligned;
-
-        D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = { 0, footprint };
-
-        D3D12_TEXTURE_COPY_LOCATION srcTexLocation = {
-            .pResource = dev_uploadBuffer.Get(),
-            .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
-            .PlacedFootprint = layout,
-        };
-        D3D12_TEXTURE_COPY_LOCATION destTexLocation = {
-            .pResource = dev_texture.Get(),
-            .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-            .SubresourceIndex = 0,
-        };
+    for (size_t pendingTexIdx = 0; pendingTexIdx < numTexturesToUpload; ++pendingTexIdx)
+    {
+        const PendingTexture& pendingTex = this->pendingTextures[pendingTexIdx];
+        const ProcessedTexture& texture = pendingTex.texture;
+        const bool isBlockCompressed = TextureProcessor::isBlockCompressed(texture.format);
+        ID3D12Resource* const dev_texture = this->textures[pendingTex.id].Get();
+        const DXGI_FORMAT format = getDxgiFormat(texture.format);
 
         BufferHelper::stateTransitionResourceBarrier(
-            cmdList, dev_texture.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
-        cmdList->CopyTextureRegion(&destTexLocation, 0, 0, 0, &srcTexLocation, nullptr);
-        BufferHelper::stateTransitionResourceBarrier(
-            cmdList, dev_texture.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            cmdList, dev_texture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
 
-        const D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle = { heapCpuHandle.ptr + descriptorSize * pendingTex.id };
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {
-            .Format = texDesc.Format,
-            .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
-            .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
-            .Texture2D = {
-                .MipLevels = 1,
-            },
-        };
-        Renderer::device->CreateShaderResourceView(dev_texture.Get(), &srvDesc, cpuDescriptorHandle);
+        for (uint32_t mipIdx = 0; mipIdx < texture.numMips; ++mipIdx)
+        {
+            const TextureProcessor::MipLayout mipLayout =
+                TextureProcessor::getMipLayout(texture.format, texture.width, texture.height, mipIdx);
+            const uint32_t rowPitchBytesAligned = (mipLayout.rowSizeBytes + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+                                                  ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+            const uint32_t uploadSizeBytes = rowPitchBytesAligned * mipLayout.numRows;
+
+            const UploadRingSection uploadSection =
+                uploadRing.allocate(toFreeList, uploadSizeBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            uint8_t* host_uploadBuffer = static_cast<uint8_t*>(uploadSection.host_ptr);
+
+            for (uint32_t row = 0; row < mipLayout.numRows; ++row)
+            {
+                const uint8_t* srcPtr = texture.data.data() + mipLayout.offsetBytes + mipLayout.rowSizeBytes * row;
+                uint8_t* destPtr = host_uploadBuffer + rowPitchBytesAligned * row;
+                memcpy(destPtr, srcPtr, mipLayout.rowSizeBytes);
+            }
+
+            D3D12_SUBRESOURCE_FOOTPRINT footprint = {};
+            footprint.Format = format;
+            footprint.Width = mipLayout.width;
+            footprint.Height = mipLayout.height;
+            if (isBlockCompressed)
+            {
+                // copied in whole blocks, including where they hang over the edges of mips smaller than a block
+                const uint32_t numBlocksX = mipLayout.rowSizeBytes / BlockCompression::BLOCK_SIZE_BYTES;
+                footprint.Width = numBlocksX * BlockCompression::BLOCK_DIM;
+                footprint.Height = mipLayout.numRows * BlockCompression::BLOCK_DIM;
+            }
+            footprint.Depth = 1;
+            footprint.RowPitch = rowPitchBytesAligned;
+
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = { uploadSection.offsetBytes, footprint };
+
+            D3D12_TEXTURE_COPY_LOCATION srcTexLocation = {
+                .pResource = uploadSection.buffer,
+                .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
+                .PlacedFootprint = layout,
+            };
+            D3D12_TEXTURE_COPY_LOCATION destTexLocation = {
+                .pResource = dev_texture,
+                .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
+                .SubresourceIndex = mipIdx,
+            };
+
+            cmdList->CopyTextureRegion(&destTexLocation, 0, 0, 0, &srcTexLocation, nullptr);
+        }
 
-        this->textures[pendingTex.id] = dev_texture;
-        toFreeList.pushResource(dev_uploadBuffer, true);
+        BufferHelper::stateTransitionResourceBarrier(
+            cmdList, dev_texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     }
 
-    this->pendingTextures.clear();
+    this->pendingTextures.erase(this->pendingTextures.begin(), this->pendingTextures.begin() + numTexturesToUpload);
+}
+
+bool Scene::hasPendingTextures() const
+{
+    return !this->pendingTextures.empty();
+}
+
+const std::vector<uint32_t>& Scene::getTextureIds() const
+{
+    return this->usedTextureIds;
 }
 
 D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevInstanceDatasAddress() const
@@ -440,6 +1142,11 @@ D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevInstanceDatasAddress() const
     return this->mappedInstanceDatasArray.getBufferGpuAddress();
 }
 
+D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevGeometryDatasBufferAddress() const
+{
+    return this->managedGeometryDatasBuffer.getBufferGpuAddress();
+}
+
 D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevMaterialsAddress() const
 {
     return this->mappedMaterialsArray.getBufferGpuAddress();
@@ -447,17 +1154,17 @@ D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevMaterialsAddress() const
 
 bool Scene::hasTlas() const
 {
-    return this->dev_tlas != nullptr;
+    return this->dev_tlas.isValid();
 }
 
 D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevTlasAddress() const
 {
-    return this->dev_tlas.Get()->GetGPUVirtualAddress();
+    return this->dev_tlas.getGpuAddress();
 }
 
-D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevVertsBufferAddress() const
+D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevVertAttribsBufferAddress() const
 {
-    return this->managedVertsBuffer.getBufferGpuAddress();
+    return this->managedVertAttribsBuffer.getBufferGpuAddress();
 }
 
 D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevIdxsBufferAddress() const
@@ -467,7 +1174,7 @@ D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevIdxsBufferAddress() const
 
 uint32_t Scene::getNumAreaLights() const
 {
-    return this->numAreaLights;
+    return static_cast<uint32_t>(this->host_areaLightSamplingStructure.size());
 }
 
 D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevAreaLightsBufferAddress() const
@@ -479,3 +1186,22 @@ D3D12_GPU_VIRTUAL_ADDRESS Scene::getDevAreaLightSamplingStructureAddress() const
 {
     return this->areaLightSamplingStructure.getBufferGpuAddress();
 }
+
+void Scene::reportMemoryPools(MemoryRegistry& memoryRegistry) const
+{
+    memoryRegistry.setPoolStats("vertexAttributes", this->managedVertAttribsBuffer.getPoolStats());
+    memoryRegistry.setPoolStats("indices", this->managedIdxsBuffer.getPoolStats());
+    memoryRegistry.setPoolStats("areaLights", this->managedAreaLightsBuffer.getPoolStats());
+    memoryRegistry.setPoolStats("instanceDescs", this->mappedInstanceDescsArray.getPoolStats());
+    memoryRegistry.setPoolStats("instanceDatas", this->mappedInstanceDatasArray.getPoolStats());
+    memoryRegistry.setPoolStats("materials", this->mappedMaterialsArray.getPoolStats());
+    memoryRegistry.setPoolStats("areaLightSampling", this->areaLightSamplingStructure.getPoolStats());
+
+    // not a container of its own, but the report is where compaction savings get looked at; capacity is what every
+    // compacted BLAS took up before compaction
+    const BlasCompactor::Stats& compactionStats = this->blasCompactor.getStats();
+    memoryRegistry.setPoolStats("compactedBlases",
+                                { .capacityBytes = compactionStats.originalBytes,
+                                  .usedBytes = compactionStats.compactedBytes,
+                                  .numAllocations = compactionStats.numCompacted });
+}
@@ -18,9 +18,13 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "loaded_scene.h"
+#include "core/retirement_queue.h"
+#include "core/spsc_queue.h"
 #include "rendering/dxr_includes.h"
 #include "rendering/host_structs.h"
 #include "rendering/buffer/acs_helper.h"
+#include "rendering/buffer/blas_compactor.h"
 #include "rendering/buffer/mapped_array.h"
 #include "rendering/common/common_registers.h"
 #include "rendering/common/common_structs.h"
@@ -32,28 +36,98 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <vector>
 
 class ToFreeList;
+class UploadRing;
 
 class Scene;
 
-struct AreaLightInputs
+class Instance;
+
+// Picks the BLAS build flags of a geometry, based on how often it is expected to be replaced.
+enum class GeometryUsage
 {
-    DirectX::XMFLOAT3 pos0;
-    DirectX::XMFLOAT3 pos1;
-    DirectX::XMFLOAT3 pos2;
-    uint32_t triangleIdx;
+    // built with PREFER_FAST_TRACE and compacted if compaction is enabled
+    STATIC,
+    // for geometry that is rebuilt often (e.g. edited or streamed chunks), built with PREFER_FAST_BUILD and never
+    // compacted
+    DYNAMIC,
 };
 
-class Instance
+// Vertex and index data along with the BLAS built from it. Any number of instances can share one geometry, which is
+// freed along with the last instance that uses it. A geometry is made of one or more parts, each with its own material,
+// which all go into the same BLAS.
+class Geometry
 {
     friend class Scene;
+    friend class Instance;
     friend class ToFreeList;
 
 private:
     Scene* const scene;
     const uint32_t id;
-    uint32_t materialId{ MATERIAL_ID_INVALID };
 
     AcsHelper::GeometryWrapper geoWrapper{};
+    std::vector<AcsHelper::GeometryRange> partRanges;
+    std::vector<uint32_t> partMaterialIds;
+    std::vector<float> partUvScaleLog2s;
+    // one GeometryData per part, uploaded along with the BLAS
+    ManagedBufferSection geometryDatasBufferSection{};
+    uint64_t blasBuildIdx{ 0 };
+    bool isQueuedForBlasBuild{ false };
+    GeometryUsage usage{ GeometryUsage::STATIC };
+    uint32_t idxFormat{ IDX_FORMAT_32 };
+    // used instead of the host vectors by geometries added from a LoadedScene whose streams are in upload memory
+    StagedGeometryStreams stagedStreams{};
+
+    // needed to patch the instances' InstanceDatas when the geometry's buffer sections move
+    std::vector<Instance*> instances;
+
+    bool isScheduledForDeletion{ false };
+
+    Geometry(Scene* scene, uint32_t id);
+
+public:
+    // freed once uploaded; both vertex streams have the same length
+    std::vector<DirectX::XMFLOAT3> host_positions;
+    std::vector<VertexAttributes> host_vertAttribs;
+    std::vector<uint32_t> host_idxs;
+    // used instead of host_idxs by geometries added from a LoadedScene with 16-bit indices
+    std::vector<uint16_t> host_idxs16;
+
+    // Appends room for a part's vertices and indices (0 for a plain triangle list) to the host vectors and returns
+    // where they go. The part's indices are relative to its first vertex. Parts are numbered in the order they
+    // are added, which is also their GeometryIndex() in hit shaders. `uvScaleLog2` is log2 of how much longer
+    // distances are in UV space than in object space on average, which hit shaders use to pick texture mips.
+    AcsHelper::GeometryRange addPart(uint32_t numVerts, uint32_t numIdxs, uint32_t materialId, float uvScaleLog2);
+    uint32_t getNumParts() const;
+    const AcsHelper::GeometryRange& getPartRange(uint32_t partIdx) const;
+    uint32_t getPartMaterialId(uint32_t partIdx) const;
+
+    uint32_t getId() const;
+    uint32_t getNumInstances() const;
+    uint32_t getNumTriangles() const;
+
+    // only affects BLAS builds that haven't started yet
+    void setUsage(GeometryUsage usage);
+    GeometryUsage getUsage() const;
+};
+
+class Instance
+{
+    friend class Scene;
+    friend class ToFreeList;
+
+private:
+    Scene* const scene;
+    const uint32_t id;
+
+    Geometry* geometry{ nullptr };
+
+    DirectX::XMFLOAT3X4 transform{};
+    // index of this instance's desc in the current TLAS, or INSTANCE_DESC_IDX_INVALID if it isn't in one yet
+    uint32_t instanceDescIdx{ INSTANCE_DESC_IDX_INVALID };
+    bool isTransformDirty{ false };
+    // set once the instance's BLAS exists and its InstanceData has been written, so it can go into the TLAS
+    bool isReady{ false };
 
     std::vector<AreaLight> host_areaLights;
     ManagedBufferSection areaLightsBufferSection{};
@@ -63,104 +137,224 @@ private:
     Instance(Scene* scene, uint32_t id);
 
 public:
-    std::vector<Vertex> host_verts;
-    std::vector<uint32_t> host_idxs;
+    static constexpr uint32_t INSTANCE_DESC_IDX_INVALID = ~0u;
 
-    DirectX::XMFLOAT3X4 transform{};
+    // must be called exactly once, before Scene::markInstanceReady()
+    void setGeometry(Geometry* geometry);
+    Geometry* getGeometry() const;
 
-    // `transform` must be set before calling this function
+    // Moving an instance that is already in the TLAS only refits the TLAS. Area lights are baked in world space when
+    // they are uploaded, so instances with area lights can't be moved after that.
+    void setTransform(const DirectX::XMFLOAT3X4& transform);
+    const DirectX::XMFLOAT3X4& getTransform() const;
+
+    // setTransform() must be called before this function
     void addAreaLight(const AreaLightInputs& lightInputs);
 
     uint32_t getId() const;
-
-    void setMaterialId(uint32_t id);
 };
 
 class Scene
 {
+    friend class Geometry;
     friend class Instance;
     friend class ToFreeList;
 
 private:
-    ManagedBuffer managedVertsBuffer{
+    // upper bound on how much vertex and index data is moved per frame to fill holes left by freed instances
+    static constexpr uint64_t MAX_COMPACTION_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
+    // Positions are only read by BLAS builds, which read them straight from upload memory, so only the attributes
+    // that hit shaders need are kept on the device.
+    ManagedBuffer managedVertAttribsBuffer{
         &DEFAULT_HEAP,
         D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
         true /*isResizable*/,
         false /*isMapped*/,
+        MemoryTag::VERTEX_POOL,
     };
     ManagedBuffer managedIdxsBuffer{
         &DEFAULT_HEAP,
         D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
         true /*isResizable*/,
         false /*isMapped*/,
+        MemoryTag::INDEX_POOL,
     };
 
     uint32_t maxNumInstances{ 0 };
     MappedArray<D3D12_RAYTRACING_INSTANCE_DESC> mappedInstanceDescsArray{};
     MappedArray<InstanceData> mappedInstanceDatasArray{};
 
+    ManagedBuffer managedGeometryDatasBuffer{
+        &DEFAULT_HEAP,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        true /*isResizable*/,
+        false /*isMapped*/,
+        MemoryTag::INSTANCES,
+    };
+
     std::queue<uint32_t> availableInstanceIds{};
     std::unordered_map<uint32_t, std::unique_ptr<Instance>> instances{};
-    std::vector<Instance*> instancesReadyForBlasBuild{};
+    std::vector<Instance*> pendingInstances{};
+
+    // geometry IDs are only used as ManagedBuffer section owners and BlasCompactor owners, so they aren't reused
+    uint32_t nextGeometryId{ 0 };
+    std::unordered_map<uint32_t, std::unique_ptr<Geometry>> geometries{};
+    std::vector<Geometry*> geometriesReadyForBlasBuild{};
+
+    static constexpr uint64_t DEFAULT_BLAS_BUILD_BUDGET_TRIANGLES = 512 * 1024;
+    uint64_t blasBuildBudgetTriangles{ DEFAULT_BLAS_BUILD_BUDGET_TRIANGLES };
+    // queued BLASes closest to this position are built first
+    DirectX::XMFLOAT3 viewerPos_WS{};
 
-    ComPtr<ID3D12Resource> dev_tlas{ nullptr };
+    // a TLAS is refit at most this many times in a row before being rebuilt, since refits degrade its quality
+    static constexpr uint32_t MAX_TLAS_REFITS_BEFORE_REBUILD = 64;
+
+    AcsPoolSection dev_tlas{};
     bool isTlasDirty{ false };
 
+    // TLASes are only built with ALLOW_UPDATE once something has moved, so static scenes keep PREFER_FAST_TRACE
+    bool hasMovingInstances{ false };
+    bool isTlasRefittable{ false };
+    uint64_t tlasUpdateScratchSize{ 0 };
+    // instances in the current TLAS
+    uint32_t numTlasInstances{ 0 };
+    uint32_t numTlasRefitsSinceRebuild{ 0 };
+    std::vector<Instance*> instancesWithDirtyTransform{};
+
+    // Instances in the TLAS, in the order of their descs in mappedInstanceDescsArray. Instances are appended once
+    // they're ready and swap-removed when freed, so a rebuild only has to write descs that changed.
+    std::vector<Instance*> tlasInstances{};
+
+    bool isBlasCompactionEnabled{ false };
+    uint64_t nextBlasBuildIdx{ 0 };
+    BlasCompactor blasCompactor{};
+
     uint32_t nextMaterialIdx{ 0 };
     MappedArray<Material> mappedMaterialsArray{};
 
-    uint32_t nextTextureId{ 0 };
-    std::array<ComPtr<ID3D12Resource>, MAX_NUM_TEXTURES> textures{};
+    // Texture IDs are descriptor indices. IDs of freed textures are only handed out again once the frames that may
+    // still read their descriptors are done, so new textures never rewrite a descriptor that's in use.
+    std::array<ComPtr<ID3D12Resource>, NUM_TEXTURE_DESCRIPTORS> textures{};
+    std::vector<uint32_t> usedTextureIds{};
+    std::vector<uint32_t> availableTextureIds{};
+    // freed since the last submit(), which tags them with its fence value
+    std::vector<uint32_t> releasedTextureIds{};
+    RetirementQueue<std::vector<uint32_t>> retiringTextureIds{};
+
     struct PendingTexture
     {
-        std::vector<uint8_t> data;
-        uint32_t width;
-        uint32_t height;
+        ProcessedTexture texture;
         uint32_t id;
     };
     std::vector<PendingTexture> pendingTextures;
 
+    static constexpr uint64_t DEFAULT_TEXTURE_UPLOAD_BUDGET_BYTES = 32 * 1024 * 1024;
+    uint64_t textureUploadBudgetBytes{ DEFAULT_TEXTURE_UPLOAD_BUDGET_BYTES };
+
     ManagedBuffer managedAreaLightsBuffer{
         &DEFAULT_HEAP,
         D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
         true /*isResizable*/,
         false /*isMapped*/,
+        MemoryTag::LIGHTS,
     };
-    uint32_t numAreaLights{ 0 };
+    // Indices of sampleable area lights in managedAreaLightsBuffer, kept dense the same way as tlasInstances.
+    // `areaLightSamplingIdxs` maps an area light index back to its slot so an instance's lights can be swap-removed.
     MappedArray<uint32_t> areaLightSamplingStructure{};
+    std::vector<uint32_t> host_areaLightSamplingStructure{};
+    std::vector<uint32_t> areaLightSamplingIdxs{};
+
+    // Scenes loaded on another thread. update() moves the newest one to nextLoadedScene and swaps it in once there are
+    // enough available texture IDs for it, which can take a few frames after another scene with textures was cleared.
+    SpscQueue<std::unique_ptr<LoadedScene>, 4> loadedSceneQueue{};
+    std::unique_ptr<LoadedScene> nextLoadedScene{};
 
+    void growMaxNumInstances(ToFreeList& toFreeList, uint32_t newMaxNumInstances);
     void freeInstance(Instance* instance);
+    void freeGeometry(Geometry* geometry);
 
-    bool makeQueuedBlases(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+    void compactGeometryBuffers(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+
+    void makeQueuedBlases(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing);
+    bool addPendingInstances(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing);
+    bool compactBlases(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+
+    void writeInstanceDesc(const Instance* instance);
+    void addInstanceToTlas(ToFreeList& toFreeList, Instance* instance);
+    void removeInstanceFromTlas(Instance* instance);
+    void writeDirtyTransforms();
     void makeTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+    void refitTlas(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+
+    void uploadPendingTextures(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing);
 
-    void uploadPendingTextures(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+    void replaceWithLoadedScene(ToFreeList& toFreeList, LoadedScene&& loadedScene);
 
 public:
     void init();
 
-    void clear();
+    void clear(ToFreeList& toFreeList);
 
-    void update(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList);
+    void update(ID3D12GraphicsCommandList4* cmdList, ToFreeList& toFreeList, UploadRing& uploadRing);
 
+    // Hands a scene loaded on another thread to update(), which clears this scene and adds the loaded one in its place
+    // as soon as the texture descriptors it needs aren't read by frames in flight anymore. Only the most recent of
+    // several queued scenes is added. Lock-free and safe to call from one thread other than the one calling update().
+    // Returns false and leaves `loadedScene` untouched if the queue is full.
+    bool queueLoadedScene(std::unique_ptr<LoadedScene>& loadedScene);
+
+    // call with the fence of the command list passed to update(), and with completed fences so that BLASes can be
+    // compacted once their compacted sizes have been read back and freed texture IDs can be reused
+    void submit(uint64_t fenceValue);
+    void reclaim(uint64_t completedFenceValue);
+
+    // Only affects BLASes built afterwards. Compacted BLASes take a few frames to shrink, since their final size has
+    // to be read back first.
+    void setBlasCompactionEnabled(bool isEnabled);
+    bool getBlasCompactionEnabled() const;
+
+    // Caps the number of triangles whose BLASes are built in one update(), 0 meaning no limit. Leftover BLASes are
+    // built in later frames, closest to the viewer first, and their instances are added to the TLAS once they're done.
+    void setBlasBuildBudget(uint64_t numTriangles);
+    void setViewerPos(const DirectX::XMFLOAT3& pos_WS);
+
+    // pre-sizes instance storage so that requesting this many instances in total doesn't need repeated resizes
+    void reserveInstances(ToFreeList& toFreeList, uint32_t numInstances);
     Instance* requestNewInstance(ToFreeList& toFreeList);
-    void markInstanceReadyForBlasBuild(Instance* instance);
+    // Adds the instance to the TLAS once its geometry's BLAS has been built, which is queued if it doesn't exist yet.
+    void markInstanceReady(Instance* instance);
+
+    // add parts with Geometry::addPart() and fill them in, then attach to instances with Instance::setGeometry()
+    Geometry* requestNewGeometry();
 
+    void reserveMaterials(ToFreeList& toFreeList, uint32_t numMaterials);
     uint32_t addMaterial(ToFreeList& toFreeList, const Material* material);
 
-    uint32_t addTexture(std::vector<uint8_t>&& data, uint32_t width, uint32_t height);
+    // Uploaded with its whole mip chain by a later update(), depending on the texture upload budget, and black until
+    // then.
+    uint32_t addTexture(ProcessedTexture&& texture);
+    // Caps the number of texture bytes uploaded in one update(), 0 meaning no limit. Textures are uploaded in the order
+    // they were added, and one larger than the budget is still uploaded on its own.
+    void setTextureUploadBudget(uint64_t numBytes);
+    bool hasPendingTextures() const;
+    // IDs of all of this scene's textures, uploaded or not, whose descriptors frames traced with it may read
+    const std::vector<uint32_t>& getTextureIds() const;
 
     D3D12_GPU_VIRTUAL_ADDRESS getDevInstanceDatasAddress() const;
+    D3D12_GPU_VIRTUAL_ADDRESS getDevGeometryDatasBufferAddress() const;
 
     D3D12_GPU_VIRTUAL_ADDRESS getDevMaterialsAddress() const;
 
     bool hasTlas() const;
     D3D12_GPU_VIRTUAL_ADDRESS getDevTlasAddress() const;
 
-    D3D12_GPU_VIRTUAL_ADDRESS getDevVertsBufferAddress() const;
+    D3D12_GPU_VIRTUAL_ADDRESS getDevVertAttribsBufferAddress() const;
     D3D12_GPU_VIRTUAL_ADDRESS getDevIdxsBufferAddress() const;
 
     uint32_t getNumAreaLights() const;
     D3D12_GPU_VIRTUAL_ADDRESS getDevAreaLightsBufferAddress() const;
     D3D12_GPU_VIRTUAL_ADDRESS getDevAreaLightSamplingStructureAddress() const;
+
+    void reportMemoryPools(MemoryRegistry& memoryRegistry) const;
 };
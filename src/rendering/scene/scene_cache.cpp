@@ -0,0 +1,417 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scene_cache.h"
+
+#include "core/chunk_file.h"
+#include "core/hash.h"
+#include "core/mapped_file.h"
+#include "core/parallel.h"
+
+#include <filesystem>
+
+namespace SceneCache
+{
+
+enum ChunkType : uint32_t
+{
+    HEADER,
+    DEPENDENCIES,
+    TEXTURES,
+    MATERIALS,
+    GEOMETRIES,
+    PARTS,
+    AREA_LIGHTS,
+    INSTANCES,
+    TEXELS,
+    POSITIONS,
+    VERT_ATTRIBS,
+    IDXS,
+};
+
+// the chunks before the texels, in ChunkType order
+static constexpr uint32_t NUM_TABLE_CHUNKS = 8;
+
+struct CacheHeader
+{
+    uint32_t numTextures;
+    uint32_t numMaterials;
+    uint32_t numGeometries;
+    uint32_t numParts;
+    uint32_t numAreaLights;
+    uint32_t numInstances;
+    uint64_t dependenciesHash;
+};
+
+static bool hashFile(const std::filesystem::path& filePath, uint64_t seed, uint64_t* outHash)
+{
+    MappedFile file;
+    if (!file.open(filePath.string()))
+    {
+        return false;
+    }
+
+    *outHash = Hash::hashBytes(file.getData(), file.getSizeBytes(), seed);
+    return true;
+}
+
+// `relativePathStrs` joined by newlines
+static bool hashDependencies(const std::filesystem::path& sourceDirPath,
+                             const std::string& relativePathStrs,
+                             uint64_t* outHash)
+{
+    uint64_t hash = 0;
+
+    size_t start = 0;
+    while (start < relativePathStrs.size())
+    {
+        size_t end = relativePathStrs.find('\n', start);
+        if (end == std::string::npos)
+        {
+            end = relativePathStrs.size();
+        }
+
+        if (!hashFile(sourceDirPath / relativePathStrs.substr(start, end - start), hash, &hash))
+        {
+            return false;
+        }
+
+        start = end + 1;
+    }
+
+    *outHash = hash;
+    return true;
+}
+
+bool write(const LoadedScene& scene,
+           const std::vector<std::string>& dependencyPathStrs,
+           const std::string& cachePathStr,
+           const std::string& sourcePathStr,
+           uint32_t loaderVersion,
+           uint32_t numThreads)
+{
+    const std::filesystem::path sourcePath(sourcePathStr);
+
+    uint64_t key;
+    if (!hashFile(sourcePath, loaderVersion, &key))
+    {
+        return false;
+    }
+
+    std::string joinedDependencyPathStrs;
+    for (const std::string& pathStr : dependencyPathStrs)
+    {
+        if (!joinedDependencyPathStrs.empty())
+        {
+            joinedDependencyPathStrs += '\n';
+        }
+        joinedDependencyPathStrs += pathStr;
+    }
+
+    std::vector<CachedTexture> textures;
+    textures.reserve(scene.textures.size());
+    for (const ProcessedTexture& texture : scene.textures)
+    {
+        textures.push_back({
+            .format = texture.format,
+            .width = texture.width,
+            .height = texture.height,
+            .numMips = texture.numMips,
+        });
+    }
+
+    std::vector<CachedGeometry> geometries;
+    std::vector<CachedPart> parts;
+    std::vector<AreaLightInputs> areaLights;
+    geometries.reserve(scene.geometries.size());
+    for (const LoadedGeometry& geometry : scene.geometries)
+    {
+        geometries.push_back({
+            .numParts = static_cast<uint32_t>(geometry.partRanges.size()),
+            .idxFormat = geometry.idxFormat,
+            .numAreaLights = static_cast<uint32_t>(geometry.areaLights.size()),
+        });
+
+        for (uint32_t partIdx = 0; partIdx < geometry.partRanges.size(); ++partIdx)
+        {
+            const AcsHelper::GeometryRange& range = geometry.partRanges[partIdx];
+            parts.push_back({
+                .numVerts = range.numVerts,
+                .numIdxs = range.numIdxs,
+                .materialIdx = geometry.partMaterialIdxs[partIdx],
+                .uvScaleLog2 = geometry.partUvScaleLog2s[partIdx],
+            });
+        }
+        areaLights.insert(areaLights.end(), geometry.areaLights.begin(), geometry.areaLights.end());
+    }
+
+    CacheHeader header = {
+        .numTextures = static_cast<uint32_t>(textures.size()),
+        .numMaterials = static_cast<uint32_t>(scene.materials.size()),
+        .numGeometries = static_cast<uint32_t>(geometries.size()),
+        .numParts = static_cast<uint32_t>(parts.size()),
+        .numAreaLights = static_cast<uint32_t>(areaLights.size()),
+        .numInstances = static_cast<uint32_t>(scene.instances.size()),
+        .dependenciesHash = 0,
+    };
+    if (!hashDependencies(sourcePath.parent_path(), joinedDependencyPathStrs, &header.dependenciesHash))
+    {
+        return false;
+    }
+
+    ChunkFileWriter chunkFileWriter;
+    chunkFileWriter.addChunk(HEADER, &header, sizeof(header));
+    chunkFileWriter.addChunk(DEPENDENCIES, joinedDependencyPathStrs.data(), joinedDependencyPathStrs.size());
+    chunkFileWriter.addChunk(TEXTURES, textures);
+    chunkFileWriter.addChunk(MATERIALS, scene.materials);
+    chunkFileWriter.addChunk(GEOMETRIES, geometries);
+    chunkFileWriter.addChunk(PARTS, parts);
+    chunkFileWriter.addChunk(AREA_LIGHTS, areaLights);
+    chunkFileWriter.addChunk(INSTANCES, scene.instances);
+    for (const ProcessedTexture& texture : scene.textures)
+    {
+        chunkFileWriter.addChunk(TEXELS, texture.data);
+    }
+    // straight from the streams, which can be staged ones in upload memory
+    for (const LoadedGeometry& geometry : scene.geometries)
+    {
+        chunkFileWriter.addChunk(POSITIONS, geometry.getPositions(), geometry.numVerts * sizeof(DirectX::XMFLOAT3));
+        chunkFileWriter.addChunk(VERT_ATTRIBS, geometry.getVertAttribs(), geometry.numVerts * sizeof(VertexAttributes));
+        chunkFileWriter.addChunk(IDXS, geometry.getIdxs(), geometry.getIdxsSizeBytes());
+    }
+
+    return chunkFileWriter.write(cachePathStr, key, numThreads);
+}
+
+bool load(const std::string& cachePathStr,
+          const std::string& sourcePathStr,
+          uint32_t loaderVersion,
+          uint32_t numThreads,
+          bool stageStreams,
+          LoadedScene* outScene)
+{
+    const std::filesystem::path sourcePath(sourcePathStr);
+
+    uint64_t key;
+    if (!hashFile(sourcePath, loaderVersion, &key))
+    {
+        return false;
+    }
+
+    ChunkFileReader reader;
+    if (!reader.open(cachePathStr, key) || reader.getNumChunks() < NUM_TABLE_CHUNKS)
+    {
+        return false;
+    }
+
+    for (uint32_t chunkIdx = 0; chunkIdx < NUM_TABLE_CHUNKS; ++chunkIdx)
+    {
+        if (reader.getChunkType(chunkIdx) != chunkIdx)
+        {
+            return false;
+        }
+    }
+
+    CacheHeader header;
+    if (reader.getChunkSizeBytes(HEADER) != sizeof(header) || !reader.readChunk(HEADER, &header, sizeof(header)))
+    {
+        return false;
+    }
+
+    std::vector<char> dependencyPathChars;
+    uint64_t dependenciesHash;
+    if (!reader.readChunk(DEPENDENCIES, &dependencyPathChars) ||
+        !hashDependencies(sourcePath.parent_path(),
+                          std::string(dependencyPathChars.begin(), dependencyPathChars.end()),
+                          &dependenciesHash) ||
+        dependenciesHash != header.dependenciesHash)
+    {
+        return false;
+    }
+
+    LoadedScene& scene = *outScene;
+    std::vector<CachedTexture> textures;
+    std::vector<CachedGeometry> geometries;
+    std::vector<CachedPart> parts;
+    std::vector<AreaLightInputs> areaLights;
+    if (!reader.readChunk(TEXTURES, &textures) || !reader.readChunk(MATERIALS, &scene.materials) ||
+        !reader.readChunk(GEOMETRIES, &geometries) || !reader.readChunk(PARTS, &parts) ||
+        !reader.readChunk(AREA_LIGHTS, &areaLights) || !reader.readChunk(INSTANCES, &scene.instances))
+    {
+        return false;
+    }
+
+    // everything below trusts these tables, so check that they agree with each other and with the chunk list
+    if (textures.size() != header.numTextures || scene.materials.size() != header.numMaterials ||
+        geometries.size() != header.numGeometries || parts.size() != header.numParts ||
+        areaLights.size() != header.numAreaLights || scene.instances.size() != header.numInstances ||
+        reader.getNumChunks() != NUM_TABLE_CHUNKS + header.numTextures + header.numGeometries * 3)
+    {
+        return false;
+    }
+
+    for (const CachedTexture& texture : textures)
+    {
+        if (texture.format > TextureFormat::BC5 || texture.width == 0 || texture.height == 0 ||
+            texture.numMips != MipGenerator::getNumMips(texture.width, texture.height))
+        {
+            return false;
+        }
+    }
+    for (const Material& material : scene.materials)
+    {
+        if (material.baseColorTextureId != TEXTURE_ID_INVALID && material.baseColorTextureId >= header.numTextures)
+        {
+            return false;
+        }
+    }
+
+    uint64_t numCachedParts = 0;
+    uint64_t numCachedAreaLights = 0;
+    for (const CachedGeometry& geometry : geometries)
+    {
+        if (geometry.idxFormat != IDX_FORMAT_32 && geometry.idxFormat != IDX_FORMAT_16)
+        {
+            return false;
+        }
+        numCachedParts += geometry.numParts;
+        numCachedAreaLights += geometry.numAreaLights;
+    }
+    if (numCachedParts != header.numParts || numCachedAreaLights != header.numAreaLights)
+    {
+        return false;
+    }
+    for (const CachedPart& part : parts)
+    {
+        if (part.materialIdx != MATERIAL_ID_INVALID && part.materialIdx >= header.numMaterials)
+        {
+            return false;
+        }
+    }
+    for (const LoadedInstance& instance : scene.instances)
+    {
+        if (instance.geometryIdx >= header.numGeometries)
+        {
+            return false;
+        }
+    }
+
+    const uint32_t firstTexelsChunkIdx = NUM_TABLE_CHUNKS;
+    const uint32_t firstGeometryChunkIdx = firstTexelsChunkIdx + header.numTextures;
+
+    scene.textures.resize(header.numTextures);
+    for (uint32_t textureIdx = 0; textureIdx < header.numTextures; ++textureIdx)
+    {
+        const CachedTexture& cachedTexture = textures[textureIdx];
+        ProcessedTexture& texture = scene.textures[textureIdx];
+        texture.format = cachedTexture.format;
+        texture.width = cachedTexture.width;
+        texture.height = cachedTexture.height;
+        texture.numMips = cachedTexture.numMips;
+    }
+
+    // geometries' streams are allocated here, usually in upload memory, then the bulk chunks are decompressed straight
+    // into them
+    scene.geometries.resize(header.numGeometries);
+    uint32_t partIdx = 0;
+    uint32_t areaLightIdx = 0;
+    for (uint32_t geometryIdx = 0; geometryIdx < header.numGeometries; ++geometryIdx)
+    {
+        const CachedGeometry& cachedGeometry = geometries[geometryIdx];
+        LoadedGeometry& geometry = scene.geometries[geometryIdx];
+        geometry.idxFormat = cachedGeometry.idxFormat;
+
+        for (uint32_t geometryPartIdx = 0; geometryPartIdx < cachedGeometry.numParts; ++geometryPartIdx)
+        {
+            const CachedPart& part = parts[partIdx++];
+            geometry.addPart(part.numVerts, part.numIdxs, part.materialIdx, part.uvScaleLog2);
+        }
+
+        geometry.areaLights.assign(areaLights.begin() + areaLightIdx,
+                                   areaLights.begin() + areaLightIdx + cachedGeometry.numAreaLights);
+        areaLightIdx += cachedGeometry.numAreaLights;
+    }
+
+    if (stageStreams)
+    {
+        scene.initStagingBuffer();
+        for (LoadedGeometry& geometry : scene.geometries)
+        {
+            geometry.allocateStagedStreams(scene.stagingBuffer);
+        }
+    }
+    else
+    {
+        for (LoadedGeometry& geometry : scene.geometries)
+        {
+            geometry.allocateHostStreams();
+        }
+    }
+
+    const uint32_t numBulkChunks = header.numTextures + header.numGeometries * 3;
+    std::vector<uint8_t> chunkSucceeded(numBulkChunks, 0);
+    Parallel::forEach(numBulkChunks, numThreads, [&](uint32_t bulkChunkIdx) {
+        const uint32_t chunkIdx = firstTexelsChunkIdx + bulkChunkIdx;
+        if (bulkChunkIdx < header.numTextures)
+        {
+            ProcessedTexture& texture = scene.textures[bulkChunkIdx];
+            const uint64_t dataSizeBytes =
+                TextureProcessor::getDataSizeBytes(texture.format, texture.width, texture.height, texture.numMips);
+            chunkSucceeded[bulkChunkIdx] = reader.getChunkType(chunkIdx) == TEXELS &&
+                                           reader.getChunkSizeBytes(chunkIdx) == dataSizeBytes &&
+                                           reader.readChunk(chunkIdx, &texture.data);
+            return;
+        }
+
+        const uint32_t geometryChunkIdx = chunkIdx - firstGeometryChunkIdx;
+        LoadedGeometry& geometry = scene.geometries[geometryChunkIdx / 3];
+
+        void* dst = nullptr;
+        uint64_t dstSizeBytes = 0;
+        switch (geometryChunkIdx % 3)
+        {
+        case 0:
+            dst = geometry.getPositions();
+            dstSizeBytes = geometry.numVerts * sizeof(DirectX::XMFLOAT3);
+            break;
+        case 1:
+            dst = geometry.getVertAttribs();
+            dstSizeBytes = geometry.numVerts * sizeof(VertexAttributes);
+            break;
+        case 2:
+            dst = geometry.getIdxs();
+            dstSizeBytes = geometry.getIdxsSizeBytes();
+            break;
+        }
+
+        std::vector<uint8_t> scratch;
+        chunkSucceeded[bulkChunkIdx] = reader.getChunkType(chunkIdx) == POSITIONS + geometryChunkIdx % 3 &&
+                                       reader.readChunkToWriteOnly(chunkIdx, dst, dstSizeBytes, &scratch);
+    });
+    for (uint32_t bulkChunkIdx = 0; bulkChunkIdx < numBulkChunks; ++bulkChunkIdx)
+    {
+        if (!chunkSucceeded[bulkChunkIdx])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace SceneCache
@@ -0,0 +1,76 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "loaded_scene.h"
+
+#include <string>
+#include <vector>
+
+// A binary snapshot of a LoadedScene: processed textures, materials, converted vertex and index streams, area lights
+// and instances. Loading one skips parsing, image decoding, texture processing and vertex conversion entirely. A cache
+// is keyed by its source file's contents and the loader's version, and also remembers the other files the source
+// referenced, so changing any of them invalidates it.
+namespace SceneCache
+{
+
+struct CachedTexture
+{
+    TextureFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t numMips;
+};
+
+struct CachedGeometry
+{
+    uint32_t numParts;
+    uint32_t idxFormat;
+    uint32_t numAreaLights;
+};
+
+struct CachedPart
+{
+    uint32_t numVerts;
+    uint32_t numIdxs;
+    // index into the cached materials, or MATERIAL_ID_INVALID
+    uint32_t materialIdx;
+    float uvScaleLog2;
+};
+
+// `dependencyPathStrs` are relative to the source file's directory. Chunks are compressed on up to `numThreads`
+// threads.
+bool write(const LoadedScene& scene,
+           const std::vector<std::string>& dependencyPathStrs,
+           const std::string& cachePathStr,
+           const std::string& sourcePathStr,
+           uint32_t loaderVersion,
+           uint32_t numThreads);
+
+// Fills `outScene` from the cache if it exists and matches the source. Chunks are decompressed on up to `numThreads`
+// threads, straight into the scene's vectors, and geometries' streams straight into its staging buffer, or into host
+// streams if `stageStreams` is false. `outScene` is left in an unspecified state if this returns false.
+bool load(const std::string& cachePathStr,
+          const std::string& sourcePathStr,
+          uint32_t loaderVersion,
+          uint32_t numThreads,
+          bool stageStreams,
+          LoadedScene* outScene);
+
+} // namespace SceneCache
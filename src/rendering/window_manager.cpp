@@ -68,6 +68,12 @@ static void onKeyDown(WPARAM wparam)
     case 'P':
         Renderer::queueScreenshot();
         break;
+    case 'M':
+        Renderer::writeMemoryReport();
+        break;
+    case 'B':
+        Renderer::toggleBlasCompaction();
+        break;
     default:
         break;
     }
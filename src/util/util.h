@@ -1,18 +1,19 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 namespace Util
 {
 
-template<typename T> inline uint32_t getVectorSizeBytes(const std::vector<T>& vec)
+template<typename T> inline uint64_t getVectorSizeBytes(const std::vector<T>& vec)
 {
     return vec.size() * sizeof(T);
 }
 
-template<typename T> inline uint32_t convertByteSizeToCount(uint32_t sizeBytes)
+template<typename T> inline uint32_t convertByteSizeToCount(uint64_t sizeBytes)
 {
-    return sizeBytes / static_cast<uint32_t>(sizeof(T));
+    return static_cast<uint32_t>(sizeBytes / sizeof(T));
 }
 
 } // namespace Util
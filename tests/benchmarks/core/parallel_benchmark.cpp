@@ -0,0 +1,91 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// What Parallel::forEach did before it had a worker pool, kept here as the baseline: every call starts its own threads
+// and joins them before returning.
+static void forEachWithNewThreads(uint32_t numItems, uint32_t numThreads, const std::function<void(uint32_t)>& fn)
+{
+    numThreads = std::min(numThreads, numItems);
+
+    std::atomic<uint32_t> nextItemIdx{ 0 };
+    const auto work = [&]() {
+        for (uint32_t itemIdx = nextItemIdx++; itemIdx < numItems; itemIdx = nextItemIdx++)
+        {
+            fn(itemIdx);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads - 1);
+    for (uint32_t threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+    {
+        workers.emplace_back(work);
+    }
+
+    work();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+template<typename ForEachFn>
+static double measureUsPerCall(uint32_t numCalls, uint32_t numItems, uint32_t numThreads, ForEachFn forEach)
+{
+    std::vector<uint32_t> results(numItems);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    for (uint32_t callIdx = 0; callIdx < numCalls; ++callIdx)
+    {
+        forEach(numItems, numThreads, [&](uint32_t itemIdx) { results[itemIdx] += itemIdx; });
+    }
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    return elapsed.count() / numCalls;
+}
+
+// The loader makes a forEach() call per texture and per mip level, many of which only have a few rows to work on, so
+// the fixed cost of a call matters as much as how well it scales.
+BENCHMARK(parallelForEachCallOverhead)
+{
+    printf("%10s %10s %16s %16s\n", "threads", "items", "pool us/call", "spawn us/call");
+
+    for (const uint32_t numThreads : { 2u, 4u, 8u, 16u })
+    {
+        for (const uint32_t numItems : { 16u, 256u })
+        {
+            const uint32_t numCalls = 2000;
+            const double poolUsPerCall = measureUsPerCall(numCalls, numItems, numThreads, Parallel::forEach);
+            const double spawnUsPerCall = measureUsPerCall(numCalls, numItems, numThreads, forEachWithNewThreads);
+            printf("%10u %10u %16.1f %16.1f\n", numThreads, numItems, poolUsPerCall, spawnUsPerCall);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "image_metrics.h"
+
+#include "core/block_compression.h"
+#include "core/mip_generator.h"
+#include "core/texture_processor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static constexpr uint32_t DIM = 1024;
+static constexpr uint32_t NUM_RUNS_PER_MEASUREMENT = 3;
+
+// fastest of a few runs, in millions of source texels per second
+template<typename Fn>
+static double measureMTexelsPerSec(Fn fn)
+{
+    double minSec = 0.0;
+    for (uint32_t runIdx = 0; runIdx < NUM_RUNS_PER_MEASUREMENT; ++runIdx)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+        minSec = runIdx == 0 ? elapsed.count() : std::min(elapsed.count(), minSec);
+    }
+    return DIM * DIM / minSec / 1e6;
+}
+
+static double measureEncodeMTexelsPerSec(BlockCompression::Format format,
+                                         const std::vector<uint8_t>& rgba,
+                                         uint32_t numThreads,
+                                         std::vector<uint8_t>* outBlocks)
+{
+    outBlocks->resize(BlockCompression::getEncodedSizeBytes(DIM, DIM));
+    return measureMTexelsPerSec(
+        [&]() { BlockCompression::encodeImage(format, rgba.data(), DIM, DIM, numThreads, outBlocks->data()); });
+}
+
+// What the loader spends on each texture: its mip chain, block compression, and both together through
+// TextureProcessor without the cache. PSNR is of mip 0 after a round trip through each format, and the same for every
+// thread count.
+BENCHMARK(textureProcessingThroughput)
+{
+    const std::vector<uint8_t> rgba = makeTestImage(DIM, DIM, Harness::getSeed());
+
+    std::vector<uint8_t> blocks;
+    std::vector<uint8_t> decoded(rgba.size());
+    measureEncodeMTexelsPerSec(BlockCompression::Format::BC7, rgba, 1, &blocks);
+    BlockCompression::decodeImage(BlockCompression::Format::BC7, blocks.data(), DIM, DIM, decoded.data());
+    const double bc7Psnr = computePsnr(rgba.data(), decoded.data(), DIM * DIM, 0, 4);
+    measureEncodeMTexelsPerSec(BlockCompression::Format::BC5, rgba, 1, &blocks);
+    BlockCompression::decodeImage(BlockCompression::Format::BC5, blocks.data(), DIM, DIM, decoded.data());
+    const double bc5Psnr = computePsnr(rgba.data(), decoded.data(), DIM * DIM, 0, 2);
+
+    printf("%ux%u, Mtexels/s (fastest of %u); BC7 RGBA PSNR %.2f dB, BC5 RG PSNR %.2f dB\n",
+           DIM,
+           DIM,
+           NUM_RUNS_PER_MEASUREMENT,
+           bc7Psnr,
+           bc5Psnr);
+    printf("%8s %10s %10s %10s %10s %12s %12s\n",
+           "threads",
+           "box mips",
+           "kaiser",
+           "BC7",
+           "BC5",
+           "color tex",
+           "normal tex");
+
+    for (const uint32_t numThreads : { 1u, 2u, 4u, 8u })
+    {
+        const double boxMipsRate = measureMTexelsPerSec([&]() {
+            MipGenerator::generateMips(rgba.data(), DIM, DIM, true, MipGenerator::Filter::BOX, numThreads);
+        });
+        const double kaiserMipsRate = measureMTexelsPerSec([&]() {
+            MipGenerator::generateMips(rgba.data(), DIM, DIM, true, MipGenerator::Filter::KAISER, numThreads);
+        });
+        const double bc7Rate = measureEncodeMTexelsPerSec(BlockCompression::Format::BC7, rgba, numThreads, &blocks);
+        const double bc5Rate = measureEncodeMTexelsPerSec(BlockCompression::Format::BC5, rgba, numThreads, &blocks);
+
+        const TextureProcessor::Options options = { .numThreads = numThreads };
+        double textureRates[2];
+        for (const TextureUsage usage : { TextureUsage::COLOR, TextureUsage::NORMAL })
+        {
+            textureRates[static_cast<uint32_t>(usage)] = measureMTexelsPerSec([&]() {
+                ProcessedTexture texture;
+                TextureProcessor::process(rgba.data(), DIM, DIM, usage, options, &texture);
+            });
+        }
+
+        printf("%8u %10.1f %10.1f %10.1f %10.1f %12.1f %12.1f\n",
+               numThreads,
+               boxMipsRate,
+               kaiserMipsRate,
+               bc7Rate,
+               bc5Rate,
+               textureRates[0],
+               textureRates[1]);
+    }
+}
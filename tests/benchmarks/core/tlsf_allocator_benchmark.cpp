@@ -0,0 +1,184 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/tlsf_allocator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <list>
+#include <random>
+#include <vector>
+
+// The first-fit free list that ManagedBuffer used before TlsfAllocator, kept here as the baseline: allocation walks
+// the list from the front and free walks it again to find the sorted insertion point.
+class FirstFitFreeList
+{
+private:
+    struct Section
+    {
+        uint64_t offsetBytes;
+        uint64_t sizeBytes;
+    };
+
+    std::list<Section> freeSections;
+
+public:
+    void init(uint64_t sizeBytes)
+    {
+        this->freeSections = { { 0, sizeBytes } };
+    }
+
+    uint64_t allocate(uint64_t sizeBytes)
+    {
+        for (auto it = this->freeSections.begin(); it != this->freeSections.end(); ++it)
+        {
+            if (it->sizeBytes >= sizeBytes)
+            {
+                const uint64_t offsetBytes = it->offsetBytes;
+                if (it->sizeBytes == sizeBytes)
+                {
+                    this->freeSections.erase(it);
+                }
+                else
+                {
+                    it->offsetBytes += sizeBytes;
+                    it->sizeBytes -= sizeBytes;
+                }
+                return offsetBytes;
+            }
+        }
+
+        return TlsfAllocator::INVALID_OFFSET;
+    }
+
+    void free(uint64_t offsetBytes, uint64_t sizeBytes)
+    {
+        auto it = this->freeSections.begin();
+        while (it != this->freeSections.end() && it->offsetBytes < offsetBytes)
+        {
+            ++it;
+        }
+
+        it = this->freeSections.insert(it, { offsetBytes, sizeBytes });
+
+        const auto next = std::next(it);
+        if (next != this->freeSections.end() && it->offsetBytes + it->sizeBytes == next->offsetBytes)
+        {
+            it->sizeBytes += next->sizeBytes;
+            this->freeSections.erase(next);
+        }
+
+        if (it != this->freeSections.begin())
+        {
+            const auto prev = std::prev(it);
+            if (prev->offsetBytes + prev->sizeBytes == it->offsetBytes)
+            {
+                prev->sizeBytes += it->sizeBytes;
+                this->freeSections.erase(it);
+            }
+        }
+    }
+};
+
+struct Churn
+{
+    uint64_t sizeBytes;
+    uint32_t liveIdx;
+};
+
+// Fills the allocator with `numLive` allocations, then measures `numOps` free + allocate pairs of random sizes, which
+// is what streaming chunks in and out looks like to the shared vertex and index buffers.
+template<typename AllocateFn, typename FreeFn>
+static double measureChurnNsPerOp(uint32_t numLive, uint32_t numOps, AllocateFn allocate, FreeFn free)
+{
+    std::mt19937 rng(Harness::getSeed());
+    std::uniform_int_distribution<uint64_t> sizeDist(64, 64 * 1024);
+
+    std::vector<std::pair<uint64_t, uint64_t>> live(numLive);
+    for (auto& [handle, sizeBytes] : live)
+    {
+        sizeBytes = sizeDist(rng);
+        handle = allocate(sizeBytes);
+    }
+
+    std::vector<Churn> churns(numOps);
+    for (Churn& churn : churns)
+    {
+        churn = { sizeDist(rng), static_cast<uint32_t>(rng() % numLive) };
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    for (const Churn& churn : churns)
+    {
+        auto& [handle, sizeBytes] = live[churn.liveIdx];
+        free(handle, sizeBytes);
+        sizeBytes = churn.sizeBytes;
+        handle = allocate(sizeBytes);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    return elapsed.count() / (2.0 * numOps);
+}
+
+BENCHMARK(tlsfVersusFirstFitChurn)
+{
+    printf("%10s %16s %16s\n", "live", "tlsf ns/op", "first-fit ns/op");
+
+    for (const uint32_t numLive : { 1000u, 4000u, 16000u, 64000u, 256000u })
+    {
+        // room for every allocation at its largest, so neither allocator runs out of space
+        const uint64_t rangeSizeBytes = uint64_t(numLive) * 64 * 1024 * 2;
+        const uint32_t numOps = 20000;
+
+        TlsfAllocator tlsf;
+        tlsf.init(rangeSizeBytes);
+        const double tlsfNsPerOp = measureChurnNsPerOp(
+            numLive,
+            numOps,
+            [&](uint64_t sizeBytes) {
+                const TlsfAllocator::Allocation allocation = tlsf.allocate(sizeBytes);
+                REQUIRE(allocation.isValid());
+                return uint64_t(allocation.blockIdx);
+            },
+            [&](uint64_t blockIdx, uint64_t) { tlsf.free(static_cast<uint32_t>(blockIdx)); });
+
+        // the list gets too slow to be worth waiting for beyond this
+        if (numLive > 16000)
+        {
+            printf("%10u %16.1f %16s\n", numLive, tlsfNsPerOp, "-");
+            continue;
+        }
+
+        FirstFitFreeList firstFit;
+        firstFit.init(rangeSizeBytes);
+        const double firstFitNsPerOp = measureChurnNsPerOp(
+            numLive,
+            numOps,
+            [&](uint64_t sizeBytes) {
+                const uint64_t offsetBytes = firstFit.allocate(sizeBytes);
+                REQUIRE(offsetBytes != TlsfAllocator::INVALID_OFFSET);
+                return offsetBytes;
+            },
+            [&](uint64_t offsetBytes, uint64_t sizeBytes) { firstFit.free(offsetBytes, sizeBytes); });
+
+        printf("%10u %16.1f %16.1f\n", numLive, tlsfNsPerOp, firstFitNsPerOp);
+    }
+}
@@ -0,0 +1,102 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "rendering/buffer/to_free_list.h"
+#include "rendering/buffer/upload_ring.h"
+#include "rendering/null/null_device.h"
+#include "rendering/renderer.h"
+#include "rendering/scene/scene.h"
+
+#include <chrono>
+#include <deque>
+
+// Runs Scene frames on the null device the way Renderer does, with the "GPU" finishing each frame a couple of frames
+// later, and times the CPU side of Scene::update() separately from replaying the recorded commands. Texture
+// descriptors count as read until their frame finishes, so rewriting them earlier is a validation error.
+struct SceneFrameLoop
+{
+    static constexpr uint32_t FRAME_LATENCY = 2;
+
+    Scene scene;
+    UploadRing uploadRing;
+    ComPtr<ID3D12GraphicsCommandList4> cmdList = NullDevice::createCommandList();
+    std::deque<ToFreeList> inFlightToFreeLists{ 1 };
+    uint64_t fenceValue{ 1 };
+
+    SceneFrameLoop()
+    {
+        this->scene.init();
+        this->uploadRing.init(4 * 1024 * 1024);
+    }
+
+    ~SceneFrameLoop()
+    {
+        this->scene.clear(this->getToFreeList());
+        while (!this->inFlightToFreeLists.empty())
+        {
+            this->inFlightToFreeLists.front().freeAll();
+            this->inFlightToFreeLists.pop_front();
+        }
+        NullDevice::resetFences();
+    }
+
+    // for changes to the scene that go with the current frame
+    ToFreeList& getToFreeList()
+    {
+        return this->inFlightToFreeLists.back();
+    }
+
+    // returns the time spent in Scene::update()
+    double runFrameMs()
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        this->scene.update(this->cmdList.Get(), this->getToFreeList(), this->uploadRing);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+
+        this->cmdList->Close();
+        NullDevice::executeCommandList(this->cmdList.Get());
+
+        // the renderer binds every texture descriptor, but only the scene's own textures are read
+        const uint32_t descriptorSize =
+            Renderer::device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        const D3D12_GPU_DESCRIPTOR_HANDLE heapGpuHandle = Renderer::sharedHeap->GetGPUDescriptorHandleForHeapStart();
+        for (const uint32_t textureId : this->scene.getTextureIds())
+        {
+            NullDevice::useDescriptor({ heapGpuHandle.ptr + descriptorSize * textureId }, this->fenceValue);
+        }
+
+        this->uploadRing.submit(this->fenceValue);
+        this->scene.submit(this->fenceValue);
+
+        if (this->inFlightToFreeLists.size() > FRAME_LATENCY)
+        {
+            this->inFlightToFreeLists.front().freeAll();
+            this->inFlightToFreeLists.pop_front();
+            NullDevice::completeFence(this->fenceValue - FRAME_LATENCY);
+            this->uploadRing.reclaim(this->fenceValue - FRAME_LATENCY);
+            this->scene.reclaim(this->fenceValue - FRAME_LATENCY);
+        }
+
+        this->inFlightToFreeLists.emplace_back();
+        ++this->fenceValue;
+
+        return elapsed.count();
+    }
+};
@@ -0,0 +1,215 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "scene_frame_loop.h"
+
+#include "rendering/null/null_device.h"
+#include "rendering/scene/gltf_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t NUM_LOADS_PER_MEASUREMENT = 3;
+
+static std::vector<std::filesystem::path> findTestScenes()
+{
+    std::vector<std::filesystem::path> scenePaths;
+    for (const auto& entry :
+         std::filesystem::recursive_directory_iterator(std::filesystem::path(CMAKE_SOURCE_DIR) / "test_scenes"))
+    {
+        const std::filesystem::path extension = entry.path().extension();
+        if (extension == ".gltf" || extension == ".glb")
+        {
+            scenePaths.push_back(entry.path());
+        }
+    }
+
+    std::sort(scenePaths.begin(), scenePaths.end());
+    return scenePaths;
+}
+
+// fastest of a few loads from scratch, to keep the page cache and other processes out of the numbers
+static double measureLoadMs(const std::filesystem::path& scenePath, const GltfLoader::LoadOptions& options)
+{
+    double minMs = 0.0;
+    for (uint32_t loadIdx = 0; loadIdx < NUM_LOADS_PER_MEASUREMENT; ++loadIdx)
+    {
+        LoadedScene loadedScene;
+        const auto startTime = std::chrono::steady_clock::now();
+        REQUIRE(GltfLoader::loadGltf(scenePath.string(), &loadedScene, options));
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+
+        minMs = loadIdx == 0 ? elapsed.count() : std::min(elapsed.count(), minMs);
+    }
+    return minMs;
+}
+
+// Loads every scene in test_scenes/ without the scene and texture caches on 1 to 16 threads. The loader logs as it
+// goes, so the table is printed once everything has been measured.
+BENCHMARK(sceneLoadVersusThreadCount)
+{
+    NullDevice::init();
+
+    const std::vector<std::filesystem::path> scenePaths = findTestScenes();
+    REQUIRE(!scenePaths.empty());
+
+    const uint32_t threadCounts[] = { 1, 2, 4, 8, 16 };
+    std::vector<std::vector<double>> loadMs(scenePaths.size());
+    for (uint32_t sceneIdx = 0; sceneIdx < scenePaths.size(); ++sceneIdx)
+    {
+        for (const uint32_t numThreads : threadCounts)
+        {
+            const GltfLoader::LoadOptions options = { .numThreads = numThreads, .useCaches = false };
+            loadMs[sceneIdx].push_back(measureLoadMs(scenePaths[sceneIdx], options));
+        }
+    }
+
+    printf("\nload ms without caches (fastest of %u), %u hardware threads\n",
+           NUM_LOADS_PER_MEASUREMENT,
+           std::thread::hardware_concurrency());
+    printf("%-24s", "scene");
+    for (const uint32_t numThreads : threadCounts)
+    {
+        printf(" %9u", numThreads);
+    }
+    printf("\n");
+
+    std::vector<double> totalMs(std::size(threadCounts), 0.0);
+    for (uint32_t sceneIdx = 0; sceneIdx < scenePaths.size(); ++sceneIdx)
+    {
+        printf("%-24s", scenePaths[sceneIdx].filename().string().c_str());
+        for (uint32_t countIdx = 0; countIdx < std::size(threadCounts); ++countIdx)
+        {
+            printf(" %9.1f", loadMs[sceneIdx][countIdx]);
+            totalMs[countIdx] += loadMs[sceneIdx][countIdx];
+        }
+        printf("\n");
+    }
+
+    printf("%-24s", "total");
+    for (const double ms : totalMs)
+    {
+        printf(" %9.1f", ms);
+    }
+    printf("\n");
+
+    NullDevice::shutdown();
+}
+
+struct LoadAndHandOverMs
+{
+    double loadMs;
+    double handOverMs;
+};
+
+// Fastest of a few loads, and of the Scene::update() time it then takes to swap each loaded scene in on the null
+// device until its TLAS is built. With host streams, that's where vertex and index data is copied into the UploadRing.
+static LoadAndHandOverMs measureLoadAndHandOverMs(const std::filesystem::path& scenePath,
+                                                  const GltfLoader::LoadOptions& options)
+{
+    static constexpr uint32_t MAX_NUM_FRAMES = 8;
+
+    LoadAndHandOverMs minMs = {};
+    for (uint32_t loadIdx = 0; loadIdx < NUM_LOADS_PER_MEASUREMENT; ++loadIdx)
+    {
+        std::unique_ptr<LoadedScene> loadedScene = std::make_unique<LoadedScene>();
+        const auto startTime = std::chrono::steady_clock::now();
+        REQUIRE(GltfLoader::loadGltf(scenePath.string(), loadedScene.get(), options));
+        const std::chrono::duration<double, std::milli> loadElapsed = std::chrono::steady_clock::now() - startTime;
+
+        SceneFrameLoop frameLoop;
+        frameLoop.scene.setBlasBuildBudget(0);
+        REQUIRE(frameLoop.scene.queueLoadedScene(loadedScene));
+
+        double handOverMs = 0.0;
+        for (uint32_t frameIdx = 0; frameIdx < MAX_NUM_FRAMES && !frameLoop.scene.hasTlas(); ++frameIdx)
+        {
+            handOverMs += frameLoop.runFrameMs();
+        }
+        CHECK(frameLoop.scene.hasTlas());
+
+        minMs.loadMs = loadIdx == 0 ? loadElapsed.count() : std::min(loadElapsed.count(), minMs.loadMs);
+        minMs.handOverMs = loadIdx == 0 ? handOverMs : std::min(handOverMs, minMs.handOverMs);
+    }
+    return minMs;
+}
+
+// Loads every scene in test_scenes/ with its vertex and index streams kept in host vectors, as before StagingBuffer,
+// and staged directly in upload memory, both from scratch and from a warm scene cache, and hands each one to a Scene.
+// The null device's upload heaps are ordinary memory rather than write-combined, so this shows the copies saved on
+// the render thread but not what writing to real upload memory costs.
+BENCHMARK(sceneLoadHostVersusStagedStreams)
+{
+    NullDevice::init();
+
+    const std::vector<std::filesystem::path> scenePaths = findTestScenes();
+    REQUIRE(!scenePaths.empty());
+
+    // host streams then staged streams, without and then with caches
+    std::vector<std::vector<LoadAndHandOverMs>> measurements(scenePaths.size());
+    for (uint32_t sceneIdx = 0; sceneIdx < scenePaths.size(); ++sceneIdx)
+    {
+        // writes the scene cache for the loads that use it
+        LoadedScene warmUpScene;
+        REQUIRE(GltfLoader::loadGltf(scenePaths[sceneIdx].string(), &warmUpScene));
+
+        for (const bool useCaches : { false, true })
+        {
+            for (const bool stageStreams : { false, true })
+            {
+                const GltfLoader::LoadOptions options = { .useCaches = useCaches, .stageStreams = stageStreams };
+                measurements[sceneIdx].push_back(measureLoadAndHandOverMs(scenePaths[sceneIdx], options));
+            }
+        }
+    }
+
+    printf("\nload + hand-over ms (fastest of %u), host streams -> staged streams\n", NUM_LOADS_PER_MEASUREMENT);
+    printf("%-24s %33s %33s\n", "scene", "without caches", "from scene cache");
+
+    std::vector<LoadAndHandOverMs> totalMs(4, LoadAndHandOverMs{});
+    for (uint32_t sceneIdx = 0; sceneIdx < scenePaths.size(); ++sceneIdx)
+    {
+        printf("%-24s", scenePaths[sceneIdx].filename().string().c_str());
+        for (uint32_t measurementIdx = 0; measurementIdx < 4; ++measurementIdx)
+        {
+            const LoadAndHandOverMs& ms = measurements[sceneIdx][measurementIdx];
+            printf(measurementIdx % 2 == 0 ? " %6.1f + %5.1f" : " -> %6.1f + %5.1f", ms.loadMs, ms.handOverMs);
+            totalMs[measurementIdx].loadMs += ms.loadMs;
+            totalMs[measurementIdx].handOverMs += ms.handOverMs;
+        }
+        printf("\n");
+    }
+
+    printf("%-24s", "total");
+    for (uint32_t measurementIdx = 0; measurementIdx < 4; ++measurementIdx)
+    {
+        const LoadAndHandOverMs& ms = totalMs[measurementIdx];
+        printf(measurementIdx % 2 == 0 ? " %6.1f + %5.1f" : " -> %6.1f + %5.1f", ms.loadMs, ms.handOverMs);
+    }
+    printf("\n");
+
+    NullDevice::shutdown();
+}
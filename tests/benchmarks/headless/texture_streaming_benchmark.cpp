@@ -0,0 +1,140 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "scene_frame_loop.h"
+
+#include "core/mip_generator.h"
+#include "core/texture_processor.h"
+#include "rendering/null/null_device.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static std::unique_ptr<LoadedScene> makeTexturedScene(uint32_t numTextures, uint32_t textureDim)
+{
+    std::unique_ptr<LoadedScene> loadedScene = std::make_unique<LoadedScene>();
+    for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+    {
+        ProcessedTexture& texture = loadedScene->textures.emplace_back();
+        texture.format = TextureFormat::RGBA8_SRGB;
+        texture.width = textureDim;
+        texture.height = textureDim;
+        texture.numMips = MipGenerator::getNumMips(textureDim, textureDim);
+        texture.data.resize(
+            TextureProcessor::getDataSizeBytes(texture.format, texture.width, texture.height, texture.numMips),
+            static_cast<uint8_t>(textureIdx));
+
+        Material& material = loadedScene->materials.emplace_back();
+        material.baseColorTextureId = textureIdx;
+    }
+    return loadedScene;
+}
+
+// Scene::update() time of the frames that swap in a scene with 8 uncompressed 1024x1024 textures, against that of
+// frames before it that only move a few instances, with and without a texture upload budget. Only CPU time is
+// measured, most of which is copying mips into the UploadRing, which also shows how far it has to grow.
+BENCHMARK(textureStreamingFrameTimes)
+{
+    static constexpr uint32_t NUM_TEXTURES = 8;
+    static constexpr uint32_t TEXTURE_DIM = 1024;
+    static constexpr uint32_t NUM_STEADY_FRAMES = 32;
+    static constexpr uint32_t MAX_NUM_LOAD_FRAMES = 64;
+
+    NullDevice::init();
+
+    printf("%14s %16s %16s %16s %12s %18s\n",
+           "budget MB",
+           "steady frame ms",
+           "worst load ms",
+           "total load ms",
+           "frames",
+           "upload ring MB");
+
+    for (const uint64_t budgetMb : { 0ull, 16ull, 8ull, 4ull })
+    {
+        SceneFrameLoop frameLoop;
+        frameLoop.scene.setTextureUploadBudget(budgetMb * 1024 * 1024);
+
+        Geometry* geometry = frameLoop.scene.requestNewGeometry();
+        const AcsHelper::GeometryRange range = geometry->addPart(3, 0, 0 /*materialId*/, 0.f /*uvScaleLog2*/);
+        geometry->host_positions[range.firstVert + 1] = { 1.f, 0.f, 0.f };
+        geometry->host_positions[range.firstVert + 2] = { 0.f, 1.f, 0.f };
+
+        std::vector<Instance*> instances;
+        for (uint32_t instanceIdx = 0; instanceIdx < 1024; ++instanceIdx)
+        {
+            Instance* instance = frameLoop.scene.requestNewInstance(frameLoop.getToFreeList());
+            instance->setGeometry(geometry);
+            frameLoop.scene.markInstanceReady(instance);
+            instances.push_back(instance);
+        }
+
+        auto moveInstances = [&](uint32_t frameIdx) {
+            for (uint32_t moveIdx = 0; moveIdx < 16; ++moveIdx)
+            {
+                DirectX::XMFLOAT3X4 transform;
+                DirectX::XMStoreFloat3x4(&transform,
+                                         DirectX::XMMatrixTranslation(0.f, 0.f, static_cast<float>(frameIdx)));
+                instances[(frameIdx * 16 + moveIdx) % instances.size()]->setTransform(transform);
+            }
+        };
+
+        for (uint32_t frameIdx = 0; frameIdx < SceneFrameLoop::FRAME_LATENCY + 2; ++frameIdx)
+        {
+            moveInstances(frameIdx);
+            frameLoop.runFrameMs();
+        }
+
+        double steadyMs = 0.0;
+        for (uint32_t frameIdx = 0; frameIdx < NUM_STEADY_FRAMES; ++frameIdx)
+        {
+            moveInstances(frameIdx);
+            steadyMs += frameLoop.runFrameMs();
+        }
+        steadyMs /= NUM_STEADY_FRAMES;
+
+        std::unique_ptr<LoadedScene> loadedScene = makeTexturedScene(NUM_TEXTURES, TEXTURE_DIM);
+        REQUIRE(frameLoop.scene.queueLoadedScene(loadedScene));
+
+        double worstLoadMs = 0.0;
+        double totalLoadMs = 0.0;
+        uint32_t numLoadFrames = 0;
+        do
+        {
+            const double frameMs = frameLoop.runFrameMs();
+            worstLoadMs = std::max(frameMs, worstLoadMs);
+            totalLoadMs += frameMs;
+            ++numLoadFrames;
+        } while (frameLoop.scene.hasPendingTextures() && numLoadFrames < MAX_NUM_LOAD_FRAMES);
+        CHECK(!frameLoop.scene.hasPendingTextures());
+
+        printf("%14llu %16.3f %16.3f %16.3f %12u %18.1f\n",
+               static_cast<unsigned long long>(budgetMb),
+               steadyMs,
+               worstLoadMs,
+               totalLoadMs,
+               numLoadFrames,
+               frameLoop.uploadRing.getPoolStats().capacityBytes / (1024.0 * 1024.0));
+    }
+
+    CHECK(NullDevice::getStats().numValidationErrors == 0);
+    NullDevice::shutdown();
+}
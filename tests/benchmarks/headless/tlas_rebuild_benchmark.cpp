@@ -0,0 +1,135 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "scene_frame_loop.h"
+
+#include "rendering/null/null_device.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+DirectX::XMFLOAT3X4 makeTranslation(float x, float y, float z)
+{
+    DirectX::XMFLOAT3X4 transform;
+    DirectX::XMStoreFloat3x4(&transform, DirectX::XMMatrixTranslation(x, y, z));
+    return transform;
+}
+
+Geometry* makeTriangleGeometry(Scene& scene)
+{
+    Geometry* geometry = scene.requestNewGeometry();
+    const AcsHelper::GeometryRange range = geometry->addPart(3, 0, 0 /*materialId*/, 0.f /*uvScaleLog2*/);
+    geometry->host_positions[range.firstVert + 0] = { 0.f, 0.f, 0.f };
+    geometry->host_positions[range.firstVert + 1] = { 1.f, 0.f, 0.f };
+    geometry->host_positions[range.firstVert + 2] = { 0.f, 1.f, 0.f };
+    return geometry;
+}
+
+Instance* addInstance(SceneFrameLoop& frameLoop, Geometry* geometry, uint32_t gridIdx)
+{
+    Instance* instance = frameLoop.scene.requestNewInstance(frameLoop.getToFreeList());
+    instance->setGeometry(geometry);
+    instance->setTransform(makeTranslation(static_cast<float>(gridIdx % 256), static_cast<float>(gridIdx / 256), 0.f));
+    frameLoop.scene.markInstanceReady(instance);
+    return instance;
+}
+
+} // namespace
+
+// Scene::update() time for the frames a streaming world produces most: one instance swapped for another, which
+// rebuilds the TLAS, and a handful of instances moving, which refits it. Only CPU time is measured; the null device's
+// build costs have nothing to do with a real GPU's.
+BENCHMARK(tlasRebuildVersusInstanceCount)
+{
+    NullDevice::init();
+
+    printf("%10s %16s %16s %18s\n", "instances", "rebuild ms", "refit ms", "rebuild ns/inst");
+
+    for (const uint32_t numInstances : { 1000u, 4000u, 16000u, 64000u, 256000u })
+    {
+        std::mt19937 rng(Harness::getSeed());
+
+        SceneFrameLoop frameLoop;
+        frameLoop.scene.reserveInstances(frameLoop.getToFreeList(), numInstances + 1);
+        Geometry* geometry = makeTriangleGeometry(frameLoop.scene);
+
+        std::vector<Instance*> instances;
+        instances.reserve(numInstances);
+        for (uint32_t instanceIdx = 0; instanceIdx < numInstances; ++instanceIdx)
+        {
+            instances.push_back(addInstance(frameLoop, geometry, instanceIdx));
+        }
+
+        // builds the BLAS and the first TLAS, then lets a few frames go by so that nothing is left over
+        for (uint32_t frameIdx = 0; frameIdx < SceneFrameLoop::FRAME_LATENCY + 2; ++frameIdx)
+        {
+            frameLoop.runFrameMs();
+        }
+
+        static constexpr uint32_t NUM_MEASURED_FRAMES = 32;
+
+        const NullDevice::Stats statsBeforeRebuilds = NullDevice::getStats();
+        double rebuildMs = 0.0;
+        for (uint32_t frameIdx = 0; frameIdx < NUM_MEASURED_FRAMES; ++frameIdx)
+        {
+            Instance*& swappedInstance = instances[rng() % numInstances];
+            frameLoop.getToFreeList().pushInstance(swappedInstance);
+            swappedInstance = addInstance(frameLoop, geometry, numInstances + frameIdx);
+
+            // the new instance goes into the TLAS this frame, since its geometry's BLAS already exists
+            rebuildMs += frameLoop.runFrameMs();
+        }
+
+        const NullDevice::Stats statsAfterRebuilds = NullDevice::getStats();
+        CHECK(statsAfterRebuilds.numAccelerationStructureBuilds - statsBeforeRebuilds.numAccelerationStructureBuilds ==
+              NUM_MEASURED_FRAMES);
+        CHECK(statsAfterRebuilds.numAccelerationStructureUpdates == statsBeforeRebuilds.numAccelerationStructureUpdates);
+
+        // the TLAS has only been built for refitting once something has moved
+        instances[0]->setTransform(makeTranslation(0.f, 0.f, -1.f));
+        frameLoop.runFrameMs();
+
+        const NullDevice::Stats statsBeforeRefits = NullDevice::getStats();
+        double refitMs = 0.0;
+        for (uint32_t frameIdx = 0; frameIdx < NUM_MEASURED_FRAMES; ++frameIdx)
+        {
+            for (uint32_t moveIdx = 0; moveIdx < 16; ++moveIdx)
+            {
+                instances[rng() % numInstances]->setTransform(makeTranslation(0.f, 0.f, static_cast<float>(frameIdx)));
+            }
+
+            refitMs += frameLoop.runFrameMs();
+        }
+
+        const NullDevice::Stats statsAfterRefits = NullDevice::getStats();
+        CHECK(statsAfterRefits.numAccelerationStructureUpdates - statsBeforeRefits.numAccelerationStructureUpdates ==
+              NUM_MEASURED_FRAMES);
+
+        rebuildMs /= NUM_MEASURED_FRAMES;
+        refitMs /= NUM_MEASURED_FRAMES;
+        printf("%10u %16.3f %16.3f %18.1f\n", numInstances, rebuildMs, refitMs, rebuildMs * 1e6 / numInstances);
+    }
+
+    CHECK(NullDevice::getStats().numValidationErrors == 0);
+    NullDevice::shutdown();
+}
@@ -0,0 +1,150 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "image_metrics.h"
+
+#include "core/block_compression.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using BlockCompression::Format;
+
+static std::vector<uint8_t> encodeAndDecode(Format format,
+                                            const std::vector<uint8_t>& rgba,
+                                            uint32_t width,
+                                            uint32_t height)
+{
+    std::vector<uint8_t> blocks(BlockCompression::getEncodedSizeBytes(width, height));
+    BlockCompression::encodeImage(format, rgba.data(), width, height, 1, blocks.data());
+
+    std::vector<uint8_t> decoded(rgba.size());
+    BlockCompression::decodeImage(format, blocks.data(), width, height, decoded.data());
+    return decoded;
+}
+
+// Thresholds are a few dB under what the encoder currently reaches on this image, so that a change that makes it
+// noticeably worse fails here rather than showing up as blotchy textures.
+TEST_CASE(bc7MeetsPsnrThreshold)
+{
+    static constexpr uint32_t DIM = 64;
+    const std::vector<uint8_t> rgba = makeTestImage(DIM, DIM, Harness::getSeed());
+    const std::vector<uint8_t> decoded = encodeAndDecode(Format::BC7, rgba, DIM, DIM);
+
+    CHECK(computePsnr(rgba.data(), decoded.data(), DIM * DIM, 0, 3) > 35.0);
+    CHECK(computePsnr(rgba.data(), decoded.data(), DIM * DIM, 3, 1) > 38.0);
+}
+
+TEST_CASE(bc5MeetsPsnrThreshold)
+{
+    static constexpr uint32_t DIM = 64;
+    const std::vector<uint8_t> rgba = makeTestImage(DIM, DIM, Harness::getSeed());
+    const std::vector<uint8_t> decoded = encodeAndDecode(Format::BC5, rgba, DIM, DIM);
+
+    CHECK(computePsnr(rgba.data(), decoded.data(), DIM * DIM, 0, 2) > 44.0);
+    for (uint32_t texelIdx = 0; texelIdx < DIM * DIM; ++texelIdx)
+    {
+        CHECK(decoded[texelIdx * 4 + 2] == 0);
+        CHECK(decoded[texelIdx * 4 + 3] == 255);
+    }
+}
+
+// BC4 endpoints are 8 bits, so BC5 hits any constant color exactly. Mode 6 endpoints are 7 bits per channel plus a
+// p-bit shared by all four, so BC7 can be one off.
+TEST_CASE(blockCompressionKeepsConstantColors)
+{
+    std::mt19937 rng(Harness::getSeed());
+
+    for (uint32_t iteration = 0; iteration < 1000; ++iteration)
+    {
+        uint8_t color[4];
+        for (uint8_t& channel : color)
+        {
+            channel = static_cast<uint8_t>(rng());
+        }
+
+        uint8_t rgba[16 * 4];
+        for (uint32_t texelIdx = 0; texelIdx < 16; ++texelIdx)
+        {
+            memcpy(&rgba[texelIdx * 4], color, 4);
+        }
+
+        uint8_t block[BlockCompression::BLOCK_SIZE_BYTES];
+        uint8_t decoded[16 * 4];
+        BlockCompression::encodeBlock(Format::BC7, rgba, block);
+        BlockCompression::decodeBlock(Format::BC7, block, decoded);
+        for (uint32_t i = 0; i < 16 * 4; ++i)
+        {
+            CHECK(std::abs(decoded[i] - rgba[i]) <= 1);
+        }
+
+        BlockCompression::encodeBlock(Format::BC5, rgba, block);
+        BlockCompression::decodeBlock(Format::BC5, block, decoded);
+        CHECK(computePsnr(rgba, decoded, 16, 0, 2) == std::numeric_limits<double>::infinity());
+    }
+}
+
+// blocks hanging over the edges are encoded as if the image went on repeating its edge texels
+TEST_CASE(blockCompressionHandlesPartialBlocks)
+{
+    static constexpr uint32_t WIDTH = 6;
+    static constexpr uint32_t HEIGHT = 5;
+    static constexpr uint32_t PADDED_DIM = 8;
+    const std::vector<uint8_t> rgba = makeTestImage(WIDTH, HEIGHT, Harness::getSeed());
+    CHECK(BlockCompression::getEncodedSizeBytes(WIDTH, HEIGHT) == 4 * BlockCompression::BLOCK_SIZE_BYTES);
+
+    std::vector<uint8_t> paddedRgba(PADDED_DIM * PADDED_DIM * 4);
+    for (uint32_t y = 0; y < PADDED_DIM; ++y)
+    {
+        for (uint32_t x = 0; x < PADDED_DIM; ++x)
+        {
+            const uint32_t srcTexelIdx = std::min(y, HEIGHT - 1) * WIDTH + std::min(x, WIDTH - 1);
+            memcpy(&paddedRgba[(y * PADDED_DIM + x) * 4], &rgba[srcTexelIdx * 4], 4);
+        }
+    }
+
+    for (const Format format : { Format::BC7, Format::BC5 })
+    {
+        const std::vector<uint8_t> decoded = encodeAndDecode(format, rgba, WIDTH, HEIGHT);
+        const std::vector<uint8_t> paddedDecoded = encodeAndDecode(format, paddedRgba, PADDED_DIM, PADDED_DIM);
+        for (uint32_t y = 0; y < HEIGHT; ++y)
+        {
+            CHECK(memcmp(&decoded[y * WIDTH * 4], &paddedDecoded[y * PADDED_DIM * 4], WIDTH * 4) == 0);
+        }
+    }
+}
+
+TEST_CASE(blockCompressionIsIndependentOfThreadCount)
+{
+    static constexpr uint32_t DIM = 64;
+    const std::vector<uint8_t> rgba = makeTestImage(DIM, DIM, Harness::getSeed());
+
+    for (const Format format : { Format::BC7, Format::BC5 })
+    {
+        std::vector<uint8_t> singleThreadBlocks(BlockCompression::getEncodedSizeBytes(DIM, DIM));
+        std::vector<uint8_t> multiThreadBlocks(singleThreadBlocks.size());
+        BlockCompression::encodeImage(format, rgba.data(), DIM, DIM, 1, singleThreadBlocks.data());
+        BlockCompression::encodeImage(format, rgba.data(), DIM, DIM, 4, multiThreadBlocks.data());
+        CHECK(singleThreadBlocks == multiThreadBlocks);
+    }
+}
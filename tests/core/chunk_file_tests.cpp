@@ -0,0 +1,195 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "temp_dir.h"
+
+#include "core/chunk_file.h"
+
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+static constexpr uint64_t KEY = 0x123456789abcdefull;
+
+static std::vector<uint8_t> makeCompressibleData(uint32_t sizeBytes)
+{
+    std::vector<uint8_t> data(sizeBytes);
+    for (uint32_t i = 0; i < sizeBytes; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i / 64);
+    }
+    return data;
+}
+
+static std::vector<uint8_t> makeRandomData(uint32_t sizeBytes, std::mt19937& rng)
+{
+    std::vector<uint8_t> data(sizeBytes);
+    for (uint8_t& byte : data)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+TEST_CASE(chunkFileRoundTrip)
+{
+    TempDir tempDir;
+    const std::string filePathStr = (tempDir.path / "nested" / "dir" / "file.bin").string();
+    std::mt19937 rng(Harness::getSeed());
+
+    // compressed, stored as is because it doesn't compress, empty, and typed
+    const std::vector<uint8_t> compressible = makeCompressibleData(100000);
+    const std::vector<uint8_t> incompressible = makeRandomData(3001, rng);
+    const std::vector<float> floats = { 1.f, 2.f, 3.f, -4.5f };
+
+    ChunkFileWriter writer;
+    CHECK(writer.addChunk(10, std::vector<uint8_t>(compressible)) == 0);
+    CHECK(writer.addChunk(11, incompressible.data(), incompressible.size()) == 1);
+    CHECK(writer.addChunk(12, std::vector<uint8_t>()) == 2);
+    CHECK(writer.addChunk(13, floats) == 3);
+    REQUIRE(writer.write(filePathStr, KEY, 4));
+
+    // smaller than its contents, since the large chunk compresses
+    CHECK(std::filesystem::file_size(filePathStr) < compressible.size());
+    CHECK(tempDir.countFilesEndingWith(".tmp") == 0);
+
+    ChunkFileReader reader;
+    REQUIRE(reader.open(filePathStr, KEY));
+    REQUIRE(reader.getNumChunks() == 4);
+    CHECK(reader.getChunkType(0) == 10);
+    CHECK(reader.getChunkType(3) == 13);
+    CHECK(reader.getChunkSizeBytes(0) == compressible.size());
+    CHECK(reader.getChunkSizeBytes(2) == 0);
+
+    std::vector<uint8_t> bytes;
+    CHECK(reader.readChunk(0, &bytes) && bytes == compressible);
+    CHECK(reader.readChunk(1, &bytes) && bytes == incompressible);
+    CHECK(reader.readChunk(2, &bytes) && bytes.empty());
+
+    std::vector<float> readFloats;
+    CHECK(reader.readChunk(3, &readFloats) && readFloats == floats);
+
+    // a size that isn't a whole number of elements, and a destination of the wrong size
+    std::vector<uint64_t> wrongElements;
+    CHECK(!reader.readChunk(1, &wrongElements));
+    std::vector<uint8_t> tooSmall(compressible.size() - 1);
+    CHECK(!reader.readChunk(0, tooSmall.data(), tooSmall.size()));
+
+    std::vector<uint8_t> writeOnly(compressible.size());
+    std::vector<uint8_t> scratch;
+    CHECK(reader.readChunkToWriteOnly(0, writeOnly.data(), writeOnly.size(), &scratch) && writeOnly == compressible);
+    writeOnly.resize(incompressible.size());
+    CHECK(reader.readChunkToWriteOnly(1, writeOnly.data(), writeOnly.size(), &scratch) && writeOnly == incompressible);
+
+    reader.close();
+    CHECK(!reader.open(filePathStr, KEY + 1));
+    CHECK(!reader.open((tempDir.path / "missing.bin").string(), KEY));
+}
+
+TEST_CASE(chunkFileDetectsCorruption)
+{
+    TempDir tempDir;
+    const std::filesystem::path filePath = tempDir.path / "file.bin";
+    std::mt19937 rng(Harness::getSeed());
+
+    const std::vector<uint8_t> compressible = makeCompressibleData(20000);
+    const std::vector<uint8_t> incompressible = makeRandomData(2000, rng);
+
+    ChunkFileWriter writer;
+    writer.addChunk(0, compressible);
+    writer.addChunk(1, incompressible);
+    REQUIRE(writer.write(filePath.string(), KEY, 1));
+
+    std::vector<uint8_t> fileBytes(std::filesystem::file_size(filePath));
+    {
+        std::ifstream stream(filePath, std::ios::binary);
+        stream.read(reinterpret_cast<char*>(fileBytes.data()), fileBytes.size());
+    }
+
+    // flip one byte at a time at random positions; every read of the damaged file either fails or returns the
+    // original contents, never something else
+    for (uint32_t iteration = 0; iteration < 300; ++iteration)
+    {
+        std::vector<uint8_t> corruptedBytes = fileBytes;
+        corruptedBytes[rng() % corruptedBytes.size()] ^= static_cast<uint8_t>(1 + rng() % 255);
+
+        const std::filesystem::path corruptedPath = tempDir.path / "corrupted.bin";
+        {
+            std::ofstream stream(corruptedPath, std::ios::binary | std::ios::trunc);
+            stream.write(reinterpret_cast<const char*>(corruptedBytes.data()), corruptedBytes.size());
+        }
+
+        ChunkFileReader reader;
+        if (!reader.open(corruptedPath.string(), KEY))
+        {
+            continue;
+        }
+
+        std::vector<uint8_t> bytes;
+        for (uint32_t chunkIdx = 0; chunkIdx < reader.getNumChunks(); ++chunkIdx)
+        {
+            if (reader.readChunk(chunkIdx, &bytes))
+            {
+                CHECK(bytes == (chunkIdx == 0 ? compressible : incompressible));
+            }
+        }
+    }
+}
+
+TEST_CASE(chunkFileConcurrentWritersUseTheirOwnTempFiles)
+{
+    TempDir tempDir;
+    const std::string filePathStr = (tempDir.path / "file.bin").string();
+
+    // Each thread writes a complete file of its own contents to the same path. With a shared temporary file, writers
+    // would interleave into it and the file that ends up in place could mix several of them.
+    static constexpr uint32_t NUM_WRITERS = 8;
+    std::vector<std::thread> writers;
+    std::vector<uint8_t> didWrite(NUM_WRITERS, 0);
+    for (uint32_t writerIdx = 0; writerIdx < NUM_WRITERS; ++writerIdx)
+    {
+        writers.emplace_back([&, writerIdx]() {
+            ChunkFileWriter writer;
+            writer.addChunk(writerIdx, std::vector<uint8_t>(50000 + writerIdx * 1000, static_cast<uint8_t>(writerIdx)));
+            didWrite[writerIdx] = writer.write(filePathStr, KEY, 1);
+        });
+    }
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+
+    for (const uint8_t writerDidWrite : didWrite)
+    {
+        CHECK(writerDidWrite);
+    }
+    CHECK(tempDir.countFilesEndingWith(".tmp") == 0);
+
+    // whichever writer finished last, the file is entirely its own
+    ChunkFileReader reader;
+    REQUIRE(reader.open(filePathStr, KEY));
+    REQUIRE(reader.getNumChunks() == 1);
+    const uint32_t writerIdx = reader.getChunkType(0);
+    REQUIRE(writerIdx < NUM_WRITERS);
+
+    std::vector<uint8_t> bytes;
+    CHECK(reader.readChunk(0, &bytes));
+    CHECK(bytes == std::vector<uint8_t>(50000 + writerIdx * 1000, static_cast<uint8_t>(writerIdx)));
+}
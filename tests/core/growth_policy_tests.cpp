@@ -0,0 +1,59 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/growth_policy.h"
+
+#include <cstdint>
+
+TEST_CASE(growthDoublesThenIncrements)
+{
+    const GrowthPolicy policy{ .doublingLimitBytes = 1024, .incrementBytes = 256 };
+
+    CHECK(policy.getGrownSize(100, 101) == 200);
+    CHECK(policy.getGrownSize(100, 700) == 800);
+    CHECK(policy.getGrownSize(0, 3) == 4);
+
+    // past the doubling limit, whole increments are added instead
+    CHECK(policy.getGrownSize(1024, 1025) == 1280);
+    CHECK(policy.getGrownSize(1024, 2000) == 2048);
+    CHECK(policy.getGrownSize(800, 2000) == 2112);
+
+    // already large enough
+    CHECK(policy.getGrownSize(4096, 100) == 4096);
+}
+
+TEST_CASE(growthNeverOverflows)
+{
+    // the doubling limit only applies when increments are enabled, so this one doubles until it would wrap
+    const GrowthPolicy doublingOnly{ .doublingLimitBytes = 1024, .incrementBytes = 0 };
+    CHECK(doublingOnly.getGrownSize(3, UINT64_MAX) == UINT64_MAX);
+    CHECK(doublingOnly.getGrownSize(1, (1ull << 63) + 1) == (1ull << 63) + 1);
+    CHECK(doublingOnly.getGrownSize(1, 1ull << 63) == 1ull << 63);
+    CHECK(doublingOnly.getGrownSize(UINT64_MAX - 1, UINT64_MAX) == UINT64_MAX);
+
+    // rounding up to whole increments would wrap as well
+    const GrowthPolicy incrementing{ .doublingLimitBytes = 1024, .incrementBytes = 1000 };
+    CHECK(incrementing.getGrownSize(1024, UINT64_MAX) == UINT64_MAX);
+    CHECK(incrementing.getGrownSize(1024, UINT64_MAX - 500) == UINT64_MAX - 500);
+
+    const GrowthPolicy defaults{};
+    const uint64_t grownSizeBytes = defaults.getGrownSize(1, UINT64_MAX / 3);
+    CHECK(grownSizeBytes >= UINT64_MAX / 3);
+}
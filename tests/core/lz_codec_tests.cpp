@@ -0,0 +1,152 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/lz_codec.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static bool roundTrips(const std::vector<uint8_t>& data)
+{
+    const std::vector<uint8_t> compressed = LzCodec::compress(data.data(), data.size());
+
+    std::vector<uint8_t> decompressed(data.size());
+    return LzCodec::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()) &&
+           decompressed == data;
+}
+
+TEST_CASE(lzRoundTripsEdgeCases)
+{
+    CHECK(roundTrips({}));
+    CHECK(roundTrips({ 42 }));
+    CHECK(roundTrips({ 1, 2, 3 }));
+
+    // shorter than the minimum match, then exactly long enough for one
+    CHECK(roundTrips({ 7, 7, 7, 7 }));
+    CHECK(roundTrips({ 7, 7, 7, 7, 7, 7, 7, 7 }));
+
+    // literal and match lengths around the 15 that spills into extra length bytes, and far past 255 of them
+    for (const uint32_t runLength : { 14u, 15u, 16u, 18u, 19u, 20u, 270u, 271u, 272u, 100000u })
+    {
+        std::vector<uint8_t> data(runLength, 0xab);
+        CHECK(roundTrips(data));
+
+        std::vector<uint8_t> literals(runLength);
+        for (uint32_t i = 0; i < runLength; ++i)
+        {
+            literals[i] = static_cast<uint8_t>(i * 7 + i / 256);
+        }
+        CHECK(roundTrips(literals));
+    }
+}
+
+TEST_CASE(lzCompressesRepetitiveData)
+{
+    std::vector<uint8_t> data;
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        data.push_back(static_cast<uint8_t>(i % 100));
+    }
+
+    const std::vector<uint8_t> compressed = LzCodec::compress(data.data(), data.size());
+    CHECK(compressed.size() < data.size() / 50);
+    CHECK(roundTrips(data));
+}
+
+TEST_CASE(lzRoundTripsRandomData)
+{
+    std::mt19937 rng(Harness::getSeed());
+
+    for (uint32_t iteration = 0; iteration < 200; ++iteration)
+    {
+        // mixes of random bytes and copies of earlier ranges, some of them further back than a match offset can reach
+        std::vector<uint8_t> data;
+        const uint32_t sizeBytes = rng() % (1 << (rng() % 19));
+        while (data.size() < sizeBytes)
+        {
+            if (data.size() > 4 && rng() % 2 == 0)
+            {
+                const size_t srcOffset = rng() % data.size();
+                const size_t length = std::min<size_t>(1 + rng() % 300, data.size() - srcOffset);
+                for (size_t i = 0; i < length; ++i)
+                {
+                    data.push_back(data[srcOffset + i]);
+                }
+            }
+            else
+            {
+                const uint32_t length = 1 + rng() % 64;
+                const uint8_t alphabetSize = static_cast<uint8_t>(1 + rng() % 255);
+                for (uint32_t i = 0; i < length; ++i)
+                {
+                    data.push_back(static_cast<uint8_t>(rng() % alphabetSize));
+                }
+            }
+        }
+
+        CHECK(roundTrips(data));
+    }
+}
+
+TEST_CASE(lzRejectsMalformedInput)
+{
+    std::mt19937 rng(Harness::getSeed());
+
+    std::vector<uint8_t> data;
+    for (uint32_t i = 0; i < 4096; ++i)
+    {
+        data.push_back(static_cast<uint8_t>(rng() % 4));
+    }
+    const std::vector<uint8_t> compressed = LzCodec::compress(data.data(), data.size());
+
+    // a destination of the wrong size
+    std::vector<uint8_t> decompressed(data.size() + 1);
+    CHECK(!LzCodec::decompress(compressed.data(), compressed.size(), decompressed.data(), data.size() + 1));
+    CHECK(!LzCodec::decompress(compressed.data(), compressed.size(), decompressed.data(), data.size() - 1));
+
+    // truncated blocks
+    for (size_t truncatedSize = 0; truncatedSize < compressed.size(); truncatedSize += 1 + truncatedSize / 4)
+    {
+        CHECK(!LzCodec::decompress(compressed.data(), truncatedSize, decompressed.data(), data.size()));
+    }
+
+    // Corrupted blocks may still happen to decode to the right size, but must never read or write out of bounds;
+    // running this under a sanitizer is what catches that.
+    for (uint32_t iteration = 0; iteration < 2000; ++iteration)
+    {
+        std::vector<uint8_t> corrupted = compressed;
+        for (uint32_t i = 0; i < 1 + rng() % 4; ++i)
+        {
+            corrupted[rng() % corrupted.size()] = static_cast<uint8_t>(rng());
+        }
+        LzCodec::decompress(corrupted.data(), corrupted.size(), decompressed.data(), data.size());
+    }
+
+    std::vector<uint8_t> garbage(256);
+    for (uint32_t iteration = 0; iteration < 2000; ++iteration)
+    {
+        for (uint8_t& byte : garbage)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+        LzCodec::decompress(garbage.data(), rng() % garbage.size(), decompressed.data(), data.size());
+    }
+}
@@ -0,0 +1,187 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "temp_dir.h"
+
+#include "core/memory_registry.h"
+
+#include "tinygltf/json.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+TEST_CASE(memoryRegistryTracksTagsAndHeaps)
+{
+    MemoryRegistry registry;
+
+    const uint32_t vertexId = registry.registerAllocation(MemoryTag::VERTEX_POOL, MemoryHeap::DEVICE, 1000);
+    const uint32_t uploadId = registry.registerAllocation(MemoryTag::UPLOAD, MemoryHeap::UPLOAD, 300);
+    const uint32_t secondVertexId = registry.registerAllocation(MemoryTag::VERTEX_POOL, MemoryHeap::DEVICE, 500);
+
+    MemoryRegistry::UsageStats vertexStats = registry.getTagStats(MemoryTag::VERTEX_POOL);
+    CHECK(vertexStats.currentBytes == 1500);
+    CHECK(vertexStats.peakBytes == 1500);
+    CHECK(vertexStats.numLive == 2);
+    CHECK(registry.getHeapStats(MemoryHeap::UPLOAD).currentBytes == 300);
+    CHECK(registry.getTotalStats().currentBytes == 1800);
+
+    registry.unregisterAllocation(vertexId);
+    vertexStats = registry.getTagStats(MemoryTag::VERTEX_POOL);
+    CHECK(vertexStats.currentBytes == 500);
+    CHECK(vertexStats.peakBytes == 1500);
+    CHECK(vertexStats.numLive == 1);
+    CHECK(vertexStats.numAllocations == 2);
+    CHECK(vertexStats.numFrees == 1);
+    CHECK(registry.getHeapStats(MemoryHeap::DEVICE).currentBytes == 500);
+
+    // freed ids are reused, and peaks only move when current usage passes them again
+    const uint32_t reusedId = registry.registerAllocation(MemoryTag::VERTEX_POOL, MemoryHeap::DEVICE, 200);
+    CHECK(reusedId == vertexId);
+    vertexStats = registry.getTagStats(MemoryTag::VERTEX_POOL);
+    CHECK(vertexStats.currentBytes == 700);
+    CHECK(vertexStats.peakBytes == 1500);
+    CHECK(vertexStats.totalAllocatedBytes == 1700);
+
+    registry.unregisterAllocation(uploadId);
+    registry.unregisterAllocation(secondVertexId);
+    registry.unregisterAllocation(reusedId);
+
+    const MemoryRegistry::UsageStats totalStats = registry.getTotalStats();
+    CHECK(totalStats.currentBytes == 0);
+    CHECK(totalStats.peakBytes == 1800);
+    CHECK(totalStats.totalAllocatedBytes == 2000);
+    CHECK(totalStats.numLive == 0);
+    CHECK(totalStats.numAllocations == 4);
+    CHECK(totalStats.numFrees == 4);
+    CHECK(registry.getTagStats(MemoryTag::TEXTURES).numAllocations == 0);
+}
+
+TEST_CASE(memoryRegistryJsonReport)
+{
+    MemoryRegistry registry;
+
+    registry.setFrameIdx(7);
+    registry.registerAllocation(MemoryTag::TEXTURES, MemoryHeap::DEVICE, 4096);
+    const uint32_t freedId = registry.registerAllocation(MemoryTag::UPLOAD, MemoryHeap::UPLOAD, 8192);
+    registry.setFrameIdx(9);
+    registry.registerAllocation(MemoryTag::READBACK, MemoryHeap::READBACK, 64);
+    registry.unregisterAllocation(freedId);
+
+    registry.setPoolStats("vertices",
+                          {
+                              .capacityBytes = 1000,
+                              .usedBytes = 600,
+                              .peakUsedBytes = 800,
+                              .largestFreeRangeBytes = 100,
+                              .numAllocations = 5,
+                              .numFreeRanges = 3,
+                              .numResizes = 2,
+                          });
+    registry.setPoolStats("full", { .capacityBytes = 256, .usedBytes = 256, .peakUsedBytes = 256 });
+
+    const nlohmann::json report = nlohmann::json::parse(registry.makeJsonReport());
+
+    std::vector<std::string> keys;
+    for (const auto& [key, value] : report.items())
+    {
+        keys.push_back(key);
+    }
+    CHECK((keys == std::vector<std::string>{ "frameIdx", "heaps", "largestAllocations", "pools", "tags", "total" }));
+    CHECK(report["frameIdx"] == 9);
+
+    const nlohmann::json& total = report["total"];
+    CHECK(total.size() == 6);
+    CHECK(total["currentBytes"] == 4096 + 64);
+    CHECK(total["peakBytes"] == 4096 + 8192 + 64);
+    CHECK(total["totalAllocatedBytes"] == 4096 + 8192 + 64);
+    CHECK(total["numLive"] == 2);
+    CHECK(total["numAllocations"] == 3);
+    CHECK(total["numFrees"] == 1);
+
+    // every heap and tag is listed, used or not
+    CHECK(report["heaps"].size() == static_cast<size_t>(MemoryHeap::COUNT));
+    CHECK(report["heaps"]["upload"]["currentBytes"] == 0);
+    CHECK(report["heaps"]["upload"]["peakBytes"] == 8192);
+    CHECK(report["heaps"]["device"]["numLive"] == 1);
+    CHECK(report["tags"].size() == static_cast<size_t>(MemoryTag::COUNT));
+    CHECK(report["tags"]["textures"]["currentBytes"] == 4096);
+    CHECK(report["tags"]["readback"]["numAllocations"] == 1);
+    CHECK(report["tags"]["vertexPool"]["numAllocations"] == 0);
+
+    const nlohmann::json& vertices = report["pools"]["vertices"];
+    CHECK(vertices.size() == 9);
+    CHECK(vertices["capacityBytes"] == 1000);
+    CHECK(vertices["usedBytes"] == 600);
+    CHECK(vertices["peakUsedBytes"] == 800);
+    CHECK(vertices["freeBytes"] == 400);
+    CHECK(vertices["largestFreeRangeBytes"] == 100);
+    CHECK(vertices["numAllocations"] == 5);
+    CHECK(vertices["numFreeRanges"] == 3);
+    CHECK(vertices["numResizes"] == 2);
+    CHECK(vertices["fragmentation"] == 0.75);
+    CHECK(report["pools"]["full"]["freeBytes"] == 0);
+    CHECK(report["pools"]["full"]["fragmentation"] == 0.0);
+
+    // live allocations only, largest first
+    const nlohmann::json& largest = report["largestAllocations"];
+    REQUIRE(largest.size() == 2);
+    CHECK(largest[0].size() == 4);
+    CHECK(largest[0]["tag"] == "textures");
+    CHECK(largest[0]["heap"] == "device");
+    CHECK(largest[0]["sizeBytes"] == 4096);
+    CHECK(largest[0]["createdFrameIdx"] == 7);
+    CHECK(largest[1]["tag"] == "readback");
+    CHECK(largest[1]["sizeBytes"] == 64);
+    CHECK(largest[1]["createdFrameIdx"] == 9);
+}
+
+TEST_CASE(memoryRegistryReportsOnlyLargestAllocations)
+{
+    MemoryRegistry registry;
+    for (uint32_t idx = 0; idx < 40; ++idx)
+    {
+        registry.registerAllocation(MemoryTag::OTHER, MemoryHeap::DEVICE, 100 + idx);
+    }
+
+    const nlohmann::json report = nlohmann::json::parse(registry.makeJsonReport());
+    const nlohmann::json& largest = report["largestAllocations"];
+    REQUIRE(largest.size() == 16);
+    for (uint32_t idx = 0; idx < largest.size(); ++idx)
+    {
+        CHECK(largest[idx]["sizeBytes"] == 139 - idx);
+    }
+    CHECK(report["pools"].is_object() && report["pools"].empty());
+}
+
+TEST_CASE(memoryRegistryWritesJsonReport)
+{
+    TempDir tempDir;
+    MemoryRegistry registry;
+    registry.registerAllocation(MemoryTag::SCRATCH, MemoryHeap::DEVICE, 123);
+
+    const std::filesystem::path reportPath = tempDir.path / "memory.json";
+    REQUIRE(registry.writeJsonReport(reportPath.string()));
+
+    std::ifstream stream(reportPath);
+    const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    CHECK(contents == registry.makeJsonReport() + "\n");
+
+    CHECK(!registry.writeJsonReport((tempDir.path / "missing" / "memory.json").string()));
+}
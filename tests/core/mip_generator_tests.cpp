@@ -0,0 +1,157 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "image_metrics.h"
+
+#include "core/mip_generator.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using MipGenerator::Filter;
+
+TEST_CASE(mipChainLevelSizes)
+{
+    CHECK(MipGenerator::getNumMips(1, 1) == 1);
+    CHECK(MipGenerator::getNumMips(2, 1) == 2);
+    CHECK(MipGenerator::getNumMips(16, 8) == 5);
+    CHECK(MipGenerator::getNumMips(13, 7) == 4);
+    CHECK(MipGenerator::getNumMips(1, 1024) == 11);
+
+    const std::vector<uint8_t> rgba = makeTestImage(13, 7, Harness::getSeed());
+    const std::vector<MipGenerator::MipLevel> mips =
+        MipGenerator::generateMips(rgba.data(), 13, 7, true, Filter::KAISER, 1);
+    REQUIRE(mips.size() == 4);
+    CHECK(mips[0].texels == rgba);
+
+    const uint32_t expectedSizes[4][2] = { { 13, 7 }, { 6, 3 }, { 3, 1 }, { 1, 1 } };
+    for (uint32_t mipIdx = 0; mipIdx < mips.size(); ++mipIdx)
+    {
+        CHECK(mips[mipIdx].width == expectedSizes[mipIdx][0]);
+        CHECK(mips[mipIdx].height == expectedSizes[mipIdx][1]);
+        CHECK(mips[mipIdx].texels.size() == mips[mipIdx].width * mips[mipIdx].height * 4);
+    }
+}
+
+TEST_CASE(mipChainKeepsConstantColors)
+{
+    static constexpr uint32_t WIDTH = 24;
+    static constexpr uint32_t HEIGHT = 10;
+    const uint8_t color[4] = { 200, 37, 91, 140 };
+    std::vector<uint8_t> rgba(WIDTH * HEIGHT * 4);
+    for (uint32_t texelIdx = 0; texelIdx < WIDTH * HEIGHT; ++texelIdx)
+    {
+        memcpy(&rgba[texelIdx * 4], color, 4);
+    }
+
+    for (const bool isSrgb : { false, true })
+    {
+        for (const Filter filter : { Filter::BOX, Filter::KAISER })
+        {
+            for (const MipGenerator::MipLevel& mip :
+                 MipGenerator::generateMips(rgba.data(), WIDTH, HEIGHT, isSrgb, filter, 1))
+            {
+                for (uint32_t texelIdx = 0; texelIdx < mip.width * mip.height; ++texelIdx)
+                {
+                    CHECK(memcmp(&mip.texels[texelIdx * 4], color, 4) == 0);
+                }
+            }
+        }
+    }
+}
+
+// Both filters are symmetric and normalized, so a linear gradient comes out as the same gradient sampled at each
+// level's texel centers. Anything that shifts or blurs texels off center shows up here.
+TEST_CASE(mipChainMeetsPsnrThresholdOnGradients)
+{
+    static constexpr uint32_t WIDTH = 64;
+    static constexpr uint32_t HEIGHT = 32;
+    const auto gradient = [](float x, float y, uint8_t* outRgba) {
+        outRgba[0] = static_cast<uint8_t>(std::lround(x * 4.f));
+        outRgba[1] = static_cast<uint8_t>(std::lround(y * 8.f));
+        outRgba[2] = static_cast<uint8_t>(std::lround((x + y) * 2.f));
+        outRgba[3] = 255;
+    };
+
+    std::vector<uint8_t> rgba(WIDTH * HEIGHT * 4);
+    for (uint32_t y = 0; y < HEIGHT; ++y)
+    {
+        for (uint32_t x = 0; x < WIDTH; ++x)
+        {
+            gradient(static_cast<float>(x), static_cast<float>(y), &rgba[(y * WIDTH + x) * 4]);
+        }
+    }
+
+    for (const Filter filter : { Filter::BOX, Filter::KAISER })
+    {
+        const std::vector<MipGenerator::MipLevel> mips =
+            MipGenerator::generateMips(rgba.data(), WIDTH, HEIGHT, false, filter, 1);
+        for (uint32_t mipIdx = 1; mipIdx < mips.size(); ++mipIdx)
+        {
+            const MipGenerator::MipLevel& mip = mips[mipIdx];
+            std::vector<uint8_t> expected(mip.texels.size());
+            for (uint32_t y = 0; y < mip.height; ++y)
+            {
+                for (uint32_t x = 0; x < mip.width; ++x)
+                {
+                    // this level's texel center in mip 0 texels
+                    const float x0 = (x + 0.5f) * WIDTH / mip.width - 0.5f;
+                    const float y0 = (y + 0.5f) * HEIGHT / mip.height - 0.5f;
+                    gradient(x0, y0, &expected[(y * mip.width + x) * 4]);
+                }
+            }
+
+            CHECK(computePsnr(expected.data(), mip.texels.data(), mip.width * mip.height, 0, 4) > 45.0);
+        }
+    }
+}
+
+// 2x2 black and white texels average to half intensity in linear space, which is 188 in sRGB rather than 128
+TEST_CASE(mipChainFiltersSrgbInLinearSpace)
+{
+    const uint8_t rgba[2 * 2 * 4] = {
+        0, 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 0,
+    };
+
+    const std::vector<MipGenerator::MipLevel> mips = MipGenerator::generateMips(rgba, 2, 2, true, Filter::BOX, 1);
+    REQUIRE(mips.size() == 2);
+    CHECK(mips[1].texels[0] == 188);
+    CHECK(mips[1].texels[1] == 188);
+    CHECK(mips[1].texels[2] == 188);
+    // alpha is always linear
+    CHECK(mips[1].texels[3] == 128);
+}
+
+TEST_CASE(mipChainIsIndependentOfThreadCount)
+{
+    const std::vector<uint8_t> rgba = makeTestImage(100, 60, Harness::getSeed());
+    for (const Filter filter : { Filter::BOX, Filter::KAISER })
+    {
+        const std::vector<MipGenerator::MipLevel> singleThreadMips =
+            MipGenerator::generateMips(rgba.data(), 100, 60, true, filter, 1);
+        const std::vector<MipGenerator::MipLevel> multiThreadMips =
+            MipGenerator::generateMips(rgba.data(), 100, 60, true, filter, 4);
+        REQUIRE(singleThreadMips.size() == multiThreadMips.size());
+        for (uint32_t mipIdx = 0; mipIdx < singleThreadMips.size(); ++mipIdx)
+        {
+            CHECK(singleThreadMips[mipIdx].texels == multiThreadMips[mipIdx].texels);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/paged_allocator.h"
+
+#include <vector>
+
+static constexpr uint64_t PAGE_SIZE_BYTES = 64 * 1024;
+static constexpr uint64_t ALIGNMENT_BYTES = 256;
+
+TEST_CASE(pagedAllocationsAreAlignedAndDisjoint)
+{
+    PagedAllocator allocator(PAGE_SIZE_BYTES, ALIGNMENT_BYTES);
+
+    std::vector<PagedAllocator::Allocation> allocations;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        uint32_t newPageIdx;
+        const PagedAllocator::Allocation allocation = allocator.allocate(1000 + i * 100, &newPageIdx);
+        REQUIRE(allocation.isValid());
+        CHECK(allocation.offsetBytes % ALIGNMENT_BYTES == 0);
+        CHECK(allocation.offsetBytes + allocation.sizeBytes <= allocator.getPageSizeBytes(allocation.pageIdx));
+
+        for (const PagedAllocator::Allocation& other : allocations)
+        {
+            if (other.pageIdx == allocation.pageIdx)
+            {
+                CHECK(allocation.offsetBytes + allocation.sizeBytes <= other.offsetBytes ||
+                      other.offsetBytes + other.sizeBytes <= allocation.offsetBytes);
+            }
+        }
+        allocations.push_back(allocation);
+    }
+
+    CHECK(allocator.getStats().numAllocations == 64);
+    CHECK(allocator.getStats().numPages > 1);
+}
+
+TEST_CASE(pagedDedicatedPageForLargeRequest)
+{
+    PagedAllocator allocator(PAGE_SIZE_BYTES, ALIGNMENT_BYTES);
+
+    uint32_t newPageIdx;
+    const PagedAllocator::Allocation allocation = allocator.allocate(PAGE_SIZE_BYTES * 3, &newPageIdx);
+    REQUIRE(allocation.isValid());
+    CHECK(newPageIdx == allocation.pageIdx);
+    CHECK(allocator.getPageSizeBytes(allocation.pageIdx) == PAGE_SIZE_BYTES * 3);
+
+    // dedicated pages are never kept once empty
+    CHECK(allocator.free(allocation));
+    CHECK(allocator.getStats().numPages == 0);
+    CHECK(allocator.getStats().reservedBytes == 0);
+}
+
+TEST_CASE(pagedKeepsOneEmptyPage)
+{
+    PagedAllocator allocator(PAGE_SIZE_BYTES, ALIGNMENT_BYTES);
+
+    // fill four pages
+    std::vector<PagedAllocator::Allocation> allocations;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        uint32_t newPageIdx;
+        allocations.push_back(allocator.allocate(PAGE_SIZE_BYTES / 4, &newPageIdx));
+        REQUIRE(allocations.back().isValid());
+    }
+    REQUIRE(allocator.getStats().numPages == 4);
+
+    // freeing everything releases all but one page
+    uint32_t numReleasedPages = 0;
+    for (const PagedAllocator::Allocation& allocation : allocations)
+    {
+        numReleasedPages += allocator.free(allocation) ? 1 : 0;
+    }
+    CHECK(numReleasedPages == 3);
+    CHECK(allocator.getStats().numPages == 1);
+    CHECK(allocator.getStats().usedBytes == 0);
+
+    // and the next allocation reuses it instead of creating a page
+    uint32_t newPageIdx;
+    const PagedAllocator::Allocation allocation = allocator.allocate(PAGE_SIZE_BYTES, &newPageIdx);
+    REQUIRE(allocation.isValid());
+    CHECK(newPageIdx == PagedAllocator::INVALID_PAGE_IDX);
+    CHECK(allocator.getStats().numPages == 1);
+
+    // once that page is in use again, another page emptying out is kept in its place
+    uint32_t otherNewPageIdx;
+    const PagedAllocator::Allocation other = allocator.allocate(100, &otherNewPageIdx);
+    REQUIRE(other.isValid());
+    CHECK(otherNewPageIdx != PagedAllocator::INVALID_PAGE_IDX);
+    CHECK(!allocator.free(other));
+    CHECK(allocator.getStats().numPages == 2);
+
+    // but a second empty page is released
+    CHECK(allocator.free(allocation));
+    CHECK(allocator.getStats().numPages == 1);
+}
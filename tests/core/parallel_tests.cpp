@@ -0,0 +1,129 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/parallel.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE(parallelForEachRunsEveryItemOnce)
+{
+    for (const uint32_t numThreads : { 0u, 1u, 2u, 4u, 16u })
+    {
+        for (const uint32_t numItems : { 0u, 1u, 3u, 1000u })
+        {
+            std::vector<std::atomic<uint32_t>> numCalls(numItems);
+            Parallel::forEach(numItems, numThreads, [&](uint32_t itemIdx) { ++numCalls[itemIdx]; });
+
+            for (const std::atomic<uint32_t>& itemNumCalls : numCalls)
+            {
+                CHECK(itemNumCalls == 1);
+            }
+        }
+    }
+}
+
+TEST_CASE(parallelForEachReusesItsThreads)
+{
+    std::mutex mutex;
+    std::set<std::thread::id> threadIds;
+
+    // every call can use up to 4 threads, and all but the caller come from the same pool every time
+    for (uint32_t callIdx = 0; callIdx < 200; ++callIdx)
+    {
+        Parallel::forEach(64, 4, [&](uint32_t) {
+            std::this_thread::yield();
+            std::lock_guard<std::mutex> lock(mutex);
+            threadIds.insert(std::this_thread::get_id());
+        });
+    }
+
+    // the pool is shared with the other cases, which may have grown it to 16 workers
+    CHECK(threadIds.size() <= 1 + 16);
+    CHECK(threadIds.count(std::this_thread::get_id()) == 1);
+}
+
+TEST_CASE(parallelForEachLimitsConcurrency)
+{
+    std::atomic<uint32_t> numRunning{ 0 };
+    std::atomic<uint32_t> maxNumRunning{ 0 };
+
+    Parallel::forEach(256, 3, [&](uint32_t) {
+        const uint32_t nowRunning = ++numRunning;
+        uint32_t prevMax = maxNumRunning.load();
+        while (nowRunning > prevMax && !maxNumRunning.compare_exchange_weak(prevMax, nowRunning))
+        {
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        --numRunning;
+    });
+
+    CHECK(maxNumRunning <= 3);
+}
+
+TEST_CASE(parallelForEachNests)
+{
+    // items that run forEach() themselves, like decoding images whose textures are then compressed in parallel
+    std::vector<std::atomic<uint32_t>> numCalls(16 * 64);
+    Parallel::forEach(16, 8, [&](uint32_t outerIdx) {
+        Parallel::forEach(64, 8, [&](uint32_t innerIdx) { ++numCalls[outerIdx * 64 + innerIdx]; });
+    });
+
+    for (const std::atomic<uint32_t>& itemNumCalls : numCalls)
+    {
+        CHECK(itemNumCalls == 1);
+    }
+}
+
+TEST_CASE(parallelForEachRethrowsFirstException)
+{
+    std::atomic<uint32_t> numCalls{ 0 };
+    bool hasThrown = false;
+    try
+    {
+        Parallel::forEach(10000, 4, [&](uint32_t itemIdx) {
+            ++numCalls;
+            if (itemIdx == 10)
+            {
+                throw std::runtime_error("item 10");
+            }
+        });
+    }
+    catch (const std::runtime_error& e)
+    {
+        hasThrown = std::string(e.what()) == "item 10";
+    }
+
+    CHECK(hasThrown);
+    // the remaining items are skipped
+    CHECK(numCalls < 10000);
+
+    // and the pool is still usable afterwards
+    std::atomic<uint32_t> numCallsAfter{ 0 };
+    Parallel::forEach(100, 4, [&](uint32_t) { ++numCallsAfter; });
+    CHECK(numCallsAfter == 100);
+}
@@ -0,0 +1,257 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/relocation_planner.h"
+#include "core/tlsf_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+struct LiveSection
+{
+    uint32_t blockIdx;
+    uint64_t offsetBytes;
+    uint64_t sizeBytes;
+    bool isPinned;
+};
+
+// A TlsfAllocator range plus a byte array standing in for the memory it manages, where every section is filled with
+// its owner's ID so that moves that lose or clobber data show up.
+class Arena
+{
+public:
+    TlsfAllocator allocator;
+    std::vector<uint8_t> memory;
+    std::unordered_map<uint32_t, LiveSection> sections;
+    uint32_t nextOwnerId{ 0 };
+
+    explicit Arena(uint64_t sizeBytes)
+        : memory(sizeBytes)
+    {
+        this->allocator.init(sizeBytes);
+    }
+
+    bool allocate(uint64_t sizeBytes, bool isPinned)
+    {
+        const TlsfAllocator::Allocation allocation = this->allocator.allocate(sizeBytes);
+        if (!allocation.isValid())
+        {
+            return false;
+        }
+
+        const uint32_t ownerId = this->nextOwnerId++;
+        if (!isPinned)
+        {
+            this->allocator.setBlockUserData(allocation.blockIdx, ownerId);
+        }
+
+        memset(this->memory.data() + allocation.offsetBytes, getFillByte(ownerId), allocation.sizeBytes);
+        this->sections[ownerId] = { allocation.blockIdx, allocation.offsetBytes, allocation.sizeBytes, isPinned };
+        return true;
+    }
+
+    void free(uint32_t ownerId)
+    {
+        const LiveSection& section = this->sections.at(ownerId);
+        this->allocator.free(section.blockIdx);
+        // poison the freed range so that reading it through a stale offset is caught
+        memset(this->memory.data() + section.offsetBytes, 0xff, section.sizeBytes);
+        this->sections.erase(ownerId);
+    }
+
+    // copies through a staging area like ManagedBuffer::copyRelocations() does, so relocations may overlap
+    void applyRelocations(const std::vector<RelocationPlanner::Relocation>& relocations)
+    {
+        std::vector<uint8_t> staging;
+        for (const RelocationPlanner::Relocation& relocation : relocations)
+        {
+            const uint8_t* src = this->memory.data() + relocation.srcOffsetBytes;
+            staging.insert(staging.end(), src, src + relocation.sizeBytes);
+        }
+
+        uint64_t stagingOffsetBytes = 0;
+        for (const RelocationPlanner::Relocation& relocation : relocations)
+        {
+            memcpy(this->memory.data() + relocation.dstOffsetBytes,
+                   staging.data() + stagingOffsetBytes,
+                   relocation.sizeBytes);
+            stagingOffsetBytes += relocation.sizeBytes;
+
+            LiveSection& section = this->sections.at(relocation.userData);
+            section.offsetBytes = relocation.dstOffsetBytes;
+        }
+    }
+
+    static uint8_t getFillByte(uint32_t ownerId)
+    {
+        return static_cast<uint8_t>(ownerId % 251);
+    }
+};
+
+} // namespace
+
+// every live section still holds its own bytes and no two sections overlap
+static void checkSectionsIntact(const Arena& arena)
+{
+    std::vector<LiveSection> sorted;
+    for (const auto& [ownerId, section] : arena.sections)
+    {
+        const TlsfAllocator::BlockInfo info = arena.allocator.getBlockInfo(section.blockIdx);
+        REQUIRE(!info.isFree);
+        REQUIRE(info.offsetBytes == section.offsetBytes);
+
+        const uint8_t fillByte = Arena::getFillByte(ownerId);
+        const uint8_t* data = arena.memory.data() + section.offsetBytes;
+        REQUIRE(std::all_of(data, data + section.sizeBytes, [=](uint8_t b) { return b == fillByte; }));
+
+        sorted.push_back(section);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const LiveSection& a, const LiveSection& b) {
+        return a.offsetBytes < b.offsetBytes;
+    });
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        REQUIRE(sorted[i - 1].offsetBytes + sorted[i - 1].sizeBytes <= sorted[i].offsetBytes);
+    }
+}
+
+TEST_CASE(relocationNothingToDoWithoutHoles)
+{
+    Arena arena(4096);
+    REQUIRE(arena.allocate(1000, false));
+    REQUIRE(arena.allocate(1000, false));
+
+    CHECK(!RelocationPlanner::hasHoles(arena.allocator));
+    CHECK(RelocationPlanner::planRelocations(arena.allocator, ~0ull).empty());
+}
+
+TEST_CASE(relocationRespectsBudgetAndPins)
+{
+    Arena arena(1 << 16);
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        REQUIRE(arena.allocate(1024, i == 9));
+    }
+
+    // free every other section, leaving holes everywhere
+    for (uint32_t ownerId = 0; ownerId < 16; ownerId += 2)
+    {
+        arena.free(ownerId);
+    }
+
+    std::vector<RelocationPlanner::Relocation> relocations = RelocationPlanner::planRelocations(arena.allocator, 2048);
+    CHECK(relocations.size() == 2);
+    arena.applyRelocations(relocations);
+    checkSectionsIntact(arena);
+
+    // a budget smaller than any section still makes progress
+    relocations = RelocationPlanner::planRelocations(arena.allocator, 1);
+    CHECK(relocations.size() == 1);
+    arena.applyRelocations(relocations);
+    checkSectionsIntact(arena);
+
+    relocations = RelocationPlanner::planRelocations(arena.allocator, ~0ull);
+    arena.applyRelocations(relocations);
+    checkSectionsIntact(arena);
+
+    // the pinned section never moved, so the holes in front of it can't all be closed
+    const LiveSection& pinned = arena.sections.at(9);
+    CHECK(pinned.offsetBytes == 9 * 1024);
+    for (const RelocationPlanner::Relocation& relocation : relocations)
+    {
+        CHECK(relocation.userData != 9);
+        CHECK(relocation.dstOffsetBytes < relocation.srcOffsetBytes);
+    }
+}
+
+TEST_CASE(relocationRandomTrace)
+{
+    std::mt19937 rng(Harness::getSeed());
+    std::uniform_int_distribution<uint64_t> sizeDist(16, 4096);
+
+    Arena arena(1 << 20);
+    for (uint32_t round = 0; round < 200; ++round)
+    {
+        // churn: mostly allocations early on, mostly frees later, so the range fills up and then empties out
+        const uint32_t allocPercent = round < 100 ? 70 : 35;
+        for (uint32_t step = 0; step < 100; ++step)
+        {
+            if (arena.sections.empty() || rng() % 100 < allocPercent)
+            {
+                arena.allocate(sizeDist(rng), rng() % 50 == 0);
+            }
+            else
+            {
+                auto it = arena.sections.begin();
+                std::advance(it, rng() % arena.sections.size());
+                arena.free(it->first);
+            }
+        }
+
+        // one frame's worth of compaction
+        const uint64_t maxMoveBytes = 16 * 1024;
+        const std::vector<RelocationPlanner::Relocation> relocations =
+            RelocationPlanner::planRelocations(arena.allocator, maxMoveBytes);
+
+        uint64_t movedBytes = 0;
+        for (const RelocationPlanner::Relocation& relocation : relocations)
+        {
+            CHECK(!arena.sections.at(relocation.userData).isPinned);
+            CHECK(relocation.dstOffsetBytes < relocation.srcOffsetBytes);
+            CHECK(relocation.sizeBytes == arena.sections.at(relocation.userData).sizeBytes);
+            movedBytes += relocation.sizeBytes;
+        }
+        CHECK(relocations.size() <= 1 || movedBytes <= maxMoveBytes);
+
+        arena.applyRelocations(relocations);
+        checkSectionsIntact(arena);
+    }
+
+    // with no more churn, compaction runs until only the pinned sections keep holes open
+    for (uint32_t frame = 0; frame < 10000; ++frame)
+    {
+        const std::vector<RelocationPlanner::Relocation> relocations =
+            RelocationPlanner::planRelocations(arena.allocator, 16 * 1024);
+        if (relocations.empty())
+        {
+            break;
+        }
+        arena.applyRelocations(relocations);
+    }
+    checkSectionsIntact(arena);
+
+    // every free range left is either the tail or sits right in front of a pinned section
+    for (uint32_t blockIdx = arena.allocator.getFirstBlockIdx(); blockIdx != TlsfAllocator::INVALID_BLOCK_IDX;)
+    {
+        const TlsfAllocator::BlockInfo info = arena.allocator.getBlockInfo(blockIdx);
+        if (info.isFree && info.nextPhysIdx != TlsfAllocator::INVALID_BLOCK_IDX)
+        {
+            CHECK(arena.allocator.getBlockInfo(info.nextPhysIdx).userData == TlsfAllocator::NO_USER_DATA);
+        }
+        blockIdx = info.nextPhysIdx;
+    }
+}
@@ -0,0 +1,127 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/retirement_queue.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// Stands in for an ID3D12Fence: the CPU signals increasing values as it submits work and the "GPU" completes them in
+// order some time later.
+class SimulatedFence
+{
+private:
+    uint64_t lastSignaledValue{ 0 };
+    uint64_t completedValue{ 0 };
+
+public:
+    uint64_t signal()
+    {
+        return ++this->lastSignaledValue;
+    }
+
+    // completes up to `numValues` more of the signaled values
+    void advance(uint64_t numValues)
+    {
+        this->completedValue = std::min(this->completedValue + numValues, this->lastSignaledValue);
+    }
+
+    uint64_t getCompletedValue() const
+    {
+        return this->completedValue;
+    }
+};
+
+// move-only like the ToFreeLists the renderer retires, and remembers which fence it was meant to wait for
+struct TrackedItem
+{
+    std::unique_ptr<uint64_t> fenceValue;
+};
+
+} // namespace
+
+TEST_CASE(retirementWaitsForFence)
+{
+    SimulatedFence fence;
+    RetirementQueue<TrackedItem> queue;
+
+    const uint64_t fenceValue = fence.signal();
+    queue.push(fenceValue, { std::make_unique<uint64_t>(fenceValue) });
+
+    // a scene load or resize right after submitting doesn't have to wait; the item just stays queued
+    uint32_t numRetired = 0;
+    queue.drain(fence.getCompletedValue(), [&](TrackedItem&) { ++numRetired; });
+    CHECK(numRetired == 0);
+    CHECK(queue.getSize() == 1);
+
+    fence.advance(1);
+    queue.drain(fence.getCompletedValue(), [&](TrackedItem&) { ++numRetired; });
+    CHECK(numRetired == 1);
+    CHECK(queue.isEmpty());
+}
+
+TEST_CASE(retirementSimulatedFrames)
+{
+    std::mt19937 rng(Harness::getSeed());
+
+    SimulatedFence fence;
+    RetirementQueue<TrackedItem> queue;
+
+    uint64_t numPushed = 0;
+    uint64_t numRetired = 0;
+    uint64_t lastRetiredFenceValue = 0;
+
+    const auto retire = [&](TrackedItem& item) {
+        // never before the GPU is done with it, and in submission order
+        REQUIRE(*item.fenceValue <= fence.getCompletedValue());
+        REQUIRE(*item.fenceValue >= lastRetiredFenceValue);
+        lastRetiredFenceValue = *item.fenceValue;
+        ++numRetired;
+    };
+
+    for (uint32_t frame = 0; frame < 10000; ++frame)
+    {
+        // some frames retire several things (e.g. a scene swap), some nothing
+        const uint64_t fenceValue = fence.signal();
+        const uint32_t numItems = rng() % 4;
+        for (uint32_t i = 0; i < numItems; ++i)
+        {
+            queue.push(fenceValue, { std::make_unique<uint64_t>(fenceValue) });
+            ++numPushed;
+        }
+
+        // the GPU sometimes stalls and sometimes catches up several frames at once
+        fence.advance(rng() % 3);
+        queue.drain(fence.getCompletedValue(), retire);
+
+        // nothing is lost or retired twice
+        CHECK(numPushed - numRetired == queue.getSize());
+    }
+
+    // shutdown drains whatever is left without waiting for the fence
+    queue.drainAll([&](TrackedItem&) { ++numRetired; });
+    CHECK(queue.isEmpty());
+    CHECK(numRetired == numPushed);
+}
@@ -0,0 +1,190 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/ring_allocator.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+TEST_CASE(ringWrapsAndReclaimsByFence)
+{
+    RingAllocator ring;
+    ring.init(1024);
+
+    CHECK(ring.allocate(400, 1) == 0);
+    CHECK(ring.allocate(400, 1) == 400);
+    ring.submit(1);
+
+    // only 224 bytes left at the end and nothing reclaimed at the front yet
+    CHECK(ring.allocate(300, 1) == RingAllocator::INVALID_OFFSET);
+    CHECK(ring.getUsedBytes() == 800);
+
+    ring.reclaim(0);
+    CHECK(ring.getUsedBytes() == 800);
+
+    // a new submission whose fence hasn't been reached keeps the front of the ring pinned
+    CHECK(ring.allocate(100, 1) == 800);
+    ring.submit(2);
+    ring.reclaim(1);
+    CHECK(ring.getUsedBytes() == 100);
+
+    // doesn't fit behind the head, so it wraps to the front; the skipped tail end counts as used until reclaimed
+    CHECK(ring.allocate(300, 1) == 0);
+    CHECK(ring.getUsedBytes() == 100 + 124 + 300);
+    ring.submit(3);
+
+    ring.reclaim(3);
+    CHECK(ring.getUsedBytes() == 0);
+}
+
+TEST_CASE(ringLargestFreeSize)
+{
+    RingAllocator ring;
+    ring.init(1024);
+    CHECK(ring.getLargestFreeSizeBytes() == 1024);
+
+    ring.allocate(300, 1);
+    ring.submit(1);
+    ring.allocate(500, 1);
+    ring.submit(2);
+    CHECK(ring.getLargestFreeSizeBytes() == 224);
+
+    // the reclaimed front is larger than what's left at the end
+    ring.reclaim(1);
+    CHECK(ring.getLargestFreeSizeBytes() == 300);
+    CHECK(ring.allocate(300, 1) == 0);
+
+    // now the free space is the single gap between head and tail
+    CHECK(ring.getLargestFreeSizeBytes() == 0);
+    // the end skipped by the wrap belongs to the unsubmitted allocation, so it isn't free yet
+    ring.reclaim(2);
+    CHECK(ring.getLargestFreeSizeBytes() == 500);
+}
+
+TEST_CASE(ringAlignment)
+{
+    RingAllocator ring;
+    ring.init(4096);
+
+    CHECK(ring.allocate(3, 1) == 0);
+    CHECK(ring.allocate(16, 256) == 256);
+    CHECK(ring.allocate(1, 512) == 512);
+    CHECK(ring.getUsedBytes() == 513);
+}
+
+TEST_CASE(ringFullAndEmpty)
+{
+    RingAllocator ring;
+    ring.init(1024);
+
+    // an exactly full ring can't hand out anything, not even zero bytes at the head
+    CHECK(ring.allocate(1024, 1) == 0);
+    CHECK(ring.allocate(1, 1) == RingAllocator::INVALID_OFFSET);
+    ring.submit(1);
+    CHECK(ring.allocate(1, 1) == RingAllocator::INVALID_OFFSET);
+
+    // once everything is reclaimed it starts over from the beginning, so the whole range is available again
+    ring.reclaim(1);
+    CHECK(ring.allocate(1024, 1) == 0);
+
+    // submitting with nothing allocated since the last submit doesn't create an empty submission
+    ring.submit(2);
+    ring.submit(3);
+    ring.reclaim(2);
+    CHECK(ring.getUsedBytes() == 0);
+}
+
+// Simulates frames in flight: every frame allocates a random amount of staging space and submits it with the next
+// fence value, and the "GPU" completes fences a few frames behind. Checks that nothing handed out overlaps anything
+// whose fence hasn't completed.
+TEST_CASE(ringSimulatedFrames)
+{
+    struct LiveRange
+    {
+        uint64_t offsetBytes;
+        uint64_t sizeBytes;
+        uint64_t fenceValue;
+    };
+
+    std::mt19937 rng(Harness::getSeed());
+
+    static constexpr uint64_t RING_SIZE_BYTES = 64 * 1024;
+    RingAllocator ring;
+    ring.init(RING_SIZE_BYTES);
+
+    std::deque<LiveRange> live;
+    uint64_t fenceValue = 0;
+    uint64_t completedFenceValue = 0;
+    uint32_t numFailed = 0;
+
+    for (uint32_t frame = 0; frame < 5000; ++frame)
+    {
+        ++fenceValue;
+
+        const uint32_t numAllocations = rng() % 8;
+        for (uint32_t i = 0; i < numAllocations; ++i)
+        {
+            const uint64_t sizeBytes = 1 + rng() % 8192;
+            const uint64_t alignmentBytes = uint64_t(1) << (rng() % 10);
+            const uint64_t usedBytesBefore = ring.getUsedBytes();
+
+            const uint64_t offsetBytes = ring.allocate(sizeBytes, alignmentBytes);
+            if (offsetBytes == RingAllocator::INVALID_OFFSET)
+            {
+                CHECK(ring.getUsedBytes() == usedBytesBefore);
+                ++numFailed;
+                continue;
+            }
+
+            REQUIRE(offsetBytes % alignmentBytes == 0);
+            REQUIRE(offsetBytes + sizeBytes <= RING_SIZE_BYTES);
+            for (const LiveRange& range : live)
+            {
+                REQUIRE(offsetBytes + sizeBytes <= range.offsetBytes ||
+                        range.offsetBytes + range.sizeBytes <= offsetBytes);
+            }
+
+            live.push_back({ offsetBytes, sizeBytes, fenceValue });
+        }
+
+        ring.submit(fenceValue);
+
+        // the GPU lags 1-3 frames behind
+        const uint64_t lag = 1 + rng() % 3;
+        if (fenceValue > lag && fenceValue - lag > completedFenceValue)
+        {
+            completedFenceValue = fenceValue - lag;
+            ring.reclaim(completedFenceValue);
+            while (!live.empty() && live.front().fenceValue <= completedFenceValue)
+            {
+                live.pop_front();
+            }
+        }
+
+        CHECK(ring.getUsedBytes() <= RING_SIZE_BYTES);
+    }
+
+    // the ring is sized so that it occasionally overflows, which is when the caller grows it
+    CHECK(numFailed > 0);
+
+    ring.reclaim(fenceValue);
+    CHECK(ring.getUsedBytes() == 0);
+}
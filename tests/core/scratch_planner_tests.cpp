@@ -0,0 +1,187 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/scratch_planner.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using ScratchPlanner::Batch;
+using ScratchPlanner::Placement;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignmentBytes)
+{
+    return (value + alignmentBytes - 1) & ~(alignmentBytes - 1);
+}
+
+// Checks everything a plan has to satisfy to be executed out of one shared scratch buffer: every build placed once,
+// aligned ranges that don't overlap within a batch, and batches within the budget unless a single build is too large.
+static void checkPlan(const std::vector<uint64_t>& scratchSizesBytes,
+                      uint64_t budgetBytes,
+                      uint64_t alignmentBytes,
+                      const std::vector<Batch>& batches)
+{
+    std::vector<uint32_t> numPlacementsPerBuild(scratchSizesBytes.size(), 0);
+    uint64_t maxBatchSizeBytes = 0;
+    for (const Batch& batch : batches)
+    {
+        CHECK(!batch.placements.empty());
+        CHECK(batch.scratchSizeBytes <= budgetBytes || batch.placements.size() == 1);
+        maxBatchSizeBytes = std::max(batch.scratchSizeBytes, maxBatchSizeBytes);
+
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        for (uint32_t placementIdx = 0; placementIdx < batch.placements.size(); ++placementIdx)
+        {
+            const Placement& placement = batch.placements[placementIdx];
+            REQUIRE(placement.buildIdx < scratchSizesBytes.size());
+            ++numPlacementsPerBuild[placement.buildIdx];
+
+            CHECK(placement.scratchOffsetBytes % alignmentBytes == 0);
+            const uint64_t endBytes = placement.scratchOffsetBytes + scratchSizesBytes[placement.buildIdx];
+            CHECK(endBytes <= batch.scratchSizeBytes);
+            ranges.emplace_back(placement.scratchOffsetBytes, endBytes);
+
+            if (placementIdx > 0)
+            {
+                CHECK(batch.placements[placementIdx - 1].buildIdx < placement.buildIdx);
+            }
+        }
+
+        std::sort(ranges.begin(), ranges.end());
+        for (uint32_t rangeIdx = 1; rangeIdx < ranges.size(); ++rangeIdx)
+        {
+            CHECK(ranges[rangeIdx - 1].second <= ranges[rangeIdx].first);
+        }
+    }
+
+    for (const uint32_t numPlacements : numPlacementsPerBuild)
+    {
+        CHECK(numPlacements == 1);
+    }
+
+    CHECK(ScratchPlanner::getRequiredScratchSize(batches) == maxBatchSizeBytes);
+}
+
+TEST_CASE(scratchPlannerEmpty)
+{
+    const std::vector<Batch> batches = ScratchPlanner::planBatches({}, 1024, 256);
+    CHECK(batches.empty());
+    CHECK(ScratchPlanner::getRequiredScratchSize(batches) == 0);
+}
+
+TEST_CASE(scratchPlannerFirstFitDecreasing)
+{
+    // aligned to 512, 256 and 256; the largest fills the first batch and the other two share the second
+    const std::vector<uint64_t> scratchSizesBytes = { 100, 300, 200 };
+    const std::vector<Batch> batches = ScratchPlanner::planBatches(scratchSizesBytes, 512, 256);
+    checkPlan(scratchSizesBytes, 512, 256, batches);
+
+    REQUIRE(batches.size() == 2);
+    REQUIRE(batches[0].placements.size() == 1);
+    CHECK(batches[0].placements[0].buildIdx == 1);
+    CHECK(batches[0].scratchSizeBytes == 512);
+
+    // the larger of the two is placed first
+    REQUIRE(batches[1].placements.size() == 2);
+    CHECK(batches[1].placements[0].buildIdx == 0);
+    CHECK(batches[1].placements[0].scratchOffsetBytes == 256);
+    CHECK(batches[1].placements[1].buildIdx == 2);
+    CHECK(batches[1].placements[1].scratchOffsetBytes == 0);
+
+    CHECK(ScratchPlanner::getRequiredScratchSize(batches) == 512);
+}
+
+TEST_CASE(scratchPlannerOversizedBuildGetsItsOwnBatch)
+{
+    const std::vector<uint64_t> scratchSizesBytes = { 10, 1000, 10 };
+    const std::vector<Batch> batches = ScratchPlanner::planBatches(scratchSizesBytes, 256, 16);
+    checkPlan(scratchSizesBytes, 256, 16, batches);
+
+    REQUIRE(batches.size() == 2);
+    REQUIRE(batches[0].placements.size() == 1);
+    CHECK(batches[0].placements[0].buildIdx == 1);
+    CHECK(batches[0].scratchSizeBytes == 1008);
+    CHECK(batches[1].placements.size() == 2);
+    CHECK(batches[1].scratchSizeBytes == 32);
+
+    // the shared buffer has to grow to fit the oversized build
+    CHECK(ScratchPlanner::getRequiredScratchSize(batches) == 1008);
+}
+
+TEST_CASE(scratchPlannerRandomInputs)
+{
+    std::mt19937_64 rng(Harness::getSeed());
+
+    for (uint32_t iteration = 0; iteration < 500; ++iteration)
+    {
+        const uint64_t alignmentBytes = 1ull << (rng() % 9);
+        const uint64_t budgetBytes = 1 + rng() % (1 << 16);
+
+        std::vector<uint64_t> scratchSizesBytes(rng() % 64);
+        for (uint64_t& sizeBytes : scratchSizesBytes)
+        {
+            // mostly builds that fit, with the occasional one over budget
+            sizeBytes = rng() % 8 == 0 ? budgetBytes + rng() % budgetBytes : 1 + rng() % (budgetBytes / 2 + 1);
+        }
+
+        const std::vector<Batch> batches = ScratchPlanner::planBatches(scratchSizesBytes, budgetBytes, alignmentBytes);
+        checkPlan(scratchSizesBytes, budgetBytes, alignmentBytes, batches);
+
+        // each batch holds exactly the aligned sizes of its builds, back to back
+        for (const Batch& batch : batches)
+        {
+            uint64_t alignedSizeBytes = 0;
+            for (const Placement& placement : batch.placements)
+            {
+                alignedSizeBytes += alignUp(scratchSizesBytes[placement.buildIdx], alignmentBytes);
+            }
+            CHECK(batch.scratchSizeBytes == alignedSizeBytes);
+        }
+
+        // First fit never opens a batch while an earlier one still has room for what goes in it, so no two batches
+        // could have been merged. This also bounds the batch count to about twice the optimum.
+        for (uint32_t batchIdx = 0; batchIdx < batches.size(); ++batchIdx)
+        {
+            for (uint32_t laterBatchIdx = batchIdx + 1; laterBatchIdx < batches.size(); ++laterBatchIdx)
+            {
+                CHECK(batches[batchIdx].scratchSizeBytes + batches[laterBatchIdx].scratchSizeBytes > budgetBytes);
+            }
+        }
+
+        // the plan only depends on the input sizes
+        const std::vector<Batch> replannedBatches =
+            ScratchPlanner::planBatches(scratchSizesBytes, budgetBytes, alignmentBytes);
+        REQUIRE(replannedBatches.size() == batches.size());
+        for (uint32_t batchIdx = 0; batchIdx < batches.size(); ++batchIdx)
+        {
+            const std::vector<Placement>& placements = batches[batchIdx].placements;
+            const std::vector<Placement>& replannedPlacements = replannedBatches[batchIdx].placements;
+            REQUIRE(placements.size() == replannedPlacements.size());
+            for (uint32_t placementIdx = 0; placementIdx < placements.size(); ++placementIdx)
+            {
+                const Placement& placement = placements[placementIdx];
+                const Placement& replannedPlacement = replannedPlacements[placementIdx];
+                CHECK(placement.buildIdx == replannedPlacement.buildIdx);
+                CHECK(placement.scratchOffsetBytes == replannedPlacement.scratchOffsetBytes);
+            }
+        }
+    }
+}
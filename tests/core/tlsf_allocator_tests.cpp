@@ -0,0 +1,225 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/tlsf_allocator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Walks the physical block list and checks that it tiles [0, getSizeBytes()) without gaps or overlaps, that no two
+// free blocks are adjacent (they should have been merged) and that the counters match what the walk found.
+static void checkConsistent(const TlsfAllocator& allocator)
+{
+    uint64_t expectedOffsetBytes = 0;
+    uint64_t usedBytes = 0;
+    uint32_t numUsedBlocks = 0;
+    uint32_t numFreeBlocks = 0;
+    bool wasPrevFree = false;
+
+    for (uint32_t blockIdx = allocator.getFirstBlockIdx(); blockIdx != TlsfAllocator::INVALID_BLOCK_IDX;)
+    {
+        const TlsfAllocator::BlockInfo info = allocator.getBlockInfo(blockIdx);
+        REQUIRE(info.offsetBytes == expectedOffsetBytes);
+        REQUIRE(info.sizeBytes > 0);
+        CHECK(!(info.isFree && wasPrevFree));
+
+        if (info.isFree)
+        {
+            ++numFreeBlocks;
+        }
+        else
+        {
+            ++numUsedBlocks;
+            usedBytes += info.sizeBytes;
+        }
+
+        wasPrevFree = info.isFree;
+        expectedOffsetBytes += info.sizeBytes;
+        blockIdx = info.nextPhysIdx;
+    }
+
+    CHECK(expectedOffsetBytes == allocator.getSizeBytes());
+    CHECK(usedBytes == allocator.getUsedBytes());
+    CHECK(numUsedBlocks == allocator.getNumUsedBlocks());
+    CHECK(numFreeBlocks == allocator.getNumFreeBlocks());
+}
+
+TEST_CASE(tlsfAllocateAndFreeMerges)
+{
+    TlsfAllocator allocator;
+    allocator.init(4096);
+
+    const TlsfAllocator::Allocation a = allocator.allocate(100);
+    const TlsfAllocator::Allocation b = allocator.allocate(200);
+    const TlsfAllocator::Allocation c = allocator.allocate(300);
+    REQUIRE(a.isValid() && b.isValid() && c.isValid());
+    CHECK(a.sizeBytes >= 100 && b.sizeBytes >= 200 && c.sizeBytes >= 300);
+    CHECK(allocator.getNumUsedBlocks() == 3);
+    checkConsistent(allocator);
+
+    // freeing the middle block leaves a hole; freeing its neighbours merges everything back into one block
+    allocator.free(b.blockIdx);
+    CHECK(allocator.getNumFreeBlocks() == 2);
+    checkConsistent(allocator);
+
+    allocator.free(a.blockIdx);
+    allocator.free(c.blockIdx);
+    CHECK(allocator.getNumFreeBlocks() == 1);
+    CHECK(allocator.getUsedBytes() == 0);
+    CHECK(allocator.getLargestFreeSizeBytes() == 4096);
+    checkConsistent(allocator);
+}
+
+TEST_CASE(tlsfExactFitOfWholeRange)
+{
+    // 1000 isn't on a second-level boundary, so the rounded-up search alone would miss the only free block
+    TlsfAllocator allocator;
+    allocator.init(1000);
+
+    TlsfAllocator::Allocation allocation = allocator.allocate(1000);
+    REQUIRE(allocation.isValid());
+    CHECK(allocation.offsetBytes == 0);
+    CHECK(!allocator.allocate(1).isValid());
+
+    allocator.free(allocation.blockIdx);
+    allocation = allocator.allocate(1000);
+    CHECK(allocation.isValid());
+    checkConsistent(allocator);
+}
+
+TEST_CASE(tlsfRejectsZeroAndOversizedRequests)
+{
+    TlsfAllocator allocator;
+    allocator.init(256);
+
+    CHECK(!allocator.allocate(0).isValid());
+    CHECK(!allocator.allocate(257).isValid());
+    CHECK(!allocator.allocate(~0ull).isValid());
+    CHECK(allocator.getUsedBytes() == 0);
+    checkConsistent(allocator);
+}
+
+TEST_CASE(tlsfGrowAndShrink)
+{
+    TlsfAllocator allocator;
+    allocator.init(1024);
+
+    const TlsfAllocator::Allocation a = allocator.allocate(512);
+    REQUIRE(a.isValid());
+
+    // the new space merges with the free tail
+    allocator.grow(4096);
+    CHECK(allocator.getNumFreeBlocks() == 1);
+    CHECK(allocator.getTailFreeSizeBytes() == 4096 - a.sizeBytes);
+    checkConsistent(allocator);
+
+    const TlsfAllocator::Allocation b = allocator.allocate(4096 - a.sizeBytes);
+    REQUIRE(b.isValid());
+    CHECK(allocator.getTailFreeSizeBytes() == 0);
+    CHECK(!allocator.shrink(2048));
+
+    allocator.free(b.blockIdx);
+    CHECK(allocator.shrink(2048));
+    CHECK(allocator.getSizeBytes() == 2048);
+    CHECK(allocator.shrink(a.sizeBytes));
+    CHECK(allocator.getNumFreeBlocks() == 0);
+    checkConsistent(allocator);
+}
+
+TEST_CASE(tlsfSlideBlockDown)
+{
+    TlsfAllocator allocator;
+    allocator.init(4096);
+
+    const TlsfAllocator::Allocation a = allocator.allocate(256);
+    const TlsfAllocator::Allocation b = allocator.allocate(512);
+    REQUIRE(a.isValid() && b.isValid());
+    allocator.setBlockUserData(b.blockIdx, 7);
+
+    allocator.free(a.blockIdx);
+    CHECK(allocator.slideBlockDown(b.blockIdx) == 0);
+
+    const TlsfAllocator::BlockInfo info = allocator.getBlockInfo(b.blockIdx);
+    CHECK(info.offsetBytes == 0);
+    CHECK(info.userData == 7);
+    CHECK(allocator.getNumFreeBlocks() == 1);
+    CHECK(allocator.getTailFreeSizeBytes() == 4096 - b.sizeBytes);
+    checkConsistent(allocator);
+}
+
+TEST_CASE(tlsfRandomTrace)
+{
+    std::mt19937 rng(Harness::getSeed());
+    std::uniform_int_distribution<uint64_t> sizeDist(1, 4096);
+
+    TlsfAllocator allocator;
+    allocator.init(1 << 20);
+
+    std::vector<TlsfAllocator::Allocation> live;
+    for (uint32_t step = 0; step < 20000; ++step)
+    {
+        if (live.empty() || rng() % 100 < 55)
+        {
+            const uint64_t sizeBytes = sizeDist(rng);
+            const TlsfAllocator::Allocation allocation = allocator.allocate(sizeBytes);
+            if (allocation.isValid())
+            {
+                REQUIRE(allocation.sizeBytes >= sizeBytes);
+                REQUIRE(allocation.offsetBytes + allocation.sizeBytes <= allocator.getSizeBytes());
+                live.push_back(allocation);
+            }
+            else
+            {
+                // only allowed to fail when no size class that is guaranteed to fit has a free block
+                CHECK(allocator.getLargestFreeSizeBytes() < sizeBytes * 2);
+            }
+        }
+        else
+        {
+            const size_t liveIdx = rng() % live.size();
+            allocator.free(live[liveIdx].blockIdx);
+            live[liveIdx] = live.back();
+            live.pop_back();
+        }
+
+        if (step % 1000 == 0)
+        {
+            checkConsistent(allocator);
+
+            std::vector<TlsfAllocator::Allocation> sorted = live;
+            std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+                return a.offsetBytes < b.offsetBytes;
+            });
+            for (size_t i = 1; i < sorted.size(); ++i)
+            {
+                REQUIRE(sorted[i - 1].offsetBytes + sorted[i - 1].sizeBytes <= sorted[i].offsetBytes);
+            }
+        }
+    }
+
+    for (const TlsfAllocator::Allocation& allocation : live)
+    {
+        allocator.free(allocation.blockIdx);
+    }
+    CHECK(allocator.getUsedBytes() == 0);
+    CHECK(allocator.getNumFreeBlocks() == 1);
+    checkConsistent(allocator);
+}
@@ -0,0 +1,161 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include "core/vertex_packing.h"
+
+#include <cmath>
+#include <random>
+
+TEST_CASE(halfRoundTripsEveryValue)
+{
+    for (uint32_t half = 0; half <= 0xffff; ++half)
+    {
+        const float value = VertexPacking::halfToFloat(static_cast<uint16_t>(half));
+        const uint16_t repacked = VertexPacking::floatToHalf(value);
+
+        const bool isNan = (half & 0x7c00) == 0x7c00 && (half & 0x3ff) != 0;
+        if (isNan)
+        {
+            CHECK(std::isnan(value));
+            CHECK((repacked & 0x7c00) == 0x7c00 && (repacked & 0x3ff) != 0);
+        }
+        else
+        {
+            CHECK(repacked == half);
+        }
+    }
+}
+
+TEST_CASE(halfRoundsToNearestEven)
+{
+    CHECK(VertexPacking::floatToHalf(1.f) == 0x3c00);
+    CHECK(VertexPacking::floatToHalf(-2.f) == 0xc000);
+    CHECK(VertexPacking::floatToHalf(-0.f) == 0x8000);
+
+    // halfway between 1 and the next half rounds down to the even mantissa, 3 quarter-steps round up
+    CHECK(VertexPacking::floatToHalf(1.f + std::ldexp(1.f, -11)) == 0x3c00);
+    CHECK(VertexPacking::floatToHalf(1.f + 3.f * std::ldexp(1.f, -11)) == 0x3c02);
+
+    // the largest half, and where rounding tips over into infinity
+    CHECK(VertexPacking::floatToHalf(65504.f) == 0x7bff);
+    CHECK(VertexPacking::floatToHalf(65519.f) == 0x7bff);
+    CHECK(VertexPacking::floatToHalf(65520.f) == 0x7c00);
+    CHECK(VertexPacking::floatToHalf(1e10f) == 0x7c00);
+    CHECK(VertexPacking::floatToHalf(-INFINITY) == 0xfc00);
+
+    // denormals are in units of 2^-24
+    CHECK(VertexPacking::floatToHalf(std::ldexp(1.f, -24)) == 0x0001);
+    CHECK(VertexPacking::floatToHalf(std::ldexp(1.f, -25)) == 0x0000);
+    CHECK(VertexPacking::floatToHalf(1.5f * std::ldexp(1.f, -24)) == 0x0002);
+    CHECK(VertexPacking::floatToHalf(std::ldexp(1.f, -14) - std::ldexp(1.f, -25)) == 0x0400);
+}
+
+TEST_CASE(halfErrorWithinHalfAnUlp)
+{
+    std::mt19937 rng(Harness::getSeed());
+    std::uniform_real_distribution<float> exponentDist(-14.f, 15.f);
+
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        const float value = (rng() & 1 ? -1.f : 1.f) * std::exp2(exponentDist(rng));
+        const float roundTripped = VertexPacking::halfToFloat(VertexPacking::floatToHalf(value));
+
+        // normal halves have 10 mantissa bits
+        const float halfUlp = std::ldexp(1.f, std::ilogb(value) - 11);
+        CHECK(std::abs(roundTripped - value) <= halfUlp);
+    }
+}
+
+TEST_CASE(half2PacksXInLowBits)
+{
+    const uint32_t packed = VertexPacking::packHalf2(1.f, -2.f);
+    CHECK(packed == (0x3c00u | (0xc000u << 16)));
+
+    float xy[2];
+    VertexPacking::unpackHalf2(packed, xy);
+    CHECK(xy[0] == 1.f);
+    CHECK(xy[1] == -2.f);
+}
+
+TEST_CASE(octahedralNormalRoundTrip)
+{
+    // decoded normals are unit length and within about 0.05 degrees of the original
+    const float minCosAngle = std::cos(0.05f * 3.14159265f / 180.f);
+
+    auto checkRoundTrip = [&](float x, float y, float z) {
+        const float invLength = 1.f / std::sqrt(x * x + y * y + z * z);
+
+        float decoded[3];
+        VertexPacking::unpackOctahedralNormal(VertexPacking::packOctahedralNormal(x, y, z), decoded);
+
+        const float length = std::sqrt(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]);
+        CHECK(std::abs(length - 1.f) < 1e-5f);
+
+        const float cosAngle = (decoded[0] * x + decoded[1] * y + decoded[2] * z) * invLength;
+        CHECK(cosAngle >= minCosAngle);
+    };
+
+    // axes and the folded edges of the octahedron
+    checkRoundTrip(1.f, 0.f, 0.f);
+    checkRoundTrip(-1.f, 0.f, 0.f);
+    checkRoundTrip(0.f, 1.f, 0.f);
+    checkRoundTrip(0.f, -1.f, 0.f);
+    checkRoundTrip(0.f, 0.f, 1.f);
+    checkRoundTrip(0.f, 0.f, -1.f);
+    checkRoundTrip(1.f, 1.f, 0.f);
+    checkRoundTrip(-1.f, 1.f, -1e-6f);
+    checkRoundTrip(1.f, -1.f, -1.f);
+
+    // the input doesn't have to be normalized
+    checkRoundTrip(0.f, 0.f, 1000.f);
+    checkRoundTrip(0.001f, -0.002f, -0.003f);
+
+    std::mt19937 rng(Harness::getSeed());
+    std::normal_distribution<float> dist;
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        const float x = dist(rng);
+        const float y = dist(rng);
+        const float z = dist(rng);
+        if (x * x + y * y + z * z < 1e-6f)
+        {
+            continue;
+        }
+
+        checkRoundTrip(x, y, z);
+    }
+}
+
+TEST_CASE(octahedralNormalAxesAreExact)
+{
+    float decoded[3];
+
+    VertexPacking::unpackOctahedralNormal(VertexPacking::packOctahedralNormal(0.f, 0.f, 1.f), decoded);
+    CHECK(decoded[0] == 0.f && decoded[1] == 0.f && decoded[2] == 1.f);
+
+    VertexPacking::unpackOctahedralNormal(VertexPacking::packOctahedralNormal(0.f, 0.f, -1.f), decoded);
+    CHECK(std::abs(decoded[0]) == 0.f && std::abs(decoded[1]) == 0.f && decoded[2] == -1.f);
+
+    VertexPacking::unpackOctahedralNormal(VertexPacking::packOctahedralNormal(1.f, 0.f, 0.f), decoded);
+    CHECK(decoded[0] == 1.f && decoded[1] == 0.f && decoded[2] == 0.f);
+
+    // -0 and +0 both count as positive, so the upper hemisphere's encoding doesn't depend on the sign of zero
+    CHECK(VertexPacking::packOctahedralNormal(0.f, 0.f, 1.f) == VertexPacking::packOctahedralNormal(-0.f, -0.f, 1.f));
+}
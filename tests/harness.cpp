@@ -0,0 +1,126 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+namespace Harness
+{
+
+struct Case
+{
+    const char* name;
+    CaseFn fn;
+};
+
+// function-local so that registration from other translation units' static initializers is safe
+static std::vector<Case>& getCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+static uint32_t numCurrentFailures = 0;
+static uint32_t currentSeed = 0;
+
+Registrar::Registrar(const char* name, CaseFn fn)
+{
+    getCases().push_back({ name, fn });
+}
+
+void reportFailure(const char* file, int line, const char* expr)
+{
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    ++numCurrentFailures;
+}
+
+uint32_t getSeed()
+{
+    return currentSeed;
+}
+
+// FNV-1a of the case name
+static uint32_t hashName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; ++c)
+    {
+        hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+    }
+    return hash;
+}
+
+} // namespace Harness
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    uint32_t numRun = 0;
+    uint32_t numFailed = 0;
+    for (const Harness::Case& testCase : Harness::getCases())
+    {
+        if (filter != nullptr && strstr(testCase.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        printf("[ RUN  ] %s\n", testCase.name);
+        fflush(stdout);
+
+        Harness::numCurrentFailures = 0;
+        Harness::currentSeed = Harness::hashName(testCase.name);
+
+        const auto startTime = std::chrono::steady_clock::now();
+        try
+        {
+            testCase.fn();
+        }
+        catch (const Harness::RequireFailure&)
+        {
+            // already reported
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "unexpected exception: %s\n", e.what());
+            ++Harness::numCurrentFailures;
+        }
+        const auto elapsedMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+
+        ++numRun;
+        if (Harness::numCurrentFailures > 0)
+        {
+            ++numFailed;
+        }
+
+        printf("[ %s ] %s (%lld ms)\n",
+               Harness::numCurrentFailures == 0 ? " OK " : "FAIL",
+               testCase.name,
+               static_cast<long long>(elapsedMs.count()));
+        fflush(stdout);
+    }
+
+    printf("%u of %u passed\n", numRun - numFailed, numRun);
+    return numFailed == 0 && numRun > 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+// Minimal self-registering test cases and benchmarks, so that the host-side checks don't need a third-party
+// framework. Every executable built from tests/ links harness.cpp, which provides main(): it runs every registered
+// case whose name contains the first command line argument (or all of them) and returns nonzero if any failed.
+namespace Harness
+{
+
+using CaseFn = void (*)();
+
+struct Registrar
+{
+    Registrar(const char* name, CaseFn fn);
+};
+
+// thrown by REQUIRE() to abandon the current case
+struct RequireFailure : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+void reportFailure(const char* file, int line, const char* expr);
+
+// deterministic per-case seed, so that a randomized case that fails can be rerun with the same inputs
+uint32_t getSeed();
+
+} // namespace Harness
+
+#define HARNESS_CASE(name)                                            \
+    static void name();                                               \
+    static const Harness::Registrar name##Registrar(#name, &name);    \
+    static void name()
+
+#define TEST_CASE(name) HARNESS_CASE(name)
+#define BENCHMARK(name) HARNESS_CASE(name)
+
+// records a failure and keeps going
+#define CHECK(expr)                                                   \
+    do                                                                \
+    {                                                                 \
+        if (!(expr))                                                  \
+        {                                                             \
+            Harness::reportFailure(__FILE__, __LINE__, #expr);        \
+        }                                                             \
+    } while (false)
+
+// records a failure and abandons the current case
+#define REQUIRE(expr)                                                 \
+    do                                                                \
+    {                                                                 \
+        if (!(expr))                                                  \
+        {                                                             \
+            Harness::reportFailure(__FILE__, __LINE__, #expr);        \
+            throw Harness::RequireFailure(#expr);                     \
+        }                                                             \
+    } while (false)
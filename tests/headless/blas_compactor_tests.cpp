@@ -0,0 +1,221 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "null_device_scope.h"
+
+#include "rendering/buffer/acs_helper.h"
+#include "rendering/buffer/blas_compactor.h"
+#include "rendering/buffer/to_free_list.h"
+#include "rendering/buffer/upload_ring.h"
+
+#include <vector>
+
+namespace
+{
+
+// Builds compactable BLASes and runs them through the compactor the way Scene does, with the test standing in for the
+// fence: each frame's commands run on the null device right away, but the compactor only sees them as complete once
+// reclaim() is called with that frame's fence value.
+struct CompactorHarness
+{
+    ComPtr<ID3D12GraphicsCommandList4> cmdList = NullDevice::createCommandList();
+    ToFreeList toFreeList;
+    UploadRing uploadRing;
+    BlasCompactor compactor;
+
+    uint64_t nextBuildIdx{ 0 };
+
+    CompactorHarness()
+    {
+        this->uploadRing.init(1024 * 1024);
+    }
+
+    ~CompactorHarness()
+    {
+        this->toFreeList.freeAll();
+    }
+
+    BlasCompactor::Request buildBlas(uint32_t ownerId, uint32_t numTris)
+    {
+        std::vector<DirectX::XMFLOAT3> positions(numTris * 3);
+        for (uint32_t vertIdx = 0; vertIdx < positions.size(); ++vertIdx)
+        {
+            positions[vertIdx] = { static_cast<float>(vertIdx), static_cast<float>(vertIdx % 3), 0.f };
+        }
+
+        AcsHelper::GeometryWrapper geoWrapper;
+        const AcsHelper::BlasBuildInputs inputs = {
+            .host_positions = &positions,
+            .outGeoWrapper = &geoWrapper,
+            .allowCompaction = true,
+        };
+        AcsHelper::makeBlases(this->cmdList.Get(), this->toFreeList, this->uploadRing, { inputs });
+
+        return { .ownerId = ownerId, .buildIdx = this->nextBuildIdx++, .blas = geoWrapper.dev_blas };
+    }
+
+    void queueSizeQueries(std::vector<BlasCompactor::Request>&& requests)
+    {
+        BufferHelper::uavBarrier(this->cmdList.Get(), nullptr);
+        this->compactor.queueSizeQueries(this->cmdList.Get(), this->toFreeList, std::move(requests));
+    }
+
+    void endFrame(uint64_t fenceValue)
+    {
+        this->cmdList->Close();
+        NullDevice::executeCommandList(this->cmdList.Get());
+        this->uploadRing.submit(fenceValue);
+        this->compactor.submit(fenceValue);
+    }
+};
+
+} // namespace
+
+TEST_CASE(blasCompactorWaitsForFenceThenShrinks)
+{
+    NullDeviceScope nullDevice;
+    CompactorHarness harness;
+
+    const uint32_t triCounts[] = { 64, 256, 1000 };
+    std::vector<BlasCompactor::Request> requests;
+    for (uint32_t ownerId = 0; ownerId < 3; ++ownerId)
+    {
+        requests.push_back(harness.buildBlas(ownerId, triCounts[ownerId]));
+    }
+
+    const std::vector<BlasCompactor::Request> builtRequests = requests;
+    harness.queueSizeQueries(std::move(requests));
+
+    // nothing can be read back before the queries are submitted, or before their fence completes
+    harness.compactor.reclaim(UINT64_MAX);
+    CHECK(harness.compactor.takeReadyResults().empty());
+
+    harness.endFrame(1);
+    harness.compactor.reclaim(0);
+    CHECK(harness.compactor.takeReadyResults().empty());
+
+    harness.compactor.reclaim(1);
+    const std::vector<BlasCompactor::Result> results = harness.compactor.takeReadyResults();
+    REQUIRE(results.size() == builtRequests.size());
+    CHECK(harness.compactor.takeReadyResults().empty());
+
+    const uint32_t numAcsAllocationsBefore = AcsHelper::getAcsPoolStats().numAllocations;
+
+    uint64_t originalBytes = 0;
+    uint64_t compactedBytes = 0;
+    std::vector<AcsPoolSection> compactedBlases;
+    for (uint32_t resultIdx = 0; resultIdx < results.size(); ++resultIdx)
+    {
+        const BlasCompactor::Result& result = results[resultIdx];
+        CHECK(result.request.ownerId == builtRequests[resultIdx].ownerId);
+        CHECK(result.request.buildIdx == builtRequests[resultIdx].buildIdx);
+        CHECK(result.request.blas.getGpuAddress() == builtRequests[resultIdx].blas.getGpuAddress());
+        CHECK(result.compactedSizeBytes > 0);
+        CHECK(result.compactedSizeBytes < result.request.blas.getSizeBytes());
+
+        const AcsPoolSection compactedBlas = harness.compactor.compact(harness.cmdList.Get(), harness.toFreeList, result);
+        CHECK(compactedBlas.getSizeBytes() >= result.compactedSizeBytes);
+        CHECK(compactedBlas.getSizeBytes() < result.request.blas.getSizeBytes());
+        CHECK(compactedBlas.getGpuAddress() != result.request.blas.getGpuAddress());
+        compactedBlases.push_back(compactedBlas);
+
+        originalBytes += result.request.blas.getSizeBytes();
+        compactedBytes += compactedBlas.getSizeBytes();
+    }
+
+    const BlasCompactor::Stats& stats = harness.compactor.getStats();
+    CHECK(stats.numCompacted == 3);
+    CHECK(stats.originalBytes == originalBytes);
+    CHECK(stats.compactedBytes == compactedBytes);
+
+    BufferHelper::uavBarrier(harness.cmdList.Get(), nullptr);
+    harness.endFrame(2);
+
+    // the originals are retired through the ToFreeList rather than freed on the spot
+    CHECK(AcsHelper::getAcsPoolStats().numAllocations == numAcsAllocationsBefore + 3);
+    harness.toFreeList.freeAll();
+    CHECK(AcsHelper::getAcsPoolStats().numAllocations == numAcsAllocationsBefore);
+
+    for (const AcsPoolSection& compactedBlas : compactedBlases)
+    {
+        harness.toFreeList.pushAcsPoolSection(compactedBlas);
+    }
+}
+
+TEST_CASE(blasCompactorReadsBackBatchesInFenceOrder)
+{
+    NullDeviceScope nullDevice;
+    CompactorHarness harness;
+
+    std::vector<BlasCompactor::Request> allRequests;
+    for (uint64_t fenceValue = 1; fenceValue <= 3; ++fenceValue)
+    {
+        std::vector<BlasCompactor::Request> requests;
+        for (uint32_t i = 0; i < fenceValue; ++i)
+        {
+            requests.push_back(harness.buildBlas(static_cast<uint32_t>(allRequests.size()), 16 * (i + 1)));
+            allRequests.push_back(requests.back());
+        }
+
+        harness.queueSizeQueries(std::move(requests));
+        harness.endFrame(fenceValue);
+    }
+
+    // the first two frames complete together, the third one later
+    harness.compactor.reclaim(2);
+    std::vector<BlasCompactor::Result> results = harness.compactor.takeReadyResults();
+    REQUIRE(results.size() == 3);
+    for (uint32_t resultIdx = 0; resultIdx < results.size(); ++resultIdx)
+    {
+        CHECK(results[resultIdx].request.ownerId == resultIdx);
+    }
+
+    harness.compactor.reclaim(2);
+    CHECK(harness.compactor.takeReadyResults().empty());
+
+    harness.compactor.reclaim(3);
+    results = harness.compactor.takeReadyResults();
+    REQUIRE(results.size() == 3);
+    for (uint32_t resultIdx = 0; resultIdx < results.size(); ++resultIdx)
+    {
+        CHECK(results[resultIdx].request.ownerId == 3 + resultIdx);
+    }
+
+    for (const BlasCompactor::Request& request : allRequests)
+    {
+        harness.toFreeList.pushAcsPoolSection(request.blas);
+    }
+}
+
+TEST_CASE(blasCompactorClearDropsQueriesInFlight)
+{
+    NullDeviceScope nullDevice;
+    CompactorHarness harness;
+
+    const BlasCompactor::Request request = harness.buildBlas(0, 32);
+    harness.queueSizeQueries({ request });
+    harness.endFrame(1);
+
+    harness.compactor.clear(harness.toFreeList);
+    harness.compactor.reclaim(UINT64_MAX);
+    CHECK(harness.compactor.takeReadyResults().empty());
+    CHECK(harness.compactor.getStats().numCompacted == 0);
+
+    harness.toFreeList.pushAcsPoolSection(request.blas);
+}
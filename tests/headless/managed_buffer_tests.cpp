@@ -0,0 +1,202 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "null_device_scope.h"
+
+#include "rendering/buffer/acs_pool.h"
+#include "rendering/buffer/managed_buffer.h"
+#include "rendering/buffer/to_free_list.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+static constexpr D3D12_RESOURCE_STATES POOL_STATE = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
+namespace
+{
+
+// Drives a pool the way Scene drives its vertex and index buffers: sections are uploaded with owners, freed through
+// a ToFreeList once the frame's commands have run, and moved by compact() with the owner patching its offset.
+struct PoolHarness
+{
+    ManagedBuffer buffer{ &DEFAULT_HEAP, POOL_STATE, true /*isResizable*/, false /*isMapped*/, MemoryTag::VERTEX_POOL };
+    std::unordered_map<uint32_t, ManagedBufferSection> sections;
+    uint32_t nextOwnerId{ 0 };
+
+    ComPtr<ID3D12GraphicsCommandList4> cmdList = NullDevice::createCommandList();
+    ToFreeList toFreeList;
+
+    static uint8_t getFillByte(uint32_t ownerId)
+    {
+        return static_cast<uint8_t>(ownerId % 251);
+    }
+
+    void allocate(uint64_t sizeBytes)
+    {
+        const uint32_t ownerId = this->nextOwnerId++;
+        const std::vector<uint8_t> data(sizeBytes, getFillByte(ownerId));
+        const ComPtr<ID3D12Resource> uploadBuffer = createUploadBuffer(data.data(), sizeBytes);
+
+        const ManagedBufferSection section =
+            this->buffer.copyFromDeviceBuffer(this->cmdList.Get(), this->toFreeList, uploadBuffer.Get(), sizeBytes);
+        this->buffer.setSectionOwner(section, ownerId);
+        this->sections[ownerId] = section;
+    }
+
+    void free(uint32_t ownerId)
+    {
+        const ManagedBufferSection& section = this->sections.at(ownerId);
+        this->buffer.setSectionOwner(section, ManagedBuffer::NO_OWNER);
+        this->toFreeList.pushManagedBufferSection(section);
+        this->sections.erase(ownerId);
+    }
+
+    uint64_t compact(uint64_t maxMoveBytes)
+    {
+        uint64_t movedBytes = 0;
+        for (const auto& relocation : this->buffer.compact(this->cmdList.Get(), this->toFreeList, maxMoveBytes))
+        {
+            this->sections.at(relocation.userData).offsetBytes = relocation.dstOffsetBytes;
+            movedBytes += relocation.sizeBytes;
+        }
+        return movedBytes;
+    }
+
+    void endFrame()
+    {
+        this->cmdList->Close();
+        NullDevice::executeCommandList(this->cmdList.Get());
+        this->toFreeList.freeAll();
+    }
+
+    // reads the whole pool back and checks every live section's bytes and that no two sections overlap
+    void checkSectionsIntact()
+    {
+        const std::vector<uint8_t> data =
+            readBackBuffer(this->cmdList.Get(), this->buffer.getBuffer(), POOL_STATE, 0, this->buffer.getSizeBytes());
+
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        for (const auto& [ownerId, section] : this->sections)
+        {
+            REQUIRE(section.offsetBytes + section.sizeBytes <= data.size());
+            const uint8_t fillByte = getFillByte(ownerId);
+            REQUIRE(std::all_of(data.begin() + section.offsetBytes,
+                                data.begin() + section.offsetBytes + section.sizeBytes,
+                                [=](uint8_t b) { return b == fillByte; }));
+            ranges.emplace_back(section.offsetBytes, section.sizeBytes);
+        }
+
+        std::sort(ranges.begin(), ranges.end());
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            REQUIRE(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+        }
+    }
+};
+
+} // namespace
+
+TEST_CASE(managedBufferCompactionRandomTrace)
+{
+    NullDeviceScope nullDevice;
+    std::mt19937 rng(Harness::getSeed());
+    std::uniform_int_distribution<uint64_t> sizeDist(4, 16 * 1024);
+
+    PoolHarness pool;
+    pool.buffer.init(256);
+
+    uint64_t peakSizeBytes = 0;
+    for (uint32_t frame = 0; frame < 300; ++frame)
+    {
+        // grow for a while, then stream most of it back out
+        const uint32_t allocPercent = frame < 150 ? 65 : 30;
+        for (uint32_t step = 0; step < 20; ++step)
+        {
+            if (pool.sections.empty() || rng() % 100 < allocPercent)
+            {
+                pool.allocate(sizeDist(rng));
+            }
+            else
+            {
+                auto it = pool.sections.begin();
+                std::advance(it, rng() % pool.sections.size());
+                pool.free(it->first);
+            }
+        }
+
+        pool.compact(64 * 1024);
+        pool.endFrame();
+        peakSizeBytes = std::max(peakSizeBytes, pool.buffer.getSizeBytes());
+
+        if (frame % 25 == 0)
+        {
+            pool.checkSectionsIntact();
+        }
+    }
+
+    // let compaction finish, after which the buffer should have shrunk back down around what is still live
+    while (pool.compact(64 * 1024) > 0)
+    {
+        pool.endFrame();
+    }
+    pool.endFrame();
+    pool.checkSectionsIntact();
+
+    uint64_t liveBytes = 0;
+    for (const auto& [ownerId, section] : pool.sections)
+    {
+        liveBytes += section.sizeBytes;
+    }
+
+    const MemoryPoolStats stats = pool.buffer.getPoolStats();
+    CHECK(stats.numFreeRanges <= 1);
+    CHECK(pool.buffer.getSizeBytes() < peakSizeBytes);
+    CHECK(pool.buffer.getSizeBytes() <= std::max<uint64_t>(256, liveBytes * 4));
+}
+
+TEST_CASE(managedBufferShrinksOnceEmpty)
+{
+    NullDeviceScope nullDevice;
+
+    PoolHarness pool;
+    pool.buffer.init(256);
+
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        pool.allocate(64 * 1024);
+    }
+    pool.endFrame();
+    const uint64_t fullSizeBytes = pool.buffer.getSizeBytes();
+    CHECK(fullSizeBytes >= 64 * 64 * 1024);
+
+    // keep the last section so that compaction has to move it all the way down before the buffer can shrink
+    for (uint32_t ownerId = 0; ownerId < 63; ++ownerId)
+    {
+        pool.free(ownerId);
+    }
+    pool.endFrame();
+
+    pool.compact(~0ull);
+    pool.endFrame();
+    CHECK(pool.sections.at(63).offsetBytes == 0);
+    CHECK(pool.buffer.getSizeBytes() <= fullSizeBytes / 4);
+    pool.checkSectionsIntact();
+}
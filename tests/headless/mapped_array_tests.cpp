@@ -0,0 +1,85 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "null_device_scope.h"
+
+#include "rendering/buffer/acs_pool.h"
+#include "rendering/buffer/managed_buffer.h"
+#include "rendering/buffer/mapped_array.h"
+#include "rendering/buffer/to_free_list.h"
+
+#include <random>
+#include <vector>
+
+// Writes random elements and resizes the array between uploads, so that resident copies from the old device buffer
+// and dirty uploads land in the same frame, and checks that the device buffer always ends up matching the host.
+TEST_CASE(mappedArrayResizeKeepsDirtyElements)
+{
+    NullDeviceScope nullDevice;
+    std::mt19937 rng(Harness::getSeed());
+
+    ComPtr<ID3D12GraphicsCommandList4> cmdList = NullDevice::createCommandList();
+    ToFreeList toFreeList;
+
+    MappedArray<uint32_t> array;
+    array.init(64, MemoryTag::OTHER);
+    std::vector<uint32_t> expected(64, 0);
+    for (uint32_t idx = 0; idx < expected.size(); ++idx)
+    {
+        array[idx] = 0;
+    }
+
+    for (uint32_t frameIdx = 0; frameIdx < 200; ++frameIdx)
+    {
+        // writes before and after the resize both have to survive it
+        for (const bool isAfterResize : { false, true })
+        {
+            if (isAfterResize && rng() % 3 == 0)
+            {
+                const uint32_t newSize = static_cast<uint32_t>(expected.size()) + 1 + rng() % 4000;
+                array.resize(toFreeList, newSize);
+                for (uint32_t idx = static_cast<uint32_t>(expected.size()); idx < newSize; ++idx)
+                {
+                    array[idx] = 0;
+                }
+                expected.resize(newSize, 0);
+            }
+
+            const uint32_t numWrites = rng() % 50;
+            for (uint32_t writeIdx = 0; writeIdx < numWrites; ++writeIdx)
+            {
+                const uint32_t idx = rng() % expected.size();
+                const uint32_t value = static_cast<uint32_t>(rng());
+                array[idx] = value;
+                expected[idx] = value;
+            }
+        }
+
+        array.copyFromUploadBufferIfDirty(cmdList.Get(), toFreeList);
+
+        const std::vector<uint8_t> devData = readBackBuffer(cmdList.Get(),
+                                                            array.getBuffer(),
+                                                            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                                            0,
+                                                            expected.size() * sizeof(uint32_t));
+        CHECK(memcmp(devData.data(), expected.data(), devData.size()) == 0);
+
+        toFreeList.freeAll();
+    }
+}
@@ -0,0 +1,85 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "harness.h"
+
+#include "rendering/buffer/buffer_helper.h"
+#include "rendering/dxr_common.h"
+#include "rendering/null/null_device.h"
+
+#include <cstring>
+#include <vector>
+
+// Sets up the null device for one test case and fails the case if anything it recorded would have tripped the D3D12
+// debug layer.
+struct NullDeviceScope
+{
+    NullDeviceScope()
+    {
+        NullDevice::init();
+        NullDevice::resetStats();
+    }
+
+    ~NullDeviceScope()
+    {
+        CHECK(NullDevice::getStats().numValidationErrors == 0);
+        NullDevice::shutdown();
+    }
+};
+
+inline ComPtr<ID3D12Resource> createUploadBuffer(const void* data, uint64_t sizeBytes)
+{
+    ComPtr<ID3D12Resource> buffer =
+        BufferHelper::createBasicBuffer(sizeBytes, &UPLOAD_HEAP, D3D12_RESOURCE_STATE_GENERIC_READ, MemoryTag::UPLOAD);
+
+    void* host_data;
+    buffer->Map(0, nullptr, &host_data);
+    memcpy(host_data, data, sizeBytes);
+    buffer->Unmap(0, nullptr);
+
+    return buffer;
+}
+
+// Copies a range of a buffer in `state` back to the host through a readback buffer. Runs `cmdList`, which must be
+// open, along with everything recorded into it so far.
+inline std::vector<uint8_t> readBackBuffer(ID3D12GraphicsCommandList4* cmdList,
+                                           ID3D12Resource* buffer,
+                                           D3D12_RESOURCE_STATES state,
+                                           uint64_t offsetBytes,
+                                           uint64_t sizeBytes)
+{
+    ComPtr<ID3D12Resource> readbackBuffer =
+        BufferHelper::createBasicBuffer(sizeBytes, &READBACK_HEAP, D3D12_RESOURCE_STATE_COPY_DEST, MemoryTag::READBACK);
+
+    BufferHelper::stateTransitionResourceBarrier(cmdList, buffer, state, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    cmdList->CopyBufferRegion(readbackBuffer.Get(), 0, buffer, offsetBytes, sizeBytes);
+    BufferHelper::stateTransitionResourceBarrier(cmdList, buffer, D3D12_RESOURCE_STATE_COPY_SOURCE, state);
+
+    cmdList->Close();
+    NullDevice::executeCommandList(cmdList);
+
+    std::vector<uint8_t> data(sizeBytes);
+    void* host_data;
+    readbackBuffer->Map(0, nullptr, &host_data);
+    memcpy(data.data(), host_data, sizeBytes);
+    readbackBuffer->Unmap(0, nullptr);
+
+    return data;
+}
@@ -0,0 +1,255 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "null_device_scope.h"
+#include "temp_dir.h"
+
+#include "rendering/scene/scene_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+
+static constexpr uint32_t LOADER_VERSION = 7;
+
+static void writeTextFile(const std::filesystem::path& filePath, const std::string& contents)
+{
+    std::ofstream stream(filePath, std::ios::binary | std::ios::trunc);
+    stream << contents;
+}
+
+// A scene with a texture, a textured and an untextured material, one geometry with 32-bit indices and two parts and
+// one narrowed to 16-bit indices with an odd index count, area lights and instances of both geometries.
+static void makeScene(std::mt19937& rng, LoadedScene* outScene)
+{
+    LoadedScene& scene = *outScene;
+
+    ProcessedTexture& texture = scene.textures.emplace_back();
+    texture.format = TextureFormat::RGBA8_SRGB;
+    texture.width = 16;
+    texture.height = 8;
+    texture.numMips = MipGenerator::getNumMips(texture.width, texture.height);
+    texture.data.resize(
+        TextureProcessor::getDataSizeBytes(texture.format, texture.width, texture.height, texture.numMips));
+    for (uint8_t& byte : texture.data)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    Material& texturedMaterial = scene.materials.emplace_back();
+    texturedMaterial.baseColorTextureId = 0;
+    Material& emissiveMaterial = scene.materials.emplace_back();
+    emissiveMaterial.emissiveStrength = 4.f;
+    emissiveMaterial.emissiveColor = { 1.f, 0.5f, 0.25f };
+
+    for (uint32_t geometryIdx = 0; geometryIdx < 2; ++geometryIdx)
+    {
+        LoadedGeometry& geometry = scene.geometries.emplace_back();
+        if (geometryIdx == 0)
+        {
+            geometry.addPart(40, 60, 0, 0.f);
+            geometry.addPart(100, 150, MATERIAL_ID_INVALID, 2.f);
+        }
+        else
+        {
+            geometry.addPart(30, 45, 1, -1.f);
+            geometry.narrowIdxFormat();
+            REQUIRE(geometry.idxFormat == IDX_FORMAT_16);
+        }
+        geometry.allocateHostStreams();
+
+        for (uint32_t vertIdx = 0; vertIdx < geometry.numVerts; ++vertIdx)
+        {
+            geometry.positions[vertIdx] = { static_cast<float>(rng() % 1000), static_cast<float>(vertIdx), -1.f };
+            geometry.vertAttribs[vertIdx] = { static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng()) };
+        }
+        for (const AcsHelper::GeometryRange& range : geometry.partRanges)
+        {
+            for (uint32_t idx = range.firstIdx; idx < range.firstIdx + range.numIdxs; ++idx)
+            {
+                const uint32_t vertIdx = static_cast<uint32_t>(rng() % range.numVerts);
+                if (geometry.idxFormat == IDX_FORMAT_16)
+                {
+                    geometry.idxs16[idx] = static_cast<uint16_t>(vertIdx);
+                }
+                else
+                {
+                    geometry.idxs[idx] = vertIdx;
+                }
+            }
+        }
+
+        if (geometryIdx == 1)
+        {
+            for (uint32_t triangleIdx = 0; triangleIdx < 3; ++triangleIdx)
+            {
+                geometry.areaLights.push_back({
+                    .pos0 = { 0.f, 0.f, static_cast<float>(triangleIdx) },
+                    .pos1 = { 1.f, 0.f, 0.f },
+                    .pos2 = { 0.f, 1.f, 0.f },
+                    .geometryIdx = geometryIdx,
+                    .triangleIdx = triangleIdx,
+                });
+            }
+        }
+    }
+
+    for (uint32_t instanceIdx = 0; instanceIdx < 5; ++instanceIdx)
+    {
+        LoadedInstance& instance = scene.instances.emplace_back();
+        instance.geometryIdx = instanceIdx % 2;
+        DirectX::XMStoreFloat3x4(&instance.transform,
+                                 DirectX::XMMatrixTranslation(static_cast<float>(instanceIdx), 2.f, 3.f));
+    }
+}
+
+static bool loadScene(const std::string& cachePathStr,
+                      const std::filesystem::path& sourcePath,
+                      uint32_t loaderVersion,
+                      bool stageStreams,
+                      LoadedScene* outScene)
+{
+    return SceneCache::load(cachePathStr, sourcePath.string(), loaderVersion, 2, stageStreams, outScene);
+}
+
+template<class T>
+static bool bytesEqual(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+static void checkLoadedScene(const LoadedScene& expected, const LoadedScene& loaded)
+{
+    REQUIRE(loaded.textures.size() == expected.textures.size());
+    for (uint32_t textureIdx = 0; textureIdx < expected.textures.size(); ++textureIdx)
+    {
+        const ProcessedTexture& expectedTexture = expected.textures[textureIdx];
+        const ProcessedTexture& loadedTexture = loaded.textures[textureIdx];
+        CHECK(loadedTexture.format == expectedTexture.format);
+        CHECK(loadedTexture.width == expectedTexture.width);
+        CHECK(loadedTexture.height == expectedTexture.height);
+        CHECK(loadedTexture.numMips == expectedTexture.numMips);
+        CHECK(loadedTexture.data == expectedTexture.data);
+    }
+
+    CHECK(bytesEqual(loaded.materials, expected.materials));
+    CHECK(bytesEqual(loaded.instances, expected.instances));
+
+    REQUIRE(loaded.geometries.size() == expected.geometries.size());
+    for (uint32_t geometryIdx = 0; geometryIdx < expected.geometries.size(); ++geometryIdx)
+    {
+        const LoadedGeometry& expectedGeometry = expected.geometries[geometryIdx];
+        const LoadedGeometry& loadedGeometry = loaded.geometries[geometryIdx];
+        CHECK(loadedGeometry.numVerts == expectedGeometry.numVerts);
+        CHECK(loadedGeometry.numIdxs == expectedGeometry.numIdxs);
+        CHECK(loadedGeometry.idxFormat == expectedGeometry.idxFormat);
+        CHECK(bytesEqual(loadedGeometry.partRanges, expectedGeometry.partRanges));
+        CHECK(loadedGeometry.partMaterialIdxs == expectedGeometry.partMaterialIdxs);
+        CHECK(loadedGeometry.partUvScaleLog2s == expectedGeometry.partUvScaleLog2s);
+        CHECK(bytesEqual(loadedGeometry.areaLights, expectedGeometry.areaLights));
+
+        // staged streams are filled directly, leaving the host streams empty
+        const bool isStaged = loadedGeometry.isStaged();
+        CHECK(loadedGeometry.positions.empty() == isStaged);
+        CHECK(!isStaged ||
+              loadedGeometry.staged.idxFormat ==
+                  (expectedGeometry.idxFormat == IDX_FORMAT_16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT));
+
+        CHECK(memcmp(loadedGeometry.getPositions(),
+                     expectedGeometry.getPositions(),
+                     expectedGeometry.numVerts * sizeof(DirectX::XMFLOAT3)) == 0);
+        CHECK(memcmp(loadedGeometry.getVertAttribs(),
+                     expectedGeometry.getVertAttribs(),
+                     expectedGeometry.numVerts * sizeof(VertexAttributes)) == 0);
+        REQUIRE(loadedGeometry.getIdxsSizeBytes() == expectedGeometry.getIdxsSizeBytes());
+        CHECK(memcmp(loadedGeometry.getIdxs(), expectedGeometry.getIdxs(), expectedGeometry.getIdxsSizeBytes()) == 0);
+    }
+}
+
+TEST_CASE(sceneCacheRoundTrip)
+{
+    NullDeviceScope nullDevice;
+    TempDir tempDir;
+    std::mt19937 rng(Harness::getSeed());
+
+    const std::filesystem::path sourcePath = tempDir.path / "scene.gltf";
+    const std::string cachePathStr = (tempDir.path / "cache" / "scene.bin").string();
+    writeTextFile(sourcePath, "{ \"asset\": {} }");
+    writeTextFile(tempDir.path / "scene.bin", "buffer contents");
+    writeTextFile(tempDir.path / "texture.png", "image contents");
+    const std::vector<std::string> dependencyPathStrs = { "scene.bin", "texture.png" };
+
+    LoadedScene scene;
+    makeScene(rng, &scene);
+    REQUIRE(SceneCache::write(scene, dependencyPathStrs, cachePathStr, sourcePath.string(), LOADER_VERSION, 2));
+
+    for (const bool stageStreams : { true, false })
+    {
+        LoadedScene loadedScene;
+        REQUIRE(loadScene(cachePathStr, sourcePath, LOADER_VERSION, stageStreams, &loadedScene));
+        checkLoadedScene(scene, loadedScene);
+    }
+
+    // a cache written from staged streams, as on a glTF cache miss, holds the same scene
+    {
+        LoadedScene stagedScene;
+        REQUIRE(loadScene(cachePathStr, sourcePath, LOADER_VERSION, true /*stageStreams*/, &stagedScene));
+        const std::string stagedCachePathStr = (tempDir.path / "cache" / "staged.bin").string();
+        REQUIRE(SceneCache::write(
+            stagedScene, dependencyPathStrs, stagedCachePathStr, sourcePath.string(), LOADER_VERSION, 2));
+
+        LoadedScene loadedScene;
+        REQUIRE(loadScene(stagedCachePathStr, sourcePath, LOADER_VERSION, false /*stageStreams*/, &loadedScene));
+        checkLoadedScene(scene, loadedScene);
+    }
+
+    // a newer loader ignores the cache
+    {
+        LoadedScene loadedScene;
+        CHECK(!loadScene(cachePathStr, sourcePath, LOADER_VERSION + 1, true /*stageStreams*/, &loadedScene));
+    }
+
+    // so does a changed dependency, until the cache is written again
+    writeTextFile(tempDir.path / "texture.png", "new image contents");
+    {
+        LoadedScene loadedScene;
+        CHECK(!loadScene(cachePathStr, sourcePath, LOADER_VERSION, true /*stageStreams*/, &loadedScene));
+    }
+    REQUIRE(SceneCache::write(scene, dependencyPathStrs, cachePathStr, sourcePath.string(), LOADER_VERSION, 2));
+    {
+        LoadedScene loadedScene;
+        REQUIRE(loadScene(cachePathStr, sourcePath, LOADER_VERSION, true /*stageStreams*/, &loadedScene));
+        checkLoadedScene(scene, loadedScene);
+    }
+
+    // and a removed dependency or a changed source file
+    std::filesystem::remove(tempDir.path / "scene.bin");
+    {
+        LoadedScene loadedScene;
+        CHECK(!loadScene(cachePathStr, sourcePath, LOADER_VERSION, true /*stageStreams*/, &loadedScene));
+    }
+    writeTextFile(tempDir.path / "scene.bin", "buffer contents");
+    writeTextFile(sourcePath, "{ \"asset\": { \"version\": \"2.0\" } }");
+    {
+        LoadedScene loadedScene;
+        CHECK(!loadScene(cachePathStr, sourcePath, LOADER_VERSION, true /*stageStreams*/, &loadedScene));
+    }
+
+    CHECK(tempDir.countFilesEndingWith(".tmp") == 0);
+}
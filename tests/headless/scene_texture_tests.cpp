@@ -0,0 +1,132 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "null_device_scope.h"
+#include "benchmarks/headless/scene_frame_loop.h"
+
+#include "core/mip_generator.h"
+#include "core/texture_processor.h"
+
+#include <memory>
+
+static std::unique_ptr<LoadedScene> makeTexturedScene(uint32_t numTextures, uint32_t textureDim)
+{
+    std::unique_ptr<LoadedScene> loadedScene = std::make_unique<LoadedScene>();
+    for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+    {
+        ProcessedTexture& texture = loadedScene->textures.emplace_back();
+        texture.format = TextureFormat::RGBA8_SRGB;
+        texture.width = textureDim;
+        texture.height = textureDim;
+        texture.numMips = MipGenerator::getNumMips(textureDim, textureDim);
+        texture.data.resize(
+            TextureProcessor::getDataSizeBytes(texture.format, texture.width, texture.height, texture.numMips));
+
+        Material& material = loadedScene->materials.emplace_back();
+        material.baseColorTextureId = textureIdx;
+    }
+    return loadedScene;
+}
+
+// Swaps in textured scenes one frame after another. Their textures have to go into descriptors that the frames still
+// in flight don't read, which the null device checks, since otherwise the renderer would have to wait for the queue
+// to drain before every load.
+TEST_CASE(sceneLoadsDoNotRewriteDescriptorsInUse)
+{
+    NullDeviceScope scope;
+    SceneFrameLoop frameLoop;
+
+    // different texture counts tell the scenes apart
+    const uint32_t textureCounts[] = { MAX_NUM_TEXTURES, MAX_NUM_TEXTURES - 1, MAX_NUM_TEXTURES, 1, 3 };
+    for (const uint32_t numTextures : textureCounts)
+    {
+        std::unique_ptr<LoadedScene> loadedScene = makeTexturedScene(numTextures, 16);
+        REQUIRE(frameLoop.scene.queueLoadedScene(loadedScene));
+
+        // waiting for the descriptors of the scene before last to be retired takes a couple of frames at most
+        uint32_t numFrames = 0;
+        do
+        {
+            frameLoop.runFrameMs();
+            ++numFrames;
+        } while (frameLoop.scene.getTextureIds().size() != numTextures &&
+                 numFrames <= SceneFrameLoop::FRAME_LATENCY + 2);
+
+        CHECK(frameLoop.scene.getTextureIds().size() == numTextures);
+        CHECK(!frameLoop.scene.hasPendingTextures());
+    }
+}
+
+TEST_CASE(textureUploadsAreSpreadOverFramesByBudget)
+{
+    static constexpr uint32_t NUM_TEXTURES = 4;
+
+    NullDeviceScope scope;
+    SceneFrameLoop frameLoop;
+
+    std::unique_ptr<LoadedScene> loadedScene = makeTexturedScene(NUM_TEXTURES, 64);
+    const uint64_t textureSizeBytes = loadedScene->textures[0].data.size();
+    frameLoop.scene.setTextureUploadBudget(textureSizeBytes);
+    REQUIRE(frameLoop.scene.queueLoadedScene(loadedScene));
+
+    // one texture fits in each frame's budget, and the first is uploaded in the frame that swaps the scene in
+    for (uint32_t frameIdx = 0; frameIdx < NUM_TEXTURES; ++frameIdx)
+    {
+        const uint64_t numBytesCopiedBefore = NullDevice::getStats().numBytesCopied;
+        frameLoop.runFrameMs();
+        CHECK(frameLoop.scene.hasPendingTextures() == (frameIdx + 1 < NUM_TEXTURES));
+        CHECK(NullDevice::getStats().numBytesCopied - numBytesCopiedBefore >= textureSizeBytes);
+    }
+
+    // a texture larger than the budget is still uploaded on its own
+    frameLoop.scene.setTextureUploadBudget(1);
+    loadedScene = makeTexturedScene(2, 64);
+    REQUIRE(frameLoop.scene.queueLoadedScene(loadedScene));
+    frameLoop.runFrameMs();
+    CHECK(frameLoop.scene.getTextureIds().size() == 2);
+    CHECK(frameLoop.scene.hasPendingTextures());
+    frameLoop.runFrameMs();
+    CHECK(!frameLoop.scene.hasPendingTextures());
+}
+
+// mips smaller than a block are still copied as a whole block, which D3D12 allows for block compressed formats
+TEST_CASE(blockCompressedTexturesUploadDownToTheSmallestMip)
+{
+    NullDeviceScope scope;
+    SceneFrameLoop frameLoop;
+
+    std::unique_ptr<LoadedScene> loadedScene = std::make_unique<LoadedScene>();
+    for (const TextureFormat format : { TextureFormat::BC7_SRGB, TextureFormat::BC5 })
+    {
+        ProcessedTexture& texture = loadedScene->textures.emplace_back();
+        texture.format = format;
+        texture.width = 64;
+        texture.height = 32;
+        texture.numMips = MipGenerator::getNumMips(texture.width, texture.height);
+        texture.data.resize(
+            TextureProcessor::getDataSizeBytes(texture.format, texture.width, texture.height, texture.numMips));
+    }
+    REQUIRE(frameLoop.scene.queueLoadedScene(loadedScene));
+
+    const uint64_t numBytesCopiedBefore = NullDevice::getStats().numBytesCopied;
+    frameLoop.runFrameMs();
+    CHECK(!frameLoop.scene.hasPendingTextures());
+    CHECK(NullDevice::getStats().numBytesCopied - numBytesCopiedBefore >=
+          TextureProcessor::getDataSizeBytes(TextureFormat::BC7_SRGB, 64, 32, MipGenerator::getNumMips(64, 32)) * 2);
+}
@@ -0,0 +1,119 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "harness.h"
+#include "null_device_scope.h"
+
+#include "rendering/buffer/acs_pool.h"
+#include "rendering/buffer/managed_buffer.h"
+#include "rendering/buffer/to_free_list.h"
+#include "rendering/buffer/upload_ring.h"
+
+#include <deque>
+#include <random>
+
+// Uploads a random amount of data per frame with the GPU a couple of frames behind, the way Renderer drives each
+// frame context's ring, and checks that once the ring has grown to fit the workload no more upload buffers are
+// created and that every upload still arrives intact.
+TEST_CASE(uploadRingSteadyStateCreatesNoResources)
+{
+    NullDeviceScope nullDevice;
+    std::mt19937 rng(Harness::getSeed());
+
+    ManagedBuffer dstBuffer{
+        &DEFAULT_HEAP, D3D12_RESOURCE_STATE_COMMON, true /*isResizable*/, false /*isMapped*/, MemoryTag::OTHER
+    };
+    dstBuffer.init(64 * 1024);
+
+    UploadRing uploadRing;
+    uploadRing.init(16 * 1024);
+
+    ComPtr<ID3D12GraphicsCommandList4> cmdList = NullDevice::createCommandList();
+    // the registry outlives the null device, so only look at what changes during this case
+    MemoryRegistry& memoryRegistry = BufferHelper::getMemoryRegistry();
+    const uint32_t numLiveUploadBuffersBefore = memoryRegistry.getTagStats(MemoryTag::UPLOAD).numLive;
+
+    // the "GPU" completes each frame's fence this many frames later
+    static constexpr uint32_t FRAME_LATENCY = 2;
+    std::deque<ToFreeList> inFlightToFreeLists;
+
+    uint32_t numUploadBuffersAfterWarmup = 0;
+    for (uint64_t fenceValue = 1; fenceValue <= 400; ++fenceValue)
+    {
+        ToFreeList& toFreeList = inFlightToFreeLists.emplace_back();
+
+        const uint32_t numUploads = 1 + rng() % 6;
+        for (uint32_t i = 0; i < numUploads; ++i)
+        {
+            std::vector<uint32_t> data(1 + rng() % 2048);
+            for (uint32_t& value : data)
+            {
+                value = static_cast<uint32_t>(rng());
+            }
+
+            const UploadRingSection uploadSection = uploadRing.copyFromHostVector(toFreeList, data);
+            const ManagedBufferSection dstSection = dstBuffer.copyFromDeviceBuffer(
+                cmdList.Get(), toFreeList, uploadSection.buffer, uploadSection.sizeBytes, uploadSection.offsetBytes);
+
+            if (rng() % 16 == 0)
+            {
+                const std::vector<uint8_t> readBack = readBackBuffer(cmdList.Get(),
+                                                                     dstBuffer.getBuffer(),
+                                                                     D3D12_RESOURCE_STATE_COMMON,
+                                                                     dstSection.offsetBytes,
+                                                                     dstSection.sizeBytes);
+                CHECK(memcmp(readBack.data(), data.data(), readBack.size()) == 0);
+            }
+
+            toFreeList.pushManagedBufferSection(dstSection);
+        }
+
+        cmdList->Close();
+        NullDevice::executeCommandList(cmdList.Get());
+        uploadRing.submit(fenceValue);
+
+        if (inFlightToFreeLists.size() > FRAME_LATENCY)
+        {
+            inFlightToFreeLists.front().freeAll();
+            inFlightToFreeLists.pop_front();
+            uploadRing.reclaim(fenceValue - FRAME_LATENCY);
+        }
+
+        if (fenceValue == 200)
+        {
+            numUploadBuffersAfterWarmup = memoryRegistry.getHeapStats(MemoryHeap::UPLOAD).numAllocations;
+        }
+    }
+
+    // the ring started too small for this workload, so it must have grown, but only during warm-up
+    const uint32_t numUploadBuffers = memoryRegistry.getHeapStats(MemoryHeap::UPLOAD).numAllocations;
+    CHECK(numUploadBuffers == numUploadBuffersAfterWarmup);
+
+    // growth is reported through the pool stats rather than logged
+    const MemoryPoolStats stats = uploadRing.getPoolStats();
+    CHECK(stats.numResizes > 0);
+    CHECK(stats.capacityBytes > 16 * 1024);
+    CHECK(stats.peakUsedBytes <= stats.capacityBytes);
+    CHECK(memoryRegistry.getTagStats(MemoryTag::UPLOAD).numLive == numLiveUploadBuffersBefore);
+
+    while (!inFlightToFreeLists.empty())
+    {
+        inFlightToFreeLists.front().freeAll();
+        inFlightToFreeLists.pop_front();
+    }
+}
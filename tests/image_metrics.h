@@ -0,0 +1,84 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+// A stand-in for a photographed RGBA8 texture: smooth gradients and waves, a hard-edged disc and a little noise, all
+// different per channel so that blocks aren't gray.
+inline std::vector<uint8_t> makeTestImage(uint32_t width, uint32_t height, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-4.f, 4.f);
+
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float u = (x + 0.5f) / width;
+            const float v = (y + 0.5f) / height;
+            const float dx = u - 0.6f;
+            const float dy = v - 0.4f;
+            const bool isInDisc = dx * dx + dy * dy < 0.04f;
+
+            const float values[4] = {
+                255.f * u + 20.f * std::sin(9.f * v),
+                255.f * v + (isInDisc ? -90.f : 30.f),
+                128.f + 100.f * std::sin(6.f * u + 4.f * v),
+                isInDisc ? 255.f : 160.f + 80.f * u,
+            };
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const float value = values[c] + noise(rng);
+                rgba[(static_cast<size_t>(y) * width + x) * 4 + c] =
+                    static_cast<uint8_t>(std::lround(std::fmin(std::fmax(value, 0.f), 255.f)));
+            }
+        }
+    }
+    return rgba;
+}
+
+// Peak signal-to-noise ratio in dB over `numChannels` channels of two RGBA8 images, starting at `firstChannel`.
+// Identical images return infinity.
+inline double computePsnr(
+    const uint8_t* a, const uint8_t* b, uint64_t numTexels, uint32_t firstChannel, uint32_t numChannels)
+{
+    double squaredErrorSum = 0.0;
+    for (uint64_t texelIdx = 0; texelIdx < numTexels; ++texelIdx)
+    {
+        for (uint32_t c = firstChannel; c < firstChannel + numChannels; ++c)
+        {
+            const double error = static_cast<double>(a[texelIdx * 4 + c]) - b[texelIdx * 4 + c];
+            squaredErrorSum += error * error;
+        }
+    }
+
+    if (squaredErrorSum == 0.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double meanSquaredError = squaredErrorSum / (numTexels * numChannels);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,65 @@
+/*
+Biomeinator - real-time path traced voxel engine
+Copyright (C) 2025 Aditya Gupta
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+
+// A fresh directory under the system's temporary directory, removed along with its contents when this goes out of
+// scope, for cases that read and write files.
+struct TempDir
+{
+    std::filesystem::path path;
+
+    TempDir()
+    {
+        std::random_device randomDevice;
+        do
+        {
+            this->path = std::filesystem::temp_directory_path() /
+                         ("biomeinator-tests-" + std::to_string(randomDevice()) + std::to_string(randomDevice()));
+        } while (!std::filesystem::create_directory(this->path));
+    }
+
+    ~TempDir()
+    {
+        std::error_code errorCode;
+        std::filesystem::remove_all(this->path, errorCode);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    // number of files in the directory whose names end in `suffix`
+    uint32_t countFilesEndingWith(const std::string& suffix) const
+    {
+        uint32_t numFiles = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(this->path))
+        {
+            const std::string fileName = entry.path().filename().string();
+            if (fileName.ends_with(suffix))
+            {
+                ++numFiles;
+            }
+        }
+        return numFiles;
+    }
+};